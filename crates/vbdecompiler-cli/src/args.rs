@@ -0,0 +1,96 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Command-line options shared by the decompiling commands
+//!
+//! Each group flattens into the subcommands that take it and converts into
+//! the matching part of [`DecompilerConfig`].
+
+use std::time::Duration;
+use vbdecompiler_core::{DecompilerConfig, MethodBudget, Parallelism};
+
+/// Thread pool and task splitting options of single-file commands
+#[derive(clap::Args)]
+pub struct ThreadingArgs {
+    /// Worker threads (default: one per core)
+    #[arg(long, value_name = "N", default_value_t = 0)]
+    threads: usize,
+
+    /// Worker thread stack size in KiB (default: Rayon's)
+    #[arg(long, value_name = "KIB", default_value_t = 0)]
+    stack_size: usize,
+
+    /// Run methods with less P-Code than BYTES serially, batched together
+    #[arg(long, value_name = "BYTES", default_value_t = 0)]
+    serial_below: usize,
+
+    /// Unit of parallel work
+    #[arg(long, value_enum, default_value = "methods")]
+    parallelism: ParallelismArg,
+
+    /// Decode and lift each method in one pass, without an instruction buffer
+    #[arg(long)]
+    fused: bool,
+}
+
+impl ThreadingArgs {
+    pub fn config(&self) -> DecompilerConfig {
+        DecompilerConfig {
+            threads: self.threads,
+            stack_size: self.stack_size.saturating_mul(1024),
+            serial_threshold: self.serial_below,
+            parallelism: match self.parallelism {
+                ParallelismArg::Methods => Parallelism::Methods,
+                ParallelismArg::Objects => Parallelism::Objects,
+            },
+            fused: self.fused,
+            ..Default::default()
+        }
+    }
+}
+
+/// Per-method limits guarding against malformed procedure tables
+#[derive(clap::Args)]
+pub struct BudgetArgs {
+    /// Skip methods with more than BYTES of P-Code or native code
+    #[arg(long, value_name = "BYTES")]
+    max_method_bytes: Option<usize>,
+
+    /// Skip methods that decode to more than N instructions
+    #[arg(long, value_name = "N")]
+    max_method_instructions: Option<usize>,
+
+    /// Give up on a single method after MS milliseconds
+    #[arg(long, value_name = "MS")]
+    method_timeout_ms: Option<u64>,
+}
+
+impl BudgetArgs {
+    pub fn budget(&self) -> MethodBudget {
+        let defaults = MethodBudget::default();
+        MethodBudget {
+            max_bytes: self.max_method_bytes.unwrap_or(defaults.max_bytes),
+            max_instructions: self
+                .max_method_instructions
+                .unwrap_or(defaults.max_instructions),
+            max_time: self.method_timeout_ms.map(Duration::from_millis),
+        }
+    }
+
+    /// `config` with these limits
+    pub fn config(&self, config: DecompilerConfig) -> DecompilerConfig {
+        DecompilerConfig {
+            budget: self.budget(),
+            ..config
+        }
+    }
+}
+
+#[derive(Clone, Copy, clap::ValueEnum)]
+enum ParallelismArg {
+    /// One task per method
+    Methods,
+    /// One task per object (for a few huge forms)
+    Objects,
+}
@@ -0,0 +1,724 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Batch decompilation of whole directories and file lists
+//!
+//! Every file runs as a task on one Rayon pool, and the per-method parallelism
+//! inside [`Decompiler`] shares that pool, so idle workers steal methods from
+//! large files while small ones finish. Inputs are enumerated lazily and
+//! admitted against an in-flight budget (file count and total input size), so
+//! memory stays bounded regardless of corpus size. A watchdog cancels files
+//! that exceed their timeout, and each finished file appends one JSON line to
+//! the summary stream.
+
+use crate::render::{export_archive, render_output, OutputFormat};
+use serde_json::json;
+use std::collections::{HashMap, HashSet};
+use std::ffi::OsString;
+use std::fs;
+use std::io::{self, BufRead, BufWriter, Write};
+use std::panic::{self, AssertUnwindSafe};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+use vbdecompiler_core::{
+    CancellationToken, DecompileHooks, Decompiler, Error, MethodBudget, PackerCheck,
+};
+
+/// Extensions picked up when walking directories
+const VB_EXTENSIONS: &[&str] = &["exe", "dll", "ocx"];
+
+/// How often the watchdog checks deadlines
+const WATCHDOG_INTERVAL: Duration = Duration::from_millis(50);
+
+/// Settings for a batch run
+pub struct BatchOptions {
+    /// Files and directories to process
+    pub inputs: Vec<PathBuf>,
+    /// File with one input path per line (`-` for stdin)
+    pub files_from: Option<PathBuf>,
+    /// Directory receiving one output file per input; no code is written if unset
+    ///
+    /// Outputs are named after the input's path below its input directory, or
+    /// its file name if named explicitly; an input whose name is already taken
+    /// fails rather than overwriting the earlier output.
+    pub output_dir: Option<PathBuf>,
+    pub format: OutputFormat,
+    /// Worker threads (0 = one per core)
+    pub jobs: usize,
+    /// Maximum number of files being decompiled at once (0 = twice the thread count)
+    pub max_in_flight: usize,
+    /// Maximum total size of the files being decompiled at once
+    pub max_in_flight_bytes: u64,
+    /// Per-file time limit
+    pub timeout: Option<Duration>,
+    /// JSONL summary destination (default: stdout)
+    pub summary: Option<PathBuf>,
+    pub cache_dir: Option<PathBuf>,
+    /// Process every file found in directories, not just .exe/.dll/.ocx
+    pub all_files: bool,
+    /// When packer detection runs on each input
+    pub packer_check: PackerCheck,
+    /// Limits applied to each method of every file
+    pub method_budget: MethodBudget,
+    pub quiet: bool,
+}
+
+/// Final tallies of a batch run
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct BatchTotals {
+    pub succeeded: usize,
+    pub failed: usize,
+    pub timed_out: usize,
+}
+
+/// Run a batch, returning once every admitted file has finished
+pub fn run(options: BatchOptions) -> Result<BatchTotals, Error> {
+    let pool = worker_pool(options.jobs)?;
+
+    let max_files = match options.max_in_flight {
+        0 => pool.current_num_threads() * 2,
+        n => n,
+    };
+
+    let summary: Box<dyn Write + Send> = match &options.summary {
+        Some(path) => Box::new(BufWriter::new(fs::File::create(path)?)),
+        None => Box::new(BufWriter::new(io::stdout())),
+    };
+
+    let mut decompiler = Decompiler::new();
+    decompiler.set_cache_dir(options.cache_dir.clone());
+    decompiler.set_packer_check(options.packer_check);
+    decompiler.set_method_budget(options.method_budget);
+
+    let shared = Arc::new(Shared {
+        budget: Budget::new(max_files, options.max_in_flight_bytes),
+        watchdog: Watchdog::default(),
+        summary: Mutex::new(summary),
+        totals: Totals::default(),
+        output_dir: options.output_dir.clone(),
+        format: options.format,
+        timeout: options.timeout,
+        decompiler,
+    });
+
+    let watchdog = {
+        let shared = Arc::clone(&shared);
+        thread::spawn(move || shared.watchdog.run())
+    };
+
+    let mut inputs = options.inputs.clone();
+    if let Some(list) = &options.files_from {
+        inputs.extend(read_file_list(list)?);
+    }
+
+    // Output names already taken, so two inputs never write the same file
+    let mut claimed = HashSet::new();
+    for entry in InputWalker::new(inputs, options.all_files) {
+        let entry = match entry {
+            Ok(entry)
+                if options.output_dir.is_some() && !claimed.insert(entry.relative.clone()) =>
+            {
+                let e = io::Error::new(
+                    io::ErrorKind::AlreadyExists,
+                    format!(
+                        "Output name {} is already used by another input",
+                        entry.relative.display()
+                    ),
+                );
+                Err((entry.path, e))
+            }
+            entry => entry,
+        };
+        let entry = match entry {
+            Ok(entry) => entry,
+            Err((path, e)) => {
+                shared.emit(json!({
+                    "path": path.display().to_string(),
+                    "status": "error",
+                    "error": e.to_string(),
+                }));
+                shared.totals.failed.fetch_add(1, Ordering::Relaxed);
+                continue;
+            }
+        };
+
+        // Blocks until enough in-flight work has finished
+        shared.budget.acquire(entry.size);
+
+        let shared = Arc::clone(&shared);
+        pool.spawn(move || shared.process(entry));
+    }
+
+    shared.budget.wait_idle();
+    shared.watchdog.stop();
+    let _ = watchdog.join();
+    shared.summary.lock().unwrap().flush()?;
+
+    let totals = shared.totals.snapshot();
+    if !options.quiet {
+        eprintln!(
+            "Batch finished: {} succeeded, {} failed, {} timed out",
+            totals.succeeded, totals.failed, totals.timed_out
+        );
+    }
+
+    Ok(totals)
+}
+
+/// Pool running one task per file (0 threads = one per core)
+pub(crate) fn worker_pool(jobs: usize) -> Result<rayon::ThreadPool, Error> {
+    rayon::ThreadPoolBuilder::new()
+        .num_threads(jobs)
+        .thread_name(|i| format!("vbdc-worker-{}", i))
+        .build()
+        .map_err(|e| Error::from(io::Error::new(io::ErrorKind::Other, e)))
+}
+
+/// State shared between the scheduler, the tasks and the watchdog
+struct Shared {
+    budget: Budget,
+    watchdog: Watchdog,
+    summary: Mutex<Box<dyn Write + Send>>,
+    totals: Totals,
+    output_dir: Option<PathBuf>,
+    format: OutputFormat,
+    timeout: Option<Duration>,
+    /// Shared by every file, so its cache and scratch buffers stay warm
+    decompiler: Decompiler,
+}
+
+impl Shared {
+    /// Decompile one file and report it; runs on a pool worker
+    fn process(&self, entry: Entry) {
+        // Return the budget even if the task panics
+        let _permit = Permit {
+            budget: &self.budget,
+            bytes: entry.size,
+        };
+
+        let started = Instant::now();
+        let token = CancellationToken::new();
+        let watch_id = self
+            .timeout
+            // A timeout too large to represent means no deadline
+            .and_then(|timeout| started.checked_add(timeout))
+            .map(|deadline| self.watchdog.watch(deadline, token.clone()));
+
+        // A malformed sample must not take the whole batch down
+        let outcome = panic::catch_unwind(AssertUnwindSafe(|| self.decompile(&entry, &token)))
+            .unwrap_or_else(|_| Err(Error::Decompilation("decompiler panicked".to_string())));
+
+        if let Some(id) = watch_id {
+            self.watchdog.unwatch(id);
+        }
+
+        let elapsed_ms = started.elapsed().as_millis() as u64;
+        let path = entry.path.display().to_string();
+        let record = match outcome {
+            Ok(done) => {
+                self.totals.succeeded.fetch_add(1, Ordering::Relaxed);
+                json!({
+                    "path": path,
+                    "status": "ok",
+                    "project": done.project_name,
+                    "is_pcode": done.is_pcode,
+                    "objects": done.object_count,
+                    "methods": done.method_count,
+                    "output": done.output.map(|p| p.display().to_string()),
+                    "elapsed_ms": elapsed_ms,
+                })
+            }
+            Err(Error::Cancelled) => {
+                self.totals.timed_out.fetch_add(1, Ordering::Relaxed);
+                json!({
+                    "path": path,
+                    "status": "timeout",
+                    "elapsed_ms": elapsed_ms,
+                })
+            }
+            Err(e) => {
+                self.totals.failed.fetch_add(1, Ordering::Relaxed);
+                json!({
+                    "path": path,
+                    "status": "error",
+                    "error": e.to_string(),
+                    "elapsed_ms": elapsed_ms,
+                })
+            }
+        };
+
+        self.emit(record);
+    }
+
+    fn decompile(&self, entry: &Entry, token: &CancellationToken) -> Result<Decompiled, Error> {
+        let path = entry
+            .path
+            .to_str()
+            .ok_or_else(|| Error::Decompilation("path is not valid UTF-8".to_string()))?;
+
+        let hooks = DecompileHooks {
+            progress: None,
+            cancel: Some(token),
+            stats: None,
+        };
+        let output = match &self.output_dir {
+            Some(dir) => {
+                let output_path = output_path(dir, &entry.relative, self.format);
+                if let Some(parent) = output_path.parent() {
+                    fs::create_dir_all(parent)?;
+                }
+                Some(output_path)
+            }
+            None => None,
+        };
+
+        let result = match (&output, self.format) {
+            (Some(output_path), OutputFormat::Binary) => {
+                let file = BufWriter::new(fs::File::create(output_path)?);
+                export_archive(&self.decompiler, path, file, &hooks)?
+            }
+            _ => {
+                let result = self.decompiler.decompile_file_with_hooks(path, &hooks)?;
+                if let Some(output_path) = &output {
+                    fs::write(output_path, render_output(&result, self.format, true)?)?;
+                }
+                result
+            }
+        };
+
+        Ok(Decompiled {
+            project_name: result.project_name,
+            is_pcode: result.is_pcode,
+            object_count: result.object_count,
+            method_count: result.method_count,
+            output,
+        })
+    }
+
+    /// Append one line to the summary stream
+    fn emit(&self, record: serde_json::Value) {
+        let mut summary = self.summary.lock().unwrap();
+        // Flush per line so the stream can be followed while the batch runs
+        let written = writeln!(summary, "{}", record).and_then(|_| summary.flush());
+        if let Err(e) = written {
+            log::error!("Failed to write batch summary: {}", e);
+        }
+    }
+}
+
+/// Summary of a successfully decompiled file
+struct Decompiled {
+    project_name: String,
+    is_pcode: bool,
+    object_count: usize,
+    method_count: usize,
+    output: Option<PathBuf>,
+}
+
+#[derive(Default)]
+pub(crate) struct Totals {
+    pub(crate) succeeded: AtomicUsize,
+    pub(crate) failed: AtomicUsize,
+    pub(crate) timed_out: AtomicUsize,
+}
+
+impl Totals {
+    pub(crate) fn snapshot(&self) -> BatchTotals {
+        BatchTotals {
+            succeeded: self.succeeded.load(Ordering::Relaxed),
+            failed: self.failed.load(Ordering::Relaxed),
+            timed_out: self.timed_out.load(Ordering::Relaxed),
+        }
+    }
+}
+
+/// Output file for an input: its relative path plus the format's extension
+///
+/// The input extension is kept (`a.exe` → `a.exe.vb`) so `a.exe` and `a.dll`
+/// in one directory don't collide.
+fn output_path(dir: &Path, relative: &Path, format: OutputFormat) -> PathBuf {
+    let mut name = OsString::from(relative.as_os_str());
+    name.push(".");
+    name.push(format.extension());
+    dir.join(name)
+}
+
+/// Bound on the work admitted but not yet finished
+pub(crate) struct Budget {
+    max_files: usize,
+    max_bytes: u64,
+    /// (files, bytes) in flight
+    state: Mutex<(usize, u64)>,
+    freed: Condvar,
+}
+
+impl Budget {
+    pub(crate) fn new(max_files: usize, max_bytes: u64) -> Self {
+        Self {
+            max_files: max_files.max(1),
+            max_bytes,
+            state: Mutex::new((0, 0)),
+            freed: Condvar::new(),
+        }
+    }
+
+    /// Wait for room for a file of `bytes`
+    ///
+    /// A file larger than the byte budget is still admitted once nothing else
+    /// is in flight, so oversized inputs run alone instead of stalling.
+    pub(crate) fn acquire(&self, bytes: u64) {
+        let mut state = self.state.lock().unwrap();
+        while state.0 >= self.max_files
+            || (state.0 > 0 && state.1.saturating_add(bytes) > self.max_bytes)
+        {
+            state = self.freed.wait(state).unwrap();
+        }
+        state.0 += 1;
+        state.1 += bytes;
+    }
+
+    pub(crate) fn release(&self, bytes: u64) {
+        let mut state = self.state.lock().unwrap();
+        state.0 -= 1;
+        state.1 -= bytes;
+        self.freed.notify_all();
+    }
+
+    /// Wait until every admitted file has finished
+    pub(crate) fn wait_idle(&self) {
+        let mut state = self.state.lock().unwrap();
+        while state.0 > 0 {
+            state = self.freed.wait(state).unwrap();
+        }
+    }
+}
+
+/// Releases a file's share of the [`Budget`] when dropped
+pub(crate) struct Permit<'a> {
+    pub(crate) budget: &'a Budget,
+    pub(crate) bytes: u64,
+}
+
+impl Drop for Permit<'_> {
+    fn drop(&mut self) {
+        self.budget.release(self.bytes);
+    }
+}
+
+/// Cancels files running past their deadline
+///
+/// Cancellation is cooperative: a timed-out file stops before its next method,
+/// so a single pathological method can overrun the limit.
+#[derive(Default)]
+pub(crate) struct Watchdog {
+    next_id: AtomicU64,
+    state: Mutex<WatchState>,
+    changed: Condvar,
+}
+
+#[derive(Default)]
+struct WatchState {
+    deadlines: HashMap<u64, (Instant, CancellationToken)>,
+    stopped: bool,
+}
+
+impl Watchdog {
+    pub(crate) fn watch(&self, deadline: Instant, token: CancellationToken) -> u64 {
+        let id = self.next_id.fetch_add(1, Ordering::Relaxed);
+        let mut state = self.state.lock().unwrap();
+        state.deadlines.insert(id, (deadline, token));
+        id
+    }
+
+    pub(crate) fn unwatch(&self, id: u64) {
+        self.state.lock().unwrap().deadlines.remove(&id);
+    }
+
+    pub(crate) fn stop(&self) {
+        self.state.lock().unwrap().stopped = true;
+        self.changed.notify_all();
+    }
+
+    /// Watchdog thread body; returns after [`stop`](Self::stop)
+    pub(crate) fn run(&self) {
+        let mut state = self.state.lock().unwrap();
+        while !state.stopped {
+            let now = Instant::now();
+            state.deadlines.retain(|_, (deadline, token)| {
+                if *deadline <= now {
+                    token.cancel();
+                    false
+                } else {
+                    true
+                }
+            });
+
+            state = self
+                .changed
+                .wait_timeout(state, WATCHDOG_INTERVAL)
+                .unwrap()
+                .0;
+        }
+    }
+}
+
+/// A file admitted to the batch
+struct Entry {
+    path: PathBuf,
+    /// Path below its input directory, used to name the output
+    relative: PathBuf,
+    size: u64,
+}
+
+/// Lazily enumerates input files, descending into directories depth-first
+///
+/// Symlinked directories are followed, but each directory is entered once,
+/// so a link back up the tree can't recurse forever.
+struct InputWalker {
+    /// Pending (path, relative name, explicitly named) items, popped from the back
+    pending: Vec<(PathBuf, PathBuf, bool)>,
+    /// Canonical paths of the directories entered so far
+    visited: HashSet<PathBuf>,
+    all_files: bool,
+}
+
+impl InputWalker {
+    fn new(inputs: Vec<PathBuf>, all_files: bool) -> Self {
+        let pending = inputs
+            .into_iter()
+            .rev()
+            .map(|path| (path, PathBuf::new(), true))
+            .collect();
+        Self {
+            pending,
+            visited: HashSet::new(),
+            all_files,
+        }
+    }
+
+    fn wanted(&self, path: &Path) -> bool {
+        self.all_files
+            || path
+                .extension()
+                .and_then(|ext| ext.to_str())
+                .map_or(false, |ext| {
+                    VB_EXTENSIONS.iter().any(|e| ext.eq_ignore_ascii_case(e))
+                })
+    }
+}
+
+impl Iterator for InputWalker {
+    type Item = Result<Entry, (PathBuf, io::Error)>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        while let Some((path, relative, explicit)) = self.pending.pop() {
+            let metadata = match fs::metadata(&path) {
+                Ok(metadata) => metadata,
+                Err(e) => return Some(Err((path, e))),
+            };
+
+            if metadata.is_dir() {
+                match fs::canonicalize(&path) {
+                    Ok(real) if !self.visited.insert(real) => continue,
+                    Ok(_) => {}
+                    Err(e) => return Some(Err((path, e))),
+                }
+                let mut children = match fs::read_dir(&path).and_then(|entries| {
+                    entries
+                        .map(|e| e.map(|e| e.path()))
+                        .collect::<io::Result<Vec<_>>>()
+                }) {
+                    Ok(children) => children,
+                    Err(e) => return Some(Err((path, e))),
+                };
+                // Deterministic order; reversed because `pending` is a stack
+                children.sort_unstable_by(|a, b| b.cmp(a));
+                for child in children {
+                    let name = relative.join(child.file_name().unwrap_or_default());
+                    self.pending.push((child, name, false));
+                }
+                continue;
+            }
+
+            if !explicit && !self.wanted(&path) {
+                continue;
+            }
+
+            let relative = if explicit {
+                PathBuf::from(path.file_name().unwrap_or_default())
+            } else {
+                relative
+            };
+
+            return Some(Ok(Entry {
+                path,
+                relative,
+                size: metadata.len(),
+            }));
+        }
+
+        None
+    }
+}
+
+/// Read input paths, one per line, skipping blank lines
+fn read_file_list(list: &Path) -> io::Result<Vec<PathBuf>> {
+    let reader: Box<dyn BufRead> = if list == Path::new("-") {
+        Box::new(io::stdin().lock())
+    } else {
+        Box::new(io::BufReader::new(fs::File::open(list)?))
+    };
+
+    let mut paths = Vec::new();
+    for line in reader.lines() {
+        let line = line?;
+        let line = line.trim();
+        if !line.is_empty() {
+            paths.push(PathBuf::from(line));
+        }
+    }
+    Ok(paths)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn temp_dir(name: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("vbdc-batch-{}-{}", name, std::process::id()));
+        let _ = fs::remove_dir_all(&dir);
+        fs::create_dir_all(&dir).unwrap();
+        dir
+    }
+
+    #[test]
+    fn test_walker_filters_and_orders() {
+        let dir = temp_dir("walk");
+        fs::create_dir_all(dir.join("sub")).unwrap();
+        fs::write(dir.join("b.exe"), b"x").unwrap();
+        fs::write(dir.join("a.DLL"), b"xy").unwrap();
+        fs::write(dir.join("notes.txt"), b"").unwrap();
+        fs::write(dir.join("sub/c.ocx"), b"").unwrap();
+
+        let found: Vec<_> = InputWalker::new(vec![dir.clone()], false)
+            .map(|e| e.unwrap())
+            .map(|e| (e.relative, e.size))
+            .collect();
+        assert_eq!(
+            found,
+            vec![
+                (PathBuf::from("a.DLL"), 2),
+                (PathBuf::from("b.exe"), 1),
+                (PathBuf::from("sub/c.ocx"), 0),
+            ]
+        );
+
+        // Explicitly named files are taken regardless of extension
+        let explicit: Vec<_> = InputWalker::new(vec![dir.join("notes.txt")], false)
+            .map(|e| e.unwrap().relative)
+            .collect();
+        assert_eq!(explicit, vec![PathBuf::from("notes.txt")]);
+
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_walker_reports_missing_input() {
+        let mut walker = InputWalker::new(vec![PathBuf::from("/nonexistent/input")], false);
+        assert!(matches!(walker.next(), Some(Err(_))));
+        assert!(walker.next().is_none());
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_walker_enters_symlink_loop_once() {
+        let dir = temp_dir("loop");
+        fs::write(dir.join("a.exe"), b"x").unwrap();
+        std::os::unix::fs::symlink(&dir, dir.join("again")).unwrap();
+
+        let found: Vec<_> = InputWalker::new(vec![dir.clone()], false)
+            .map(|e| e.unwrap().relative)
+            .collect();
+        assert_eq!(found, vec![PathBuf::from("a.exe")]);
+
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_colliding_output_names_fail() {
+        let dir = temp_dir("collide");
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let sample = corpus.join("synthetic-small.exe");
+        fs::create_dir_all(dir.join("copy")).unwrap();
+        fs::copy(&sample, dir.join("copy/synthetic-small.exe")).unwrap();
+
+        let totals = run(BatchOptions {
+            inputs: vec![sample, dir.join("copy/synthetic-small.exe")],
+            files_from: None,
+            output_dir: Some(dir.join("out")),
+            format: OutputFormat::Vb6,
+            jobs: 1,
+            max_in_flight: 0,
+            max_in_flight_bytes: u64::MAX,
+            timeout: None,
+            summary: Some(dir.join("summary.jsonl")),
+            cache_dir: None,
+            all_files: false,
+            packer_check: PackerCheck::Skip,
+            method_budget: MethodBudget::default(),
+            quiet: true,
+        })
+        .unwrap();
+        assert_eq!(totals.succeeded, 1);
+        assert_eq!(totals.failed, 1);
+
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_budget_admits_oversized_file_alone() {
+        let budget = Budget::new(4, 100);
+        budget.acquire(500);
+        budget.release(500);
+        budget.acquire(60);
+        budget.acquire(40);
+        assert_eq!(*budget.state.lock().unwrap(), (2, 100));
+        budget.release(60);
+        budget.release(40);
+        budget.wait_idle();
+    }
+
+    #[test]
+    fn test_output_path_keeps_input_extension() {
+        let path = output_path(Path::new("out"), Path::new("sub/a.exe"), OutputFormat::Vb6);
+        assert_eq!(path, PathBuf::from("out/sub/a.exe.vb"));
+    }
+
+    #[test]
+    fn test_watchdog_cancels_expired() {
+        let watchdog = Arc::new(Watchdog::default());
+        let handle = {
+            let watchdog = Arc::clone(&watchdog);
+            thread::spawn(move || watchdog.run())
+        };
+
+        let expired = CancellationToken::new();
+        let pending = CancellationToken::new();
+        watchdog.watch(Instant::now(), expired.clone());
+        watchdog.watch(Instant::now() + Duration::from_secs(3600), pending.clone());
+
+        let start = Instant::now();
+        while !expired.is_cancelled() && start.elapsed() < Duration::from_secs(5) {
+            thread::sleep(Duration::from_millis(5));
+        }
+        assert!(expired.is_cancelled());
+        assert!(!pending.is_cancelled());
+
+        watchdog.stop();
+        handle.join().unwrap();
+    }
+}
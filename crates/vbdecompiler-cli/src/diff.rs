@@ -0,0 +1,198 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Release-to-release comparison (`vbdc diff OLD NEW`)
+//!
+//! Built on [`Decompiler::diff_files`]: both builds are parsed and hashed per
+//! method, and only methods whose P-Code differs are decompiled.
+
+use crate::InfoFormat;
+use colored::Colorize;
+use std::fmt::Write;
+use std::path::PathBuf;
+use vbdecompiler_core::{
+    BuildDiff, ChangeKind, DecompileHooks, Decompiler, DecompilerConfig, Error, MethodChange,
+};
+
+/// Unchanged lines shown around each changed region with `--code`
+const CONTEXT_LINES: usize = 2;
+
+/// Settings for a diff run
+pub struct DiffOptions {
+    pub old: PathBuf,
+    pub new: PathBuf,
+    pub format: InfoFormat,
+    /// Show the code of each differing method
+    pub code: bool,
+    pub cache_dir: Option<PathBuf>,
+    pub config: DecompilerConfig,
+    pub quiet: bool,
+}
+
+/// Compare the builds and print the differences
+///
+/// Returns whether any method differs.
+pub fn run(options: DiffOptions) -> Result<bool, Error> {
+    if !options.quiet && matches!(options.format, InfoFormat::Text) {
+        println!(
+            "{} {} → {}",
+            "Comparing:".green().bold(),
+            options.old.display(),
+            options.new.display()
+        );
+    }
+
+    let mut decompiler = Decompiler::with_config(options.config)?;
+    decompiler.set_cache_dir(options.cache_dir);
+    let diff = decompiler.diff_files(
+        &options.old.to_string_lossy(),
+        &options.new.to_string_lossy(),
+        &DecompileHooks::default(),
+    )?;
+
+    match options.format {
+        InfoFormat::Text => print!("{}", render_text(&diff, options.code, options.quiet)),
+        InfoFormat::Json => println!(
+            "{}",
+            serde_json::to_string_pretty(&diff)
+                .map_err(|e| Error::from(std::io::Error::new(std::io::ErrorKind::Other, e)))?
+        ),
+    }
+
+    Ok(!diff.changes.is_empty())
+}
+
+/// One line per differing method, optionally followed by its code, then a summary
+fn render_text(diff: &BuildDiff, code: bool, quiet: bool) -> String {
+    let mut out = String::new();
+
+    for change in &diff.changes {
+        let mut name = format!("{}.{}", change.object_name, change.method_name);
+        if failed(change) {
+            name.push_str(" (failed to decompile)");
+        }
+        let _ = match change.kind {
+            ChangeKind::Added => writeln!(out, "{} {}", "+".green().bold(), name),
+            ChangeKind::Changed => writeln!(out, "{} {}", "~".yellow().bold(), name),
+            ChangeKind::Removed => writeln!(out, "{} {}", "-".red().bold(), name),
+        };
+        if code {
+            write_code(&mut out, change);
+            out.push('\n');
+        }
+    }
+
+    if !quiet {
+        let _ = writeln!(
+            out,
+            "\n{} changed, {} added, {} removed, {} unchanged",
+            diff.count(ChangeKind::Changed),
+            diff.count(ChangeKind::Added),
+            diff.count(ChangeKind::Removed),
+            diff.unchanged
+        );
+    }
+
+    out
+}
+
+/// Whether a build that has the method could not decompile it
+fn failed(change: &MethodChange) -> bool {
+    let old = change.kind != ChangeKind::Added && change.old_code.is_none();
+    let new = change.kind != ChangeKind::Removed && change.new_code.is_none();
+    old || new
+}
+
+/// Write the lines that differ between the old and new code of `change`
+///
+/// Common leading and trailing lines are trimmed to [`CONTEXT_LINES`] of
+/// context on each side of the changed region.
+fn write_code(out: &mut String, change: &MethodChange) {
+    let old: Vec<&str> = change.old_code.as_deref().unwrap_or("").lines().collect();
+    let new: Vec<&str> = change.new_code.as_deref().unwrap_or("").lines().collect();
+
+    let prefix = old.iter().zip(&new).take_while(|(a, b)| a == b).count();
+    let suffix = old[prefix..]
+        .iter()
+        .rev()
+        .zip(new[prefix..].iter().rev())
+        .take_while(|(a, b)| a == b)
+        .count();
+
+    for line in &old[prefix.saturating_sub(CONTEXT_LINES)..prefix] {
+        let _ = writeln!(out, "  {}", line);
+    }
+    for line in &old[prefix..old.len() - suffix] {
+        let _ = writeln!(out, "{}", format!("- {}", line).red());
+    }
+    for line in &new[prefix..new.len() - suffix] {
+        let _ = writeln!(out, "{}", format!("+ {}", line).green());
+    }
+    let tail = new.len() - suffix;
+    for line in &new[tail..(tail + CONTEXT_LINES).min(new.len())] {
+        let _ = writeln!(out, "  {}", line);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn change(old: Option<&str>, new: Option<&str>) -> MethodChange {
+        MethodChange {
+            kind: ChangeKind::Changed,
+            object_name: "Form1".to_string(),
+            method_name: "Load".to_string(),
+            old_code: old.map(str::to_string),
+            new_code: new.map(str::to_string),
+        }
+    }
+
+    /// `write_code` output without colour escapes
+    fn plain_code(change: &MethodChange) -> String {
+        let mut out = String::new();
+        write_code(&mut out, change);
+
+        let mut plain = String::new();
+        let mut chars = out.chars();
+        while let Some(c) = chars.next() {
+            if c == '\x1b' {
+                chars.by_ref().find(|&c| c == 'm');
+            } else {
+                plain.push(c);
+            }
+        }
+        plain
+    }
+
+    #[test]
+    fn test_code_keeps_context_around_change() {
+        let old = "Sub A()\n    x = 1\n    y = 2\n    z = 3\n    w = 4\nEnd Sub";
+        let new = "Sub A()\n    x = 1\n    y = 5\n    z = 3\n    w = 4\nEnd Sub";
+        assert_eq!(
+            plain_code(&change(Some(old), Some(new))),
+            "  Sub A()\n      x = 1\n-     y = 2\n+     y = 5\n      z = 3\n      w = 4\n"
+        );
+    }
+
+    #[test]
+    fn test_failed_method_is_labelled() {
+        assert!(!failed(&change(Some("Sub A()"), Some("Sub A()"))));
+        assert!(failed(&change(Some("Sub A()"), None)));
+
+        let mut added = change(None, Some("Sub B()"));
+        added.kind = ChangeKind::Added;
+        assert!(!failed(&added));
+        added.new_code = None;
+        assert!(failed(&added));
+    }
+
+    #[test]
+    fn test_code_of_added_method() {
+        assert_eq!(
+            plain_code(&change(None, Some("Sub B()\nEnd Sub"))),
+            "+ Sub B()\n+ End Sub\n"
+        );
+    }
+}
@@ -4,13 +4,32 @@
 
 //! VBDecompiler CLI - Command-line interface for decompiling VB5/6 executables
 
+mod args;
+mod batch;
+mod diff;
+mod render;
+mod serve;
+
+use args::{BudgetArgs, ThreadingArgs};
 use clap::{CommandFactory, Parser, Subcommand};
 use clap_complete::{generate, Shell};
 use colored::Colorize;
+use render::{export_archive, format_stats, render_output, OutputFormat};
 use std::fs;
 use std::io;
-use std::path::PathBuf;
-use vbdecompiler_core::{detect_packer, Decompiler, Error};
+use std::path::{Path, PathBuf};
+use std::time::Duration;
+use vbdecompiler_core::packer::PackerError;
+use vbdecompiler_core::{
+    detect_packer, DecompileHooks, Decompiler, DecompilerConfig, Error, PEFile, PackerCheck,
+    PackerDetection, StatsCollector,
+};
+
+// Lets --stats report allocation counts
+#[cfg(feature = "count-allocations")]
+#[global_allocator]
+static ALLOCATOR: vbdecompiler_core::CountingAllocator =
+    vbdecompiler_core::CountingAllocator::new(std::alloc::System);
 
 #[derive(Parser)]
 #[command(name = "vbdc")]
@@ -27,6 +46,43 @@ struct Cli {
     /// Quiet mode (minimal output, errors only)
     #[arg(short, long, global = true)]
     quiet: bool,
+
+    /// Print stage timings, counters and the slowest methods to stderr
+    #[arg(long, global = true)]
+    stats: bool,
+
+    /// Write a Chrome trace of the decompilation to FILE (chrome://tracing, Perfetto)
+    #[arg(long, global = true, value_name = "FILE")]
+    trace: Option<PathBuf>,
+}
+
+/// What to measure about a decompilation and where to report it
+struct Instrumentation {
+    stats: bool,
+    trace: Option<PathBuf>,
+}
+
+impl Instrumentation {
+    /// A collector if anything was asked for
+    fn collector(&self) -> Option<StatsCollector> {
+        match (self.stats, &self.trace) {
+            (false, None) => None,
+            (_, None) => Some(StatsCollector::new()),
+            (_, Some(_)) => Some(StatsCollector::new().with_trace()),
+        }
+    }
+
+    fn report(&self, collector: &StatsCollector) -> Result<(), Error> {
+        if let Some(path) = &self.trace {
+            let mut out = io::BufWriter::new(fs::File::create(path)?);
+            collector.write_chrome_trace(&mut out)?;
+            io::Write::flush(&mut out)?;
+        }
+        if self.stats {
+            eprint!("{}", format_stats(&collector.finish()));
+        }
+        Ok(())
+    }
 }
 
 #[derive(Subcommand)]
@@ -48,6 +104,144 @@ enum Commands {
         /// Force processing even if warnings detected
         #[arg(long)]
         force: bool,
+
+        /// Cache results in DIR and reuse methods whose P-Code is unchanged
+        #[arg(long, value_name = "DIR")]
+        cache_dir: Option<PathBuf>,
+
+        /// Store an IR listing with each method (binary format only)
+        #[arg(long)]
+        with_ir: bool,
+
+        #[command(flatten)]
+        threading: ThreadingArgs,
+
+        #[command(flatten)]
+        budget: BudgetArgs,
+    },
+
+    /// Decompile every executable in directories or file lists on one thread pool
+    ///
+    /// Writes one JSON line per file to the summary stream.
+    Batch {
+        /// Files and directories to process (directories are walked recursively)
+        #[arg(value_name = "PATH")]
+        inputs: Vec<PathBuf>,
+
+        /// Read additional input paths from FILE, one per line ("-" for stdin)
+        #[arg(long, value_name = "FILE")]
+        files_from: Option<PathBuf>,
+
+        /// Write one output file per input below DIR, mirroring input directories
+        #[arg(short, long, value_name = "DIR")]
+        output_dir: Option<PathBuf>,
+
+        /// Output format
+        #[arg(short, long, value_enum, default_value = "vb6")]
+        format: OutputFormat,
+
+        /// Worker threads (default: one per core)
+        #[arg(short, long, value_name = "N", default_value_t = 0)]
+        jobs: usize,
+
+        /// Maximum files decompiled at once (default: twice the thread count)
+        #[arg(long, value_name = "N", default_value_t = 0)]
+        max_in_flight: usize,
+
+        /// Maximum total size of the files decompiled at once, in MiB
+        #[arg(long, value_name = "MIB", default_value_t = 1024)]
+        max_in_flight_mb: u64,
+
+        /// Give up on a file after SECS seconds
+        #[arg(long, value_name = "SECS")]
+        timeout: Option<f64>,
+
+        /// Write the JSONL summary to FILE instead of stdout
+        #[arg(long, value_name = "FILE")]
+        summary: Option<PathBuf>,
+
+        /// Cache results in DIR and reuse methods whose P-Code is unchanged
+        #[arg(long, value_name = "DIR")]
+        cache_dir: Option<PathBuf>,
+
+        /// Process every file in directories, not just .exe/.dll/.ocx
+        #[arg(long)]
+        all_files: bool,
+
+        /// Don't run packer detection (inputs were already triaged)
+        #[arg(long)]
+        skip_packer_check: bool,
+
+        #[command(flatten)]
+        budget: BudgetArgs,
+    },
+
+    /// Serve triage requests as JSON lines on stdin, one result line each on stdout
+    ///
+    /// Each request is an object with a "path" and optional "id", "decompile",
+    /// "code" (include the code in the result), "output" (write the code to a
+    /// file), "force" (decompile packed files) and "timeout" fields. Results
+    /// arrive in completion order and echo the request's id. All requests
+    /// share one decompiler session and its cache.
+    Serve {
+        /// Worker threads (default: one per core)
+        #[arg(short, long, value_name = "N", default_value_t = 0)]
+        jobs: usize,
+
+        /// Maximum requests processed at once (default: twice the thread count)
+        #[arg(long, value_name = "N", default_value_t = 0)]
+        max_in_flight: usize,
+
+        /// Maximum total size of the files processed at once, in MiB
+        #[arg(long, value_name = "MIB", default_value_t = 1024)]
+        max_in_flight_mb: u64,
+
+        /// Give up on a request after SECS seconds unless it sets its own "timeout"
+        #[arg(long, value_name = "SECS")]
+        timeout: Option<f64>,
+
+        /// Cache results in DIR and reuse methods whose P-Code is unchanged
+        #[arg(long, value_name = "DIR")]
+        cache_dir: Option<PathBuf>,
+
+        /// Format of files written for requests with an "output"
+        #[arg(short, long, value_enum, default_value = "vb6")]
+        format: OutputFormat,
+
+        #[command(flatten)]
+        budget: BudgetArgs,
+    },
+
+    /// Compare two builds of a VB application method by method
+    ///
+    /// Only methods whose P-Code differs are decompiled. Exits with status 1
+    /// if any method was added, changed or removed.
+    Diff {
+        /// Older build
+        #[arg(value_name = "OLD")]
+        old: PathBuf,
+
+        /// Newer build
+        #[arg(value_name = "NEW")]
+        new: PathBuf,
+
+        /// Show the changed lines of each differing method
+        #[arg(long)]
+        code: bool,
+
+        /// Output format (text or json)
+        #[arg(short, long, value_enum, default_value = "text")]
+        format: InfoFormat,
+
+        /// Cache results in DIR and reuse methods whose P-Code is unchanged
+        #[arg(long, value_name = "DIR")]
+        cache_dir: Option<PathBuf>,
+
+        #[command(flatten)]
+        threading: ThreadingArgs,
+
+        #[command(flatten)]
+        budget: BudgetArgs,
     },
 
     /// Analyze a VB executable without decompiling
@@ -95,16 +289,6 @@ enum Commands {
     },
 }
 
-#[derive(Clone, Copy, clap::ValueEnum)]
-enum OutputFormat {
-    /// VB6 source code
-    Vb6,
-    /// JSON representation
-    Json,
-    /// IR (Intermediate Representation)
-    Ir,
-}
-
 #[derive(Clone, Copy, clap::ValueEnum)]
 enum InfoFormat {
     /// Human-readable text
@@ -126,6 +310,11 @@ fn main() {
     };
     env_logger::Builder::from_env(env_logger::Env::default().default_filter_or(log_level)).init();
 
+    let instrumentation = Instrumentation {
+        stats: cli.stats,
+        trace: cli.trace,
+    };
+
     // Execute command
     let result = match cli.command {
         Commands::Decompile {
@@ -133,7 +322,94 @@ fn main() {
             output,
             format,
             force,
-        } => cmd_decompile(input, output, format, force, cli.quiet),
+            cache_dir,
+            with_ir,
+            threading,
+            budget,
+        } => cmd_decompile(
+            input,
+            output,
+            format,
+            force,
+            cache_dir,
+            with_ir,
+            budget.config(threading.config()),
+            &instrumentation,
+            cli.quiet,
+        ),
+        Commands::Batch {
+            inputs,
+            files_from,
+            output_dir,
+            format,
+            jobs,
+            max_in_flight,
+            max_in_flight_mb,
+            timeout,
+            summary,
+            cache_dir,
+            all_files,
+            skip_packer_check,
+            budget,
+        } => cmd_batch(batch::BatchOptions {
+            inputs,
+            files_from,
+            output_dir,
+            format,
+            jobs,
+            max_in_flight,
+            max_in_flight_bytes: max_in_flight_mb.saturating_mul(1024 * 1024),
+            // Negative or non-finite values become zero and are rejected below
+            timeout: timeout
+                .map(|secs| Duration::try_from_secs_f64(secs).unwrap_or(Duration::ZERO)),
+            summary,
+            cache_dir,
+            all_files,
+            packer_check: if skip_packer_check {
+                PackerCheck::Skip
+            } else {
+                PackerCheck::Eager
+            },
+            method_budget: budget.budget(),
+            quiet: cli.quiet,
+        }),
+        Commands::Serve {
+            jobs,
+            max_in_flight,
+            max_in_flight_mb,
+            timeout,
+            cache_dir,
+            format,
+            budget,
+        } => cmd_serve(serve::ServeOptions {
+            jobs,
+            max_in_flight,
+            max_in_flight_bytes: max_in_flight_mb.saturating_mul(1024 * 1024),
+            // Negative or non-finite values become zero and are rejected below
+            timeout: timeout
+                .map(|secs| Duration::try_from_secs_f64(secs).unwrap_or(Duration::ZERO)),
+            cache_dir,
+            format,
+            method_budget: budget.budget(),
+            quiet: cli.quiet,
+        }),
+        Commands::Diff {
+            old,
+            new,
+            code,
+            format,
+            cache_dir,
+            threading,
+            budget,
+        } => cmd_diff(diff::DiffOptions {
+            old,
+            new,
+            format,
+            code,
+            cache_dir,
+            config: budget.config(threading.config()),
+            quiet: cli.quiet,
+        }),
         Commands::Info {
             input,
             detailed,
@@ -159,25 +435,28 @@ fn cmd_decompile(
     output: Option<PathBuf>,
     format: OutputFormat,
     _force: bool,
+    cache_dir: Option<PathBuf>,
+    with_ir: bool,
+    config: DecompilerConfig,
+    instrumentation: &Instrumentation,
     quiet: bool,
 ) -> Result<(), Error> {
+    let binary = matches!(format, OutputFormat::Binary);
+    if with_ir && !binary {
+        return Err(Error::from(std::io::Error::new(
+            std::io::ErrorKind::InvalidInput,
+            "--with-ir requires --format binary",
+        )));
+    }
+    // Status lines would corrupt an archive written to stdout
+    let quiet = quiet || (binary && output.is_none());
+
     if !quiet {
         println!("{} {}", "Decompiling:".green().bold(), input.display());
     }
 
-    let mut decompiler = Decompiler::new();
-    let result = decompiler.decompile_file(input.to_str().unwrap())?;
-
-    // Generate output based on format
-    let output_content = match format {
-        OutputFormat::Vb6 => format_vb6(&result, quiet),
-        OutputFormat::Json => format_json(&result)?,
-        OutputFormat::Ir => format_ir(&result),
-    };
-
-    // Write to output
-    if let Some(output_path) = output {
-        // Determine if output is a directory or file
+    // Determine if output is a directory or file
+    let output_file = output.map(|output_path| {
         if output_path.is_dir() {
             // Generate filename based on input
             let filename = input
@@ -185,70 +464,98 @@ fn cmd_decompile(
                 .unwrap_or_default()
                 .to_string_lossy()
                 .into_owned();
-            let extension = match format {
-                OutputFormat::Vb6 => "vb",
-                OutputFormat::Json => "json",
-                OutputFormat::Ir => "ir.txt",
-            };
-            let output_file = output_path.join(format!("{}.{}", filename, extension));
-
-            fs::write(&output_file, output_content)?;
-
-            if !quiet {
-                println!(
-                    "{} {}",
-                    "Output written to:".green().bold(),
-                    output_file.display()
-                );
-            }
+            output_path.join(format!("{}.{}", filename, format.extension()))
         } else {
-            // Write directly to file
-            fs::write(&output_path, output_content)?;
-
-            if !quiet {
-                println!(
-                    "{} {}",
-                    "Output written to:".green().bold(),
-                    output_path.display()
-                );
+            output_path
+        }
+    });
+
+    let mut decompiler = Decompiler::with_config(config)?;
+    decompiler.set_cache_dir(cache_dir);
+    decompiler.set_capture_ir(with_ir);
+    let collector = instrumentation.collector();
+    let hooks = DecompileHooks {
+        stats: collector.as_ref(),
+        ..Default::default()
+    };
+    let input_str = input.to_str().unwrap();
+
+    if let OutputFormat::Binary = format {
+        // Records are written as methods finish; nothing is rendered afterwards
+        match &output_file {
+            Some(path) => {
+                let file = io::BufWriter::new(fs::File::create(path)?);
+                export_archive(&decompiler, input_str, file, &hooks)?;
+            }
+            None => {
+                let stdout = io::BufWriter::new(io::stdout());
+                export_archive(&decompiler, input_str, stdout, &hooks)?;
             }
         }
     } else {
-        // Write to stdout
-        print!("{}", output_content);
+        let result = decompiler.decompile_file_with_hooks(input_str, &hooks)?;
+
+        // Generate output based on format
+        let output_content = render_output(&result, format, quiet)?;
+        match &output_file {
+            Some(path) => fs::write(path, output_content)?,
+            None => print!("{}", output_content),
+        }
+    }
+    if let Some(collector) = &collector {
+        instrumentation.report(collector)?;
+    }
+
+    if let (Some(path), false) = (&output_file, quiet) {
+        println!("{} {}", "Output written to:".green().bold(), path.display());
     }
 
     Ok(())
 }
 
-fn format_vb6(result: &vbdecompiler_core::DecompilationResult, quiet: bool) -> String {
-    let mut output = String::new();
-
-    if !quiet {
-        output.push_str(&format!("\n{}\n", "=".repeat(60)));
-        output.push_str(&format!("Project: {}\n", result.project_name));
-        output.push_str(&format!("P-Code: {}\n", result.is_pcode));
-        output.push_str(&format!("Objects: {}\n", result.object_count));
-        output.push_str(&format!("Methods: {}\n", result.method_count));
-        output.push_str(&format!("{}\n\n", "=".repeat(60)));
+fn cmd_batch(options: batch::BatchOptions) -> Result<(), Error> {
+    if options.inputs.is_empty() && options.files_from.is_none() {
+        return Err(Error::from(std::io::Error::new(
+            std::io::ErrorKind::InvalidInput,
+            "no inputs given (pass paths or --files-from)",
+        )));
+    }
+    if options.timeout.map_or(false, |t| t.is_zero()) {
+        return Err(Error::from(std::io::Error::new(
+            std::io::ErrorKind::InvalidInput,
+            "--timeout must be a positive number of seconds",
+        )));
     }
 
-    output.push_str(&result.vb6_code);
-    output
+    batch::run(options)?;
+    Ok(())
 }
 
-fn format_json(result: &vbdecompiler_core::DecompilationResult) -> Result<String, Error> {
-    serde_json::to_string_pretty(result)
-        .map_err(|e| Error::from(std::io::Error::new(std::io::ErrorKind::Other, e)))
+fn cmd_serve(options: serve::ServeOptions) -> Result<(), Error> {
+    if options.timeout.map_or(false, |t| t.is_zero()) {
+        return Err(Error::from(std::io::Error::new(
+            std::io::ErrorKind::InvalidInput,
+            "--timeout must be a positive number of seconds",
+        )));
+    }
+    if let OutputFormat::Binary = options.format {
+        return Err(Error::from(std::io::Error::new(
+            std::io::ErrorKind::InvalidInput,
+            "serve cannot write binary archives; use vbdc decompile --format binary",
+        )));
+    }
+
+    let stdin = io::stdin().lock();
+    let stdout = Box::new(io::BufWriter::new(io::stdout()));
+    serve::run(options, stdin, stdout)?;
+    Ok(())
 }
 
-fn format_ir(result: &vbdecompiler_core::DecompilationResult) -> String {
-    // TODO: Implement IR formatting
-    // For now, return a simple representation
-    format!(
-        "; IR Representation\n; Project: {}\n; Methods: {}\n\n{}",
-        result.project_name, result.method_count, result.vb6_code
-    )
+fn cmd_diff(options: diff::DiffOptions) -> Result<(), Error> {
+    if diff::run(options)? {
+        std::process::exit(1); // Exit code 1 = builds differ
+    }
+    Ok(())
 }
 
 fn cmd_info(input: PathBuf, detailed: bool, format: InfoFormat, quiet: bool) -> Result<(), Error> {
@@ -256,21 +563,16 @@ fn cmd_info(input: PathBuf, detailed: bool, format: InfoFormat, quiet: bool) ->
         println!("{} {}", "Analyzing:".green().bold(), input.display());
     }
 
-    // Read and analyze file
-    let data = fs::read(&input)?;
-
-    // Basic PE info
-    let pe_result = vbdecompiler_core::pe::PEFile::from_bytes(data.clone());
-
-    // Packer detection
-    let packer_result = detect_packer(&data);
+    // Parse once; packer detection reuses the parsed headers
+    let size = fs::metadata(&input)?.len();
+    let (pe_result, packer_result) = parse_and_detect_packer(&input)?;
 
     // Output based on format
     match format {
         InfoFormat::Text => {
             println!("\n{}", "=".repeat(60).blue());
             println!("{} {}", "File:".cyan().bold(), input.display());
-            println!("{} {} bytes", "Size:".cyan().bold(), data.len());
+            println!("{} {} bytes", "Size:".cyan().bold(), size);
 
             // Packer info
             match packer_result {
@@ -307,13 +609,19 @@ fn cmd_info(input: PathBuf, detailed: bool, format: InfoFormat, quiet: bool) ->
 
                     if detailed {
                         println!("\n{}", "Section Table:".cyan().bold());
-                        for section in pe.sections() {
-                            let name = String::from_utf8_lossy(&section.name);
+                        // Reuses the entropy measured by packer detection
+                        for (section, measured) in pe.sections().iter().zip(pe.section_entropy()) {
+                            let entropy = match measured.entropy {
+                                Some(value) if measured.is_high() => format!("{:.2} (high)", value),
+                                Some(value) => format!("{:.2}", value),
+                                None => "-".to_string(),
+                            };
                             println!(
-                                "  {} VA=0x{:08X} Size=0x{:08X}",
-                                name.trim_end_matches('\0'),
+                                "  {} VA=0x{:08X} Size=0x{:08X} Entropy={}",
+                                measured.name,
                                 section.virtual_address,
-                                section.virtual_size
+                                section.virtual_size,
+                                entropy
                             );
                         }
 
@@ -334,18 +642,9 @@ fn cmd_info(input: PathBuf, detailed: bool, format: InfoFormat, quiet: bool) ->
             // JSON output
             let json_data = serde_json::json!({
                 "file": input.to_str(),
-                "size": data.len(),
-                "packer": packer_result.ok().and_then(|p| p.map(|d| serde_json::json!({
-                    "name": d.packer.name(),
-                    "confidence": d.confidence,
-                    "method": format!("{:?}", d.method),
-                }))),
-                "pe": pe_result.as_ref().ok().map(|pe| serde_json::json!({
-                    "image_base": format!("0x{:08X}", pe.image_base()),
-                    "entry_point": format!("0x{:08X}", pe.entry_point()),
-                    "is_dll": pe.is_dll(),
-                    "section_count": pe.sections().len(),
-                })),
+                "size": size,
+                "packer": packer_result.ok().and_then(|p| p.as_ref().map(packer_summary)),
+                "pe": pe_result.as_ref().ok().map(pe_summary),
             });
             println!("{}", serde_json::to_string_pretty(&json_data).unwrap());
         }
@@ -354,6 +653,25 @@ fn cmd_info(input: PathBuf, detailed: bool, format: InfoFormat, quiet: bool) ->
     Ok(())
 }
 
+/// JSON summary of a packer detection, as shown by `info` and `serve`
+fn packer_summary(detection: &PackerDetection) -> serde_json::Value {
+    serde_json::json!({
+        "name": detection.packer.name(),
+        "confidence": detection.confidence,
+        "method": format!("{:?}", detection.method),
+    })
+}
+
+/// JSON summary of PE headers, as shown by `info` and `serve`
+fn pe_summary(pe: &PEFile) -> serde_json::Value {
+    serde_json::json!({
+        "image_base": format!("0x{:08X}", pe.image_base()),
+        "entry_point": format!("0x{:08X}", pe.entry_point()),
+        "is_dll": pe.is_dll(),
+        "section_count": pe.sections().len(),
+    })
+}
+
 fn cmd_disasm(
     input: PathBuf,
     hex: bool,
@@ -367,7 +685,7 @@ fn cmd_disasm(
     // TODO: Full P-Code disassembly implementation
     // For now, provide basic disassembly info
 
-    let mut decompiler = Decompiler::new();
+    let decompiler = Decompiler::new();
     let result = decompiler.decompile_file(input.to_str().unwrap())?;
 
     let mut disasm_output = String::new();
@@ -405,9 +723,7 @@ fn cmd_check_packer(input: PathBuf, quiet: bool) -> Result<(), Error> {
         println!("{} {}", "Checking:".green().bold(), input.display());
     }
 
-    let data = fs::read(&input)?;
-
-    match detect_packer(&data) {
+    match parse_and_detect_packer(&input)?.1 {
         Ok(Some(detection)) => {
             if quiet {
                 println!("{}", detection.packer.name());
@@ -440,6 +756,29 @@ fn cmd_check_packer(input: PathBuf, quiet: bool) -> Result<(), Error> {
     }
 }
 
+/// Parsed PE (or why it failed) and the packer detection result
+type Triage = (
+    Result<PEFile, Error>,
+    Result<Option<PackerDetection>, PackerError>,
+);
+
+/// Parse a PE image and run packer detection on the same parse
+///
+/// Packed files frequently fail to parse, so detection falls back to the
+/// standalone raw-bytes path in that case.
+fn parse_and_detect_packer(path: &Path) -> Result<Triage, Error> {
+    match PEFile::from_path_with(path, PackerCheck::Lazy) {
+        Ok(pe) => {
+            let packer = pe.packer().cloned();
+            Ok((Ok(pe), Ok(packer)))
+        }
+        Err(e) => {
+            let data = fs::read(path)?;
+            Ok((Err(e), detect_packer(&data)))
+        }
+    }
+}
+
 fn cmd_completions(shell: Shell) {
     let mut cmd = Cli::command();
     generate(shell, &mut cmd, "vbdc", &mut io::stdout());
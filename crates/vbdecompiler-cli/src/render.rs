@@ -0,0 +1,177 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Output formats of decompilation results and `--stats` reports
+//!
+//! Text formats are rendered from a finished [`DecompilationResult`]; the
+//! binary archive is written by [`export_archive`] while methods finish.
+
+use std::io::{self, Write};
+use std::sync::Mutex;
+use vbdecompiler_core::{
+    ArchiveRecord, ArchiveWriter, DecompilationResult, DecompileHooks, DecompileStats,
+    DecompiledMethod, Decompiler, Error,
+};
+
+#[derive(Clone, Copy, clap::ValueEnum)]
+pub enum OutputFormat {
+    /// VB6 source code
+    Vb6,
+    /// JSON representation
+    Json,
+    /// IR (Intermediate Representation)
+    Ir,
+    /// Seekable binary archive, one record per method, written as methods finish
+    Binary,
+}
+
+impl OutputFormat {
+    /// File extension for output written in this format
+    pub fn extension(self) -> &'static str {
+        match self {
+            OutputFormat::Vb6 => "vb",
+            OutputFormat::Json => "json",
+            OutputFormat::Ir => "ir.txt",
+            OutputFormat::Binary => "vbda",
+        }
+    }
+}
+
+/// Decompile `input`, appending each method to a binary archive on `sink` as it finishes
+///
+/// Only the archive index is kept in memory. See `vbdecompiler_core::archive`.
+/// IR listings are stored if the decompiler captures them.
+pub fn export_archive(
+    decompiler: &Decompiler,
+    input: &str,
+    sink: impl Write + Send,
+    hooks: &DecompileHooks<'_>,
+) -> Result<DecompilationResult, Error> {
+    // The first write error is kept; later methods are then dropped
+    let archive = Mutex::new((
+        ArchiveWriter::new(sink, decompiler.capture_ir())?,
+        None::<io::Error>,
+    ));
+    let on_method = |method: &DecompiledMethod<'_>| {
+        let mut guard = archive.lock().unwrap_or_else(|e| e.into_inner());
+        let (writer, error) = &mut *guard;
+        if error.is_some() {
+            return;
+        }
+        let record = ArchiveRecord {
+            object_index: method.object_index as u32,
+            method_index: method.method_index as u32,
+            object_name: method.object_name,
+            method_name: method.method_name,
+            pcode_hash: method.pcode_hash,
+            code: method.code,
+            ir: method.ir,
+        };
+        if let Err(e) = writer.write_record(&record) {
+            *error = Some(e);
+        }
+    };
+    let result = decompiler.decompile_file_streaming(input, &on_method, hooks);
+
+    let (writer, error) = archive.into_inner().unwrap_or_else(|e| e.into_inner());
+    let result = result?;
+    if let Some(e) = error {
+        return Err(e.into());
+    }
+    writer.finish(&result.project_name, result.is_pcode)?;
+    Ok(result)
+}
+
+/// Human-readable summary of [`DecompileStats`] for --stats
+pub fn format_stats(stats: &DecompileStats) -> String {
+    use std::fmt::Write;
+
+    let ms = |ns: u64| ns as f64 / 1e6;
+    let mut out = String::new();
+    let _ = writeln!(out, "Wall time:      {:>10.3} ms", ms(stats.wall_ns));
+    for (name, ns) in [
+        ("read", stats.stages.read_ns),
+        ("pe_parse", stats.stages.pe_parse_ns),
+        ("vb_parse", stats.stages.vb_parse_ns),
+        ("disassemble", stats.stages.disassemble_ns),
+        ("lift", stats.stages.lift_ns),
+        ("codegen", stats.stages.codegen_ns),
+    ] {
+        let _ = writeln!(out, "  {:<13} {:>10.3} ms", name, ms(ns));
+    }
+    let _ = writeln!(
+        out,
+        "Methods:        {:>10} ({} from cache)",
+        stats.methods + stats.cached_methods,
+        stats.cached_methods
+    );
+    let _ = writeln!(out, "Instructions:   {:>10}", stats.instructions);
+    let _ = writeln!(out, "P-Code bytes:   {:>10}", stats.pcode_bytes);
+    let _ = writeln!(out, "Code bytes:     {:>10}", stats.code_bytes);
+    if let (Some(count), Some(bytes)) = (stats.allocations, stats.allocated_bytes) {
+        let _ = writeln!(out, "Allocations:    {:>10} ({} bytes)", count, bytes);
+    }
+    if !stats.slowest.is_empty() {
+        let _ = writeln!(out, "Slowest methods:");
+        for method in &stats.slowest {
+            let _ = writeln!(
+                out,
+                "  {:>10.3} ms  {}.{} ({} instructions, {} bytes)",
+                ms(method.total_ns),
+                method.object_name,
+                method.method_name,
+                method.instructions,
+                method.pcode_bytes
+            );
+        }
+    }
+    out
+}
+
+/// Render a decompilation result in the requested output format
+pub fn render_output(
+    result: &DecompilationResult,
+    format: OutputFormat,
+    quiet: bool,
+) -> Result<String, Error> {
+    match format {
+        OutputFormat::Vb6 => Ok(format_vb6(result, quiet)),
+        OutputFormat::Json => format_json(result),
+        OutputFormat::Ir => Ok(format_ir(result)),
+        OutputFormat::Binary => Err(Error::from(io::Error::new(
+            io::ErrorKind::InvalidInput,
+            "binary output is written while decompiling (see export_archive)",
+        ))),
+    }
+}
+
+fn format_vb6(result: &DecompilationResult, quiet: bool) -> String {
+    let mut output = String::new();
+
+    if !quiet {
+        output.push_str(&format!("\n{}\n", "=".repeat(60)));
+        output.push_str(&format!("Project: {}\n", result.project_name));
+        output.push_str(&format!("P-Code: {}\n", result.is_pcode));
+        output.push_str(&format!("Objects: {}\n", result.object_count));
+        output.push_str(&format!("Methods: {}\n", result.method_count));
+        output.push_str(&format!("{}\n\n", "=".repeat(60)));
+    }
+
+    output.push_str(&result.vb6_code);
+    output
+}
+
+fn format_json(result: &DecompilationResult) -> Result<String, Error> {
+    serde_json::to_string_pretty(result)
+        .map_err(|e| Error::from(std::io::Error::new(std::io::ErrorKind::Other, e)))
+}
+
+fn format_ir(result: &DecompilationResult) -> String {
+    // TODO: Implement IR formatting
+    // For now, return a simple representation
+    format!(
+        "; IR Representation\n; Project: {}\n; Methods: {}\n\n{}",
+        result.project_name, result.method_count, result.vb6_code
+    )
+}
@@ -0,0 +1,471 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Long-lived triage service speaking JSONL on stdin and stdout
+//!
+//! Each input line is a request naming one file; each output line is the
+//! result of one request, written in completion order and tagged with the
+//! request's `id`. A file is opened once per request and its PE parse is
+//! shared by the header summary, packer detection and, if asked for,
+//! decompilation.
+//!
+//! Requests run as tasks on one Rayon pool, and all of them share a single
+//! [`Decompiler`], so the result cache and the scratch buffers stay warm
+//! across files while the per-method parallelism inside each decompilation
+//! fills idle workers. The reader stops taking requests while the in-flight
+//! budget (see [`Budget`]) is exhausted, and results are written as they
+//! complete with no queue in between: a consumer that stops reading stalls
+//! the workers, which stalls admission, so memory stays bounded either way.
+
+use crate::batch::{self, BatchTotals, Budget, Permit, Totals, Watchdog};
+use crate::render::{render_output, OutputFormat};
+use crate::{packer_summary, parse_and_detect_packer, pe_summary};
+use serde_json::{json, Map, Value};
+use std::fs;
+use std::io::{BufRead, Write};
+use std::panic::{self, AssertUnwindSafe};
+use std::path::PathBuf;
+use std::sync::atomic::Ordering;
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+use vbdecompiler_core::{CancellationToken, DecompileHooks, Decompiler, Error, MethodBudget};
+
+/// Settings of a service session
+pub struct ServeOptions {
+    /// Worker threads (0 = one per core)
+    pub jobs: usize,
+    /// Maximum number of requests being processed at once (0 = twice the thread count)
+    pub max_in_flight: usize,
+    /// Maximum total size of the files being processed at once
+    pub max_in_flight_bytes: u64,
+    /// Time limit for requests that don't set their own
+    pub timeout: Option<Duration>,
+    pub cache_dir: Option<PathBuf>,
+    /// Format of the files written for requests with an `output`
+    pub format: OutputFormat,
+    /// Limits applied to each method of every request
+    pub method_budget: MethodBudget,
+    pub quiet: bool,
+}
+
+/// One parsed request line
+#[derive(Debug, PartialEq)]
+struct Request {
+    /// Echoed back in the result; the line number if the request has none
+    id: Value,
+    path: PathBuf,
+    /// Also decompile the file
+    decompile: bool,
+    /// Include the decompiled code in the result
+    code: bool,
+    /// Write the decompiled code to this file
+    output: Option<PathBuf>,
+    /// Decompile even if a packer was detected
+    force: bool,
+    timeout: Option<Duration>,
+}
+
+impl Request {
+    /// Parse line `line_number` (1-based); on failure returns the id to
+    /// report the error under and the reason
+    fn parse(line: &str, line_number: usize) -> Result<Self, (Value, String)> {
+        let fields = match serde_json::from_str::<Value>(line) {
+            Ok(Value::Object(fields)) => fields,
+            Ok(_) => return Err((json!(line_number), "request is not a JSON object".into())),
+            Err(e) => return Err((json!(line_number), format!("invalid JSON: {}", e))),
+        };
+        let id = fields.get("id").cloned().unwrap_or(json!(line_number));
+        let fail = |reason: String| (id.clone(), reason);
+
+        let flag = |name: &str| match fields.get(name) {
+            None | Some(Value::Null) => Ok(false),
+            Some(Value::Bool(value)) => Ok(*value),
+            Some(_) => Err(fail(format!("\"{}\" must be a boolean", name))),
+        };
+        let path_field = |name: &str| match fields.get(name) {
+            None | Some(Value::Null) => Ok(None),
+            Some(Value::String(path)) => Ok(Some(PathBuf::from(path))),
+            Some(_) => Err(fail(format!("\"{}\" must be a string", name))),
+        };
+
+        let path = path_field("path")?.ok_or_else(|| fail("missing \"path\"".into()))?;
+        let timeout = match fields.get("timeout") {
+            None | Some(Value::Null) => None,
+            Some(secs) => match secs
+                .as_f64()
+                .and_then(|s| Duration::try_from_secs_f64(s).ok())
+            {
+                Some(timeout) if !timeout.is_zero() => Some(timeout),
+                _ => {
+                    return Err(fail(
+                        "\"timeout\" must be a positive number of seconds".into(),
+                    ))
+                }
+            },
+        };
+
+        let output = path_field("output")?;
+        let code = flag("code")?;
+        Ok(Self {
+            decompile: flag("decompile")? || code || output.is_some(),
+            code,
+            output,
+            force: flag("force")?,
+            timeout,
+            path,
+            id,
+        })
+    }
+}
+
+/// Serve requests read from `input` until it ends, writing results to `output`
+///
+/// Returns once every request has been answered.
+pub fn run(
+    options: ServeOptions,
+    input: impl BufRead,
+    output: Box<dyn Write + Send>,
+) -> Result<BatchTotals, Error> {
+    let pool = batch::worker_pool(options.jobs)?;
+    let max_requests = match options.max_in_flight {
+        0 => pool.current_num_threads() * 2,
+        n => n,
+    };
+
+    let mut decompiler = Decompiler::new();
+    decompiler.set_cache_dir(options.cache_dir.clone());
+    decompiler.set_method_budget(options.method_budget);
+
+    let shared = Arc::new(Service {
+        budget: Budget::new(max_requests, options.max_in_flight_bytes),
+        watchdog: Watchdog::default(),
+        output: Mutex::new(output),
+        totals: Totals::default(),
+        decompiler,
+        format: options.format,
+        timeout: options.timeout,
+    });
+
+    let watchdog = {
+        let shared = Arc::clone(&shared);
+        thread::spawn(move || shared.watchdog.run())
+    };
+
+    let mut read_error = None;
+    for (index, line) in input.lines().enumerate() {
+        let line = match line {
+            Ok(line) => line,
+            Err(e) => {
+                read_error = Some(e);
+                break;
+            }
+        };
+        if line.trim().is_empty() {
+            continue;
+        }
+
+        let request = match Request::parse(&line, index + 1) {
+            Ok(request) => request,
+            Err((id, reason)) => {
+                shared.fail(json!({ "id": id, "status": "error", "error": reason }));
+                continue;
+            }
+        };
+        let size = match fs::metadata(&request.path) {
+            Ok(metadata) => metadata.len(),
+            Err(e) => {
+                shared.fail(json!({
+                    "id": request.id,
+                    "path": request.path.display().to_string(),
+                    "status": "error",
+                    "error": e.to_string(),
+                }));
+                continue;
+            }
+        };
+
+        // Blocks until enough in-flight work has finished
+        shared.budget.acquire(size);
+
+        let shared = Arc::clone(&shared);
+        pool.spawn(move || shared.process(request, size));
+    }
+
+    shared.budget.wait_idle();
+    shared.watchdog.stop();
+    let _ = watchdog.join();
+    if let Some(e) = read_error {
+        return Err(e.into());
+    }
+
+    let totals = shared.totals.snapshot();
+    if !options.quiet {
+        eprintln!(
+            "Served {} requests: {} succeeded, {} failed, {} timed out",
+            totals.succeeded + totals.failed + totals.timed_out,
+            totals.succeeded,
+            totals.failed,
+            totals.timed_out
+        );
+    }
+
+    Ok(totals)
+}
+
+/// State shared between the reader, the tasks and the watchdog
+struct Service {
+    budget: Budget,
+    watchdog: Watchdog,
+    output: Mutex<Box<dyn Write + Send>>,
+    totals: Totals,
+    /// One session for every request, so caches and scratch buffers are shared
+    decompiler: Decompiler,
+    format: OutputFormat,
+    timeout: Option<Duration>,
+}
+
+impl Service {
+    /// Answer one request; runs on a pool worker
+    fn process(&self, request: Request, size: u64) {
+        // Return the budget even if the task panics
+        let _permit = Permit {
+            budget: &self.budget,
+            bytes: size,
+        };
+
+        let started = Instant::now();
+        let token = CancellationToken::new();
+        let watch_id = request
+            .timeout
+            .or(self.timeout)
+            // A timeout too large to represent means no deadline
+            .and_then(|timeout| started.checked_add(timeout))
+            .map(|deadline| self.watchdog.watch(deadline, token.clone()));
+
+        let mut record = Map::new();
+        record.insert("id".into(), request.id.clone());
+        record.insert("path".into(), json!(request.path.display().to_string()));
+        record.insert("size".into(), json!(size));
+
+        // A malformed sample must not take the whole service down
+        let outcome = panic::catch_unwind(AssertUnwindSafe(|| {
+            self.triage(&request, &token, &mut record)
+        }))
+        .unwrap_or_else(|_| Err(Error::Decompilation("decompiler panicked".to_string())));
+
+        if let Some(id) = watch_id {
+            self.watchdog.unwatch(id);
+        }
+
+        let (status, counter) = match &outcome {
+            Ok(()) => ("ok", &self.totals.succeeded),
+            Err(Error::Cancelled) => ("timeout", &self.totals.timed_out),
+            Err(_) => ("error", &self.totals.failed),
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+        record.insert("status".into(), json!(status));
+        if let Err(e) = outcome {
+            if !matches!(e, Error::Cancelled) {
+                record.insert("error".into(), json!(e.to_string()));
+            }
+        }
+        record.insert(
+            "elapsed_ms".into(),
+            json!(started.elapsed().as_millis() as u64),
+        );
+
+        self.emit(&Value::Object(record));
+    }
+
+    /// Fill `record` with what the request asked for
+    ///
+    /// Header and packer fields are filled even if decompilation then fails.
+    fn triage(
+        &self,
+        request: &Request,
+        token: &CancellationToken,
+        record: &mut Map<String, Value>,
+    ) -> Result<(), Error> {
+        let (pe, packer) = parse_and_detect_packer(&request.path)?;
+
+        let packer =
+            packer.map_err(|e| Error::Decompilation(format!("Packer detection failed: {}", e)))?;
+        record.insert("packer".into(), json!(packer.as_ref().map(packer_summary)));
+        match &pe {
+            Ok(pe) => record.insert("pe".into(), pe_summary(pe)),
+            Err(e) => record.insert("pe_error".into(), json!(e.to_string())),
+        };
+
+        if !request.decompile {
+            return Ok(());
+        }
+        if let (Some(detection), false) = (&packer, request.force) {
+            return Err(Error::Decompilation(format!(
+                "packed with {}; set \"force\" to decompile anyway",
+                detection.packer.name()
+            )));
+        }
+
+        let hooks = DecompileHooks {
+            progress: None,
+            cancel: Some(token),
+            stats: None,
+        };
+        let result = self.decompiler.decompile_pe(pe?, &hooks)?;
+
+        if let Some(path) = &request.output {
+            fs::write(path, render_output(&result, self.format, true)?)?;
+        }
+        record.insert(
+            "decompile".into(),
+            json!({
+                "project": result.project_name,
+                "is_pcode": result.is_pcode,
+                "objects": result.object_count,
+                "methods": result.method_count,
+                "output": request.output.as_ref().map(|p| p.display().to_string()),
+            }),
+        );
+        if request.code {
+            record.insert("code".into(), json!(result.vb6_code));
+        }
+        Ok(())
+    }
+
+    /// Report a request rejected before it was admitted
+    fn fail(&self, record: Value) {
+        self.totals.failed.fetch_add(1, Ordering::Relaxed);
+        self.emit(&record);
+    }
+
+    /// Write one result line
+    ///
+    /// Blocks while the consumer is not reading; see the module docs.
+    fn emit(&self, record: &Value) {
+        let mut output = self.output.lock().unwrap_or_else(|e| e.into_inner());
+        // Flush per line: the client is waiting for this answer
+        let written = writeln!(output, "{}", record).and_then(|_| output.flush());
+        if let Err(e) = written {
+            log::error!("Failed to write result: {}", e);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Cursor;
+    use std::path::Path;
+
+    /// Output sink readable after the service has finished
+    #[derive(Clone, Default)]
+    struct Captured(Arc<Mutex<Vec<u8>>>);
+
+    impl Write for Captured {
+        fn write(&mut self, buf: &[u8]) -> std::io::Result<usize> {
+            self.0.lock().unwrap().extend_from_slice(buf);
+            Ok(buf.len())
+        }
+
+        fn flush(&mut self) -> std::io::Result<()> {
+            Ok(())
+        }
+    }
+
+    fn options() -> ServeOptions {
+        ServeOptions {
+            jobs: 2,
+            max_in_flight: 0,
+            max_in_flight_bytes: 1 << 30,
+            timeout: None,
+            cache_dir: None,
+            format: OutputFormat::Vb6,
+            method_budget: MethodBudget::default(),
+            quiet: true,
+        }
+    }
+
+    #[test]
+    fn test_parse_request() {
+        let request = Request::parse(r#"{"id": "a", "path": "x.exe", "code": true}"#, 3).unwrap();
+        assert_eq!(request.id, json!("a"));
+        assert_eq!(request.path, PathBuf::from("x.exe"));
+        // Asking for the code implies decompiling
+        assert!(request.decompile && request.code && !request.force);
+
+        let request = Request::parse(r#"{"path": "x.exe", "timeout": 1.5}"#, 3).unwrap();
+        assert_eq!(request.id, json!(3));
+        assert!(!request.decompile);
+        assert_eq!(request.timeout, Some(Duration::from_millis(1500)));
+
+        let rejected = |line: &str| Request::parse(line, 7).unwrap_err();
+        assert_eq!(rejected("not json").0, json!(7));
+        assert_eq!(rejected("[1]").0, json!(7));
+        assert!(rejected(r#"{"id": 9}"#).1.contains("path"));
+        assert_eq!(rejected(r#"{"id": 9}"#).0, json!(9));
+        assert!(rejected(r#"{"path": "x", "force": 1}"#).1.contains("force"));
+        assert!(rejected(r#"{"path": "x", "timeout": -1}"#)
+            .1
+            .contains("timeout"));
+    }
+
+    #[test]
+    fn test_serves_every_request() {
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let sample = corpus.join("synthetic-small.exe").display().to_string();
+        let input = format!(
+            "{}\n\n{}\n{}\nnot json\n",
+            json!({ "id": 1, "path": sample }),
+            json!({ "id": 2, "path": sample, "code": true }),
+            json!({ "id": 3, "path": "/nonexistent/sample.exe" }),
+        );
+
+        let captured = Captured::default();
+        let totals = run(options(), Cursor::new(input), Box::new(captured.clone())).unwrap();
+        assert_eq!(
+            totals,
+            BatchTotals {
+                succeeded: 2,
+                failed: 2,
+                timed_out: 0
+            }
+        );
+
+        let text = String::from_utf8(captured.0.lock().unwrap().clone()).unwrap();
+        let mut results: Vec<Value> = text
+            .lines()
+            .map(|line| serde_json::from_str(line).unwrap())
+            .collect();
+        results.sort_by_key(|r| r["id"].as_u64());
+        assert_eq!(results.len(), 4);
+
+        let triaged = &results[0];
+        assert_eq!(triaged["id"], json!(1));
+        assert_eq!(triaged["status"], json!("ok"));
+        assert!(triaged["pe"].is_object());
+        assert!(triaged["packer"].is_null());
+        assert!(triaged.get("decompile").is_none());
+
+        let decompiled = &results[1];
+        assert_eq!(decompiled["status"], json!("ok"));
+        assert!(decompiled["decompile"]["methods"].as_u64().unwrap() > 0);
+        assert!(decompiled["code"].as_str().unwrap().contains("End "));
+
+        assert_eq!(results[2]["status"], json!("error"));
+        // The malformed line is reported under its line number
+        assert_eq!(results[3]["id"], json!(5));
+    }
+
+    #[test]
+    fn test_huge_timeout_means_no_deadline() {
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let sample = corpus.join("synthetic-small.exe").display().to_string();
+        let input = format!("{}\n", json!({ "id": 1, "path": sample, "timeout": 1e19 }));
+
+        let captured = Captured::default();
+        let totals = run(options(), Cursor::new(input), Box::new(captured.clone())).unwrap();
+        assert_eq!(totals.succeeded, 1);
+    }
+}
@@ -0,0 +1,240 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Mutation fuzzing and worst-case timing of whole-file decompilation
+//!
+//! Mutates the synthetic corpus (bit flips, boundary values written over
+//! 16/32-bit fields such as procedure sizes and object counts, duplicated
+//! byte ranges) and decompiles each mutant under a per-method
+//! [`MethodBudget`]. Mutants that panic or take longer than the slow
+//! threshold are reported, and kept in `VBDC_FUZZ_SAVE_DIR`, named by content
+//! hash, if that is set. The inputs in `tests/corpus/adversarial/`, finds
+//! reviewed and checked in by hand, and those in the save directory are then
+//! replayed and timed, one JSON record per line:
+//!
+//! ```text
+//! {"bench":"adversarial","input":"0f3c9a71d2e4b856","bytes":8704,
+//!  "status":"ok","methods":8,"elapsed_ns":412003}
+//! ```
+//!
+//! Exits with status 1 if any input panicked or was slow, so the replay of a
+//! checked-in corpus doubles as a performance regression gate:
+//!
+//! ```text
+//! cargo bench -p vbdecompiler-core --bench fuzz > fuzz.jsonl
+//! ```
+//!
+//! Environment:
+//! - `VBDC_FUZZ_ITERATIONS`: mutants to try (default 500; 0 only replays)
+//! - `VBDC_FUZZ_SEED`: mutation seed (default 1)
+//! - `VBDC_FUZZ_SLOW_MS`: whole-file time above which an input counts as slow (default 250)
+//! - `VBDC_FUZZ_SAVE_DIR`: directory to keep finds in (default: not kept)
+//! - `VBDC_BENCH_CORPUS`: as for the pipeline bench
+
+mod support;
+
+use std::panic::{self, AssertUnwindSafe};
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+use support::harness;
+use support::synth;
+use vbdecompiler_core::cache;
+use vbdecompiler_core::packer::detect_packer;
+use vbdecompiler_core::{Decompiler, DecompilerConfig, MethodBudget, PackerCheck};
+
+/// Values that tend to hit off-by-one and overflow paths in size fields
+const BOUNDARY_VALUES: &[u32] = &[
+    0,
+    1,
+    0x7F,
+    0x80,
+    0xFF,
+    0x7FFF,
+    0x8000,
+    0xFFFF,
+    0x7FFF_FFFF,
+    0x8000_0000,
+    0xFFFF_FFFF,
+];
+
+fn main() {
+    let iterations = env_number("VBDC_FUZZ_ITERATIONS", 500);
+    let seed = env_number("VBDC_FUZZ_SEED", 1);
+    let slow = Duration::from_millis(env_number("VBDC_FUZZ_SLOW_MS", 250));
+    let save_dir = std::env::var_os("VBDC_FUZZ_SAVE_DIR").map(PathBuf::from);
+
+    // One worker keeps timings comparable between machines and runs
+    let mut decompiler = Decompiler::with_config(DecompilerConfig {
+        threads: 1,
+        budget: MethodBudget {
+            max_time: Some(slow),
+            ..MethodBudget::default()
+        },
+        ..Default::default()
+    })
+    .expect("single worker pool starts");
+    // Packer detection is timed separately; skipping it lets mutants that
+    // look packed still reach the VB parser
+    decompiler.set_packer_check(PackerCheck::Skip);
+
+    let seeds: Vec<Vec<u8>> = synth::CORPUS
+        .iter()
+        .filter(|spec| spec.objects <= 128)
+        .map(synth::build)
+        .collect();
+
+    let mut rng = XorShift::new(seed);
+    let mut failures = 0;
+    for _ in 0..iterations {
+        let seed_input = &seeds[rng.below(seeds.len())];
+        let mutant = mutate(seed_input, &mut rng);
+        let run = run_one(&mut decompiler, &mutant);
+        if run.panicked || run.elapsed > slow {
+            failures += 1;
+            let name = format!("{:016x}", cache::content_hash(&mutant));
+            report("fuzz_find", &name, &mutant, &run);
+            if let Some(dir) = &save_dir {
+                let saved = std::fs::create_dir_all(dir)
+                    .and_then(|()| std::fs::write(dir.join(&name), &mutant));
+                if let Err(e) = saved {
+                    eprintln!("Failed to save {}: {}", name, e);
+                }
+            }
+        }
+    }
+
+    let checked_in = harness::corpus_dir().join("adversarial");
+    failures += replay(&mut decompiler, &checked_in, slow);
+    if let Some(dir) = &save_dir {
+        failures += replay(&mut decompiler, dir, slow);
+    }
+    if failures > 0 {
+        eprintln!("{} input(s) panicked or exceeded {:?}", failures, slow);
+        std::process::exit(1);
+    }
+}
+
+/// Outcome of decompiling one input
+struct Run {
+    elapsed: Duration,
+    panicked: bool,
+    /// Decompiled methods, or `None` if the file was rejected
+    methods: Option<usize>,
+}
+
+fn run_one(decompiler: &mut Decompiler, data: &[u8]) -> Run {
+    let start = Instant::now();
+    let outcome = panic::catch_unwind(AssertUnwindSafe(|| {
+        let _ = detect_packer(data);
+        decompiler
+            .decompile_bytes(data)
+            .ok()
+            .map(|result| result.method_count)
+    }));
+    Run {
+        elapsed: start.elapsed(),
+        panicked: outcome.is_err(),
+        methods: outcome.ok().flatten(),
+    }
+}
+
+/// Time every input kept in `dir`; returns how many panicked or were slow
+fn replay(decompiler: &mut Decompiler, dir: &Path, slow: Duration) -> usize {
+    let Ok(entries) = std::fs::read_dir(dir) else {
+        return 0;
+    };
+    let mut paths: Vec<_> = entries
+        .filter_map(|entry| Some(entry.ok()?.path()))
+        .filter(|path| path.is_file())
+        .collect();
+    paths.sort();
+
+    let mut failures = 0;
+    for path in paths {
+        let Ok(data) = std::fs::read(&path) else {
+            continue;
+        };
+        let run = run_one(decompiler, &data);
+        if run.panicked || run.elapsed > slow {
+            failures += 1;
+        }
+        let name = path.file_name().unwrap_or_default().to_string_lossy();
+        report("adversarial", &name, &data, &run);
+    }
+    failures
+}
+
+fn report(bench: &str, input: &str, data: &[u8], run: &Run) {
+    let status = match (run.panicked, run.methods) {
+        (true, _) => "panic",
+        (false, Some(_)) => "ok",
+        (false, None) => "rejected",
+    };
+    let record = serde_json::json!({
+        "bench": bench,
+        "input": input,
+        "bytes": data.len(),
+        "status": status,
+        "methods": run.methods,
+        "elapsed_ns": run.elapsed.as_nanos() as u64,
+    });
+    println!("{}", record);
+}
+
+/// Apply one to four random mutations to a copy of `input`
+fn mutate(input: &[u8], rng: &mut XorShift) -> Vec<u8> {
+    let mut data = input.to_vec();
+    for _ in 0..1 + rng.below(4) {
+        match rng.below(3) {
+            0 => {
+                let at = rng.below(data.len());
+                data[at] ^= 1 << rng.below(8);
+            }
+            1 => {
+                let value = BOUNDARY_VALUES[rng.below(BOUNDARY_VALUES.len())];
+                let width = if rng.below(2) == 0 { 2 } else { 4 };
+                // Fields are at least 2-byte aligned in every VB structure
+                let at = rng.below(data.len() - width) & !1;
+                data[at..at + width].copy_from_slice(&value.to_le_bytes()[..width]);
+            }
+            _ => {
+                // Overwrite a range with a copy of another, e.g. repeating a
+                // branch or a table entry
+                let len = 1 + rng.below(64);
+                let from = rng.below(data.len() - len);
+                let to = rng.below(data.len() - len);
+                data.copy_within(from..from + len, to);
+            }
+        }
+    }
+    data
+}
+
+/// Deterministic xorshift64 generator
+struct XorShift(u64);
+
+impl XorShift {
+    fn new(seed: u64) -> Self {
+        Self(seed.max(1))
+    }
+
+    fn next(&mut self) -> u64 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        self.0
+    }
+
+    /// Uniform-enough value in `0..n`
+    fn below(&mut self, n: usize) -> usize {
+        (self.next() % n as u64) as usize
+    }
+}
+
+fn env_number(name: &str, default: u64) -> u64 {
+    std::env::var(name)
+        .ok()
+        .and_then(|value| value.parse().ok())
+        .unwrap_or(default)
+}
@@ -0,0 +1,213 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Per-stage throughput of the decompilation pipeline
+//!
+//! Runs every stage separately over each executable in the synthetic corpus
+//! and prints one JSON record per (stage, input):
+//!
+//! ```text
+//! cargo bench -p vbdecompiler-core --bench pipeline > pipeline.jsonl
+//! ```
+
+mod support;
+
+use support::harness::{self, Harness};
+use support::synth;
+use vbdecompiler_core::codegen::VB6CodeGenerator;
+use vbdecompiler_core::lifter::PCodeLifter;
+use vbdecompiler_core::packer::detect_packer;
+use vbdecompiler_core::pcode::{Disassembler, Instruction};
+use vbdecompiler_core::pe::PEFile;
+use vbdecompiler_core::scan;
+use vbdecompiler_core::scratch::MethodScratch;
+use vbdecompiler_core::vb::VBFile;
+
+fn main() {
+    let harness = Harness::from_env();
+
+    for spec in synth::CORPUS {
+        let path = harness::corpus_dir().join(format!("{}.exe", spec.name));
+        let data = std::fs::read(&path).unwrap_or_else(|e| {
+            eprintln!(
+                "{}: {} (regenerate with `cargo run --example gen-bench-corpus`)",
+                path.display(),
+                e
+            );
+            std::process::exit(1);
+        });
+        bench_file(&harness, spec.name, &data);
+    }
+}
+
+fn bench_file(harness: &Harness, input: &str, data: &[u8]) {
+    let size = data.len();
+
+    harness.bench("signature_scan", input, size, || scan::scan_image(data));
+
+    harness.bench("packer_detect", input, size, || detect_packer(data));
+
+    harness.bench("pe_parse", input, size, || {
+        PEFile::from_bytes(data.to_vec()).expect("corpus file parses")
+    });
+
+    harness.bench("vb_parse", input, size, || {
+        let pe = PEFile::from_bytes(data.to_vec()).unwrap();
+        VBFile::from_pe(pe).expect("corpus file has VB structures")
+    });
+
+    let vb_file = VBFile::from_pe(PEFile::from_bytes(data.to_vec()).unwrap()).unwrap();
+    let methods: Vec<(String, &[u8])> = vb_file
+        .objects()
+        .iter()
+        .enumerate()
+        .flat_map(|(obj_idx, obj)| {
+            let vb_file = &vb_file;
+            obj.method_names
+                .iter()
+                .enumerate()
+                .filter_map(move |(method_idx, name)| {
+                    let pcode = vb_file.get_pcode_for_method(obj_idx, method_idx)?;
+                    Some((format!("{}_{}", obj.name, name), pcode))
+                })
+        })
+        .collect();
+    let pcode_bytes: usize = methods.iter().map(|(_, pcode)| pcode.len()).sum();
+
+    harness.bench("get_pcode", input, pcode_bytes, || {
+        let mut total = 0;
+        for (obj_idx, obj) in vb_file.objects().iter().enumerate() {
+            for method_idx in 0..obj.method_count() {
+                total += vb_file
+                    .get_pcode_for_method(obj_idx, method_idx)
+                    .map_or(0, |pcode| pcode.len());
+            }
+        }
+        total
+    });
+
+    harness.bench("pcode_disasm", input, pcode_bytes, || {
+        methods
+            .iter()
+            .map(|(_, pcode)| Disassembler::new(pcode).disassemble(0).unwrap().len())
+            .sum::<usize>()
+    });
+
+    let disassembled: Vec<(&str, Vec<Instruction<'_>>)> = methods
+        .iter()
+        .map(|(name, pcode)| {
+            (
+                name.as_str(),
+                Disassembler::new(pcode).disassemble(0).unwrap(),
+            )
+        })
+        .collect();
+
+    harness.bench("lift", input, pcode_bytes, || {
+        let mut lifter = PCodeLifter::new();
+        disassembled
+            .iter()
+            .map(|(name, instructions)| {
+                lifter
+                    .lift(instructions, name.to_string(), 0)
+                    .expect("corpus method lifts")
+                    .basic_blocks
+                    .len()
+            })
+            .sum::<usize>()
+    });
+
+    let functions: Vec<_> = disassembled
+        .iter()
+        .map(|(name, instructions)| {
+            PCodeLifter::new()
+                .lift(instructions, name.to_string(), 0)
+                .unwrap()
+        })
+        .collect();
+
+    harness.bench("codegen", input, pcode_bytes, || {
+        let mut generator = VB6CodeGenerator::new();
+        let mut code = String::new();
+        functions
+            .iter()
+            .map(|function| {
+                code.clear();
+                generator.write_function(function, &mut code).unwrap();
+                code.len()
+            })
+            .sum::<usize>()
+    });
+
+    harness.bench("lift_arena", input, pcode_bytes, || {
+        let mut lifter = PCodeLifter::new();
+        disassembled
+            .iter()
+            .map(|(name, instructions)| {
+                lifter
+                    .lift_arena(instructions, name.to_string(), 0)
+                    .expect("corpus method lifts")
+                    .block_count()
+            })
+            .sum::<usize>()
+    });
+
+    let arena_functions: Vec<_> = disassembled
+        .iter()
+        .map(|(name, instructions)| {
+            PCodeLifter::new()
+                .lift_arena(instructions, name.to_string(), 0)
+                .unwrap()
+        })
+        .collect();
+
+    harness.bench("codegen_arena", input, pcode_bytes, || {
+        let mut generator = VB6CodeGenerator::new();
+        let mut code = String::new();
+        arena_functions
+            .iter()
+            .map(|function| {
+                code.clear();
+                generator.write_arena_function(function, &mut code).unwrap();
+                code.len()
+            })
+            .sum::<usize>()
+    });
+
+    // Whole per-method pipeline: fresh state per method vs one reused scratch
+    harness.bench("method_pipeline", input, pcode_bytes, || {
+        methods
+            .iter()
+            .map(|(name, pcode)| {
+                let instructions = Disassembler::new(pcode).disassemble(0).unwrap();
+                let function = PCodeLifter::new()
+                    .lift_arena(&instructions, name.clone(), 0)
+                    .unwrap();
+                let mut code = String::with_capacity(pcode.len());
+                VB6CodeGenerator::new()
+                    .write_arena_function(&function, &mut code)
+                    .unwrap();
+                code.len()
+            })
+            .sum::<usize>()
+    });
+
+    let mut scratch = MethodScratch::new();
+    harness.bench("method_pipeline_pooled", input, pcode_bytes, || {
+        methods
+            .iter()
+            .map(|(name, pcode)| scratch.decompile(pcode, name).map_or(0, str::len))
+            .sum::<usize>()
+    });
+
+    // One pass per method, without an instruction buffer
+    let mut fused = MethodScratch::new();
+    fused.set_fused(true);
+    harness.bench("method_pipeline_fused", input, pcode_bytes, || {
+        methods
+            .iter()
+            .map(|(name, pcode)| fused.decompile(pcode, name).map_or(0, str::len))
+            .sum::<usize>()
+    });
+}
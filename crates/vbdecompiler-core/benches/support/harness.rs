@@ -0,0 +1,110 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Minimal benchmark harness emitting one JSON object per line
+//!
+//! Each measurement runs the closure in batches sized to take roughly
+//! `SAMPLE_TARGET`, repeats that `SAMPLES` times, and reports per-iteration
+//! min/median/mean together with input throughput. Records look like:
+//!
+//! ```text
+//! {"bench":"pe_parse","input":"synthetic-small","bytes":8704,"iterations":1024,
+//!  "min_ns":910,"median_ns":934,"mean_ns":951,"mib_per_s":8889.1}
+//! ```
+//!
+//! Environment:
+//! - `VBDC_BENCH_FILTER`: only run benches whose name contains this string
+//! - `VBDC_BENCH_QUICK`: one short sample per bench (smoke test)
+//! - `VBDC_BENCH_CORPUS`: directory to load the corpus from instead of `tests/corpus`
+
+#![allow(dead_code)]
+
+use std::path::PathBuf;
+use std::time::{Duration, Instant};
+
+const SAMPLES: usize = 7;
+const SAMPLE_TARGET: Duration = Duration::from_millis(40);
+
+/// Directory holding the synthetic corpus (checked in under `tests/corpus`)
+pub fn corpus_dir() -> PathBuf {
+    std::env::var_os("VBDC_BENCH_CORPUS")
+        .map(PathBuf::from)
+        .unwrap_or_else(|| PathBuf::from(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus"))
+}
+
+/// Runs and reports measurements
+pub struct Harness {
+    filter: Option<String>,
+    quick: bool,
+}
+
+impl Harness {
+    pub fn from_env() -> Self {
+        // `cargo bench` passes `--bench`; a bare trailing argument acts as a filter
+        let arg_filter = std::env::args().skip(1).find(|a| !a.starts_with('-'));
+        Self {
+            filter: std::env::var("VBDC_BENCH_FILTER").ok().or(arg_filter),
+            quick: std::env::var_os("VBDC_BENCH_QUICK").is_some(),
+        }
+    }
+
+    /// Measure `f`, which processes `bytes` of input from `input` per call
+    pub fn bench<R>(&self, name: &str, input: &str, bytes: usize, mut f: impl FnMut() -> R) {
+        if let Some(filter) = &self.filter {
+            if !name.contains(filter.as_str()) {
+                return;
+            }
+        }
+
+        // Calibrate the batch size so each sample takes about SAMPLE_TARGET
+        let mut iterations = 1usize;
+        let target = if self.quick {
+            Duration::from_millis(1)
+        } else {
+            SAMPLE_TARGET
+        };
+        loop {
+            let elapsed = time_batch(&mut f, iterations);
+            if elapsed >= target / 2 || iterations >= 1 << 24 {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        let samples = if self.quick { 1 } else { SAMPLES };
+        let mut per_iter: Vec<f64> = (0..samples)
+            .map(|_| time_batch(&mut f, iterations).as_nanos() as f64 / iterations as f64)
+            .collect();
+        per_iter.sort_by(|a, b| a.total_cmp(b));
+
+        let min = per_iter[0];
+        let median = per_iter[per_iter.len() / 2];
+        let mean = per_iter.iter().sum::<f64>() / per_iter.len() as f64;
+        let mib_per_s = if median > 0.0 {
+            bytes as f64 / (1024.0 * 1024.0) / (median / 1e9)
+        } else {
+            0.0
+        };
+
+        let record = serde_json::json!({
+            "bench": name,
+            "input": input,
+            "bytes": bytes,
+            "iterations": iterations,
+            "min_ns": min.round() as u64,
+            "median_ns": median.round() as u64,
+            "mean_ns": mean.round() as u64,
+            "mib_per_s": (mib_per_s * 10.0).round() / 10.0,
+        });
+        println!("{}", record);
+    }
+}
+
+fn time_batch<R>(f: &mut impl FnMut() -> R, iterations: usize) -> Duration {
+    let start = Instant::now();
+    for _ in 0..iterations {
+        std::hint::black_box(f());
+    }
+    start.elapsed()
+}
@@ -0,0 +1,8 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Shared benchmark support: timing harness and synthetic corpus builder
+
+pub mod harness;
+pub mod synth;
@@ -0,0 +1,444 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Synthetic VB5/6 P-Code executables for benchmarking
+//!
+//! Builds a minimal PE32 image with a single `.text` section holding an entry
+//! stub, the VB5! header, project info, object table, one P-Code method per
+//! object (laid out the way `VBFile` reads them) and an MSVBVM60.DLL import
+//! table, so packer detection sees an ordinary VB6 executable. Output is deterministic, so
+//! the checked-in corpus under `tests/corpus/` can be regenerated bit for bit
+//! with `cargo run --example gen-bench-corpus`.
+
+#![allow(dead_code)]
+
+/// Image base of every synthetic executable
+pub const IMAGE_BASE: u32 = 0x0040_0000;
+
+const FILE_ALIGNMENT: u32 = 0x200;
+const SECTION_ALIGNMENT: u32 = 0x1000;
+const TEXT_RVA: u32 = 0x1000;
+const HEADERS_SIZE: u32 = 0x200;
+
+/// Runtime imports of a typical P-Code executable; ThunRTMain comes first
+const RUNTIME_IMPORTS: &[&str] = &[
+    "ThunRTMain",
+    "__vbaStrCopy",
+    "__vbaFreeStr",
+    "__vbaFreeVar",
+    "__vbaVarMove",
+    "__vbaStrCat",
+    "__vbaHresultCheckObj",
+    "__vbaNew2",
+    "ProcCallEngine",
+    "MethCallEngine",
+];
+
+/// Data directory entries of the `.text` layout, as (RVA, size)
+struct Directories {
+    import: (u32, u32),
+    iat: (u32, u32),
+}
+
+/// Shape of a synthetic executable
+#[derive(Debug, Clone, Copy)]
+pub struct SynthSpec {
+    pub name: &'static str,
+    /// Number of objects; each holds one P-Code method
+    pub objects: usize,
+    /// Approximate P-Code bytes per method
+    pub pcode_size: usize,
+}
+
+/// The checked-in corpus, in increasing size
+pub const CORPUS: &[SynthSpec] = &[
+    SynthSpec {
+        name: "synthetic-small",
+        objects: 8,
+        pcode_size: 256,
+    },
+    SynthSpec {
+        name: "synthetic-medium",
+        objects: 128,
+        pcode_size: 1024,
+    },
+    SynthSpec {
+        name: "synthetic-large",
+        objects: 960,
+        pcode_size: 1024,
+    },
+];
+
+/// Little-endian byte writer with absolute patching
+struct Image {
+    bytes: Vec<u8>,
+}
+
+impl Image {
+    fn u8(&mut self, v: u8) {
+        self.bytes.push(v);
+    }
+
+    fn u16(&mut self, v: u16) {
+        self.bytes.extend_from_slice(&v.to_le_bytes());
+    }
+
+    fn u32(&mut self, v: u32) {
+        self.bytes.extend_from_slice(&v.to_le_bytes());
+    }
+
+    fn zeros(&mut self, n: usize) {
+        self.bytes.resize(self.bytes.len() + n, 0);
+    }
+
+    fn fixed_str(&mut self, s: &str, len: usize) {
+        let start = self.bytes.len();
+        self.bytes.extend_from_slice(s.as_bytes());
+        self.bytes.resize(start + len, 0);
+    }
+
+    fn align(&mut self, alignment: usize) {
+        let len = self.bytes.len().next_multiple_of(alignment);
+        self.bytes.resize(len, 0);
+    }
+
+    fn patch_u32(&mut self, at: usize, v: u32) {
+        self.bytes[at..at + 4].copy_from_slice(&v.to_le_bytes());
+    }
+}
+
+/// Small deterministic generator for literal values
+struct Lcg(u32);
+
+impl Lcg {
+    fn next(&mut self) -> u16 {
+        self.0 = self.0.wrapping_mul(1_103_515_245).wrapping_add(12_345);
+        (self.0 >> 16) as u16
+    }
+}
+
+/// Straight-line P-Code mixing literals, arithmetic, comparisons and branches
+fn pcode_body(seed: u32, target_size: usize) -> Vec<u8> {
+    const LIT_I2: u8 = 0x5E;
+    const LIT_STR: u8 = 0x1B;
+    const ADD_I2: u8 = 0x95;
+    const MUL_I2: u8 = 0x97;
+    const LT_I2: u8 = 0xA4;
+    const BRANCH_F: u8 = 0x1C;
+    const EXIT_PROC: u8 = 0x14;
+
+    let mut rng = Lcg(seed);
+    let mut code = Vec::with_capacity(target_size + 16);
+    let lit = |code: &mut Vec<u8>, rng: &mut Lcg| {
+        code.push(LIT_I2);
+        code.push((rng.next() & 0x7F) as u8);
+    };
+
+    let mut unit = 0u32;
+    while code.len() + 16 < target_size {
+        match unit % 3 {
+            0 => {
+                lit(&mut code, &mut rng);
+                lit(&mut code, &mut rng);
+                code.push(ADD_I2);
+                lit(&mut code, &mut rng);
+                code.push(MUL_I2);
+            }
+            1 => {
+                // If a < b, skip the next literal
+                lit(&mut code, &mut rng);
+                lit(&mut code, &mut rng);
+                code.push(LT_I2);
+                code.push(BRANCH_F);
+                code.extend_from_slice(&2i16.to_le_bytes());
+                lit(&mut code, &mut rng);
+            }
+            _ => {
+                code.push(LIT_STR);
+                code.extend_from_slice(format!("s{}", rng.next()).as_bytes());
+                code.push(0);
+            }
+        }
+        unit += 1;
+    }
+
+    code.push(EXIT_PROC);
+    code
+}
+
+/// Build the executable described by `spec`
+pub fn build(spec: &SynthSpec) -> Vec<u8> {
+    let (text, dirs) = build_text(spec);
+    let raw_size = (text.len() as u32).next_multiple_of(FILE_ALIGNMENT);
+    let virtual_size = text.len() as u32;
+    let image_size = TEXT_RVA + virtual_size.next_multiple_of(SECTION_ALIGNMENT);
+
+    let mut img = Image {
+        bytes: Vec::with_capacity((HEADERS_SIZE + raw_size) as usize),
+    };
+
+    // DOS header
+    img.bytes.extend_from_slice(b"MZ");
+    img.zeros(0x3A);
+    img.u32(0x40); // e_lfanew
+
+    // PE signature + COFF header
+    img.bytes.extend_from_slice(b"PE\0\0");
+    img.u16(0x014C); // i386
+    img.u16(1); // one section
+    img.u32(0); // timestamp
+    img.u32(0); // symbol table
+    img.u32(0); // symbol count
+    img.u16(0xE0); // optional header size
+    img.u16(0x010F); // executable, 32-bit, stripped
+
+    // PE32 optional header
+    img.u16(0x010B);
+    img.u8(6); // linker version (VB6 ships LINK 6.0)
+    img.u8(0);
+    img.u32(raw_size); // size of code
+    img.u32(0); // initialized data
+    img.u32(0); // uninitialized data
+    img.u32(TEXT_RVA); // entry point
+    img.u32(TEXT_RVA); // base of code
+    img.u32(TEXT_RVA); // base of data
+    img.u32(IMAGE_BASE);
+    img.u32(SECTION_ALIGNMENT);
+    img.u32(FILE_ALIGNMENT);
+    img.u16(4); // OS version
+    img.u16(0);
+    img.u16(1); // image version
+    img.u16(0);
+    img.u16(4); // subsystem version
+    img.u16(0);
+    img.u32(0); // Win32 version
+    img.u32(image_size);
+    img.u32(HEADERS_SIZE);
+    img.u32(0); // checksum
+    img.u16(2); // GUI subsystem
+    img.u16(0); // DLL characteristics
+    img.u32(0x0010_0000); // stack reserve
+    img.u32(0x1000); // stack commit
+    img.u32(0x0010_0000); // heap reserve
+    img.u32(0x1000); // heap commit
+    img.u32(0); // loader flags
+    img.u32(16); // data directories
+    img.zeros(8); // export
+    img.u32(dirs.import.0);
+    img.u32(dirs.import.1);
+    img.zeros(10 * 8);
+    img.u32(dirs.iat.0);
+    img.u32(dirs.iat.1);
+    img.zeros(3 * 8);
+
+    // Section table
+    img.fixed_str(".text", 8);
+    img.u32(virtual_size);
+    img.u32(TEXT_RVA);
+    img.u32(raw_size);
+    img.u32(HEADERS_SIZE); // pointer to raw data
+    img.u32(0); // relocations
+    img.u32(0); // line numbers
+    img.u16(0);
+    img.u16(0);
+    img.u32(0x6000_0020); // code, execute, read
+
+    img.align(HEADERS_SIZE as usize);
+    img.bytes.extend_from_slice(&text);
+    img.align(FILE_ALIGNMENT as usize);
+    img.bytes
+}
+
+/// Lay out the `.text` section; all VB pointers are VAs, as `VBFile` expects
+fn build_text(spec: &SynthSpec) -> (Vec<u8>, Directories) {
+    const HEADER_OFFSET: usize = 0x10;
+    const HEADER_SIZE: usize = 104;
+    const PROJECT_INFO_SIZE: usize = 564;
+    const OBJECT_TABLE_SIZE: usize = 60;
+    const DESCRIPTOR_SIZE: usize = 48;
+    const OBJECT_INFO_SIZE: usize = 56;
+    const PROC_DESC_SIZE: usize = 30;
+
+    let va = |offset: usize| IMAGE_BASE + TEXT_RVA + offset as u32;
+    let mut img = Image { bytes: Vec::new() };
+
+    // Entry stub: push offset VBHeader; call [ThunRTMain]; ret
+    img.u8(0x68);
+    img.u32(va(HEADER_OFFSET));
+    img.u8(0xFF);
+    img.u8(0x15);
+    let thunrtmain_field = img.bytes.len();
+    img.u32(0);
+    img.u8(0xC3);
+    img.align(HEADER_OFFSET);
+
+    let project_info = HEADER_OFFSET + HEADER_SIZE;
+    let object_table = project_info + PROJECT_INFO_SIZE;
+    let descriptors = object_table + OBJECT_TABLE_SIZE;
+    let infos = descriptors + spec.objects * DESCRIPTOR_SIZE;
+    let strings = infos + spec.objects * OBJECT_INFO_SIZE;
+
+    // VB header; string fields are patched once the string pool is laid out
+    img.bytes.extend_from_slice(b"VB5!");
+    img.u16(0x2306); // runtime build
+    img.fixed_str("*", 14);
+    img.fixed_str("~", 14);
+    img.u16(0x000A); // runtime DLL version
+    img.u32(0x0409); // LCID
+    img.u32(0);
+    img.u32(0); // no Sub Main
+    img.u32(va(project_info));
+    img.zeros(0x64 - 0x34);
+    let project_name_field = img.bytes.len();
+    img.u32(0);
+    debug_assert_eq!(img.bytes.len(), project_info);
+
+    // Project info
+    img.u32(0x01F4);
+    img.u32(va(object_table));
+    img.u32(0);
+    img.u32(va(0)); // code start
+    img.u32(0); // code end, patched below
+    let code_end_field = img.bytes.len() - 4;
+    img.u32(0);
+    img.u32(0);
+    img.u32(0);
+    img.u32(0); // no native code: P-Code project
+    img.fixed_str(spec.name, 260);
+    img.zeros(260);
+    img.u32(0);
+    img.u32(0);
+    debug_assert_eq!(img.bytes.len(), object_table);
+
+    // Object table header
+    img.zeros(0x0E);
+    img.u16(spec.objects as u16);
+    img.u16(spec.objects as u16);
+    img.u16(spec.objects as u16);
+    img.u32(va(descriptors));
+    img.zeros(0x28 - 0x18);
+    let table_name_field = img.bytes.len();
+    img.u32(0);
+    img.zeros(OBJECT_TABLE_SIZE - 0x2C);
+    debug_assert_eq!(img.bytes.len(), descriptors);
+
+    // Object descriptors; name and method pointers are patched below
+    let mut descriptor_fields = Vec::with_capacity(spec.objects);
+    for i in 0..spec.objects {
+        img.u32(va(infos + i * OBJECT_INFO_SIZE));
+        img.zeros(0x18 - 4);
+        descriptor_fields.push(img.bytes.len());
+        img.u32(0); // object name
+        img.u32(1); // method count
+        img.u32(0); // method names array
+        img.u32(0);
+        // Alternate standard modules and class modules
+        img.u32(if i % 2 == 0 { 0x01 } else { 0x02 });
+        img.u32(0);
+    }
+    debug_assert_eq!(img.bytes.len(), infos);
+
+    // Object infos; method table pointers are patched below
+    let mut info_fields = Vec::with_capacity(spec.objects);
+    for i in 0..spec.objects {
+        img.u16(1);
+        img.u16(i as u16);
+        img.u32(va(object_table));
+        img.zeros(0x20 - 8);
+        img.u16(1); // method count
+        img.u16(1);
+        info_fields.push(img.bytes.len());
+        img.u32(0); // methods
+        img.zeros(OBJECT_INFO_SIZE - 0x28);
+    }
+    debug_assert_eq!(img.bytes.len(), strings);
+
+    // String pool
+    let cstr = |img: &mut Image, s: &str| {
+        let offset = img.bytes.len();
+        img.bytes.extend_from_slice(s.as_bytes());
+        img.u8(0);
+        va(offset)
+    };
+    let project_name = cstr(&mut img, spec.name);
+    img.patch_u32(project_name_field, project_name);
+    img.patch_u32(table_name_field, project_name);
+
+    for (i, &field) in descriptor_fields.iter().enumerate() {
+        let kind = if i % 2 == 0 { "Module" } else { "Class" };
+        let object_name = cstr(&mut img, &format!("{}{}", kind, i + 1));
+        let method_name = cstr(&mut img, &format!("Compute{}", i + 1));
+        img.patch_u32(field, object_name);
+
+        // Method name table: one entry pointing at the name
+        img.align(4);
+        let names = img.bytes.len();
+        img.u32(method_name);
+        img.u32(0);
+        img.patch_u32(field + 8, va(names));
+    }
+
+    // Methods: procedure descriptor immediately followed by its P-Code
+    for (i, &field) in info_fields.iter().enumerate() {
+        img.align(4);
+        let method = img.bytes.len();
+        let pcode = pcode_body(i as u32 + 1, spec.pcode_size);
+
+        img.u32(0);
+        img.u16(0);
+        img.u16(0x20); // frame size
+        img.u16(pcode.len() as u16);
+        img.zeros(PROC_DESC_SIZE - 0x0A);
+        img.bytes.extend_from_slice(&pcode);
+        img.patch_u32(field, va(method));
+    }
+
+    let code_end = va(img.bytes.len());
+    img.patch_u32(code_end_field, code_end);
+
+    let dirs = build_imports(&mut img);
+    img.patch_u32(thunrtmain_field, IMAGE_BASE + dirs.iat.0);
+    (img.bytes, dirs)
+}
+
+/// Append the MSVBVM60.DLL import directory, lookup table and IAT
+fn build_imports(img: &mut Image) -> Directories {
+    const DESCRIPTOR_SIZE: usize = 20;
+
+    let rva = |offset: usize| TEXT_RVA + offset as u32;
+    let thunk_table_size = (RUNTIME_IMPORTS.len() + 1) * 4;
+
+    img.align(16);
+    let descriptors = img.bytes.len();
+    let lookup = descriptors + 2 * DESCRIPTOR_SIZE;
+    let iat = lookup + thunk_table_size;
+    let dll_name = iat + thunk_table_size;
+
+    // One descriptor plus the null terminator
+    img.u32(rva(lookup));
+    img.u32(0); // timestamp
+    img.u32(0); // forwarder chain
+    img.u32(rva(dll_name));
+    img.u32(rva(iat));
+    img.zeros(DESCRIPTOR_SIZE);
+
+    // Lookup table and IAT both point at the hint/name entries, patched below
+    img.zeros(2 * thunk_table_size);
+    img.bytes.extend_from_slice(b"MSVBVM60.DLL\0");
+
+    for (i, name) in RUNTIME_IMPORTS.iter().enumerate() {
+        img.align(2);
+        let hint_name = rva(img.bytes.len());
+        img.u16(i as u16);
+        img.bytes.extend_from_slice(name.as_bytes());
+        img.u8(0);
+        img.patch_u32(lookup + i * 4, hint_name);
+        img.patch_u32(iat + i * 4, hint_name);
+    }
+
+    Directories {
+        import: (rva(descriptors), (2 * DESCRIPTOR_SIZE) as u32),
+        iat: (rva(iat), thunk_table_size as u32),
+    }
+}
@@ -0,0 +1,37 @@
+//! Regenerate the synthetic benchmark corpus in tests/corpus
+//!
+//! Usage: cargo run --example gen-bench-corpus [-- OUTPUT_DIR]
+
+#[path = "../benches/support/synth.rs"]
+mod synth;
+
+use std::env;
+use std::fs;
+use std::path::PathBuf;
+
+fn main() {
+    let out_dir = env::args()
+        .nth(1)
+        .map(PathBuf::from)
+        .unwrap_or_else(|| PathBuf::from(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus"));
+
+    if let Err(e) = fs::create_dir_all(&out_dir) {
+        eprintln!("Failed to create {}: {}", out_dir.display(), e);
+        std::process::exit(1);
+    }
+
+    for spec in synth::CORPUS {
+        let path = out_dir.join(format!("{}.exe", spec.name));
+        let image = synth::build(spec);
+        if let Err(e) = fs::write(&path, &image) {
+            eprintln!("Failed to write {}: {}", path.display(), e);
+            std::process::exit(1);
+        }
+        println!(
+            "{}: {} objects, {} bytes",
+            path.display(),
+            spec.objects,
+            image.len()
+        );
+    }
+}
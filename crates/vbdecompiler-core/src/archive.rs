@@ -0,0 +1,460 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Compact binary archive of decompiled methods
+//!
+//! A seekable alternative to JSON output for pipelines that ingest many
+//! methods. [`ArchiveWriter`] appends one length-prefixed record per method as
+//! it finishes, so nothing but the index is held in memory, and
+//! [`ArchiveWriter::finish`] appends an index sorted by object and method
+//! index. [`Archive`] reads a finished file, typically through a read-only
+//! mapping, and locates a single method without touching the others.
+//!
+//! All integers are little-endian and every structure starts on an 8-byte
+//! boundary, so C readers can map the file and cast (see
+//! `include/vbdecompiler_ffi.h`):
+//!
+//! ```text
+//! header   magic "VBDCMETH", version u32, flags u32
+//! record*  length u32 (whole record, padded to 8 bytes), object_index u32,
+//!          method_index u32, object_name_len u32, method_name_len u32,
+//!          code_len u32, ir_len u32, flags u32, pcode_hash u64,
+//!          then object name, method name, code and IR, each NUL-terminated
+//! index    per method: record offset u64, object_index u32, method_index u32
+//!          then the project name, NUL-terminated, padded to 8 bytes
+//! trailer  index offset u64, method count u64, project_name_len u32,
+//!          flags u32, magic "VBDCINDX"
+//! ```
+//!
+//! String lengths exclude the NUL. Readers must skip records whose length
+//! they do not expect, so later versions can append fields.
+
+use crate::error::{Error, Result};
+use std::io::{self, Write};
+use std::path::Path;
+
+/// File magic at offset 0
+pub const ARCHIVE_MAGIC: [u8; 8] = *b"VBDCMETH";
+/// Magic closing the trailer of a finished archive
+pub const INDEX_MAGIC: [u8; 8] = *b"VBDCINDX";
+/// Bumped whenever the layout changes incompatibly
+pub const ARCHIVE_VERSION: u32 = 1;
+
+/// Header flag: records were written with IR listings
+pub const ARCHIVE_HAS_IR: u32 = 1 << 0;
+/// Trailer flag: the executable was compiled to P-Code
+pub const ARCHIVE_IS_PCODE: u32 = 1 << 0;
+/// Record flag: the record carries an IR listing
+pub const RECORD_HAS_IR: u32 = 1 << 0;
+/// Record flag: `pcode_hash` is set (native methods have no P-Code)
+pub const RECORD_HAS_PCODE_HASH: u32 = 1 << 1;
+
+const HEADER_SIZE: usize = 16;
+const RECORD_HEADER_SIZE: usize = 40;
+const INDEX_ENTRY_SIZE: usize = 16;
+const TRAILER_SIZE: usize = 32;
+
+/// One method of an archive
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ArchiveRecord<'a> {
+    pub object_index: u32,
+    pub method_index: u32,
+    pub object_name: &'a str,
+    pub method_name: &'a str,
+    /// Content hash of the method's P-Code, if it has any
+    pub pcode_hash: Option<u64>,
+    /// Generated VB6 code
+    pub code: &'a str,
+    /// IR listing, if the archive was written with one
+    pub ir: Option<&'a str>,
+}
+
+/// Index entry kept in memory until [`ArchiveWriter::finish`]
+#[derive(Debug, Clone, Copy)]
+struct IndexEntry {
+    offset: u64,
+    object_index: u32,
+    method_index: u32,
+}
+
+/// Incremental archive writer
+///
+/// Records are written straight through to `out`; wrap unbuffered sinks in a
+/// [`io::BufWriter`]. An archive that is never finished has no index and is
+/// rejected by [`Archive::new`].
+pub struct ArchiveWriter<W: Write> {
+    out: W,
+    offset: u64,
+    index: Vec<IndexEntry>,
+    buffer: Vec<u8>,
+}
+
+impl<W: Write> ArchiveWriter<W> {
+    /// Start an archive; set `with_ir` if records will carry IR listings
+    pub fn new(mut out: W, with_ir: bool) -> io::Result<Self> {
+        let mut header = [0u8; HEADER_SIZE];
+        header[..8].copy_from_slice(&ARCHIVE_MAGIC);
+        header[8..12].copy_from_slice(&ARCHIVE_VERSION.to_le_bytes());
+        let flags = if with_ir { ARCHIVE_HAS_IR } else { 0 };
+        header[12..16].copy_from_slice(&flags.to_le_bytes());
+        out.write_all(&header)?;
+
+        Ok(Self {
+            out,
+            offset: HEADER_SIZE as u64,
+            index: Vec::new(),
+            buffer: Vec::new(),
+        })
+    }
+
+    /// Number of records written so far
+    pub fn len(&self) -> usize {
+        self.index.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.index.is_empty()
+    }
+
+    /// Append one method
+    pub fn write_record(&mut self, record: &ArchiveRecord<'_>) -> io::Result<()> {
+        let ir = record.ir.unwrap_or("");
+        let strings = [record.object_name, record.method_name, record.code, ir];
+        let payload: usize = strings.iter().map(|s| s.len() + 1).sum();
+        let length = padded(RECORD_HEADER_SIZE + payload);
+        let too_long = || io::Error::new(io::ErrorKind::InvalidInput, "record over 4 GiB");
+        let length32 = u32::try_from(length).map_err(|_| too_long())?;
+
+        let mut flags = 0;
+        if record.ir.is_some() {
+            flags |= RECORD_HAS_IR;
+        }
+        if record.pcode_hash.is_some() {
+            flags |= RECORD_HAS_PCODE_HASH;
+        }
+
+        let buffer = &mut self.buffer;
+        buffer.clear();
+        buffer.reserve(length);
+        for value in [
+            length32,
+            record.object_index,
+            record.method_index,
+            strings[0].len() as u32,
+            strings[1].len() as u32,
+            strings[2].len() as u32,
+            strings[3].len() as u32,
+            flags,
+        ] {
+            buffer.extend_from_slice(&value.to_le_bytes());
+        }
+        buffer.extend_from_slice(&record.pcode_hash.unwrap_or(0).to_le_bytes());
+        for s in strings {
+            buffer.extend_from_slice(s.as_bytes());
+            buffer.push(0);
+        }
+        buffer.resize(length, 0);
+        self.out.write_all(buffer)?;
+
+        self.index.push(IndexEntry {
+            offset: self.offset,
+            object_index: record.object_index,
+            method_index: record.method_index,
+        });
+        self.offset += length as u64;
+        Ok(())
+    }
+
+    /// Write the index and trailer, returning the underlying writer
+    pub fn finish(mut self, project_name: &str, is_pcode: bool) -> io::Result<W> {
+        self.index
+            .sort_unstable_by_key(|entry| (entry.object_index, entry.method_index));
+
+        let buffer = &mut self.buffer;
+        buffer.clear();
+        buffer.reserve(self.index.len() * INDEX_ENTRY_SIZE + project_name.len() + TRAILER_SIZE);
+        for entry in &self.index {
+            buffer.extend_from_slice(&entry.offset.to_le_bytes());
+            buffer.extend_from_slice(&entry.object_index.to_le_bytes());
+            buffer.extend_from_slice(&entry.method_index.to_le_bytes());
+        }
+        buffer.extend_from_slice(project_name.as_bytes());
+        buffer.push(0);
+        buffer.resize(padded(buffer.len()), 0);
+
+        let flags = if is_pcode { ARCHIVE_IS_PCODE } else { 0 };
+        buffer.extend_from_slice(&self.offset.to_le_bytes());
+        buffer.extend_from_slice(&(self.index.len() as u64).to_le_bytes());
+        buffer.extend_from_slice(&(project_name.len() as u32).to_le_bytes());
+        buffer.extend_from_slice(&flags.to_le_bytes());
+        buffer.extend_from_slice(&INDEX_MAGIC);
+
+        self.out.write_all(buffer)?;
+        self.out.flush()?;
+        Ok(self.out)
+    }
+}
+
+/// Round up to the 8-byte alignment of every archive structure
+fn padded(len: usize) -> usize {
+    (len + 7) & !7
+}
+
+/// Reader over a finished archive
+///
+/// Opening validates the header, trailer and index bounds only; records are
+/// decoded when asked for.
+pub struct Archive<D: AsRef<[u8]>> {
+    data: D,
+    index_offset: usize,
+    count: usize,
+    project_name_len: usize,
+    flags: u32,
+}
+
+/// An [`Archive`] over a read-only file mapping
+pub type MappedArchive = Archive<memmap2::Mmap>;
+
+impl MappedArchive {
+    /// Map the archive at `path` read-only
+    pub fn open(path: impl AsRef<Path>) -> Result<Self> {
+        let file = std::fs::File::open(path)?;
+        // SAFETY: read-only mapping; we assume the file is not truncated while mapped
+        let map = unsafe { memmap2::Mmap::map(&file)? };
+        Self::new(map)
+    }
+}
+
+impl<D: AsRef<[u8]>> Archive<D> {
+    pub fn new(data: D) -> Result<Self> {
+        let bytes = data.as_ref();
+        if bytes.len() < HEADER_SIZE + TRAILER_SIZE || bytes[..8] != ARCHIVE_MAGIC {
+            return Err(Error::parse("not a method archive"));
+        }
+        let version = read_u32(bytes, 8)?;
+        if version != ARCHIVE_VERSION {
+            return Err(Error::Unsupported(format!("archive version {}", version)));
+        }
+
+        let trailer = bytes.len() - TRAILER_SIZE;
+        if bytes[trailer + 24..] != INDEX_MAGIC {
+            return Err(Error::parse("archive has no index (unfinished write?)"));
+        }
+        let index_offset = read_u64(bytes, trailer)? as usize;
+        let count = read_u64(bytes, trailer + 8)? as usize;
+        let project_name_len = read_u32(bytes, trailer + 16)? as usize;
+        let flags = read_u32(bytes, trailer + 20)?;
+
+        // The index and project name must fit between the records and the trailer
+        let index_end = count
+            .checked_mul(INDEX_ENTRY_SIZE)
+            .and_then(|size| size.checked_add(index_offset))
+            .filter(|&end| {
+                index_offset >= HEADER_SIZE && end.saturating_add(project_name_len) < trailer
+            })
+            .ok_or_else(|| Error::out_of_bounds(index_offset))?;
+        std::str::from_utf8(&bytes[index_end..index_end + project_name_len])
+            .map_err(|_| Error::parse("archive project name is not UTF-8"))?;
+
+        Ok(Self {
+            data,
+            index_offset,
+            count,
+            project_name_len,
+            flags,
+        })
+    }
+
+    /// Number of methods
+    pub fn len(&self) -> usize {
+        self.count
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    pub fn project_name(&self) -> &str {
+        let start = self.index_offset + self.count * INDEX_ENTRY_SIZE;
+        let name = &self.data.as_ref()[start..start + self.project_name_len];
+        // Checked in `new`
+        std::str::from_utf8(name).unwrap_or_default()
+    }
+
+    pub fn is_pcode(&self) -> bool {
+        self.flags & ARCHIVE_IS_PCODE != 0
+    }
+
+    /// The `position`th method in object/method index order
+    pub fn record(&self, position: usize) -> Result<ArchiveRecord<'_>> {
+        if position >= self.count {
+            return Err(Error::out_of_bounds(position));
+        }
+        let bytes = self.data.as_ref();
+        let entry = self.index_offset + position * INDEX_ENTRY_SIZE;
+        let offset = read_u64(bytes, entry)? as usize;
+        if offset >= self.index_offset {
+            return Err(Error::out_of_bounds(offset));
+        }
+        // The records end where the index starts
+        decode_record(&bytes[..self.index_offset], offset)
+    }
+
+    /// Position of the method `method_index` of object `object_index`
+    pub fn find(&self, object_index: u32, method_index: u32) -> Option<usize> {
+        let bytes = self.data.as_ref();
+        let key_at = |position: usize| {
+            let entry = self.index_offset + position * INDEX_ENTRY_SIZE;
+            let object = read_u32(bytes, entry + 8).unwrap_or(u32::MAX);
+            let method = read_u32(bytes, entry + 12).unwrap_or(u32::MAX);
+            (object, method)
+        };
+
+        // Binary search over the sorted index, reading only the probed entries
+        let (mut low, mut high) = (0, self.count);
+        while low < high {
+            let mid = low + (high - low) / 2;
+            match key_at(mid).cmp(&(object_index, method_index)) {
+                std::cmp::Ordering::Less => low = mid + 1,
+                std::cmp::Ordering::Greater => high = mid,
+                std::cmp::Ordering::Equal => return Some(mid),
+            }
+        }
+        None
+    }
+
+    /// Every method in object/method index order
+    pub fn records(&self) -> impl Iterator<Item = Result<ArchiveRecord<'_>>> + '_ {
+        (0..self.count).map(|position| self.record(position))
+    }
+}
+
+fn read_u32(bytes: &[u8], offset: usize) -> Result<u32> {
+    bytes
+        .get(offset..offset + 4)
+        .map(|b| u32::from_le_bytes(b.try_into().unwrap()))
+        .ok_or_else(|| Error::out_of_bounds(offset))
+}
+
+fn read_u64(bytes: &[u8], offset: usize) -> Result<u64> {
+    bytes
+        .get(offset..offset + 8)
+        .map(|b| u64::from_le_bytes(b.try_into().unwrap()))
+        .ok_or_else(|| Error::out_of_bounds(offset))
+}
+
+/// Decode the record at `offset`, which must lie entirely within `bytes`
+fn decode_record(bytes: &[u8], offset: usize) -> Result<ArchiveRecord<'_>> {
+    let length = read_u32(bytes, offset)? as usize;
+    let record = offset
+        .checked_add(length)
+        .filter(|_| length >= RECORD_HEADER_SIZE)
+        .and_then(|end| bytes.get(offset..end))
+        .ok_or_else(|| Error::out_of_bounds(offset))?;
+
+    let field = |i: usize| read_u32(record, 4 * i);
+    let flags = field(7)?;
+    let pcode_hash = read_u64(record, 32)?;
+
+    // Four NUL-terminated strings follow the fixed fields
+    let mut strings = [""; 4];
+    let mut start = RECORD_HEADER_SIZE;
+    for (i, s) in strings.iter_mut().enumerate() {
+        let len = field(3 + i)? as usize;
+        let end = start.saturating_add(len);
+        let text = record
+            .get(start..end)
+            .filter(|_| record.get(end) == Some(&0))
+            .ok_or_else(|| Error::out_of_bounds(offset + start))?;
+        *s = std::str::from_utf8(text).map_err(|_| Error::parse("archive string is not UTF-8"))?;
+        start = end + 1;
+    }
+
+    Ok(ArchiveRecord {
+        object_index: field(1)?,
+        method_index: field(2)?,
+        object_name: strings[0],
+        method_name: strings[1],
+        pcode_hash: (flags & RECORD_HAS_PCODE_HASH != 0).then_some(pcode_hash),
+        code: strings[2],
+        ir: (flags & RECORD_HAS_IR != 0).then_some(strings[3]),
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn record<'a>(object_index: u32, method_index: u32, code: &'a str) -> ArchiveRecord<'a> {
+        ArchiveRecord {
+            object_index,
+            method_index,
+            object_name: "Form1",
+            method_name: "Click",
+            pcode_hash: Some(0x1234_5678_9abc_def0),
+            code,
+            ir: None,
+        }
+    }
+
+    #[test]
+    fn test_roundtrip_and_find() {
+        // Written in completion order, read back in index order
+        let mut writer = ArchiveWriter::new(Vec::new(), true).unwrap();
+        writer
+            .write_record(&record(1, 0, "Sub B()\nEnd Sub"))
+            .unwrap();
+        writer
+            .write_record(&ArchiveRecord {
+                pcode_hash: None,
+                ir: Some("Block0:\n    Return"),
+                ..record(0, 1, "Sub A()\nEnd Sub")
+            })
+            .unwrap();
+        writer.write_record(&record(0, 0, "")).unwrap();
+        let data = writer.finish("Project1", true).unwrap();
+        assert_eq!(data.len() % 8, 0);
+
+        let archive = Archive::new(&data[..]).unwrap();
+        assert_eq!(archive.len(), 3);
+        assert_eq!(archive.project_name(), "Project1");
+        assert!(archive.is_pcode());
+
+        let keys: Vec<_> = archive
+            .records()
+            .map(|r| r.map(|r| (r.object_index, r.method_index)))
+            .collect::<Result<_>>()
+            .unwrap();
+        assert_eq!(keys, vec![(0, 0), (0, 1), (1, 0)]);
+
+        let second = archive.record(archive.find(0, 1).unwrap()).unwrap();
+        assert_eq!(second.code, "Sub A()\nEnd Sub");
+        assert_eq!(second.pcode_hash, None);
+        assert_eq!(second.ir, Some("Block0:\n    Return"));
+
+        let last = archive.record(archive.find(1, 0).unwrap()).unwrap();
+        assert_eq!(last, record(1, 0, "Sub B()\nEnd Sub"));
+        assert_eq!(archive.find(2, 0), None);
+        assert!(archive.record(3).is_err());
+    }
+
+    #[test]
+    fn test_rejects_unfinished_and_corrupt_archives() {
+        let mut writer = ArchiveWriter::new(Vec::new(), false).unwrap();
+        writer
+            .write_record(&record(0, 0, "Sub A()\nEnd Sub"))
+            .unwrap();
+        let data = writer.finish("P", false).unwrap();
+
+        // Without its trailer the archive cannot be indexed
+        assert!(Archive::new(&data[..data.len() - TRAILER_SIZE]).is_err());
+        assert!(Archive::new(&b"not an archive at all, just bytes"[..]).is_err());
+
+        // A record length running into the index is caught on access
+        let mut corrupt = data.clone();
+        corrupt[HEADER_SIZE..HEADER_SIZE + 4].copy_from_slice(&u32::MAX.to_le_bytes());
+        let archive = Archive::new(&corrupt[..]).unwrap();
+        assert!(archive.record(0).is_err());
+    }
+}
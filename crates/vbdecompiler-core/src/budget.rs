@@ -0,0 +1,127 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Per-method resource limits
+//!
+//! A malformed procedure size or a descent into data can make one method
+//! decode far more than any real VB procedure contains. The pipeline checks
+//! each method against a [`MethodBudget`] and gives up on it, like a method
+//! that fails to disassemble, so one pathological sample cannot stall a
+//! batch worker.
+
+use crate::error::{Error, Result};
+use std::time::{Duration, Instant};
+
+/// Instructions decoded between deadline checks
+pub(crate) const DEADLINE_INTERVAL: usize = 1024;
+
+/// Size, instruction and time limits applied to every method
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MethodBudget {
+    /// Largest P-Code body, or native function extent, in bytes
+    pub max_bytes: usize,
+    /// Most instructions decoded for one method
+    pub max_instructions: usize,
+    /// Longest wall-clock time spent on one method, if limited
+    ///
+    /// Checked between stages and periodically while disassembling.
+    pub max_time: Option<Duration>,
+}
+
+impl MethodBudget {
+    /// No limits at all
+    pub const UNLIMITED: Self = Self {
+        max_bytes: usize::MAX,
+        max_instructions: usize::MAX,
+        max_time: None,
+    };
+
+    /// Deadline for a method started at `start`
+    pub fn deadline(&self, start: Instant) -> Option<Instant> {
+        self.max_time.and_then(|limit| start.checked_add(limit))
+    }
+
+    /// Fail if a method of `len` bytes is over the size limit
+    pub fn check_bytes(&self, len: usize) -> Result<()> {
+        if len > self.max_bytes {
+            return Err(Error::BudgetExceeded(format!(
+                "{} bytes (limit {})",
+                len, self.max_bytes
+            )));
+        }
+        Ok(())
+    }
+
+    /// Fail if `count` decoded instructions are over the instruction limit
+    pub fn check_instructions(&self, count: usize) -> Result<()> {
+        if count > self.max_instructions {
+            return Err(Error::BudgetExceeded(format!(
+                "{} instructions (limit {})",
+                count, self.max_instructions
+            )));
+        }
+        Ok(())
+    }
+
+    /// Fail if `deadline` has passed
+    pub fn check_deadline(deadline: Option<Instant>) -> Result<()> {
+        if expired(deadline) {
+            return Err(Error::BudgetExceeded("time limit passed".to_string()));
+        }
+        Ok(())
+    }
+}
+
+impl Default for MethodBudget {
+    /// Generous limits no real method reaches
+    ///
+    /// A P-Code procedure is at most 64 KiB (its size is 16-bit), so only
+    /// native functions and corrupted tables come near them. There is no
+    /// default time limit, keeping output independent of machine load.
+    fn default() -> Self {
+        Self {
+            max_bytes: 1 << 20,
+            max_instructions: 1 << 16,
+            max_time: None,
+        }
+    }
+}
+
+/// Whether `deadline` is set and has passed
+pub(crate) fn expired(deadline: Option<Instant>) -> bool {
+    deadline.is_some_and(|deadline| Instant::now() >= deadline)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_limits() {
+        let budget = MethodBudget {
+            max_bytes: 16,
+            max_instructions: 4,
+            max_time: None,
+        };
+        assert!(budget.check_bytes(16).is_ok());
+        assert!(matches!(
+            budget.check_bytes(17),
+            Err(Error::BudgetExceeded(_))
+        ));
+        assert!(budget.check_instructions(4).is_ok());
+        assert!(budget.check_instructions(5).is_err());
+        assert!(budget.deadline(Instant::now()).is_none());
+        assert!(MethodBudget::check_deadline(None).is_ok());
+
+        let start = Instant::now();
+        let deadline = MethodBudget {
+            max_time: Some(Duration::ZERO),
+            ..budget
+        }
+        .deadline(start);
+        assert_eq!(deadline, Some(start));
+        assert!(MethodBudget::check_deadline(deadline).is_err());
+        assert!(MethodBudget::UNLIMITED.check_bytes(usize::MAX).is_ok());
+    }
+}
@@ -0,0 +1,309 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! On-disk decompilation cache
+//!
+//! Opt-in cache of decompilation results keyed by content hash. Entries live
+//! in a subdirectory versioned by the decompiler release, so upgrading never
+//! serves stale output:
+//! - `files/<hash>.json`: object/method metadata plus the code of every method,
+//!   keyed by the hash of the whole file. A hit skips all parsing.
+//! - `methods/<hash>.json`: the code of a single method, keyed by its P-Code
+//!   bytes and names. Lets a rebuilt executable reuse unchanged methods.
+//!
+//! The cache is best-effort: I/O and format errors are logged and treated as misses.
+
+use serde::de::DeserializeOwned;
+use serde::{Deserialize, Serialize};
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Bumped whenever the entry format changes
+const CACHE_FORMAT: u32 = 1;
+
+/// 64-bit FNV-1a content hasher
+#[derive(Debug, Clone, Copy)]
+pub struct ContentHasher(u64);
+
+impl ContentHasher {
+    const OFFSET_BASIS: u64 = 0xcbf2_9ce4_8422_2325;
+    const PRIME: u64 = 0x0000_0100_0000_01b3;
+
+    pub fn new() -> Self {
+        Self(Self::OFFSET_BASIS)
+    }
+
+    /// Feed bytes into the hash
+    pub fn write(&mut self, bytes: &[u8]) {
+        let mut hash = self.0;
+        for &b in bytes {
+            hash ^= b as u64;
+            hash = hash.wrapping_mul(Self::PRIME);
+        }
+        self.0 = hash;
+    }
+
+    pub fn finish(&self) -> u64 {
+        self.0
+    }
+}
+
+impl Default for ContentHasher {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Hash a byte slice
+pub fn content_hash(data: &[u8]) -> u64 {
+    let mut hasher = ContentHasher::new();
+    hasher.write(data);
+    hasher.finish()
+}
+
+/// Hash a file's contents through a read-only mapping
+pub fn hash_file(path: impl AsRef<Path>) -> std::io::Result<u64> {
+    let file = fs::File::open(path)?;
+
+    if file.metadata()?.len() == 0 {
+        return Ok(content_hash(&[]));
+    }
+
+    // SAFETY: read-only mapping; we assume the file is not truncated while hashing
+    let map = unsafe { memmap2::Mmap::map(&file)? };
+    Ok(content_hash(&map))
+}
+
+/// Cached metadata of a VB object
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct CachedObject {
+    pub name: String,
+    pub object_type: u32,
+    pub method_names: Vec<String>,
+}
+
+/// Cached output of a single decompiled method
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct CachedMethod {
+    pub object_index: usize,
+    pub method_index: usize,
+    /// Generated function name
+    pub name: String,
+    /// Generated VB6 code
+    pub code: String,
+    /// Content hash of the method's P-Code, if it has any
+    #[serde(default)]
+    pub pcode_hash: Option<u64>,
+}
+
+/// Cached decompilation of a whole file
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct CachedFile {
+    pub project_name: String,
+    pub is_pcode: bool,
+    pub objects: Vec<CachedObject>,
+    /// Decompiled methods in object/method table order
+    pub methods: Vec<CachedMethod>,
+}
+
+impl CachedFile {
+    /// Object and method names of a cached method, if its indices are valid
+    pub fn method_names(&self, method: &CachedMethod) -> Option<(&str, &str)> {
+        let object = self.objects.get(method.object_index)?;
+        let method_name = object.method_names.get(method.method_index)?;
+        Some((&object.name, method_name))
+    }
+}
+
+/// Single-method cache entry
+#[derive(Serialize, Deserialize)]
+struct MethodEntry {
+    name: String,
+    code: String,
+}
+
+/// Directory-backed decompilation cache
+#[derive(Debug, Clone)]
+pub struct DecompileCache {
+    root: PathBuf,
+}
+
+impl DecompileCache {
+    /// Use `dir` as the cache root; nothing is created until the first store
+    pub fn new(dir: impl Into<PathBuf>) -> Self {
+        let version = format!("v{}-{}", CACHE_FORMAT, env!("CARGO_PKG_VERSION"));
+        Self {
+            root: dir.into().join(version),
+        }
+    }
+
+    /// Versioned directory holding the entries
+    pub fn dir(&self) -> &Path {
+        &self.root
+    }
+
+    /// Key for a method's cached code: its P-Code bytes plus the names used in codegen
+    pub fn method_key(pcode: &[u8], object_name: &str, method_name: &str) -> u64 {
+        let mut hasher = ContentHasher::new();
+        hasher.write(pcode);
+        // Separators keep ("ab", "c") and ("a", "bc") distinct
+        hasher.write(&[0]);
+        hasher.write(object_name.as_bytes());
+        hasher.write(&[0]);
+        hasher.write(method_name.as_bytes());
+        hasher.finish()
+    }
+
+    /// Look up a whole-file entry
+    pub fn load_file(&self, hash: u64) -> Option<CachedFile> {
+        self.read_entry(&self.entry_path("files", hash))
+    }
+
+    /// Store a whole-file entry
+    pub fn store_file(&self, hash: u64, entry: &CachedFile) {
+        self.write_entry(&self.entry_path("files", hash), entry);
+    }
+
+    /// Look up a method entry, returning `(function_name, code)`
+    pub fn load_method(&self, key: u64) -> Option<(String, String)> {
+        let entry: MethodEntry = self.read_entry(&self.entry_path("methods", key))?;
+        Some((entry.name, entry.code))
+    }
+
+    /// Store a method entry
+    pub fn store_method(&self, key: u64, name: &str, code: &str) {
+        let entry = MethodEntry {
+            name: name.to_string(),
+            code: code.to_string(),
+        };
+        self.write_entry(&self.entry_path("methods", key), &entry);
+    }
+
+    fn entry_path(&self, kind: &str, hash: u64) -> PathBuf {
+        self.root.join(kind).join(format!("{:016x}.json", hash))
+    }
+
+    fn read_entry<T: DeserializeOwned>(&self, path: &Path) -> Option<T> {
+        let data = fs::read(path).ok()?;
+        match serde_json::from_slice(&data) {
+            Ok(entry) => Some(entry),
+            Err(e) => {
+                log::warn!("Ignoring corrupt cache entry {}: {}", path.display(), e);
+                None
+            }
+        }
+    }
+
+    /// Write through a temporary file and rename, so readers never see partial entries
+    fn write_entry<T: Serialize>(&self, path: &Path, entry: &T) {
+        static NEXT_TEMP: AtomicU64 = AtomicU64::new(0);
+
+        let result = (|| -> std::io::Result<()> {
+            if let Some(parent) = path.parent() {
+                fs::create_dir_all(parent)?;
+            }
+
+            let temp = path.with_extension(format!(
+                "tmp.{}.{}",
+                std::process::id(),
+                NEXT_TEMP.fetch_add(1, Ordering::Relaxed)
+            ));
+            let data = serde_json::to_vec(entry)?;
+            fs::write(&temp, data)?;
+            if let Err(e) = fs::rename(&temp, path) {
+                let _ = fs::remove_file(&temp);
+                return Err(e);
+            }
+            Ok(())
+        })();
+
+        if let Err(e) = result {
+            log::warn!("Failed to write cache entry {}: {}", path.display(), e);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn temp_dir(name: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!(
+            "vbdecompiler-cache-{}-{}",
+            name,
+            std::process::id()
+        ));
+        let _ = fs::remove_dir_all(&dir);
+        dir
+    }
+
+    #[test]
+    fn test_content_hash_known_values() {
+        // Reference FNV-1a 64 vectors
+        assert_eq!(content_hash(b""), 0xcbf2_9ce4_8422_2325);
+        assert_eq!(content_hash(b"a"), 0xaf63_dc4c_8601_ec8c);
+    }
+
+    #[test]
+    fn test_method_key_separates_names() {
+        let a = DecompileCache::method_key(&[1, 2], "ab", "c");
+        let b = DecompileCache::method_key(&[1, 2], "a", "bc");
+        assert_ne!(a, b);
+    }
+
+    #[test]
+    fn test_file_roundtrip() {
+        let dir = temp_dir("file");
+        let cache = DecompileCache::new(&dir);
+        let entry = CachedFile {
+            project_name: "Project1".to_string(),
+            is_pcode: true,
+            objects: vec![CachedObject {
+                name: "Form1".to_string(),
+                object_type: 0,
+                method_names: vec!["Load".to_string()],
+            }],
+            methods: vec![CachedMethod {
+                object_index: 0,
+                method_index: 0,
+                name: "Form1_Load".to_string(),
+                code: "Sub Form1_Load()\nEnd Sub".to_string(),
+                pcode_hash: Some(7),
+            }],
+        };
+
+        assert!(cache.load_file(42).is_none());
+        cache.store_file(42, &entry);
+
+        let loaded = cache.load_file(42).unwrap();
+        assert_eq!(loaded.methods[0].code, entry.methods[0].code);
+        assert_eq!(
+            loaded.method_names(&loaded.methods[0]),
+            Some(("Form1", "Load"))
+        );
+
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_method_roundtrip_and_corrupt_entry() {
+        let dir = temp_dir("method");
+        let cache = DecompileCache::new(&dir);
+
+        cache.store_method(7, "Module1_Main", "Sub Main()\nEnd Sub");
+        assert_eq!(
+            cache.load_method(7),
+            Some((
+                "Module1_Main".to_string(),
+                "Sub Main()\nEnd Sub".to_string()
+            ))
+        );
+
+        fs::write(cache.entry_path("methods", 8), b"not json").unwrap();
+        assert!(cache.load_method(8).is_none());
+
+        let _ = fs::remove_dir_all(&dir);
+    }
+}
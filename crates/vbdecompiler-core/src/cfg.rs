@@ -0,0 +1,89 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Control-flow analysis and structuring
+//!
+//! [`ControlFlow`] packs the blocks of an
+//! [`ArenaFunction`](crate::ir::arena::ArenaFunction) into dense
+//! successor and predecessor arrays and computes, over a reverse postorder,
+//! the dominator and postdominator trees (the iterative algorithm of Cooper,
+//! Harvey and Kennedy) and the natural loops. [`Structurer`] uses them to turn
+//! the block graph into a flat list of [`Op`]s: `If`/`ElseIf`/`Else`,
+//! `Select Case`, `Do`/`Loop` and `For`/`Next`, with `GoTo` for the edges that
+//! fit none of these.
+//!
+//! Every pass is linear in blocks and edges, apart from the dominator
+//! fixpoint, which settles in a few sweeps on the reducible graphs VB
+//! compilers emit. Chains of tests are walked iteratively rather than nested,
+//! so a `Select Case` with hundreds of arms costs no more than the same number
+//! of straight-line blocks. All buffers are kept between functions.
+
+mod graph;
+mod structure;
+
+pub use graph::{body_len, ControlFlow, Exit, NONE};
+pub use structure::{inverse_comparison, strip_not, Op, Structurer, Test};
+
+#[cfg(test)]
+mod tests {
+    use crate::ir::arena::{ArenaFunction, ExprId, Stmt, VarRef};
+    use crate::ir::{ExpressionKind, TypeKind};
+
+    /// Function with `blocks` blocks and a local `x`
+    pub(super) fn function(blocks: usize) -> (ArenaFunction, VarRef) {
+        let mut function = ArenaFunction::new("Test".to_string(), TypeKind::Void);
+        for _ in 1..blocks {
+            function.add_block();
+        }
+        let name = function.intern("x");
+        let x = VarRef {
+            id: 1,
+            name,
+            var_type: TypeKind::Integer,
+        };
+        (function, x)
+    }
+
+    pub(super) fn compare(
+        function: &mut ArenaFunction,
+        kind: ExpressionKind,
+        x: VarRef,
+        value: i64,
+    ) -> ExprId {
+        let var = function.variable(x);
+        let constant = function.int_const(value);
+        function.binary(kind, var, constant, TypeKind::Boolean)
+    }
+
+    pub(super) fn branch(
+        function: &mut ArenaFunction,
+        block: u32,
+        condition: ExprId,
+        taken: u32,
+        fall: u32,
+    ) {
+        let block = function.block_mut(block).unwrap();
+        block.statements.push(Stmt::Branch {
+            condition,
+            target_block: taken,
+        });
+        block.successors = vec![taken, fall];
+    }
+
+    pub(super) fn jump(function: &mut ArenaFunction, block: u32, next: u32) {
+        function.block_mut(block).unwrap().successors = vec![next];
+    }
+
+    pub(super) fn call(function: &mut ArenaFunction, block: u32, name: &str) {
+        let name = function.intern(name);
+        function
+            .block_mut(block)
+            .unwrap()
+            .statements
+            .push(Stmt::Call {
+                function: name,
+                arguments: Default::default(),
+            });
+    }
+}
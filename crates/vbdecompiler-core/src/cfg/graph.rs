@@ -0,0 +1,572 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Dominators, postdominators and natural loops of a block graph
+
+use crate::ir::arena::{ArenaFunction, Block, ExprId, Stmt};
+
+/// Marks a missing block, dominator or loop
+pub const NONE: u32 = u32::MAX;
+
+/// How control leaves a block
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Exit {
+    /// Continue at a block, or leave the function if [`NONE`]
+    Jump(u32),
+    /// Continue at `taken` when `condition` holds, else at `fall`
+    Branch {
+        condition: ExprId,
+        taken: u32,
+        fall: u32,
+    },
+    /// Leave the function through a `Return` statement
+    Return,
+}
+
+/// Adjacency lists packed into one array
+#[derive(Debug, Default)]
+struct Csr {
+    start: Vec<u32>,
+    edges: Vec<u32>,
+}
+
+impl Csr {
+    /// Rebuild over `nodes` nodes from `(from, to)` pairs, reversed if `reverse`
+    ///
+    /// Each node's edges keep the order of `pairs`.
+    fn build(&mut self, nodes: usize, pairs: &[(u32, u32)], reverse: bool) {
+        self.start.clear();
+        self.start.resize(nodes + 1, 0);
+        for &(from, to) in pairs {
+            let node = if reverse { to } else { from };
+            self.start[node as usize + 1] += 1;
+        }
+        for i in 0..nodes {
+            self.start[i + 1] += self.start[i];
+        }
+
+        // Fill using start[node] as a cursor, then shift back into place
+        self.edges.clear();
+        self.edges.resize(pairs.len(), 0);
+        for &(from, to) in pairs {
+            let (node, edge) = if reverse { (to, from) } else { (from, to) };
+            let cursor = &mut self.start[node as usize];
+            self.edges[*cursor as usize] = edge;
+            *cursor += 1;
+        }
+        for i in (1..=nodes).rev() {
+            self.start[i] = self.start[i - 1];
+        }
+        self.start[0] = 0;
+    }
+
+    fn edges(&self, node: u32) -> &[u32] {
+        let node = node as usize;
+        &self.edges[self.start[node] as usize..self.start[node + 1] as usize]
+    }
+}
+
+/// Fill `order` with the nodes reachable from `root` in reverse postorder and
+/// `index` with each node's position in it ([`NONE`] if unreachable)
+fn reverse_postorder(
+    root: u32,
+    succ: &Csr,
+    order: &mut Vec<u32>,
+    index: &mut Vec<u32>,
+    stack: &mut Vec<(u32, u32)>,
+) {
+    let nodes = succ.start.len() - 1;
+    order.clear();
+    index.clear();
+    index.resize(nodes, NONE);
+
+    // index doubles as the visited mark until the final numbering
+    stack.clear();
+    stack.push((root, 0));
+    index[root as usize] = 0;
+    while let Some(top) = stack.len().checked_sub(1) {
+        let (node, next) = stack[top];
+        match succ.edges(node).get(next as usize) {
+            Some(&child) => {
+                stack[top].1 += 1;
+                if index[child as usize] == NONE {
+                    index[child as usize] = 0;
+                    stack.push((child, 0));
+                }
+            }
+            None => {
+                stack.pop();
+                order.push(node);
+            }
+        }
+    }
+
+    order.reverse();
+    for (position, &node) in order.iter().enumerate() {
+        index[node as usize] = position as u32;
+    }
+}
+
+/// Dominator tree, with depth-first intervals for constant-time ancestry
+#[derive(Debug, Default)]
+struct DomTree {
+    idom: Vec<u32>,
+    pre: Vec<u32>,
+    post: Vec<u32>,
+    children: Csr,
+    pairs: Vec<(u32, u32)>,
+}
+
+impl DomTree {
+    /// Compute the tree of the nodes in `order`, a reverse postorder from its
+    /// first node, given each node's predecessors
+    fn compute(&mut self, order: &[u32], index: &[u32], preds: &Csr, stack: &mut Vec<(u32, u32)>) {
+        let nodes = index.len();
+        let root = order[0];
+        self.idom.clear();
+        self.idom.resize(nodes, NONE);
+        self.idom[root as usize] = root;
+
+        let idom = &mut self.idom;
+        let mut changed = true;
+        while changed {
+            changed = false;
+            for &node in &order[1..] {
+                let mut new_idom = NONE;
+                for &pred in preds.edges(node) {
+                    if idom[pred as usize] == NONE {
+                        continue;
+                    }
+                    new_idom = if new_idom == NONE {
+                        pred
+                    } else {
+                        intersect(idom, index, pred, new_idom)
+                    };
+                }
+                if idom[node as usize] != new_idom {
+                    idom[node as usize] = new_idom;
+                    changed = true;
+                }
+            }
+        }
+
+        self.pairs.clear();
+        self.pairs.extend(
+            order[1..]
+                .iter()
+                .map(|&node| (self.idom[node as usize], node)),
+        );
+        self.children.build(nodes, &self.pairs, false);
+
+        self.pre.clear();
+        self.pre.resize(nodes, NONE);
+        self.post.clear();
+        self.post.resize(nodes, NONE);
+        let mut clock = 0;
+        stack.clear();
+        stack.push((root, 0));
+        self.pre[root as usize] = clock;
+        while let Some(top) = stack.len().checked_sub(1) {
+            let (node, next) = stack[top];
+            clock += 1;
+            match self.children.edges(node).get(next as usize) {
+                Some(&child) => {
+                    stack[top].1 += 1;
+                    self.pre[child as usize] = clock;
+                    stack.push((child, 0));
+                }
+                None => {
+                    stack.pop();
+                    self.post[node as usize] = clock;
+                }
+            }
+        }
+    }
+
+    /// Whether `a` dominates `b`; every node dominates itself
+    fn dominates(&self, a: u32, b: u32) -> bool {
+        let (a, b) = (a as usize, b as usize);
+        self.pre[a] != NONE
+            && self.pre[b] != NONE
+            && self.pre[a] <= self.pre[b]
+            && self.post[b] <= self.post[a]
+    }
+}
+
+/// Nearest common dominator of two processed nodes
+fn intersect(idom: &[u32], index: &[u32], mut a: u32, mut b: u32) -> u32 {
+    while a != b {
+        while index[a as usize] > index[b as usize] {
+            a = idom[a as usize];
+        }
+        while index[b as usize] > index[a as usize] {
+            b = idom[b as usize];
+        }
+    }
+    a
+}
+
+/// Classify how a block ends, or `None` if its statements and successors
+/// disagree
+fn classify(block: &Block, blocks: usize) -> Option<Exit> {
+    if block.successors.iter().any(|&s| s as usize >= blocks) {
+        return None;
+    }
+    let successors = block.successors.as_slice();
+    let Some((last, body)) = block.statements.split_last() else {
+        return fall_through(successors);
+    };
+    if body.iter().any(is_terminator) {
+        return None;
+    }
+
+    match *last {
+        Stmt::Return { .. } => successors.is_empty().then_some(Exit::Return),
+        Stmt::Goto { target_block } => {
+            (successors == [target_block]).then_some(Exit::Jump(target_block))
+        }
+        Stmt::Branch {
+            condition,
+            target_block,
+        } => match *successors {
+            // Both ways lead to the same block
+            [only] if only == target_block => Some(Exit::Jump(only)),
+            [a, b] if a == target_block || b == target_block => Some(Exit::Branch {
+                condition,
+                taken: target_block,
+                fall: if a == target_block { b } else { a },
+            }),
+            _ => None,
+        },
+        _ => fall_through(successors),
+    }
+}
+
+fn fall_through(successors: &[u32]) -> Option<Exit> {
+    match *successors {
+        [] => Some(Exit::Jump(NONE)),
+        [next] => Some(Exit::Jump(next)),
+        _ => None,
+    }
+}
+
+fn is_terminator(stmt: &Stmt) -> bool {
+    matches!(
+        stmt,
+        Stmt::Branch { .. } | Stmt::Goto { .. } | Stmt::Return { .. }
+    )
+}
+
+/// Number of leading statements that are not a branch or jump
+pub fn body_len(block: &Block) -> u32 {
+    let len = block.statements.len();
+    match block.statements.last() {
+        Some(Stmt::Branch { .. } | Stmt::Goto { .. }) => len as u32 - 1,
+        _ => len as u32,
+    }
+}
+
+/// Dominators, postdominators and natural loops of an [`ArenaFunction`]
+///
+/// Node `block_count()` is a virtual exit that every returning block leads
+/// to; queries take and return real block ids only.
+#[derive(Debug, Default)]
+pub struct ControlFlow {
+    blocks: usize,
+    exits: Vec<Exit>,
+    succ: Csr,
+    pred: Csr,
+    order: Vec<u32>,
+    index: Vec<u32>,
+    post_order: Vec<u32>,
+    post_index: Vec<u32>,
+    dom: DomTree,
+    postdom: DomTree,
+    // Innermost loop header of each block, the enclosing loop of each
+    // header, and per header its exit and its back edge if there is one
+    loop_of: Vec<u32>,
+    loop_parent: Vec<u32>,
+    follow: Vec<u32>,
+    latch: Vec<u32>,
+    pairs: Vec<(u32, u32)>,
+    stack: Vec<(u32, u32)>,
+    work: Vec<u32>,
+    stamp: Vec<u32>,
+    body: Vec<u32>,
+}
+
+impl ControlFlow {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Analyze `function`; returns false, leaving nothing usable, if some
+    /// block's terminator and successor list disagree
+    pub fn analyze(&mut self, function: &ArenaFunction) -> bool {
+        let blocks = function.block_count();
+        self.blocks = blocks;
+        if blocks == 0 {
+            return false;
+        }
+
+        let exit = blocks as u32;
+        self.exits.clear();
+        self.pairs.clear();
+        for (id, block) in function.blocks().iter().enumerate() {
+            let Some(kind) = classify(block, blocks) else {
+                return false;
+            };
+            let id = id as u32;
+            match kind {
+                Exit::Jump(NONE) | Exit::Return => self.pairs.push((id, exit)),
+                Exit::Jump(next) => self.pairs.push((id, next)),
+                Exit::Branch { taken, fall, .. } => {
+                    self.pairs.push((id, taken));
+                    self.pairs.push((id, fall));
+                }
+            }
+            self.exits.push(kind);
+        }
+        self.succ.build(blocks + 1, &self.pairs, false);
+        self.pred.build(blocks + 1, &self.pairs, true);
+
+        reverse_postorder(
+            0,
+            &self.succ,
+            &mut self.order,
+            &mut self.index,
+            &mut self.stack,
+        );
+        self.dom
+            .compute(&self.order, &self.index, &self.pred, &mut self.stack);
+
+        // Postdominators are dominators of the reversed graph from the exit
+        reverse_postorder(
+            exit,
+            &self.pred,
+            &mut self.post_order,
+            &mut self.post_index,
+            &mut self.stack,
+        );
+        self.postdom.compute(
+            &self.post_order,
+            &self.post_index,
+            &self.succ,
+            &mut self.stack,
+        );
+
+        self.find_loops();
+        true
+    }
+
+    /// Find natural loops, innermost first
+    fn find_loops(&mut self) {
+        let blocks = self.blocks;
+        for list in [
+            &mut self.loop_of,
+            &mut self.loop_parent,
+            &mut self.follow,
+            &mut self.latch,
+        ] {
+            list.clear();
+            list.resize(blocks, NONE);
+        }
+
+        // A header is processed before any loop enclosing it, which is
+        // reached earlier in reverse postorder; `stamp` marks the body
+        let mut stamp = std::mem::take(&mut self.stamp);
+        let mut body = std::mem::take(&mut self.body);
+        stamp.clear();
+        stamp.resize(blocks, NONE);
+        for position in (0..self.order.len()).rev() {
+            let header = self.order[position];
+            if header as usize == blocks {
+                continue;
+            }
+
+            self.work.clear();
+            for &pred in self.pred.edges(header) {
+                if self.dom.dominates(header, pred) {
+                    self.work.push(pred);
+                }
+            }
+            let latch = match *self.work {
+                [] => continue,
+                [only] => only,
+                _ => NONE,
+            };
+
+            self.loop_of[header as usize] = header;
+            stamp[header as usize] = header;
+            body.clear();
+            body.push(header);
+            while let Some(node) = self.work.pop() {
+                if stamp[node as usize] == header {
+                    continue;
+                }
+                stamp[node as usize] = header;
+                body.push(node);
+                let inner = self.loop_of[node as usize];
+                if inner == NONE {
+                    self.loop_of[node as usize] = header;
+                } else if inner == node && self.loop_parent[node as usize] == NONE {
+                    self.loop_parent[node as usize] = header;
+                }
+                for &pred in self.pred.edges(node) {
+                    if stamp[pred as usize] != header && self.dom.dominates(header, pred) {
+                        self.work.push(pred);
+                    }
+                }
+            }
+
+            let inside = |block: u32| (block as usize) < blocks && stamp[block as usize] == header;
+            let mut follow = NONE;
+            // Prefer the exit tested at the top, then the one at the bottom
+            for test in [header, latch] {
+                if follow != NONE || test == NONE {
+                    break;
+                }
+                if let Exit::Branch { taken, fall, .. } = self.exits[test as usize] {
+                    if inside(taken) != inside(fall) {
+                        follow = if inside(taken) { fall } else { taken };
+                    }
+                }
+            }
+            if follow == NONE {
+                // Otherwise the earliest block the loop leaves to
+                for &block in &body {
+                    for &next in self.succ.edges(block) {
+                        if (next as usize) < blocks
+                            && !inside(next)
+                            && (follow == NONE
+                                || self.index[next as usize] < self.index[follow as usize])
+                        {
+                            follow = next;
+                        }
+                    }
+                }
+            }
+            self.follow[header as usize] = follow;
+            self.latch[header as usize] = latch;
+        }
+        self.stamp = stamp;
+        self.body = body;
+    }
+
+    /// Number of blocks analyzed
+    pub fn block_count(&self) -> usize {
+        self.blocks
+    }
+
+    /// How `block` ends
+    pub fn exit(&self, block: u32) -> Exit {
+        self.exits[block as usize]
+    }
+
+    /// Blocks that can continue at `block`
+    pub fn predecessors(&self, block: u32) -> &[u32] {
+        self.pred.edges(block)
+    }
+
+    /// Whether `block` is reachable from the entry block
+    pub fn is_reachable(&self, block: u32) -> bool {
+        self.index[block as usize] != NONE
+    }
+
+    /// Reachable blocks in reverse postorder, entry first
+    pub fn reverse_postorder(&self) -> impl Iterator<Item = u32> + '_ {
+        let exit = self.blocks as u32;
+        self.order
+            .iter()
+            .copied()
+            .filter(move |&block| block != exit)
+    }
+
+    /// Immediate dominator; `None` for the entry and unreachable blocks
+    pub fn idom(&self, block: u32) -> Option<u32> {
+        let idom = self.dom.idom[block as usize];
+        (idom != NONE && idom != block).then_some(idom)
+    }
+
+    /// Immediate postdominator; `None` if every path on leaves the function
+    /// or the block never returns
+    pub fn ipdom(&self, block: u32) -> Option<u32> {
+        let ipdom = self.postdom.idom[block as usize];
+        ((ipdom as usize) < self.blocks).then_some(ipdom)
+    }
+
+    /// Whether every path from the entry to `b` passes through `a`
+    pub fn dominates(&self, a: u32, b: u32) -> bool {
+        self.dom.dominates(a, b)
+    }
+
+    /// Whether every path from `b` out of the function passes through `a`
+    pub fn postdominates(&self, a: u32, b: u32) -> bool {
+        self.postdom.dominates(a, b)
+    }
+
+    /// Whether `block` is the header of a natural loop
+    pub fn is_loop_header(&self, block: u32) -> bool {
+        self.loop_of[block as usize] == block
+    }
+
+    /// Header of the innermost loop containing `block`
+    pub fn loop_header(&self, block: u32) -> Option<u32> {
+        let header = self.loop_of[block as usize];
+        (header != NONE).then_some(header)
+    }
+
+    /// Whether `block` lies in the loop headed by `header`
+    pub fn in_loop(&self, block: u32, header: u32) -> bool {
+        let mut current = self.loop_of[block as usize];
+        while current != NONE {
+            if current == header {
+                return true;
+            }
+            current = self.loop_parent[current as usize];
+        }
+        false
+    }
+
+    /// Block the loop headed by `header` is taken to exit to
+    pub fn loop_follow(&self, header: u32) -> Option<u32> {
+        let follow = self.follow[header as usize];
+        (follow != NONE).then_some(follow)
+    }
+
+    /// The only block jumping back to `header`, if there is just one
+    pub fn single_latch(&self, header: u32) -> Option<u32> {
+        let latch = self.latch[header as usize];
+        (latch != NONE).then_some(latch)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::cfg::tests::{branch, compare, function, jump};
+    use crate::ir::ExpressionKind;
+
+    #[test]
+    fn test_dominators_of_diamond() {
+        // 0 -> 1 | 2 -> 3
+        let (mut f, x) = function(4);
+        let c = compare(&mut f, ExpressionKind::Equal, x, 1);
+        branch(&mut f, 0, c, 2, 1);
+        jump(&mut f, 1, 3);
+        jump(&mut f, 2, 3);
+
+        let mut cfg = ControlFlow::new();
+        assert!(cfg.analyze(&f));
+        assert_eq!(cfg.idom(0), None);
+        assert_eq!(cfg.idom(3), Some(0));
+        assert_eq!(cfg.ipdom(0), Some(3));
+        assert_eq!(cfg.ipdom(1), Some(3));
+        assert_eq!(cfg.ipdom(3), None);
+        assert!(cfg.dominates(0, 2));
+        assert!(!cfg.dominates(1, 3));
+        assert!(cfg.postdominates(3, 0));
+        assert!(!cfg.is_loop_header(0));
+    }
+}
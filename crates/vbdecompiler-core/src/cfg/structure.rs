@@ -0,0 +1,718 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Structured VB constructs recovered from a block graph
+
+mod loops;
+
+use super::graph::{body_len, ControlFlow, Exit, NONE};
+use crate::ir::arena::{ArenaFunction, Constant, ExprData, ExprId, Stmt, VarRef};
+use crate::ir::ExpressionKind;
+
+/// Deepest construct nesting written before falling back to `GoTo`
+const MAX_NESTING: u32 = 96;
+
+/// A condition, or its negation
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Test {
+    pub condition: ExprId,
+    pub negate: bool,
+}
+
+/// One step of structured output
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Op {
+    /// The first `end` statements of a block: all but a trailing jump
+    Block {
+        block: u32,
+        end: u32,
+    },
+    If(Test),
+    ElseIf(Test),
+    Else,
+    EndIf,
+    SelectCase {
+        subject: ExprId,
+    },
+    Case {
+        value: ExprId,
+    },
+    CaseElse,
+    EndSelect,
+    /// Loop back to `header`, tested before each pass if `test` is set
+    Do {
+        header: u32,
+        test: Option<Test>,
+    },
+    /// End of a `Do`, tested after each pass if `test` is set
+    Loop(Option<Test>),
+    For {
+        header: u32,
+        variable: VarRef,
+        start: ExprId,
+        end: ExprId,
+        step: ExprId,
+        descending: bool,
+    },
+    Next {
+        variable: VarRef,
+    },
+    ExitDo,
+    ExitFor,
+    ExitProc,
+    Goto(u32),
+}
+
+/// Loop being written, for `Exit Do` and `Exit For`
+#[derive(Debug, Clone, Copy)]
+struct Scope {
+    header: u32,
+    follow: u32,
+    is_for: bool,
+}
+
+/// One test of an `If`/`ElseIf` chain or `Select Case`
+#[derive(Debug, Clone, Copy)]
+struct Arm {
+    test: Test,
+    target: u32,
+    value: ExprId,
+}
+
+/// Turns a block graph into nested VB constructs
+///
+/// Conditionals close at the immediate postdominator, loops are natural
+/// loops, and chains of `If`s on one value become `Select Case`. Anything
+/// else is kept with `GoTo` and a label on its target, so the output always
+/// means what the graph means.
+#[derive(Debug, Default)]
+pub struct Structurer {
+    cfg: ControlFlow,
+    ops: Vec<Op>,
+    emitted: Vec<bool>,
+    labels: Vec<bool>,
+    looped: Vec<bool>,
+    scopes: Vec<Scope>,
+    arms: Vec<Arm>,
+    pending: Vec<u32>,
+}
+
+impl Structurer {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Structure `function`; returns false if its control flow is not
+    /// well-formed and it must be written block by block instead
+    pub fn structure(&mut self, function: &ArenaFunction) -> bool {
+        self.ops.clear();
+        self.scopes.clear();
+        self.arms.clear();
+        self.pending.clear();
+        if !self.cfg.analyze(function) {
+            return false;
+        }
+
+        let blocks = self.cfg.block_count();
+        for flags in [&mut self.emitted, &mut self.labels, &mut self.looped] {
+            flags.clear();
+            flags.resize(blocks, false);
+        }
+
+        self.region(function, 0, NONE, 0);
+
+        self.drain(function);
+
+        // Unreachable code is kept as written
+        for block in 0..blocks as u32 {
+            if !self.emitted[block as usize]
+                && !self.cfg.is_reachable(block)
+                && !function.blocks()[block as usize].statements.is_empty()
+            {
+                self.close();
+                self.linear(function, block);
+            }
+        }
+        self.drain(function);
+        true
+    }
+
+    /// Write the blocks jumped to but not yet written: too deeply nested,
+    /// outside any construct, or empty and unreachable
+    fn drain(&mut self, function: &ArenaFunction) {
+        while let Some(block) = self.pending.pop() {
+            if self.emitted[block as usize] {
+                continue;
+            }
+            self.close();
+            if self.cfg.is_reachable(block) {
+                self.region(function, block, NONE, 0);
+            } else {
+                self.linear(function, block);
+            }
+        }
+    }
+
+    /// Result of the last [`Self::structure`]
+    pub fn ops(&self) -> &[Op] {
+        &self.ops
+    }
+
+    /// Analysis of the last structured function
+    pub fn control_flow(&self) -> &ControlFlow {
+        &self.cfg
+    }
+
+    /// Whether `block` is written with a label inside its [`Op::Block`]
+    pub fn block_label(&self, block: u32) -> bool {
+        self.labels[block as usize] && !self.looped[block as usize]
+    }
+
+    /// Whether the loop headed by `header` is written with a label before it
+    pub fn loop_label(&self, header: u32) -> bool {
+        self.labels[header as usize]
+    }
+
+    /// Write blocks from `block` until control reaches `stop`
+    fn region(&mut self, function: &ArenaFunction, mut block: u32, stop: u32, depth: u32) {
+        loop {
+            if block == stop {
+                return;
+            }
+            if block == NONE {
+                self.ops.push(Op::ExitProc);
+                return;
+            }
+            if let Some(scope) = self.scopes.last().copied() {
+                if block == scope.header {
+                    self.goto(block);
+                    return;
+                }
+                if !self.cfg.in_loop(block, scope.header) {
+                    if block == scope.follow {
+                        self.ops.push(if scope.is_for {
+                            Op::ExitFor
+                        } else {
+                            Op::ExitDo
+                        });
+                    } else {
+                        self.goto(block);
+                    }
+                    return;
+                }
+            }
+            if self.emitted[block as usize] || depth > MAX_NESTING {
+                self.goto(block);
+                return;
+            }
+
+            block = if self.cfg.is_loop_header(block) {
+                self.write_loop(function, block, stop, depth)
+            } else {
+                self.step(function, block, stop, depth)
+            };
+        }
+    }
+
+    /// Write one block and the construct its exit opens; returns where
+    /// control continues
+    fn step(&mut self, function: &ArenaFunction, block: u32, stop: u32, depth: u32) -> u32 {
+        self.emitted[block as usize] = true;
+        self.block(function, block);
+        match self.cfg.exit(block) {
+            Exit::Return => stop,
+            Exit::Jump(next) => next,
+            Exit::Branch { .. } => self.conditional(function, block, stop, depth),
+        }
+    }
+
+    fn block(&mut self, function: &ArenaFunction, block: u32) {
+        let end = body_len(&function.blocks()[block as usize]);
+        self.ops.push(Op::Block { block, end });
+    }
+
+    /// Write the construct opened by the branch ending `block`
+    fn conditional(&mut self, function: &ArenaFunction, block: u32, stop: u32, depth: u32) -> u32 {
+        let Exit::Branch {
+            condition,
+            taken,
+            fall,
+        } = self.cfg.exit(block)
+        else {
+            unreachable!("conditionals end in a branch");
+        };
+        let merge = self.merge_point(block, stop);
+        let end = if merge == NONE { stop } else { merge };
+
+        if fall == end || taken == end {
+            let (arm, negate) = if fall == end {
+                (taken, false)
+            } else {
+                (fall, true)
+            };
+            let start = self.ops.len();
+            self.ops.push(Op::If(Test { condition, negate }));
+            self.region(function, arm, end, depth + 1);
+
+            // An If around nothing is dropped unless its test has effects
+            let empty = self.ops[start + 1..]
+                .iter()
+                .all(|op| matches!(op, Op::Block { end: 0, .. }));
+            if empty && is_pure(function, condition) {
+                self.ops.remove(start);
+            } else {
+                self.ops.push(Op::EndIf);
+            }
+        } else {
+            self.chain(function, condition, taken, fall, end, depth);
+        }
+        end
+    }
+
+    /// Where both arms of the conditional ending `block` meet again, if that
+    /// is inside the construct being written
+    fn merge_point(&self, block: u32, stop: u32) -> u32 {
+        let Some(merge) = self.cfg.ipdom(block) else {
+            return NONE;
+        };
+        if let Some(scope) = self.scopes.last() {
+            if merge != scope.header && !self.cfg.in_loop(merge, scope.header) {
+                return NONE;
+            }
+        }
+        // Past the end of the region, unless that is the top of a loop
+        let looping = self.scopes.last().is_some_and(|scope| scope.header == stop);
+        if stop != NONE && merge != stop && !looping && self.cfg.postdominates(merge, stop) {
+            return NONE;
+        }
+        merge
+    }
+
+    /// Write an `If`/`ElseIf` chain, or a `Select Case` if every test
+    /// compares one value with a constant
+    fn chain(
+        &mut self,
+        function: &ArenaFunction,
+        condition: ExprId,
+        taken: u32,
+        fall: u32,
+        end: u32,
+        depth: u32,
+    ) {
+        // The fall-through arm comes first, as it does in the source
+        let base = self.arms.len();
+        let mut tail = NONE;
+        let (mut condition, mut taken, mut fall) = (condition, taken, fall);
+        loop {
+            let arm = |negate, target| Arm {
+                test: Test { condition, negate },
+                target,
+                value: condition,
+            };
+            let next = if fall == end {
+                self.arms.push(arm(false, taken));
+                break;
+            } else if taken == end {
+                self.arms.push(arm(true, fall));
+                break;
+            } else if self.chains(function, taken, end) {
+                self.arms.push(arm(true, fall));
+                taken
+            } else if self.chains(function, fall, end) {
+                self.arms.push(arm(false, taken));
+                fall
+            } else {
+                self.arms.push(arm(true, fall));
+                tail = taken;
+                break;
+            };
+
+            self.emitted[next as usize] = true;
+            match self.cfg.exit(next) {
+                Exit::Branch {
+                    condition: c,
+                    taken: t,
+                    fall: f,
+                } => (condition, taken, fall) = (c, t, f),
+                _ => unreachable!("chained blocks end in a branch"),
+            }
+        }
+
+        let arms = base..self.arms.len();
+        if let Some(subject) = self.select_subject(function, base) {
+            self.ops.push(Op::SelectCase { subject });
+            for i in arms {
+                let arm = self.arms[i];
+                self.ops.push(Op::Case { value: arm.value });
+                self.region(function, arm.target, end, depth + 1);
+            }
+            if tail != NONE {
+                self.ops.push(Op::CaseElse);
+                self.region(function, tail, end, depth + 1);
+            }
+            self.ops.push(Op::EndSelect);
+        } else {
+            for i in arms {
+                let arm = self.arms[i];
+                self.ops.push(if i == base {
+                    Op::If(arm.test)
+                } else {
+                    Op::ElseIf(arm.test)
+                });
+                self.region(function, arm.target, end, depth + 1);
+            }
+            if tail != NONE {
+                self.ops.push(Op::Else);
+                self.region(function, tail, end, depth + 1);
+            }
+            self.ops.push(Op::EndIf);
+        }
+        self.arms.truncate(base);
+    }
+
+    /// Whether `block` is a bare test only reached from the previous test
+    fn chains(&self, function: &ArenaFunction, block: u32, end: u32) -> bool {
+        block != end
+            && !self.emitted[block as usize]
+            && !self.cfg.is_loop_header(block)
+            && matches!(self.cfg.exit(block), Exit::Branch { .. })
+            && function.blocks()[block as usize].statements.len() == 1
+            && self.cfg.predecessors(block).len() == 1
+            && self
+                .scopes
+                .last()
+                .map_or(true, |scope| self.cfg.in_loop(block, scope.header))
+    }
+
+    /// Common subject if every arm from `base` on tests it for equality with
+    /// a constant; fills in each arm's value
+    fn select_subject(&mut self, function: &ArenaFunction, base: usize) -> Option<ExprId> {
+        if self.arms.len() - base < 2 {
+            return None;
+        }
+        let mut subject = None;
+        for i in base..self.arms.len() {
+            let (tested, value) = equality(function, self.arms[i].test)?;
+            match subject {
+                None => subject = Some(tested),
+                Some(first) if same_value(function, first, tested, 0) => {}
+                Some(_) => return None,
+            }
+            self.arms[i].value = value;
+        }
+        subject
+    }
+
+    /// Write an unreachable block with its jumps spelled out
+    fn linear(&mut self, function: &ArenaFunction, block: u32) {
+        self.emitted[block as usize] = true;
+        self.block(function, block);
+        match self.cfg.exit(block) {
+            Exit::Return => {}
+            Exit::Jump(next) => self.jump(function, next),
+            Exit::Branch {
+                condition,
+                taken,
+                fall,
+            } => {
+                self.ops.push(Op::If(Test {
+                    condition,
+                    negate: false,
+                }));
+                self.jump(function, taken);
+                self.ops.push(Op::EndIf);
+                self.jump(function, fall);
+            }
+        }
+    }
+
+    /// GoTo `target`, skipping empty unreachable blocks that are not written
+    fn jump(&mut self, function: &ArenaFunction, mut target: u32) {
+        for _ in 0..self.cfg.block_count() {
+            if target == NONE
+                || self.cfg.is_reachable(target)
+                || !function.blocks()[target as usize].statements.is_empty()
+            {
+                break;
+            }
+            match self.cfg.exit(target) {
+                Exit::Jump(next) => target = next,
+                _ => break,
+            }
+        }
+        if target == NONE {
+            self.ops.push(Op::ExitProc);
+        } else {
+            self.goto(target);
+        }
+    }
+
+    fn goto(&mut self, block: u32) {
+        self.ops.push(Op::Goto(block));
+        self.labels[block as usize] = true;
+        if !self.emitted[block as usize] {
+            self.pending.push(block);
+        }
+    }
+
+    /// End the function before writing code only reached by `GoTo`
+    fn close(&mut self) {
+        let ends = match self.ops.last() {
+            Some(Op::Goto(_) | Op::ExitProc) => true,
+            Some(&Op::Block { block, .. }) => self.cfg.exit(block) == Exit::Return,
+            _ => false,
+        };
+        if !ends {
+            self.ops.push(Op::ExitProc);
+        }
+    }
+}
+
+/// Remove `Not`s from a condition, flipping `negate` for each
+pub fn strip_not(
+    function: &ArenaFunction,
+    mut condition: ExprId,
+    mut negate: bool,
+) -> (ExprId, bool) {
+    loop {
+        let expr = function.expr(condition);
+        match expr.data {
+            ExprData::Unary(operand) if expr.kind == ExpressionKind::Not => {
+                condition = operand;
+                negate = !negate;
+            }
+            _ => return (condition, negate),
+        }
+    }
+}
+
+/// Comparison testing the opposite of `kind`
+pub fn inverse_comparison(kind: ExpressionKind) -> Option<ExpressionKind> {
+    Some(match kind {
+        ExpressionKind::Equal => ExpressionKind::NotEqual,
+        ExpressionKind::NotEqual => ExpressionKind::Equal,
+        ExpressionKind::LessThan => ExpressionKind::GreaterEqual,
+        ExpressionKind::GreaterEqual => ExpressionKind::LessThan,
+        ExpressionKind::LessEqual => ExpressionKind::GreaterThan,
+        ExpressionKind::GreaterThan => ExpressionKind::LessEqual,
+        _ => return None,
+    })
+}
+
+/// The value and constant a test compares for equality
+fn equality(function: &ArenaFunction, test: Test) -> Option<(ExprId, ExprId)> {
+    let (condition, negate) = strip_not(function, test.condition, test.negate);
+    let expr = function.expr(condition);
+    let expected = if negate {
+        ExpressionKind::NotEqual
+    } else {
+        ExpressionKind::Equal
+    };
+    let ExprData::Binary { left, right } = expr.data else {
+        return None;
+    };
+    if expr.kind != expected {
+        return None;
+    }
+    let is_constant = |id| matches!(function.expr(id).data, ExprData::Constant(_));
+    if is_constant(right) {
+        Some((left, right))
+    } else if is_constant(left) {
+        Some((right, left))
+    } else {
+        None
+    }
+}
+
+/// Whether two expressions read the same value; calls never do
+fn same_value(function: &ArenaFunction, a: ExprId, b: ExprId, depth: u32) -> bool {
+    if a == b {
+        return true;
+    }
+    if depth > 8 {
+        return false;
+    }
+    let (x, y) = (function.expr(a), function.expr(b));
+    if x.kind != y.kind {
+        return false;
+    }
+    match (x.data, y.data) {
+        (ExprData::Variable(v), ExprData::Variable(w)) => v == w,
+        (ExprData::Constant(c), ExprData::Constant(d)) => c == d,
+        (ExprData::Unary(p), ExprData::Unary(q)) => same_value(function, p, q, depth + 1),
+        (
+            ExprData::MemberAccess {
+                object: p,
+                member: m,
+            },
+            ExprData::MemberAccess {
+                object: q,
+                member: n,
+            },
+        ) => m == n && same_value(function, p, q, depth + 1),
+        (
+            ExprData::Cast {
+                expr: p,
+                target_type: s,
+            },
+            ExprData::Cast {
+                expr: q,
+                target_type: t,
+            },
+        ) => s == t && same_value(function, p, q, depth + 1),
+        _ => false,
+    }
+}
+
+/// Whether evaluating an expression cannot call anything
+fn is_pure(function: &ArenaFunction, id: ExprId) -> bool {
+    fn walk(function: &ArenaFunction, id: ExprId, depth: u32) -> bool {
+        if depth > 32 {
+            return false;
+        }
+        match function.expr(id).data {
+            ExprData::None | ExprData::Constant(_) | ExprData::Variable(_) => true,
+            ExprData::Unary(operand) => walk(function, operand, depth + 1),
+            ExprData::Binary { left, right } => {
+                walk(function, left, depth + 1) && walk(function, right, depth + 1)
+            }
+            ExprData::Cast { expr, .. } => walk(function, expr, depth + 1),
+            // Property gets and array reads may run code
+            ExprData::Call { .. } | ExprData::MemberAccess { .. } | ExprData::ArrayIndex { .. } => {
+                false
+            }
+        }
+    }
+    walk(function, id, 0)
+}
+
+fn is_variable(function: &ArenaFunction, id: ExprId, var: VarRef) -> bool {
+    function.expr(id).data == ExprData::Variable(var)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::cfg::tests::{branch, call, compare, function, jump};
+
+    #[test]
+    fn test_if_else_and_loop() {
+        // 0: Do While x < 10 -> 1, else 4
+        // 1: If x = 1 Then 2 Else 3; both back to 0
+        let (mut f, x) = function(5);
+        let c = compare(&mut f, ExpressionKind::LessThan, x, 10);
+        branch(&mut f, 0, c, 1, 4);
+        let c = compare(&mut f, ExpressionKind::Equal, x, 1);
+        branch(&mut f, 1, c, 3, 2);
+        call(&mut f, 2, "A");
+        jump(&mut f, 2, 0);
+        call(&mut f, 3, "B");
+        jump(&mut f, 3, 0);
+        f.block_mut(4)
+            .unwrap()
+            .statements
+            .push(Stmt::Return { value: None });
+
+        let mut s = Structurer::new();
+        assert!(s.structure(&f));
+        let cfg = s.control_flow();
+        assert!(cfg.is_loop_header(0));
+        assert_eq!(cfg.loop_follow(0), Some(4));
+        assert!(cfg.in_loop(3, 0));
+        assert!(!cfg.in_loop(4, 0));
+
+        let shape: Vec<_> = s
+            .ops()
+            .iter()
+            .map(|op| match op {
+                Op::Block { block, .. } => format!("B{}", block),
+                Op::Do { test: Some(_), .. } => "DoWhile".to_string(),
+                Op::If(test) => format!("If{}", test.negate),
+                other => format!("{:?}", other),
+            })
+            .collect();
+        assert_eq!(
+            shape,
+            [
+                "DoWhile",
+                "B1",
+                "Iftrue",
+                "B2",
+                "Else",
+                "B3",
+                "EndIf",
+                "Loop(None)",
+                "B4"
+            ]
+        );
+        assert!(!s.loop_label(0));
+    }
+
+    #[test]
+    fn test_select_case_chain_is_flat() {
+        // Tests on x = 0..n, each case then the end block
+        let arms = 500;
+        let (mut f, x) = function(2 * arms + 2);
+        let end = (2 * arms + 1) as u32;
+        for i in 0..arms as u32 {
+            let test = 2 * i;
+            let next = if i + 1 == arms as u32 {
+                end - 1
+            } else {
+                test + 2
+            };
+            let c = compare(&mut f, ExpressionKind::NotEqual, x, i as i64);
+            branch(&mut f, test, c, next, test + 1);
+            call(&mut f, test + 1, "Case");
+            jump(&mut f, test + 1, end);
+        }
+        // Case Else
+        call(&mut f, end - 1, "Other");
+        jump(&mut f, end - 1, end);
+
+        let mut s = Structurer::new();
+        assert!(s.structure(&f));
+        let ops = s.ops();
+        assert!(matches!(ops[1], Op::SelectCase { .. }));
+        let cases = ops
+            .iter()
+            .filter(|op| matches!(op, Op::Case { .. }))
+            .count();
+        assert_eq!(cases, arms);
+        assert!(ops.contains(&Op::CaseElse));
+        assert!(!ops.iter().any(|op| matches!(op, Op::Goto(_))));
+    }
+
+    #[test]
+    fn test_unstructured_edges_become_gotos() {
+        // Irreducible: 0 -> 1 | 2, 1 <-> 2
+        let (mut f, x) = function(3);
+        let c = compare(&mut f, ExpressionKind::Equal, x, 1);
+        branch(&mut f, 0, c, 2, 1);
+        call(&mut f, 1, "A");
+        let c = compare(&mut f, ExpressionKind::Equal, x, 2);
+        branch(&mut f, 1, c, 2, NONE - 1);
+        // Malformed successor list is rejected
+        let mut s = Structurer::new();
+        assert!(!s.structure(&f));
+
+        f.block_mut(1).unwrap().statements.pop();
+        jump(&mut f, 1, 2);
+        call(&mut f, 2, "B");
+        jump(&mut f, 2, 1);
+        assert!(s.structure(&f));
+        let gotos: Vec<_> = s
+            .ops()
+            .iter()
+            .filter_map(|op| match op {
+                Op::Goto(target) => Some(*target),
+                _ => None,
+            })
+            .collect();
+        assert!(!gotos.is_empty());
+        for target in gotos {
+            assert!(s.block_label(target) || s.loop_label(target));
+        }
+    }
+}
@@ -0,0 +1,304 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Loop recovery: `Do`/`Loop` with a test at either end, and `For`/`Next`
+
+use super::{inverse_comparison, is_variable, strip_not, Op, Scope, Structurer, Test};
+use crate::cfg::graph::{body_len, Exit, NONE};
+use crate::ir::arena::{ArenaFunction, Constant, ExprData, ExprId, Stmt, VarRef};
+use crate::ir::ExpressionKind;
+
+/// Parts of a recognized `For` loop
+struct Counter {
+    variable: VarRef,
+    start: ExprId,
+    end: ExprId,
+    step: ExprId,
+    descending: bool,
+}
+
+impl Structurer {
+    /// Write the natural loop headed by `header`; returns where control
+    /// continues after it
+    pub(super) fn write_loop(
+        &mut self,
+        function: &ArenaFunction,
+        header: u32,
+        stop: u32,
+        depth: u32,
+    ) -> u32 {
+        let follow = self.cfg.loop_follow(header).unwrap_or(NONE);
+        let latch = self.cfg.single_latch(header).unwrap_or(NONE);
+        self.emitted[header as usize] = true;
+        self.looped[header as usize] = true;
+        let mut scope = Scope {
+            header,
+            follow,
+            is_for: false,
+        };
+
+        if let Some((test, inside)) = self.top_test(function, header, follow) {
+            if let Some(counter) = self.counter(function, header, test, latch) {
+                scope.is_for = true;
+                self.ops.push(Op::For {
+                    header,
+                    variable: counter.variable,
+                    start: counter.start,
+                    end: counter.end,
+                    step: counter.step,
+                    descending: counter.descending,
+                });
+                self.scopes.push(scope);
+                self.region(function, inside, latch, depth + 1);
+                self.write_latch(latch, body_len(&function.blocks()[latch as usize]) - 1);
+                self.scopes.pop();
+                self.ops.push(Op::Next {
+                    variable: counter.variable,
+                });
+            } else {
+                self.ops.push(Op::Do {
+                    header,
+                    test: Some(test),
+                });
+                self.scopes.push(scope);
+                self.region(function, inside, header, depth + 1);
+                self.scopes.pop();
+                self.ops.push(Op::Loop(None));
+            }
+        } else if let Some(test) = self.bottom_test(header, latch, follow) {
+            self.ops.push(Op::Do { header, test: None });
+            self.scopes.push(scope);
+            if latch == header {
+                self.block(function, header);
+            } else {
+                let next = self.step(function, header, latch, depth + 1);
+                self.region(function, next, latch, depth + 1);
+                self.write_latch(latch, body_len(&function.blocks()[latch as usize]));
+            }
+            self.scopes.pop();
+            self.ops.push(Op::Loop(Some(test)));
+        } else {
+            self.ops.push(Op::Do { header, test: None });
+            self.scopes.push(scope);
+            let next = self.step(function, header, header, depth + 1);
+            self.region(function, next, header, depth + 1);
+            self.scopes.pop();
+            self.ops.push(Op::Loop(None));
+        }
+
+        if follow == NONE {
+            stop
+        } else {
+            follow
+        }
+    }
+
+    /// Write the first `end` statements of a loop's only latch
+    fn write_latch(&mut self, latch: u32, end: u32) {
+        if !self.emitted[latch as usize] {
+            self.emitted[latch as usize] = true;
+            self.ops.push(Op::Block { block: latch, end });
+        }
+    }
+
+    /// Test of a loop whose header only decides whether to go on, and the
+    /// block the loop goes on to
+    fn top_test(&self, function: &ArenaFunction, header: u32, follow: u32) -> Option<(Test, u32)> {
+        let Exit::Branch {
+            condition,
+            taken,
+            fall,
+        } = self.cfg.exit(header)
+        else {
+            return None;
+        };
+        if follow == NONE || function.blocks()[header as usize].statements.len() != 1 {
+            return None;
+        }
+        if fall == follow && self.cfg.in_loop(taken, header) {
+            Some((
+                Test {
+                    condition,
+                    negate: false,
+                },
+                taken,
+            ))
+        } else if taken == follow && self.cfg.in_loop(fall, header) {
+            Some((
+                Test {
+                    condition,
+                    negate: true,
+                },
+                fall,
+            ))
+        } else {
+            None
+        }
+    }
+
+    /// Test of a loop whose only latch decides whether to go round again
+    fn bottom_test(&self, header: u32, latch: u32, follow: u32) -> Option<Test> {
+        if latch == NONE || follow == NONE {
+            return None;
+        }
+        match self.cfg.exit(latch) {
+            Exit::Branch {
+                condition,
+                taken,
+                fall,
+            } if taken == header && fall == follow => Some(Test {
+                condition,
+                negate: false,
+            }),
+            Exit::Branch {
+                condition,
+                taken,
+                fall,
+            } if fall == header && taken == follow => Some(Test {
+                condition,
+                negate: true,
+            }),
+            _ => None,
+        }
+    }
+
+    /// Recognize `v = start` before the loop, `v <= end` (or `>=` counting
+    /// down) at the top and `v = v + step` at the end of the only latch;
+    /// drops the assignment to `v` from the block already written
+    fn counter(
+        &mut self,
+        function: &ArenaFunction,
+        header: u32,
+        test: Test,
+        latch: u32,
+    ) -> Option<Counter> {
+        if latch == NONE || latch == header || self.cfg.exit(latch) != Exit::Jump(header) {
+            return None;
+        }
+
+        // Latch ends with the increment
+        let latch_block = &function.blocks()[latch as usize];
+        let Some(&Stmt::Assign { target, value }) =
+            latch_block.statements[..body_len(latch_block) as usize].last()
+        else {
+            return None;
+        };
+        let increment = function.expr(value);
+        let ExprData::Binary { left, right: step } = increment.data else {
+            return None;
+        };
+        let descending = match increment.kind {
+            ExpressionKind::Add => false,
+            ExpressionKind::Subtract => true,
+            _ => return None,
+        };
+        if !is_variable(function, left, target)
+            || !matches!(
+                function.expr(step).data,
+                ExprData::Constant(Constant::Integer(_))
+            )
+        {
+            return None;
+        }
+
+        // The loop goes on while the counter has not passed the end
+        let (condition, negate) = strip_not(function, test.condition, test.negate);
+        let compare = function.expr(condition);
+        let ExprData::Binary {
+            left: counter,
+            right: end,
+        } = compare.data
+        else {
+            return None;
+        };
+        let kind = if negate {
+            inverse_comparison(compare.kind)?
+        } else {
+            compare.kind
+        };
+        let expected = if descending {
+            ExpressionKind::GreaterEqual
+        } else {
+            ExpressionKind::LessEqual
+        };
+        if kind != expected || !is_variable(function, counter, target) {
+            return None;
+        }
+
+        // The block just written sets the start and falls into the loop
+        let Some(&Op::Block { block, end: set }) = self.ops.last() else {
+            return None;
+        };
+        if set == 0 || self.cfg.exit(block) != Exit::Jump(header) {
+            return None;
+        }
+        let Stmt::Assign {
+            target: initialized,
+            value: start,
+        } = function.blocks()[block as usize].statements[set as usize - 1]
+        else {
+            return None;
+        };
+        if initialized != target {
+            return None;
+        }
+        *self.ops.last_mut().unwrap() = Op::Block {
+            block,
+            end: set - 1,
+        };
+
+        Some(Counter {
+            variable: target,
+            start,
+            end,
+            step,
+            descending,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::cfg::tests::{branch, call, compare, function, jump};
+    use crate::ir::TypeKind;
+
+    #[test]
+    fn test_for_loop() {
+        // 0: x = 1; 1: x <= 10 ? 2 : 3; 2: body, x = x + 1 -> 1; 3: end
+        let (mut f, x) = function(4);
+        let one = f.int_const(1);
+        f.block_mut(0).unwrap().statements.push(Stmt::Assign {
+            target: x,
+            value: one,
+        });
+        jump(&mut f, 0, 1);
+        let c = compare(&mut f, ExpressionKind::LessEqual, x, 10);
+        branch(&mut f, 1, c, 2, 3);
+        call(&mut f, 2, "Body");
+        let var = f.variable(x);
+        let step = f.int_const(1);
+        let next = f.binary(ExpressionKind::Add, var, step, TypeKind::Integer);
+        f.block_mut(2).unwrap().statements.push(Stmt::Assign {
+            target: x,
+            value: next,
+        });
+        jump(&mut f, 2, 1);
+
+        let mut s = Structurer::new();
+        assert!(s.structure(&f));
+        let ops = s.ops();
+        assert_eq!(ops[0], Op::Block { block: 0, end: 0 });
+        assert!(matches!(
+            ops[1],
+            Op::For {
+                header: 1,
+                descending: false,
+                ..
+            }
+        ));
+        assert_eq!(ops[2], Op::Block { block: 2, end: 1 });
+        assert_eq!(ops[3], Op::Next { variable: x });
+    }
+}
@@ -11,106 +11,150 @@
 //! - Variable declarations
 //! - Statement generation
 //! - Expression generation with proper VB6 syntax
-//! - Basic control flow generation
+//! - Structured control flow: `If`, `Select Case`, `Do` and `For` loops
 //! - Proper indentation
+//!
+//! Every emitter writes into a caller-supplied [`fmt::Write`] sink, so a whole
+//! function is generated into one buffer without temporary strings. Both IR
+//! forms are supported: [`VB6CodeGenerator::write_function`] walks the tree
+//! IR and [`VB6CodeGenerator::write_arena_function`] walks an
+//! [`ArenaFunction`](crate::ir::arena::ArenaFunction). The `generate_*`
+//! methods are conveniences that collect the output into a fresh `String`.
+//!
+//! Arena functions are structured by [`Structurer`] first; blocks are only
+//! written one after another, joined by `GoTo`, when their control flow is
+//! not well-formed. The tree IR is always written block by block.
+
+mod arena;
 
+use std::fmt::{self, Write};
+
+use crate::cfg::Structurer;
 use crate::ir::*;
 
+/// Indentation unit
+const INDENT: &str = "    ";
+
+/// Pre-built indentation, sliced instead of repeated for typical depths
+const INDENTS: &str = "                                                                ";
+
 /// VB6 Code Generator
 pub struct VB6CodeGenerator {
     indent_level: usize,
+    structurer: Structurer,
 }
 
 impl VB6CodeGenerator {
     pub fn new() -> Self {
-        Self { indent_level: 0 }
+        Self {
+            indent_level: 0,
+            structurer: Structurer::new(),
+        }
     }
 
     /// Generate VB6 code for a complete function
     pub fn generate_function(&mut self, function: &Function) -> String {
         let mut code = String::new();
+        // Writing into a String cannot fail
+        let _ = self.write_function(function, &mut code);
+        code
+    }
 
-        // Generate function header
-        code.push_str(&self.generate_function_header(function));
-        code.push('\n');
+    /// Write VB6 code for a complete function to `out`
+    pub fn write_function<W: Write + ?Sized>(
+        &mut self,
+        function: &Function,
+        out: &mut W,
+    ) -> fmt::Result {
+        // Function header
+        self.write_function_header(function, out)?;
+        out.write_char('\n')?;
 
         self.indent_level += 1;
 
-        // Generate local variable declarations
+        // Local variable declarations
         if !function.local_variables.is_empty() {
-            code.push_str(&self.generate_local_variables(function));
-            code.push('\n');
+            self.write_local_variables(function, out)?;
+            out.write_char('\n')?;
         }
 
-        // Generate function body (statements from basic blocks)
-        code.push_str(&self.generate_function_body(function));
+        // Function body (statements from basic blocks)
+        let body = self.write_function_body(function, out);
 
         self.indent_level -= 1;
+        body?;
 
-        // Generate function footer
-        code.push_str(&self.generate_function_footer(function));
-
-        code
+        // Function footer
+        self.write_function_footer(function, out)
     }
 
-    /// Generate function header
-    fn generate_function_header(&self, function: &Function) -> String {
-        let func_type = if function.return_type.kind == TypeKind::Void {
-            "Sub"
-        } else {
-            "Function"
-        };
-
-        let params = function
-            .parameters
-            .iter()
-            .map(|p| format!("{} As {}", p.name, self.format_type_kind(p.var_type)))
-            .collect::<Vec<_>>()
-            .join(", ");
+    /// Write function header
+    fn write_function_header<W: Write + ?Sized>(
+        &self,
+        function: &Function,
+        out: &mut W,
+    ) -> fmt::Result {
+        let is_sub = function.return_type.kind == TypeKind::Void;
+        out.write_str(if is_sub { "Sub " } else { "Function " })?;
+        out.write_str(&function.name)?;
+        out.write_char('(')?;
+        for (i, param) in function.parameters.iter().enumerate() {
+            if i > 0 {
+                out.write_str(", ")?;
+            }
+            write!(
+                out,
+                "{} As {}",
+                param.name,
+                self.format_type_kind(param.var_type)
+            )?;
+        }
+        out.write_char(')')?;
 
-        if function.return_type.kind == TypeKind::Void {
-            format!("{} {}({})", func_type, function.name, params)
-        } else {
-            format!(
-                "{} {}({}) As {}",
-                func_type,
-                function.name,
-                params,
-                self.format_type(&function.return_type)
-            )
+        if !is_sub {
+            out.write_str(" As ")?;
+            self.write_type(&function.return_type, out)?;
         }
+        Ok(())
     }
 
-    /// Generate function footer
-    fn generate_function_footer(&self, function: &Function) -> String {
-        let func_type = if function.return_type.kind == TypeKind::Void {
-            "Sub"
+    /// Write function footer
+    fn write_function_footer<W: Write + ?Sized>(
+        &self,
+        function: &Function,
+        out: &mut W,
+    ) -> fmt::Result {
+        if function.return_type.kind == TypeKind::Void {
+            out.write_str("End Sub")
         } else {
-            "Function"
-        };
-        format!("End {}", func_type)
+            out.write_str("End Function")
+        }
     }
 
-    /// Generate local variable declarations
-    fn generate_local_variables(&self, function: &Function) -> String {
-        let mut code = String::new();
-
+    /// Write local variable declarations
+    fn write_local_variables<W: Write + ?Sized>(
+        &self,
+        function: &Function,
+        out: &mut W,
+    ) -> fmt::Result {
         for var in &function.local_variables {
-            code.push_str(&self.indent());
-            code.push_str(&format!(
-                "Dim {} As {}\n",
+            self.write_indent(out)?;
+            writeln!(
+                out,
+                "Dim {} As {}",
                 var.name,
                 self.format_type_kind(var.var_type)
-            ));
+            )?;
         }
-
-        code
+        Ok(())
     }
 
-    /// Generate function body from basic blocks
-    fn generate_function_body(&mut self, function: &Function) -> String {
-        let mut code = String::new();
-
+    /// Write function body from basic blocks
+    fn write_function_body<W: Write + ?Sized>(
+        &self,
+        function: &Function,
+        out: &mut W,
+    ) -> fmt::Result {
         // Process blocks in order (simplified - assumes sequential order)
         for block in &function.basic_blocks {
             // Skip if block is entry and has no statements (common for structured code)
@@ -120,161 +164,175 @@ impl VB6CodeGenerator {
 
             // Add block label if it has multiple predecessors (merge point)
             if block.predecessors.len() > 1 {
-                code.push_str(&format!("Block{}:\n", block.id));
+                writeln!(out, "Block{}:", block.id)?;
             }
 
-            // Generate statements
+            // Write statements
             for stmt in &block.statements {
-                code.push_str(&self.generate_statement(stmt));
+                self.write_statement(stmt, out)?;
             }
         }
-
-        code
+        Ok(())
     }
 
     /// Generate a statement
     pub fn generate_statement(&self, stmt: &Statement) -> String {
-        let mut code = self.indent();
+        let mut code = String::new();
+        let _ = self.write_statement(stmt, &mut code);
+        code
+    }
+
+    /// Write a statement, indented and newline-terminated
+    pub fn write_statement<W: Write + ?Sized>(&self, stmt: &Statement, out: &mut W) -> fmt::Result {
+        // Labels are never indented
+        if let StatementData::Label { label_id } = &stmt.data {
+            return writeln!(out, "Label{}:", label_id);
+        }
+
+        self.write_indent(out)?;
 
         match &stmt.data {
-            StatementData::None => {
-                code.push_str("' NOP\n");
-            }
+            StatementData::None => out.write_str("' NOP")?,
             StatementData::Assign { target, value } => {
-                code.push_str(&format!(
-                    "{} = {}\n",
-                    target.name,
-                    self.generate_expression(value)
-                ));
+                out.write_str(&target.name)?;
+                out.write_str(" = ")?;
+                self.write_expression(value, out)?;
             }
             StatementData::Store { address, value } => {
-                code.push_str(&format!(
-                    "[{}] = {}\n",
-                    self.generate_expression(address),
-                    self.generate_expression(value)
-                ));
+                out.write_char('[')?;
+                self.write_expression(address, out)?;
+                out.write_str("] = ")?;
+                self.write_expression(value, out)?;
             }
             StatementData::Call {
                 function,
                 arguments,
             } => {
-                if arguments.is_empty() {
-                    code.push_str(&format!("{}\n", function));
-                } else {
-                    let args = arguments
-                        .iter()
-                        .map(|a| self.generate_expression(a))
-                        .collect::<Vec<_>>()
-                        .join(", ");
-                    code.push_str(&format!("{} {}\n", function, args));
+                out.write_str(function)?;
+                if !arguments.is_empty() {
+                    out.write_char(' ')?;
+                    self.write_expression_list(arguments, out)?;
                 }
             }
             StatementData::Return { value } => {
                 if let Some(v) = value {
-                    code.push_str(&format!(
-                        "{} = {}\n",
-                        "ReturnValue",
-                        self.generate_expression(v)
-                    ));
-                    code.push_str(&self.indent());
-                    code.push_str("Exit Function\n");
+                    out.write_str("ReturnValue = ")?;
+                    self.write_expression(v, out)?;
+                    out.write_char('\n')?;
+                    self.write_indent(out)?;
+                    out.write_str("Exit Function")?;
                 } else {
-                    code.push_str("Exit Sub\n");
+                    out.write_str("Exit Sub")?;
                 }
             }
             StatementData::Branch {
                 condition,
                 target_block,
             } => {
-                code.push_str(&format!(
-                    "If {} Then GoTo Block{}\n",
-                    self.generate_expression(condition),
-                    target_block
-                ));
+                out.write_str("If ")?;
+                self.write_expression(condition, out)?;
+                write!(out, " Then GoTo Block{}", target_block)?;
             }
             StatementData::Goto { target_block } => {
-                code.push_str(&format!("GoTo Block{}\n", target_block));
-            }
-            StatementData::Label { label_id } => {
-                code = format!("Label{}:\n", label_id);
+                write!(out, "GoTo Block{}", target_block)?;
             }
+            StatementData::Label { .. } => unreachable!("labels are written unindented above"),
         }
 
-        code
+        out.write_char('\n')
     }
 
     /// Generate an expression
     pub fn generate_expression(&self, expr: &Expression) -> String {
+        let mut code = String::new();
+        let _ = self.write_expression(expr, &mut code);
+        code
+    }
+
+    /// Write an expression
+    pub fn write_expression<W: Write + ?Sized>(
+        &self,
+        expr: &Expression,
+        out: &mut W,
+    ) -> fmt::Result {
         match &expr.data {
-            ExpressionData::None => String::new(),
-            ExpressionData::Constant(val) => self.generate_constant(val),
-            ExpressionData::Variable(var) => var.name.clone(),
+            ExpressionData::None => Ok(()),
+            ExpressionData::Constant(val) => self.write_constant(val, out),
+            ExpressionData::Variable(var) => out.write_str(&var.name),
             ExpressionData::Unary(operand) => {
-                let op = match expr.kind {
-                    ExpressionKind::Negate => "-",
-                    ExpressionKind::Not => "Not ",
-                    _ => "?",
-                };
-                format!("{}{}", op, self.generate_expression(operand))
+                out.write_str(self.get_unary_operator(expr.kind))?;
+                self.write_expression(operand, out)
             }
             ExpressionData::Binary { left, right } => {
-                let op = self.get_binary_operator(expr.kind);
-                format!(
-                    "({} {} {})",
-                    self.generate_expression(left),
-                    op,
-                    self.generate_expression(right)
-                )
+                out.write_char('(')?;
+                self.write_expression(left, out)?;
+                out.write_char(' ')?;
+                out.write_str(self.get_binary_operator(expr.kind))?;
+                out.write_char(' ')?;
+                self.write_expression(right, out)?;
+                out.write_char(')')
             }
             ExpressionData::Call {
                 function,
                 arguments,
             } => {
-                if arguments.is_empty() {
-                    format!("{}()", function)
-                } else {
-                    let args = arguments
-                        .iter()
-                        .map(|a| self.generate_expression(a))
-                        .collect::<Vec<_>>()
-                        .join(", ");
-                    format!("{}({})", function, args)
-                }
+                out.write_str(function)?;
+                out.write_char('(')?;
+                self.write_expression_list(arguments, out)?;
+                out.write_char(')')
             }
             ExpressionData::MemberAccess { object, member } => {
-                format!("{}.{}", self.generate_expression(object), member)
+                self.write_expression(object, out)?;
+                out.write_char('.')?;
+                out.write_str(member)
             }
             ExpressionData::ArrayIndex { array, indices } => {
-                let idx = indices
-                    .iter()
-                    .map(|i| self.generate_expression(i))
-                    .collect::<Vec<_>>()
-                    .join(", ");
-                format!("{}({})", self.generate_expression(array), idx)
+                self.write_expression(array, out)?;
+                out.write_char('(')?;
+                self.write_expression_list(indices, out)?;
+                out.write_char(')')
             }
             ExpressionData::Cast { expr, target_type } => {
-                format!(
-                    "CType({}, {})",
-                    self.generate_expression(expr),
-                    self.format_type(target_type)
-                )
+                out.write_str("CType(")?;
+                self.write_expression(expr, out)?;
+                out.write_str(", ")?;
+                self.write_type(target_type, out)?;
+                out.write_char(')')
             }
         }
     }
 
-    /// Generate a constant value
-    fn generate_constant(&self, value: &ConstantValue) -> String {
-        match value {
-            ConstantValue::Integer(v) => v.to_string(),
-            ConstantValue::Float(v) => v.to_string(),
-            ConstantValue::String(s) => format!("\"{}\"", s),
-            ConstantValue::Boolean(b) => {
-                if *b {
-                    "True".to_string()
-                } else {
-                    "False".to_string()
-                }
+    /// Write a comma-separated expression list
+    fn write_expression_list<W: Write + ?Sized>(
+        &self,
+        items: &[Expression],
+        out: &mut W,
+    ) -> fmt::Result {
+        for (i, item) in items.iter().enumerate() {
+            if i > 0 {
+                out.write_str(", ")?;
             }
+            self.write_expression(item, out)?;
+        }
+        Ok(())
+    }
+
+    /// Write a constant value
+    fn write_constant<W: Write + ?Sized>(&self, value: &ConstantValue, out: &mut W) -> fmt::Result {
+        match value {
+            ConstantValue::Integer(v) => write!(out, "{}", v),
+            ConstantValue::Float(v) => write!(out, "{}", v),
+            ConstantValue::String(s) => write!(out, "\"{}\"", s),
+            ConstantValue::Boolean(b) => out.write_str(if *b { "True" } else { "False" }),
+        }
+    }
+
+    /// Get unary operator string (including any trailing space)
+    fn get_unary_operator(&self, kind: ExpressionKind) -> &'static str {
+        match kind {
+            ExpressionKind::Negate => "-",
+            ExpressionKind::Not => "Not ",
+            _ => "?",
         }
     }
 
@@ -322,30 +380,34 @@ impl VB6CodeGenerator {
         }
     }
 
-    /// Format a type
-    fn format_type(&self, ty: &Type) -> String {
+    /// Write a type
+    fn write_type<W: Write + ?Sized>(&self, ty: &Type, out: &mut W) -> fmt::Result {
         match ty.kind {
             TypeKind::Array => {
                 if let Some(element_type) = &ty.element_type {
-                    format!("{}()", self.format_type(element_type))
+                    self.write_type(element_type, out)?;
+                    out.write_str("()")
                 } else {
-                    "Array".to_string()
+                    out.write_str("Array")
                 }
             }
             TypeKind::UserDefined => {
-                if let Some(name) = &ty.type_name {
-                    name.clone()
-                } else {
-                    "UserDefined".to_string()
-                }
+                out.write_str(ty.type_name.as_deref().unwrap_or("UserDefined"))
             }
-            _ => self.format_type_kind(ty.kind).to_string(),
+            _ => out.write_str(self.format_type_kind(ty.kind)),
         }
     }
 
-    /// Get current indentation string
-    fn indent(&self) -> String {
-        "    ".repeat(self.indent_level)
+    /// Write the current indentation
+    fn write_indent<W: Write + ?Sized>(&self, out: &mut W) -> fmt::Result {
+        let width = self.indent_level * INDENT.len();
+        if width <= INDENTS.len() {
+            return out.write_str(&INDENTS[..width]);
+        }
+        for _ in 0..self.indent_level {
+            out.write_str(INDENT)?;
+        }
+        Ok(())
     }
 }
 
@@ -365,15 +427,15 @@ mod tests {
 
         // Test Sub (void return)
         let func1 = Function::new("TestSub".to_string(), Type::new(TypeKind::Void));
-        assert!(gen
-            .generate_function_header(&func1)
-            .starts_with("Sub TestSub("));
+        let mut header = String::new();
+        gen.write_function_header(&func1, &mut header).unwrap();
+        assert!(header.starts_with("Sub TestSub("));
 
         // Test Function (non-void return)
         let func2 = Function::new("TestFunc".to_string(), Type::new(TypeKind::Integer));
-        assert!(gen
-            .generate_function_header(&func2)
-            .starts_with("Function TestFunc("));
+        let mut header = String::new();
+        gen.write_function_header(&func2, &mut header).unwrap();
+        assert!(header.starts_with("Function TestFunc("));
     }
 
     #[test]
@@ -412,6 +474,49 @@ mod tests {
         assert!(ret_code.contains("Exit Function"));
     }
 
+    #[test]
+    fn test_write_propagates_sink_errors() {
+        /// Accepts `limit` bytes, then fails
+        struct Limited {
+            written: usize,
+            limit: usize,
+        }
+
+        impl fmt::Write for Limited {
+            fn write_str(&mut self, s: &str) -> fmt::Result {
+                self.written += s.len();
+                if self.written > self.limit {
+                    Err(fmt::Error)
+                } else {
+                    Ok(())
+                }
+            }
+        }
+
+        let mut function = Function::new("TestFunc".to_string(), Type::new(TypeKind::Integer));
+        let mut block = BasicBlock::new(0);
+        block.add_statement(Statement::return_stmt(Some(Expression::int_const(1))));
+        function.add_basic_block(block);
+
+        let mut gen = VB6CodeGenerator::new();
+        let full = gen.generate_function(&function);
+
+        let mut sink = Limited {
+            written: 0,
+            limit: usize::MAX,
+        };
+        gen.write_function(&function, &mut sink).unwrap();
+        assert_eq!(sink.written, full.len());
+
+        let mut sink = Limited {
+            written: 0,
+            limit: 10,
+        };
+        assert!(gen.write_function(&function, &mut sink).is_err());
+        // Indentation is restored after a failed write
+        assert_eq!(gen.generate_function(&function), full);
+    }
+
     #[test]
     fn test_binary_operators() {
         let gen = VB6CodeGenerator::new();
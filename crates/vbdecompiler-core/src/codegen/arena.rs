@@ -0,0 +1,460 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Code generation for arena-backed functions
+//!
+//! The control flow of an [`ArenaFunction`] is structured into nested
+//! constructs when it is well-formed, and written block by block, joined by
+//! `GoTo`, otherwise.
+
+use std::fmt::{self, Write};
+
+use super::VB6CodeGenerator;
+use crate::cfg::{self, Op, Test};
+use crate::ir::arena::{ArenaFunction, Constant, ExprData, ExprId, Stmt};
+use crate::ir::*;
+
+impl VB6CodeGenerator {
+    /// Generate VB6 code for an arena-backed function
+    pub fn generate_arena_function(&mut self, function: &ArenaFunction) -> String {
+        let mut code = String::new();
+        let _ = self.write_arena_function(function, &mut code);
+        code
+    }
+
+    /// Write VB6 code for an arena-backed function to `out`
+    ///
+    /// Control flow is written as nested constructs; if it is not
+    /// well-formed, this produces the same text as [`Self::write_function`]
+    /// on the equivalent tree IR.
+    pub fn write_arena_function<W: Write + ?Sized>(
+        &mut self,
+        function: &ArenaFunction,
+        out: &mut W,
+    ) -> fmt::Result {
+        let is_sub = function.return_type == TypeKind::Void;
+
+        // Header
+        out.write_str(if is_sub { "Sub " } else { "Function " })?;
+        out.write_str(&function.name)?;
+        out.write_char('(')?;
+        for (i, param) in function.parameters.iter().enumerate() {
+            if i > 0 {
+                out.write_str(", ")?;
+            }
+            out.write_str(function.name(param.name))?;
+            out.write_str(" As ")?;
+            out.write_str(self.format_type_kind(param.var_type))?;
+        }
+        out.write_char(')')?;
+        if !is_sub {
+            out.write_str(" As ")?;
+            out.write_str(self.format_type_kind(function.return_type))?;
+        }
+        out.write_char('\n')?;
+
+        self.indent_level += 1;
+        let body = self.write_arena_body(function, out);
+        self.indent_level -= 1;
+        body?;
+
+        // Footer
+        out.write_str(if is_sub { "End Sub" } else { "End Function" })
+    }
+
+    /// Write local declarations and statements of an arena-backed function
+    fn write_arena_body<W: Write + ?Sized>(
+        &mut self,
+        function: &ArenaFunction,
+        out: &mut W,
+    ) -> fmt::Result {
+        if !function.local_variables.is_empty() {
+            for var in &function.local_variables {
+                self.write_indent(out)?;
+                out.write_str("Dim ")?;
+                out.write_str(function.name(var.name))?;
+                out.write_str(" As ")?;
+                out.write_str(self.format_type_kind(var.var_type))?;
+                out.write_char('\n')?;
+            }
+            out.write_char('\n')?;
+        }
+
+        if self.structurer.structure(function) {
+            // Constructs change the indentation; restore it even on error
+            let level = self.indent_level;
+            let result = self.write_structured(function, out);
+            self.indent_level = level;
+            return result;
+        }
+
+        // Same block order and labelling as write_function_body
+        for (id, block) in function.blocks().iter().enumerate() {
+            if block.statements.is_empty() {
+                continue;
+            }
+
+            if block.predecessors.len() > 1 {
+                writeln!(out, "Block{}:", id)?;
+            }
+
+            for stmt in &block.statements {
+                self.write_arena_statement(function, stmt, out)?;
+            }
+        }
+        Ok(())
+    }
+
+    /// Write the structurer's ops for `function`
+    fn write_structured<W: Write + ?Sized>(
+        &mut self,
+        function: &ArenaFunction,
+        out: &mut W,
+    ) -> fmt::Result {
+        let is_sub = function.return_type == TypeKind::Void;
+        for i in 0..self.structurer.ops().len() {
+            let op = self.structurer.ops()[i];
+
+            // Closing keywords line up with their opening one
+            match op {
+                Op::ElseIf(_) | Op::Else | Op::EndIf | Op::Case { .. } | Op::CaseElse => {
+                    self.indent_level -= 1
+                }
+                Op::EndSelect => self.indent_level -= 2,
+                Op::Loop(_) | Op::Next { .. } => self.indent_level -= 1,
+                _ => {}
+            }
+
+            match op {
+                Op::Block { block, end } => {
+                    if self.structurer.block_label(block) {
+                        writeln!(out, "Block{}:", block)?;
+                    }
+                    let statements = &function.blocks()[block as usize].statements;
+                    for stmt in &statements[..end as usize] {
+                        self.write_arena_statement(function, stmt, out)?;
+                    }
+                    continue;
+                }
+                Op::Do { header, .. } | Op::For { header, .. }
+                    if self.structurer.loop_label(header) =>
+                {
+                    writeln!(out, "Block{}:", header)?;
+                }
+                _ => {}
+            }
+
+            self.write_indent(out)?;
+            match op {
+                Op::Block { .. } => unreachable!("blocks are written above"),
+                Op::If(test) | Op::ElseIf(test) => {
+                    out.write_str(if matches!(op, Op::If(_)) {
+                        "If "
+                    } else {
+                        "ElseIf "
+                    })?;
+                    self.write_condition(function, test, out)?;
+                    out.write_str(" Then")?;
+                }
+                Op::Else => out.write_str("Else")?,
+                Op::EndIf => out.write_str("End If")?,
+                Op::SelectCase { subject } => {
+                    out.write_str("Select Case ")?;
+                    self.write_arena_expression(function, subject, out)?;
+                }
+                Op::Case { value } => {
+                    out.write_str("Case ")?;
+                    self.write_arena_expression(function, value, out)?;
+                }
+                Op::CaseElse => out.write_str("Case Else")?,
+                Op::EndSelect => out.write_str("End Select")?,
+                Op::Do { test, .. } | Op::Loop(test) => {
+                    out.write_str(if matches!(op, Op::Do { .. }) {
+                        "Do"
+                    } else {
+                        "Loop"
+                    })?;
+                    if let Some(test) = test {
+                        out.write_str(" While ")?;
+                        self.write_condition(function, test, out)?;
+                    }
+                }
+                Op::For {
+                    variable,
+                    start,
+                    end,
+                    step,
+                    descending,
+                    ..
+                } => {
+                    out.write_str("For ")?;
+                    out.write_str(function.name(variable.name))?;
+                    out.write_str(" = ")?;
+                    self.write_arena_expression(function, start, out)?;
+                    out.write_str(" To ")?;
+                    self.write_arena_expression(function, end, out)?;
+                    let unit = function.expr(step).data == ExprData::Constant(Constant::Integer(1));
+                    if descending || !unit {
+                        out.write_str(if descending { " Step -" } else { " Step " })?;
+                        self.write_arena_expression(function, step, out)?;
+                    }
+                }
+                Op::Next { variable } => {
+                    out.write_str("Next ")?;
+                    out.write_str(function.name(variable.name))?;
+                }
+                Op::ExitDo => out.write_str("Exit Do")?,
+                Op::ExitFor => out.write_str("Exit For")?,
+                Op::ExitProc => out.write_str(if is_sub { "Exit Sub" } else { "Exit Function" })?,
+                Op::Goto(target) => write!(out, "GoTo Block{}", target)?,
+            }
+            out.write_char('\n')?;
+
+            match op {
+                Op::If(_) | Op::ElseIf(_) | Op::Else | Op::Case { .. } | Op::CaseElse => {
+                    self.indent_level += 1
+                }
+                Op::SelectCase { .. } => self.indent_level += 2,
+                Op::Do { .. } | Op::For { .. } => self.indent_level += 1,
+                _ => {}
+            }
+        }
+        Ok(())
+    }
+
+    /// Write a test, folding its negation into a comparison where possible
+    fn write_condition<W: Write + ?Sized>(
+        &self,
+        function: &ArenaFunction,
+        test: Test,
+        out: &mut W,
+    ) -> fmt::Result {
+        let (condition, negate) = cfg::strip_not(function, test.condition, test.negate);
+        if !negate {
+            return self.write_arena_expression(function, condition, out);
+        }
+
+        let expr = function.expr(condition);
+        match (expr.data, cfg::inverse_comparison(expr.kind)) {
+            (ExprData::Binary { left, right }, Some(inverse)) => {
+                out.write_char('(')?;
+                self.write_arena_expression(function, left, out)?;
+                out.write_char(' ')?;
+                out.write_str(self.get_binary_operator(inverse))?;
+                out.write_char(' ')?;
+                self.write_arena_expression(function, right, out)?;
+                out.write_char(')')
+            }
+            _ => {
+                out.write_str("Not ")?;
+                self.write_arena_expression(function, condition, out)
+            }
+        }
+    }
+
+    /// Write one arena statement, indented and newline-terminated
+    fn write_arena_statement<W: Write + ?Sized>(
+        &self,
+        function: &ArenaFunction,
+        stmt: &Stmt,
+        out: &mut W,
+    ) -> fmt::Result {
+        if let Stmt::Label { label_id } = *stmt {
+            return writeln!(out, "Label{}:", label_id);
+        }
+
+        self.write_indent(out)?;
+
+        match *stmt {
+            Stmt::Nop => out.write_str("' NOP")?,
+            Stmt::Assign { target, value } => {
+                out.write_str(function.name(target.name))?;
+                out.write_str(" = ")?;
+                self.write_arena_expression(function, value, out)?;
+            }
+            Stmt::Store { address, value } => {
+                out.write_char('[')?;
+                self.write_arena_expression(function, address, out)?;
+                out.write_str("] = ")?;
+                self.write_arena_expression(function, value, out)?;
+            }
+            Stmt::Call {
+                function: name,
+                arguments,
+            } => {
+                out.write_str(function.name(name))?;
+                if !arguments.is_empty() {
+                    out.write_char(' ')?;
+                    self.write_arena_list(function, function.list(arguments), out)?;
+                }
+            }
+            Stmt::Return { value } => {
+                if let Some(v) = value {
+                    out.write_str("ReturnValue = ")?;
+                    self.write_arena_expression(function, v, out)?;
+                    out.write_char('\n')?;
+                    self.write_indent(out)?;
+                    out.write_str("Exit Function")?;
+                } else if function.return_type == TypeKind::Void {
+                    out.write_str("Exit Sub")?;
+                } else {
+                    // Leaves the function with whatever was last assigned
+                    out.write_str("Exit Function")?;
+                }
+            }
+            Stmt::Branch {
+                condition,
+                target_block,
+            } => {
+                out.write_str("If ")?;
+                self.write_arena_expression(function, condition, out)?;
+                write!(out, " Then GoTo Block{}", target_block)?;
+            }
+            Stmt::Goto { target_block } => {
+                write!(out, "GoTo Block{}", target_block)?;
+            }
+            Stmt::Label { .. } => unreachable!("labels are written unindented above"),
+        }
+
+        out.write_char('\n')
+    }
+
+    /// Write an arena expression
+    fn write_arena_expression<W: Write + ?Sized>(
+        &self,
+        function: &ArenaFunction,
+        id: ExprId,
+        out: &mut W,
+    ) -> fmt::Result {
+        let expr = function.expr(id);
+        match expr.data {
+            ExprData::None => Ok(()),
+            ExprData::Constant(value) => match value {
+                Constant::Integer(v) => write!(out, "{}", v),
+                Constant::Float(v) => write!(out, "{}", v),
+                Constant::String(s) => {
+                    out.write_char('"')?;
+                    out.write_str(function.name(s))?;
+                    out.write_char('"')
+                }
+                Constant::Boolean(b) => out.write_str(if b { "True" } else { "False" }),
+            },
+            ExprData::Variable(var) => out.write_str(function.name(var.name)),
+            // Same notation as a store
+            ExprData::Unary(address) if expr.kind == ExpressionKind::Load => {
+                out.write_char('[')?;
+                self.write_arena_expression(function, address, out)?;
+                out.write_char(']')
+            }
+            ExprData::Unary(operand) => {
+                out.write_str(self.get_unary_operator(expr.kind))?;
+                self.write_arena_expression(function, operand, out)
+            }
+            ExprData::Binary { left, right } => {
+                out.write_char('(')?;
+                self.write_arena_expression(function, left, out)?;
+                out.write_char(' ')?;
+                out.write_str(self.get_binary_operator(expr.kind))?;
+                out.write_char(' ')?;
+                self.write_arena_expression(function, right, out)?;
+                out.write_char(')')
+            }
+            ExprData::Call {
+                function: name,
+                arguments,
+            } => {
+                out.write_str(function.name(name))?;
+                out.write_char('(')?;
+                self.write_arena_list(function, function.list(arguments), out)?;
+                out.write_char(')')
+            }
+            ExprData::MemberAccess { object, member } => {
+                self.write_arena_expression(function, object, out)?;
+                out.write_char('.')?;
+                out.write_str(function.name(member))
+            }
+            ExprData::ArrayIndex { array, indices } => {
+                self.write_arena_expression(function, array, out)?;
+                out.write_char('(')?;
+                self.write_arena_list(function, function.list(indices), out)?;
+                out.write_char(')')
+            }
+            ExprData::Cast { expr, target_type } => {
+                out.write_str("CType(")?;
+                self.write_arena_expression(function, expr, out)?;
+                out.write_str(", ")?;
+                out.write_str(self.format_type_kind(target_type))?;
+                out.write_char(')')
+            }
+        }
+    }
+
+    /// Write a comma-separated list of arena expressions
+    fn write_arena_list<W: Write + ?Sized>(
+        &self,
+        function: &ArenaFunction,
+        items: &[ExprId],
+        out: &mut W,
+    ) -> fmt::Result {
+        for (i, &item) in items.iter().enumerate() {
+            if i > 0 {
+                out.write_str(", ")?;
+            }
+            self.write_arena_expression(function, item, out)?;
+        }
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_arena_matches_tree() {
+        use crate::ir::arena::VarRef;
+
+        let mut function = ArenaFunction::new("Sample".to_string(), TypeKind::Variant);
+        let name = function.intern("local1");
+        let local = VarRef {
+            id: 1,
+            name,
+            var_type: TypeKind::Integer,
+        };
+        let one = function.int_const(1);
+        let var = function.variable(local);
+        let sum = function.binary(ExpressionKind::Add, var, one, TypeKind::Variant);
+        let text = function.string_const("Hi");
+        let args = function.push_list(&[text, sum]);
+        let callee = function.intern("MsgBox");
+        let call = function.call(callee, args, TypeKind::Variant);
+        let cond = function.unary(ExpressionKind::Not, call, TypeKind::Boolean);
+        let exit = function.add_block();
+        function.local_variables.push(local);
+
+        let entry = function.block_mut(0).unwrap();
+        entry.statements.push(Stmt::Assign {
+            target: local,
+            value: sum,
+        });
+        entry.statements.push(Stmt::Branch {
+            condition: cond,
+            target_block: exit,
+        });
+        entry.statements.push(Stmt::Call {
+            function: callee,
+            arguments: args,
+        });
+        let exit_block = function.block_mut(exit).unwrap();
+        exit_block.statements.push(Stmt::Label { label_id: 7 });
+        exit_block
+            .statements
+            .push(Stmt::Return { value: Some(var) });
+
+        let mut gen = VB6CodeGenerator::new();
+        let expected = gen.generate_function(&function.to_function());
+        assert_eq!(gen.generate_arena_function(&function), expected);
+        assert!(expected.contains("If Not MsgBox(\"Hi\", (local1 + 1)) Then GoTo Block1"));
+    }
+}
@@ -7,163 +7,611 @@
 //! Wires together all decompilation stages:
 //! PE → VB → P-Code → IR → Code Generation
 
+mod incremental;
+mod jobs;
+mod pipeline;
+
+pub(crate) use pipeline::{MethodOutput, Pipeline};
+
+use crate::budget::MethodBudget;
+use crate::cache::{self, CachedFile, CachedMethod, CachedObject, DecompileCache};
 use crate::codegen::VB6CodeGenerator;
 use crate::error::{Error, Result};
+use crate::index::{IndexBuilder, MethodRefs, SymbolIndex};
 use crate::ir::Function;
-use crate::lifter::PCodeLifter;
-use crate::pcode::Disassembler;
-use crate::pe::PEFile;
+use crate::native::NativeImage;
+use crate::pe::{PEFile, PackerCheck};
+use crate::project::Project;
+use crate::scratch::ScratchPool;
+use crate::stats::{self, Stage, StatsCollector};
 use crate::vb;
-use rayon::prelude::*;
-use std::fs;
+use jobs::MethodJob;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::Arc;
 
+/// Progress callback invoked as `(completed_methods, total_methods)`
+///
+/// Called from Rayon worker threads, so it must be `Sync`.
+pub type ProgressFn = dyn Fn(usize, usize) + Sync;
+
+/// Cooperative cancellation flag shared between a caller and a running decompilation
+///
+/// Cloning the token shares the underlying flag.
+#[derive(Debug, Clone, Default)]
+pub struct CancellationToken {
+    cancelled: Arc<AtomicBool>,
+}
+
+impl CancellationToken {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Request cancellation; running methods finish, pending ones are skipped
+    pub fn cancel(&self) {
+        self.cancelled.store(true, Ordering::Relaxed);
+    }
+
+    /// Check whether cancellation was requested
+    pub fn is_cancelled(&self) -> bool {
+        self.cancelled.load(Ordering::Relaxed)
+    }
+}
+
+/// Optional observers for a running decompilation
+#[derive(Default, Clone, Copy)]
+pub struct DecompileHooks<'a> {
+    /// Progress reporting callback
+    pub progress: Option<&'a ProgressFn>,
+    /// Cancellation token checked before each method
+    pub cancel: Option<&'a CancellationToken>,
+    /// Collector for stage timings and counters
+    pub stats: Option<&'a StatsCollector>,
+}
+
+impl DecompileHooks<'_> {
+    fn is_cancelled(&self) -> bool {
+        self.cancel.map_or(false, |token| token.is_cancelled())
+    }
+
+    fn report_progress(&self, completed: usize, total: usize) {
+        if let Some(progress) = self.progress {
+            progress(completed, total);
+        }
+    }
+}
+
+/// Callback receiving each method as soon as it has been decompiled
+///
+/// Called from Rayon worker threads in completion order, so it must be `Sync`.
+pub type MethodFn<'f> = dyn Fn(&DecompiledMethod<'_>) + Sync + 'f;
+
+/// A single decompiled method, borrowed for the duration of a [`MethodFn`] call
+#[derive(Debug, Clone, Copy)]
+pub struct DecompiledMethod<'a> {
+    /// Index of the owning object in the VB object table
+    pub object_index: usize,
+    /// Index of the method within its object
+    pub method_index: usize,
+    pub object_name: &'a str,
+    pub method_name: &'a str,
+    /// Content hash of the method's P-Code; `None` for native methods
+    pub pcode_hash: Option<u64>,
+    /// Generated VB6 code for this method
+    pub code: &'a str,
+    /// IR listing, if requested with [`Decompiler::set_capture_ir`]
+    pub ir: Option<&'a str>,
+}
+
+/// Where an executable is read from
+enum Source<'s> {
+    Path(&'s str),
+    Buffer(&'s [u8]),
+    /// Already parsed (and triaged) by the caller
+    Parsed(PEFile),
+}
+
+impl Source<'_> {
+    fn content_hash(&self) -> Result<u64> {
+        match self {
+            Source::Path(path) => Ok(cache::hash_file(path)?),
+            Source::Buffer(data) => Ok(cache::content_hash(data)),
+            Source::Parsed(pe) => Ok(pe.content_hash()),
+        }
+    }
+}
+
+/// How a decompilation is split into parallel tasks
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub enum Parallelism {
+    /// One task per method (small methods may be batched; see
+    /// [`DecompilerConfig::serial_threshold`])
+    #[default]
+    Methods,
+    /// One task per object; suits binaries with a few huge forms
+    Objects,
+}
+
+/// Threading settings of a [`Decompiler`]
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct DecompilerConfig {
+    /// Worker threads of a dedicated pool; 0 uses the caller's Rayon pool
+    /// (the global pool unless called from inside another pool)
+    pub threads: usize,
+    /// Stack size of dedicated worker threads in bytes; 0 keeps Rayon's default
+    pub stack_size: usize,
+    /// Methods with less P-Code than this many bytes are run serially,
+    /// batched with their neighbours, instead of as tasks of their own
+    pub serial_threshold: usize,
+    pub parallelism: Parallelism,
+    /// Per-method size, instruction and time limits
+    pub budget: MethodBudget,
+    /// Decode and lift each P-Code method in one pass, without an
+    /// instruction buffer; bounds per-thread memory on large methods
+    pub fused: bool,
+}
+
+impl DecompilerConfig {
+    /// Whether the settings need a dedicated thread pool
+    fn needs_pool(&self) -> bool {
+        self.threads > 0 || self.stack_size > 0
+    }
+}
+
 /// Main decompiler orchestrator
+///
+/// A decompiler keeps a [`ScratchPool`] of per-thread pipeline buffers that
+/// is reused across methods and across files, so hosts should hold on to one
+/// instance rather than creating one per file. Decompiling only needs
+/// `&self`, so one decompiler can serve several files concurrently.
 pub struct Decompiler {
     generator: VB6CodeGenerator,
+    cache: Option<DecompileCache>,
+    packer_check: PackerCheck,
+    /// Shared with every [`Project`] opened from this decompiler
+    scratch: Arc<ScratchPool>,
+    config: DecompilerConfig,
+    /// Dedicated workers, if the config asks for them
+    pool: Option<rayon::ThreadPool>,
+    capture_ir: bool,
+    build_index: bool,
 }
 
 impl Decompiler {
     pub fn new() -> Self {
         Self {
             generator: VB6CodeGenerator::new(),
+            cache: None,
+            packer_check: PackerCheck::Eager,
+            scratch: Arc::new(ScratchPool::new()),
+            config: DecompilerConfig::default(),
+            pool: None,
+            capture_ir: false,
+            build_index: false,
         }
     }
 
-    /// Decompile a VB executable file
-    pub fn decompile_file(&mut self, path: &str) -> Result<DecompilationResult> {
-        log::info!("Decompiling file: {}", path);
+    /// Create a decompiler with the given threading settings
+    ///
+    /// Fails if a dedicated thread pool was requested and could not be started.
+    pub fn with_config(config: DecompilerConfig) -> Result<Self> {
+        let pool =
+            if config.needs_pool() {
+                let mut builder = rayon::ThreadPoolBuilder::new()
+                    .num_threads(config.threads)
+                    .thread_name(|i| format!("vbdc-worker-{}", i));
+                if config.stack_size > 0 {
+                    builder = builder.stack_size(config.stack_size);
+                }
+                Some(builder.build().map_err(|e| {
+                    Error::Decompilation(format!("Failed to start thread pool: {}", e))
+                })?)
+            } else {
+                None
+            };
+
+        Ok(Self {
+            config,
+            pool,
+            ..Self::new()
+        })
+    }
 
-        // 1. Read file
-        let data = fs::read(path).map_err(|e| Error::Io(e))?;
+    /// Threading settings in use
+    pub fn config(&self) -> &DecompilerConfig {
+        &self.config
+    }
 
-        // 2. Parse PE file
-        log::info!("Parsing PE file...");
-        let pe = PEFile::from_bytes(data)?;
+    /// Hand an IR listing of each method to streaming callbacks
+    ///
+    /// See [`DecompiledMethod::ir`]. Listings are never cached, so while this
+    /// is set cached results are not reused (they are still stored).
+    pub fn set_capture_ir(&mut self, capture_ir: bool) {
+        self.capture_ir = capture_ir;
+    }
 
-        // 3. Parse VB structures
-        log::info!("Parsing VB structures...");
-        let vb_file = Arc::new(vb::VBFile::from_pe(pe)?);
+    /// Whether streaming callbacks receive IR listings
+    pub fn capture_ir(&self) -> bool {
+        self.capture_ir
+    }
 
-        log::info!(
-            "Found VB project: {}",
-            vb_file.project_name().as_deref().unwrap_or("Unknown")
-        );
+    /// Build a [`SymbolIndex`] of calls, string constants and symbols into
+    /// each [`DecompilationResult`] of a whole-file decompilation
+    ///
+    /// References are collected from each method's IR while it is still in
+    /// its scratch arena. Like IR listings they are not cached, so while
+    /// this is set cached results are not reused.
+    pub fn set_build_index(&mut self, build_index: bool) {
+        self.build_index = build_index;
+    }
 
-        // 4. Collect all methods to decompile
-        let mut methods_to_decompile = Vec::new();
+    /// Limit what each following method may cost; see [`MethodBudget`]
+    ///
+    /// Methods over budget are skipped like methods that fail to disassemble.
+    /// Projects opened afterwards use the new limits.
+    pub fn set_method_budget(&mut self, budget: MethodBudget) {
+        self.config.budget = budget;
+    }
 
-        for (obj_idx, object) in vb_file.objects().iter().enumerate() {
-            log::info!("Processing object: {}", object.name);
+    /// Enable the on-disk result cache rooted at `dir`, or disable it with `None`
+    ///
+    /// See [`crate::cache`] for what is stored.
+    pub fn set_cache_dir(&mut self, dir: Option<PathBuf>) {
+        self.cache = dir.map(DecompileCache::new);
+    }
 
-            for (method_idx, method_name) in object.method_names.iter().enumerate() {
-                methods_to_decompile.push((
-                    obj_idx,
-                    method_idx,
-                    object.name.clone(),
-                    method_name.clone(),
-                ));
-            }
-        }
+    /// Versioned cache directory in use, if caching is enabled
+    pub fn cache_dir(&self) -> Option<&Path> {
+        self.cache.as_ref().map(|cache| cache.dir())
+    }
 
-        log::info!(
-            "Found {} methods, decompiling in parallel with Rayon...",
-            methods_to_decompile.len()
-        );
+    /// Choose when packer detection runs on opened files
+    ///
+    /// The default, [`PackerCheck::Eager`], rejects packed executables before
+    /// VB parsing. Batch callers that have already triaged their inputs can
+    /// skip the check.
+    pub fn set_packer_check(&mut self, packer_check: PackerCheck) {
+        self.packer_check = packer_check;
+    }
 
-        // 5. Decompile methods in parallel using Rayon
-        // This provides significant speedup for executables with many methods.
-        // Each method is decompiled independently on a separate thread from Rayon's thread pool.
-        // Benefits:
-        // - Scales with CPU cores (e.g., 8 cores → ~8x faster for 100+ methods)
-        // - Memory-safe: Rust's ownership prevents data races
-        // - Automatic work stealing: Rayon balances work across threads
-        let decompiled_methods: Vec<(String, String)> = methods_to_decompile
-            .par_iter()
-            .filter_map(|(obj_idx, method_idx, obj_name, method_name)| {
-                log::info!("  Processing method: {}_{}", obj_name, method_name);
-
-                // Get P-Code for this specific method
-                let pcode_data = match vb_file.get_pcode_for_method(*obj_idx, *method_idx) {
-                    Some(data) => data,
-                    None => {
-                        log::info!("    No P-Code (native compiled)");
-                        return None;
-                    }
-                };
-
-                if pcode_data.is_empty() {
-                    log::info!("    Empty P-Code data");
-                    return None;
-                }
+    /// Open a VB executable for lazy, per-method decompilation
+    ///
+    /// Only the PE and VB structures are parsed; see [`Project`]. The project
+    /// shares this decompiler's cache configuration at the time of the call,
+    /// and its scratch buffers.
+    pub fn open(&self, path: &str) -> Result<Project> {
+        Ok(Project::from_vb_file(
+            Self::load(path, self.packer_check)?,
+            self.cache.clone(),
+            Arc::clone(&self.scratch),
+            self.config.budget,
+            self.config.fused,
+        ))
+    }
 
-                log::info!(
-                    "    P-Code found ({} bytes), disassembling...",
-                    pcode_data.len()
-                );
-
-                // Disassemble P-Code
-                let mut disassembler = Disassembler::new(pcode_data);
-                let instructions = match disassembler.disassemble(0) {
-                    Ok(insns) => insns,
-                    Err(e) => {
-                        log::warn!("    Failed to disassemble: {}", e);
-                        return None;
-                    }
-                };
-
-                if instructions.is_empty() {
-                    log::warn!("    No instructions found");
-                    return None;
-                }
+    /// Decompile a VB executable file
+    pub fn decompile_file(&self, path: &str) -> Result<DecompilationResult> {
+        self.decompile_file_with_hooks(path, &DecompileHooks::default())
+    }
 
-                log::info!("    Disassembled {} instructions", instructions.len());
+    /// Decompile a VB executable file, reporting progress and honouring cancellation
+    ///
+    /// Returns `Error::Cancelled` if the token in `hooks` was cancelled before
+    /// all methods were processed.
+    pub fn decompile_file_with_hooks(
+        &self,
+        path: &str,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        self.decompile_source(Source::Path(path), None, hooks)
+    }
 
-                // Lift P-Code to IR
-                let mut lifter = PCodeLifter::new();
-                let function_name = format!("{}_{}", obj_name, method_name);
-                let function = match lifter.lift(&instructions, function_name.clone(), 0) {
-                    Ok(func) => func,
-                    Err(e) => {
-                        log::warn!("    Failed to lift: {}", e);
-                        return None;
-                    }
-                };
+    /// Decompile a VB executable already held in memory (e.g. a host-side mapping)
+    pub fn decompile_bytes(&self, data: &[u8]) -> Result<DecompilationResult> {
+        self.decompile_bytes_with_hooks(data, &DecompileHooks::default())
+    }
 
-                log::info!("    Lifted to IR: {} blocks", function.basic_blocks.len());
+    /// Decompile an in-memory VB executable, reporting progress and honouring cancellation
+    pub fn decompile_bytes_with_hooks(
+        &self,
+        data: &[u8],
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        self.decompile_source(Source::Buffer(data), None, hooks)
+    }
 
-                // Generate VB6 code (each thread gets its own generator)
-                let mut generator = VB6CodeGenerator::new();
-                let code = generator.generate_function(&function);
+    /// Decompile an already parsed PE file, reporting progress and honouring cancellation
+    ///
+    /// For callers that inspect the headers first (e.g. triage services):
+    /// the file is not parsed again, and its packer check is whatever `pe`
+    /// was opened with, not this decompiler's.
+    pub fn decompile_pe(
+        &self,
+        pe: PEFile,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        self.decompile_source(Source::Parsed(pe), None, hooks)
+    }
 
-                log::info!("    Successfully decompiled {}", function_name);
+    /// Decompile an in-memory VB executable, handing each method to `on_method` as it finishes
+    ///
+    /// See [`decompile_file_streaming`](Self::decompile_file_streaming).
+    pub fn decompile_bytes_streaming(
+        &self,
+        data: &[u8],
+        on_method: &MethodFn<'_>,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        self.decompile_source(Source::Buffer(data), Some(on_method), hooks)
+    }
 
-                Some((function_name, code))
-            })
-            .collect();
+    /// Decompile a VB executable file, handing each method to `on_method` as it finishes
+    ///
+    /// Methods arrive in completion order, not table order. The combined code is
+    /// never materialized, so `vb6_code` in the returned result is empty.
+    pub fn decompile_file_streaming(
+        &self,
+        path: &str,
+        on_method: &MethodFn<'_>,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        self.decompile_source(Source::Path(path), Some(on_method), hooks)
+    }
 
-        if decompiled_methods.is_empty() {
-            return Err(Error::Decompilation(
-                "No P-Code methods found (executable may be native-compiled)".to_string(),
-            ));
+    /// Decompile every method of `source`
+    ///
+    /// With `on_method` each method is streamed and the combined code is left
+    /// empty; without it the code of all methods is combined into the result.
+    fn decompile_source(
+        &self,
+        source: Source<'_>,
+        on_method: Option<&MethodFn<'_>>,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        let cache = self.cache.as_ref();
+        let pipeline = self.pipeline(hooks.stats);
+
+        // 0. A whole-file cache hit skips parsing entirely
+        let file_hash = match cache {
+            Some(_) => Some(source.content_hash()?),
+            None => None,
+        };
+        if let (Some(cache), Some(hash), true) = (cache, file_hash, pipeline.reuses_cache()) {
+            if let Some(entry) = cache.load_file(hash) {
+                log::info!("Using cached decompilation ({:016x})", hash);
+                if let Some(stats) = hooks.stats {
+                    stats.record_cached(entry.methods.len());
+                }
+                return Self::replay(&entry, on_method, hooks);
+            }
         }
 
-        // 6. Combine all decompiled code
-        let mut vb6_code = String::new();
-        for (_name, code) in &decompiled_methods {
-            vb6_code.push_str(code);
-            vb6_code.push_str("\n\n");
+        let vb_file = match source {
+            Source::Path(path) => Self::load_with(path, self.packer_check, hooks.stats)?,
+            Source::Buffer(data) => {
+                log::info!("Decompiling {} byte buffer", data.len());
+
+                // SAFETY: the PEFile and VBFile are locals dropped before this
+                // returns, while `data` outlives the call
+                let pe = stats::timed(hooks.stats, Stage::PeParse, || unsafe {
+                    PEFile::from_borrowed(data, self.packer_check)
+                })?;
+                Self::load_pe(pe, hooks.stats)?
+            }
+            Source::Parsed(pe) => Self::load_pe(pe, hooks.stats)?,
+        };
+
+        let jobs = Self::collect_jobs(&vb_file);
+
+        // Native methods are disassembled from their entry points instead
+        let native = vb_file.is_native_code().then(|| {
+            log::info!("Native-code executable; disassembling methods as x86");
+            NativeImage::new(&vb_file)
+        });
+        let pipeline = Pipeline {
+            native: native.as_ref(),
+            ..pipeline
+        };
+
+        // Per-method code is only kept when it is combined or cached
+        let keep_code = on_method.is_none() || cache.is_some();
+        // P-Code hashes are only reported to streaming callers and cached
+        let keep_hash = on_method.is_some() || cache.is_some();
+        // Set if a method with code failed, possibly only over the budget
+        let dropped = AtomicBool::new(false);
+        let shape = |job: &MethodJob<'_>| Self::job_shape(&vb_file, job);
+        let methods = self.run_jobs(&jobs, shape, hooks, |job| {
+            let Some(MethodOutput {
+                name,
+                code,
+                ir,
+                refs,
+            }) = Self::decompile_job(&vb_file, pipeline, job)
+            else {
+                if pipeline.native.is_some() || Self::job_pcode(&vb_file, job).is_some() {
+                    dropped.store(true, Ordering::Relaxed);
+                }
+                return None;
+            };
+            let pcode_hash = keep_hash
+                .then(|| Self::job_pcode(&vb_file, job).map(cache::content_hash))
+                .flatten();
+            if let Some(on_method) = on_method {
+                on_method(&DecompiledMethod {
+                    object_index: job.object_index,
+                    method_index: job.method_index,
+                    object_name: job.object_name,
+                    method_name: job.method_name,
+                    pcode_hash,
+                    code: &code,
+                    ir: ir.as_deref(),
+                });
+            }
+
+            let method = CachedMethod {
+                object_index: job.object_index,
+                method_index: job.method_index,
+                name,
+                code: if keep_code { code } else { String::new() },
+                pcode_hash,
+            };
+            Some((method, refs))
+        })?;
+        let (methods, refs): (Vec<_>, Vec<_>) = methods.into_iter().unzip();
+        Self::require_methods(&methods)?;
+        if let Some(native) = &native {
+            log::info!(
+                "Decoded {} distinct x86 instructions",
+                native.decoded_instructions()
+            );
         }
 
-        Ok(DecompilationResult {
+        let entry = CachedFile {
             project_name: vb_file
                 .project_name()
                 .unwrap_or_else(|| "Unknown".to_string()),
+            is_pcode: vb_file.is_pcode(),
+            objects: vb_file
+                .objects()
+                .iter()
+                .map(|object| CachedObject {
+                    name: object.name.clone(),
+                    object_type: object.object_type,
+                    method_names: object.method_names.clone(),
+                })
+                .collect(),
+            methods,
+        };
+
+        // The entry is keyed on content alone, so only store results any
+        // decompiler would reproduce: none with methods dropped by the budget
+        // (whose time limit depends on machine load), and none of files that
+        // skipped or would fail the packer check
+        if let (Some(cache), Some(hash)) = (cache, file_hash) {
+            let pe = vb_file.pe_file();
+            if !dropped.into_inner()
+                && pe.packer_check() != PackerCheck::Skip
+                && pe.packer().is_none()
+            {
+                cache.store_file(hash, &entry);
+            }
+        }
+
+        let mut result = Self::summarize(&entry, on_method.is_none());
+        if pipeline.index {
+            result.index = Some(Self::build_index(&vb_file, &entry.methods, &refs));
+        }
+        Ok(result)
+    }
+
+    /// Merge the references of each decompiled method with the object table
+    fn build_index(
+        vb_file: &vb::VBFile,
+        methods: &[CachedMethod],
+        refs: &[Option<MethodRefs>],
+    ) -> SymbolIndex {
+        let mut builder = IndexBuilder::new();
+        for object in vb_file.objects() {
+            builder.add_object(&object.name);
+            for method_name in &object.method_names {
+                builder.add_method(&format!("{}_{}", object.name, method_name), None);
+            }
+        }
+        for (method, refs) in methods.iter().zip(refs) {
+            builder.add_method(&method.name, refs.as_ref());
+        }
+        builder.finish()
+    }
+
+    /// Serve a decompilation from a whole-file cache entry
+    fn replay(
+        entry: &CachedFile,
+        on_method: Option<&MethodFn<'_>>,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<DecompilationResult> {
+        let total_methods = entry.methods.len();
+        hooks.report_progress(0, total_methods);
+
+        if let Some(on_method) = on_method {
+            for (completed, method) in entry.methods.iter().enumerate() {
+                if hooks.is_cancelled() {
+                    return Err(Error::Cancelled);
+                }
+
+                let (object_name, method_name) = entry.method_names(method).unwrap_or(("", ""));
+                on_method(&DecompiledMethod {
+                    object_index: method.object_index,
+                    method_index: method.method_index,
+                    object_name,
+                    method_name,
+                    pcode_hash: method.pcode_hash,
+                    code: &method.code,
+                    ir: None,
+                });
+                hooks.report_progress(completed + 1, total_methods);
+            }
+        } else {
+            hooks.report_progress(total_methods, total_methods);
+        }
+
+        Ok(Self::summarize(entry, on_method.is_none()))
+    }
+
+    /// Build the result summary, combining all method code if `combine` is set
+    fn summarize(entry: &CachedFile, combine: bool) -> DecompilationResult {
+        // 6. Combine all decompiled code
+        let mut vb6_code = String::new();
+        if combine {
+            vb6_code.reserve(entry.methods.iter().map(|m| m.code.len() + 2).sum());
+            for method in &entry.methods {
+                vb6_code.push_str(&method.code);
+                vb6_code.push_str("\n\n");
+            }
+        }
+
+        DecompilationResult {
+            project_name: entry.project_name.clone(),
             vb6_code,
-            is_pcode: true,
-            object_count: vb_file.objects().len(),
-            method_count: decompiled_methods.len(),
-        })
+            is_pcode: entry.is_pcode,
+            object_count: entry.objects.len(),
+            method_count: entry.methods.len(),
+            index: None,
+        }
+    }
+
+    /// Map and parse the PE and VB structures of a file
+    pub(crate) fn load(path: &str, packer_check: PackerCheck) -> Result<vb::VBFile> {
+        Self::load_with(path, packer_check, None)
+    }
+
+    /// [`Self::load`], timing each stage into `stats`
+    fn load_with(
+        path: &str,
+        packer_check: PackerCheck,
+        stats: Option<&StatsCollector>,
+    ) -> Result<vb::VBFile> {
+        log::info!("Decompiling file: {}", path);
+
+        // 1-2. Map and parse PE file
+        log::info!("Parsing PE file...");
+        let pe = PEFile::from_path_staged(Path::new(path), packer_check, stats)?;
+
+        Self::load_pe(pe, stats)
+    }
+
+    /// Parse the VB structures of a parsed PE file
+    fn load_pe(pe: PEFile, stats: Option<&StatsCollector>) -> Result<vb::VBFile> {
+        // 3. Parse VB structures
+        log::info!("Parsing VB structures...");
+        let vb_file = stats::timed(stats, Stage::VbParse, || vb::VBFile::from_pe(pe))?;
+
+        log::info!(
+            "Found VB project: {}",
+            vb_file.project_name().as_deref().unwrap_or("Unknown")
+        );
+
+        Ok(vb_file)
     }
 
     /// Generate VB6 code from an IR function (for testing/API use)
@@ -191,12 +639,17 @@ pub struct DecompilationResult {
     pub object_count: usize,
     /// Number of methods decompiled
     pub method_count: usize,
+    /// Call graph, string table and symbols, if requested with
+    /// [`Decompiler::set_build_index`]
+    #[serde(skip)]
+    pub index: Option<SymbolIndex>,
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
     use crate::ir::{Expression, Statement, Type, TypeKind, Variable};
+    use std::sync::atomic::AtomicUsize;
 
     #[test]
     fn test_decompiler_creation() {
@@ -204,6 +657,230 @@ mod tests {
         // Just test that it creates successfully
     }
 
+    #[test]
+    fn test_cancellation_token_shared() {
+        let token = CancellationToken::new();
+        let clone = token.clone();
+        assert!(!clone.is_cancelled());
+
+        token.cancel();
+        assert!(clone.is_cancelled());
+    }
+
+    #[test]
+    fn test_cancelled_before_start() {
+        let token = CancellationToken::new();
+        token.cancel();
+        let hooks = DecompileHooks {
+            cancel: Some(&token),
+            ..Default::default()
+        };
+
+        // A missing file still fails with an I/O error before cancellation is checked
+        let decompiler = Decompiler::new();
+        let result = decompiler.decompile_file_with_hooks("/nonexistent/file.exe", &hooks);
+        assert!(matches!(result, Err(Error::Io(_))));
+    }
+
+    #[test]
+    fn test_streaming_missing_file() {
+        let delivered = AtomicUsize::new(0);
+        let on_method = |_: &DecompiledMethod<'_>| {
+            delivered.fetch_add(1, Ordering::Relaxed);
+        };
+
+        let decompiler = Decompiler::new();
+        let result = decompiler.decompile_file_streaming(
+            "/nonexistent/file.exe",
+            &on_method,
+            &DecompileHooks::default(),
+        );
+        assert!(matches!(result, Err(Error::Io(_))));
+        assert_eq!(delivered.load(Ordering::Relaxed), 0);
+    }
+
+    #[test]
+    fn test_decompile_bytes_rejects_non_pe() {
+        let decompiler = Decompiler::new();
+        let result = decompiler.decompile_bytes(&[0u8; 128]);
+        assert!(matches!(result, Err(Error::InvalidPE(_))));
+    }
+
+    #[test]
+    fn test_cache_dir_toggle() {
+        let mut decompiler = Decompiler::new();
+        assert!(decompiler.cache_dir().is_none());
+
+        let root = std::env::temp_dir().join("vbdecompiler-cache-toggle");
+        decompiler.set_cache_dir(Some(root.clone()));
+        assert!(decompiler.cache_dir().unwrap().starts_with(&root));
+
+        // Hashing a missing file fails like reading it would
+        let result = decompiler.decompile_file("/nonexistent/file.exe");
+        assert!(matches!(result, Err(Error::Io(_))));
+
+        decompiler.set_cache_dir(None);
+        assert!(decompiler.cache_dir().is_none());
+    }
+
+    #[test]
+    fn test_whole_file_cache_skips_incomplete_results() {
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let data = std::fs::read(corpus.join("synthetic-small.exe")).unwrap();
+        let hash = cache::content_hash(&data);
+        let root = std::env::temp_dir().join(format!(
+            "vbdecompiler-cache-incomplete-{}",
+            std::process::id()
+        ));
+
+        // Drop every method but the smallest
+        let vb_file = Decompiler::load_pe(PEFile::from_bytes(data.clone()).unwrap(), None).unwrap();
+        let sizes: Vec<usize> = Decompiler::collect_jobs(&vb_file)
+            .iter()
+            .filter_map(|job| Decompiler::job_pcode(&vb_file, job).map(<[u8]>::len))
+            .collect();
+        let smallest = *sizes.iter().min().unwrap();
+        assert!(sizes.iter().any(|&size| size > smallest));
+
+        let mut decompiler = Decompiler::new();
+        decompiler.set_method_budget(MethodBudget {
+            max_bytes: smallest,
+            ..MethodBudget::default()
+        });
+        decompiler.set_cache_dir(Some(root.clone()));
+        decompiler.decompile_bytes(&data).unwrap();
+        assert!(decompiler.cache.as_ref().unwrap().load_file(hash).is_none());
+
+        let mut decompiler = Decompiler::new();
+        decompiler.set_cache_dir(Some(root.clone()));
+        decompiler.set_packer_check(PackerCheck::Skip);
+        decompiler.decompile_bytes(&data).unwrap();
+        assert!(decompiler.cache.as_ref().unwrap().load_file(hash).is_none());
+
+        decompiler.set_packer_check(PackerCheck::Eager);
+        decompiler.decompile_bytes(&data).unwrap();
+        assert!(decompiler.cache.as_ref().unwrap().load_file(hash).is_some());
+
+        let _ = std::fs::remove_dir_all(root);
+    }
+
+    /// Copy the small benchmark executable to a temp file named `name`,
+    /// changing the first literal of its first method if `modify` is set
+    pub(super) fn corpus_build(name: &str, modify: bool) -> String {
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let mut data = std::fs::read(corpus.join("synthetic-small.exe")).unwrap();
+
+        if modify {
+            let vb_file =
+                Decompiler::load_pe(PEFile::from_bytes(data.clone()).unwrap(), None).unwrap();
+            let pcode = vb_file.get_pcode_for_method(0, 0).unwrap();
+            let offset = crate::scan::find(&data, pcode).unwrap();
+            // The method starts with LitI2 <byte>
+            data[offset + 1] ^= 0x01;
+        }
+
+        let path = std::env::temp_dir().join(format!(
+            "vbdecompiler-incremental-{}-{}.exe",
+            name,
+            std::process::id()
+        ));
+        std::fs::write(&path, data).unwrap();
+        path.to_string_lossy().into_owned()
+    }
+
+    #[test]
+    fn test_streaming_reports_hashes_and_ir() {
+        let path = corpus_build("stream-ir", false);
+        let seen = std::sync::Mutex::new(Vec::new());
+        let on_method = |method: &DecompiledMethod<'_>| {
+            let listing = method.ir.map(str::to_string);
+            seen.lock().unwrap().push((method.pcode_hash, listing));
+        };
+
+        let mut decompiler = Decompiler::new();
+        decompiler.set_capture_ir(true);
+        decompiler
+            .decompile_file_streaming(&path, &on_method, &DecompileHooks::default())
+            .unwrap();
+
+        let seen = seen.into_inner().unwrap();
+        assert!(!seen.is_empty());
+        for (hash, listing) in &seen {
+            assert!(hash.is_some());
+            assert!(listing.as_deref().unwrap().contains("Block0:"));
+        }
+
+        let _ = std::fs::remove_file(path);
+    }
+
+    #[test]
+    fn test_decompile_pe_matches_bytes_and_shares_decompiler() {
+        fn assert_sync<T: Sync>(_: &T) {}
+
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let data = std::fs::read(corpus.join("synthetic-small.exe")).unwrap();
+        let expected = Decompiler::new().decompile_bytes(&data).unwrap().vb6_code;
+
+        let decompiler = Decompiler::new();
+        assert_sync(&decompiler);
+        let hooks = DecompileHooks::default();
+        std::thread::scope(|scope| {
+            let workers: Vec<_> = (0..4)
+                .map(|_| {
+                    scope.spawn(|| {
+                        let pe = PEFile::from_bytes_with(data.clone(), PackerCheck::Lazy).unwrap();
+                        decompiler.decompile_pe(pe, &hooks).unwrap().vb6_code
+                    })
+                })
+                .collect();
+            for worker in workers {
+                assert_eq!(worker.join().unwrap(), expected);
+            }
+        });
+    }
+
+    #[test]
+    fn test_index_lists_objects_and_methods() {
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let data = std::fs::read(corpus.join("synthetic-small.exe")).unwrap();
+
+        let mut decompiler = Decompiler::new();
+        assert!(decompiler.decompile_bytes(&data).unwrap().index.is_none());
+
+        decompiler.set_build_index(true);
+        let result = decompiler.decompile_bytes(&data).unwrap();
+        let index = result.index.unwrap();
+        let vb_file = Decompiler::load_pe(PEFile::from_bytes(data).unwrap(), None).unwrap();
+        for object in vb_file.objects() {
+            let id = index.lookup(&object.name).unwrap();
+            assert_eq!(index.kind(id), Some(crate::SymbolKind::Object));
+            let prefix = format!("{}_", object.name);
+            assert!(index.find_symbols(&prefix).len() >= object.method_names.len());
+        }
+    }
+
+    #[test]
+    fn test_dedicated_pool_matches_global_pool() {
+        let path = corpus_build("pool", false);
+        let expected = Decompiler::new().decompile_file(&path).unwrap();
+
+        let config = DecompilerConfig {
+            threads: 2,
+            stack_size: 4 << 20,
+            serial_threshold: 64,
+            parallelism: Parallelism::Objects,
+            budget: MethodBudget::default(),
+            fused: true,
+        };
+        let decompiler = Decompiler::with_config(config.clone()).unwrap();
+        assert_eq!(decompiler.config(), &config);
+        let result = decompiler.decompile_file(&path).unwrap();
+        assert_eq!(result.vb6_code, expected.vb6_code);
+        assert_eq!(result.method_count, expected.method_count);
+
+        let _ = std::fs::remove_file(path);
+    }
+
     #[test]
     fn test_generate_simple_function() {
         let mut decompiler = Decompiler::new();
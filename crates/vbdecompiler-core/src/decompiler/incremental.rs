@@ -0,0 +1,318 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Incremental decompilation against a [`Snapshot`] of an earlier build, and
+//! method-level diffs between two builds
+
+use super::jobs::{with_pcode, MethodJob};
+use super::pipeline::MethodOutput;
+use super::{DecompileHooks, Decompiler};
+use crate::cache;
+use crate::error::Result;
+use crate::incremental::{
+    method_keys, BuildDiff, ChangeKind, IncrementalResult, MethodChange, MethodKey, Snapshot,
+    SnapshotMethod,
+};
+use std::collections::{HashMap, HashSet};
+
+/// Jobs with P-Code, with their [`MethodKey`]s and P-Code hashes
+fn keyed<'j, 'v>(
+    jobs: &'j [MethodJob<'v>],
+    hashes: &'j [Option<u64>],
+) -> Vec<(MethodKey<'v>, &'j MethodJob<'v>, u64)> {
+    let methods: Vec<_> = with_pcode(jobs, hashes).collect();
+    let keys = method_keys(
+        methods
+            .iter()
+            .map(|(job, _)| (job.object_name, job.method_name)),
+    );
+    keys.into_iter()
+        .zip(methods)
+        .map(|(key, (job, hash))| (key, job, hash))
+        .collect()
+}
+
+impl Decompiler {
+    /// Decompile a VB executable, reusing unchanged methods of an earlier build
+    ///
+    /// Each method's P-Code is hashed; methods whose [`MethodKey`] and hash
+    /// match `baseline` take their code from it instead of being decompiled
+    /// again. Without a baseline every method is reported as added. Methods
+    /// that fail to decompile stay in the snapshot without code so they are
+    /// not reported as removed, and are decompiled again by the next call.
+    /// Pass the returned snapshot as the baseline of the next call.
+    pub fn decompile_incremental(
+        &self,
+        path: &str,
+        baseline: Option<&Snapshot>,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<IncrementalResult> {
+        let vb_file = Self::load_with(path, self.packer_check, hooks.stats)?;
+        let jobs: Vec<_> = Self::collect_jobs(&vb_file)
+            .into_iter()
+            .filter(|job| Self::job_pcode(&vb_file, job).is_some())
+            .collect();
+        let keys = method_keys(jobs.iter().map(|job| (job.object_name, job.method_name)));
+        let work: Vec<(MethodKey<'_>, &MethodJob<'_>)> = keys.into_iter().zip(&jobs).collect();
+        let previous = baseline.map(Snapshot::index).unwrap_or_default();
+        let pipeline = self.pipeline(hooks.stats);
+
+        let shape = |(_, job): &(MethodKey<'_>, &MethodJob<'_>)| Self::job_shape(&vb_file, job);
+        let keyed_methods = self.run_jobs(&work, shape, hooks, |&(key, job)| {
+            let pcode = Self::job_pcode(&vb_file, job)?;
+            let pcode_hash = cache::content_hash(pcode);
+
+            // Methods that failed last time are retried
+            let unchanged = previous
+                .get(&key)
+                .filter(|old| old.pcode_hash == pcode_hash && old.code.is_some());
+            if let Some(old) = unchanged {
+                log::debug!("  Reusing unchanged method: {}", old.name);
+                return Some((key, (*old).clone()));
+            }
+
+            // Failures are kept so the next build does not see them as added
+            let output = Self::decompile_job(&vb_file, pipeline, job);
+            let (name, code) = match output {
+                Some(MethodOutput { name, code, .. }) => (name, Some(code)),
+                None => (format!("{}_{}", job.object_name, job.method_name), None),
+            };
+            let method = SnapshotMethod {
+                object_name: job.object_name.to_string(),
+                method_name: job.method_name.to_string(),
+                pcode_hash,
+                name,
+                code,
+            };
+            Some((key, method))
+        })?;
+        let (keys, methods): (Vec<_>, Vec<_>) = keyed_methods.into_iter().unzip();
+        let decompiled: Vec<_> = methods.iter().filter(|m| m.code.is_some()).collect();
+        Self::require_methods(&decompiled)?;
+
+        let mut changes = Vec::new();
+        let mut reused = 0;
+        for (key, method) in keys.iter().zip(&methods) {
+            let (kind, old_code) = match previous.get(key) {
+                None => (ChangeKind::Added, None),
+                Some(old) if old.pcode_hash != method.pcode_hash => {
+                    (ChangeKind::Changed, old.code.clone())
+                }
+                Some(old) if old.code.is_some() => {
+                    reused += 1;
+                    continue;
+                }
+                // Failed in the baseline and still fails
+                Some(_) if method.code.is_none() => continue,
+                Some(_) => (ChangeKind::Changed, None),
+            };
+            changes.push(MethodChange {
+                kind,
+                object_name: method.object_name.clone(),
+                method_name: method.method_name.clone(),
+                old_code,
+                new_code: method.code.clone(),
+            });
+        }
+
+        if let Some(baseline) = baseline {
+            let current: HashSet<MethodKey<'_>> = keys.iter().copied().collect();
+            let names = baseline
+                .methods
+                .iter()
+                .map(|m| (m.object_name.as_str(), m.method_name.as_str()));
+            for (key, old) in method_keys(names).iter().zip(&baseline.methods) {
+                if !current.contains(key) {
+                    changes.push(MethodChange {
+                        kind: ChangeKind::Removed,
+                        object_name: old.object_name.clone(),
+                        method_name: old.method_name.clone(),
+                        old_code: old.code.clone(),
+                        new_code: None,
+                    });
+                }
+            }
+        }
+
+        log::info!(
+            "{} methods changed, {} reused from the baseline",
+            changes.len(),
+            reused
+        );
+
+        Ok(IncrementalResult {
+            snapshot: Snapshot {
+                project_name: vb_file
+                    .project_name()
+                    .unwrap_or_else(|| "Unknown".to_string()),
+                methods,
+            },
+            changes,
+            reused,
+        })
+    }
+
+    /// Compare two builds of a VB application method by method
+    ///
+    /// Both files are parsed and every method's P-Code is hashed, but only
+    /// methods present in one build or whose P-Code differs are decompiled,
+    /// so the cost grows with the size of the change rather than the program.
+    pub fn diff_files(
+        &self,
+        old_path: &str,
+        new_path: &str,
+        hooks: &DecompileHooks<'_>,
+    ) -> Result<BuildDiff> {
+        let old_file = Self::load_with(old_path, self.packer_check, hooks.stats)?;
+        let new_file = Self::load_with(new_path, self.packer_check, hooks.stats)?;
+        let old_jobs = Self::collect_jobs(&old_file);
+        let new_jobs = Self::collect_jobs(&new_file);
+        let old_hashes = self.hash_jobs(&old_file, &old_jobs);
+        let new_hashes = self.hash_jobs(&new_file, &new_jobs);
+
+        let old_methods = keyed(&old_jobs, &old_hashes);
+        let new_methods = keyed(&new_jobs, &new_hashes);
+        let old_index: HashMap<_, _> = old_methods
+            .iter()
+            .map(|&(key, _, hash)| (key, hash))
+            .collect();
+        let new_index: HashMap<_, _> = new_methods
+            .iter()
+            .map(|&(key, _, hash)| (key, hash))
+            .collect();
+
+        // Decompile only what differs; `true` marks the old build
+        let work: Vec<(bool, MethodKey<'_>, &MethodJob<'_>)> = old_methods
+            .iter()
+            .filter(|(key, _, hash)| new_index.get(key) != Some(hash))
+            .map(|&(key, job, _)| (true, key, job))
+            .chain(
+                new_methods
+                    .iter()
+                    .filter(|(key, _, hash)| old_index.get(key) != Some(hash))
+                    .map(|&(key, job, _)| (false, key, job)),
+            )
+            .collect();
+
+        let pipeline = self.pipeline(hooks.stats);
+        let file = |is_old| if is_old { &old_file } else { &new_file };
+        let shape = |&(is_old, _, job): &(bool, MethodKey<'_>, &MethodJob<'_>)| {
+            let (object, bytes) = Self::job_shape(file(is_old), job);
+            ((is_old, object), bytes)
+        };
+        let decompiled = self.run_jobs(&work, shape, hooks, |&(is_old, key, job)| {
+            let vb_file = file(is_old);
+            let MethodOutput { code, .. } = Self::decompile_job(vb_file, pipeline, job)?;
+            Some(((is_old, key), code))
+        })?;
+        let mut codes: HashMap<_, _> = decompiled.into_iter().collect();
+
+        let mut changes = Vec::new();
+        let mut unchanged = 0;
+        for &(key, job, hash) in &new_methods {
+            let kind = match old_index.get(&key) {
+                None => ChangeKind::Added,
+                Some(&old_hash) if old_hash != hash => ChangeKind::Changed,
+                Some(_) => {
+                    unchanged += 1;
+                    continue;
+                }
+            };
+            changes.push(MethodChange {
+                kind,
+                object_name: job.object_name.to_string(),
+                method_name: job.method_name.to_string(),
+                old_code: codes.remove(&(true, key)),
+                new_code: codes.remove(&(false, key)),
+            });
+        }
+        for &(key, job, _) in &old_methods {
+            if !new_index.contains_key(&key) {
+                changes.push(MethodChange {
+                    kind: ChangeKind::Removed,
+                    object_name: job.object_name.to_string(),
+                    method_name: job.method_name.to_string(),
+                    old_code: codes.remove(&(true, key)),
+                    new_code: None,
+                });
+            }
+        }
+
+        Ok(BuildDiff {
+            old_project: old_file
+                .project_name()
+                .unwrap_or_else(|| "Unknown".to_string()),
+            new_project: new_file
+                .project_name()
+                .unwrap_or_else(|| "Unknown".to_string()),
+            changes,
+            unchanged,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::decompiler::tests::corpus_build;
+
+    #[test]
+    fn test_incremental_reuses_unchanged_methods() {
+        let old = corpus_build("old", false);
+        let new = corpus_build("new", true);
+        let decompiler = Decompiler::new();
+        let hooks = DecompileHooks::default();
+
+        let first = decompiler
+            .decompile_incremental(&old, None, &hooks)
+            .unwrap();
+        let total = first.snapshot.methods.len();
+        assert!(total > 1);
+        assert_eq!(first.reused, 0);
+        assert_eq!(first.changes.len(), total);
+        assert!(first.changes.iter().all(|c| c.kind == ChangeKind::Added));
+
+        let again = decompiler
+            .decompile_incremental(&old, Some(&first.snapshot), &hooks)
+            .unwrap();
+        assert_eq!(again.reused, total);
+        assert!(again.changes.is_empty());
+
+        // A method that failed in the baseline is decompiled again
+        let mut failed = first.snapshot.clone();
+        failed.methods[0].code = None;
+        let retried = decompiler
+            .decompile_incremental(&old, Some(&failed), &hooks)
+            .unwrap();
+        assert_eq!(retried.reused, total - 1);
+        assert_eq!(retried.changes.len(), 1);
+        assert_eq!(retried.changes[0].kind, ChangeKind::Changed);
+        assert_eq!(retried.changes[0].old_code, None);
+        assert_eq!(retried.changes[0].new_code, first.snapshot.methods[0].code);
+
+        let next = decompiler
+            .decompile_incremental(&new, Some(&first.snapshot), &hooks)
+            .unwrap();
+        assert_eq!(next.reused, total - 1);
+        assert_eq!(next.changes.len(), 1);
+        let change = &next.changes[0];
+        assert_eq!(change.kind, ChangeKind::Changed);
+        // The lifter drops unused stack values, so the code itself may not differ
+        assert!(change.new_code.is_some());
+        assert_eq!(change.old_code, first.snapshot.methods[0].code);
+
+        let diff = decompiler.diff_files(&old, &new, &hooks).unwrap();
+        assert_eq!(diff.unchanged, total - 1);
+        assert_eq!(diff.count(ChangeKind::Changed), 1);
+        assert_eq!(diff.changes[0].old_code, change.old_code);
+        assert_eq!(diff.changes[0].new_code, change.new_code);
+
+        let same = decompiler.diff_files(&old, &old, &hooks).unwrap();
+        assert!(same.changes.is_empty());
+        assert_eq!(same.unchanged, total);
+
+        let _ = std::fs::remove_file(old);
+        let _ = std::fs::remove_file(new);
+    }
+}
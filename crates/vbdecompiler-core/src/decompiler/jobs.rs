@@ -0,0 +1,243 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Scheduling of methods as parallel tasks
+
+use super::{DecompileHooks, Decompiler, Parallelism};
+use crate::cache;
+use crate::error::{Error, Result};
+use crate::vb;
+use rayon::prelude::*;
+use std::ops::Range;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+/// A method scheduled for decompilation, borrowing names from the parsed VB file
+pub(super) struct MethodJob<'v> {
+    pub(super) object_index: usize,
+    pub(super) method_index: usize,
+    pub(super) object_name: &'v str,
+    pub(super) method_name: &'v str,
+}
+
+/// Pair jobs with their P-Code hashes, skipping jobs without P-Code
+pub(super) fn with_pcode<'j, 'v>(
+    jobs: &'j [MethodJob<'v>],
+    hashes: &'j [Option<u64>],
+) -> impl Iterator<Item = (&'j MethodJob<'v>, u64)> {
+    jobs.iter()
+        .zip(hashes)
+        .filter_map(|(job, hash)| Some((job, (*hash)?)))
+}
+
+impl Decompiler {
+    /// Collect all methods to decompile
+    pub(super) fn collect_jobs(vb_file: &vb::VBFile) -> Vec<MethodJob<'_>> {
+        let mut jobs = Vec::new();
+
+        for (object_index, object) in vb_file.objects().iter().enumerate() {
+            log::debug!("Processing object: {}", object.name);
+
+            for (method_index, method_name) in object.method_names.iter().enumerate() {
+                jobs.push(MethodJob {
+                    object_index,
+                    method_index,
+                    object_name: &object.name,
+                    method_name,
+                });
+            }
+        }
+
+        jobs
+    }
+
+    /// P-Code of a job, or `None` for native or empty methods
+    pub(super) fn job_pcode<'v>(vb_file: &'v vb::VBFile, job: &MethodJob<'_>) -> Option<&'v [u8]> {
+        vb_file
+            .get_pcode_for_method(job.object_index, job.method_index)
+            .filter(|pcode| !pcode.is_empty())
+    }
+
+    /// P-Code hash of every job (`None` where there is no P-Code)
+    pub(super) fn hash_jobs(
+        &self,
+        vb_file: &vb::VBFile,
+        jobs: &[MethodJob<'_>],
+    ) -> Vec<Option<u64>> {
+        self.install(|| {
+            jobs.par_iter()
+                .map(|job| Self::job_pcode(vb_file, job).map(cache::content_hash))
+                .collect()
+        })
+    }
+
+    /// Object index and P-Code size of a job, for [`Self::plan_tasks`]
+    ///
+    /// A native method's size is unknown until it is disassembled, so each
+    /// one counts as large enough to be its own task.
+    pub(super) fn job_shape(vb_file: &vb::VBFile, job: &MethodJob<'_>) -> (usize, usize) {
+        let bytes = if vb_file.is_native_code() {
+            usize::MAX
+        } else {
+            Self::job_pcode(vb_file, job).map_or(0, <[u8]>::len)
+        };
+        (job.object_index, bytes)
+    }
+
+    /// Process all jobs in parallel
+    ///
+    /// `process` runs once per job; its `Some` values are collected in job
+    /// order. Progress is reported and cancellation checked per job. `shape`
+    /// gives each job's group (its object) and P-Code size, from which
+    /// [`Self::plan_tasks`] decides what runs serially.
+    pub(super) fn run_jobs<J, G, T, P>(
+        &self,
+        jobs: &[J],
+        shape: impl Fn(&J) -> (G, usize),
+        hooks: &DecompileHooks<'_>,
+        process: P,
+    ) -> Result<Vec<T>>
+    where
+        J: Sync,
+        G: PartialEq,
+        T: Send,
+        P: Fn(&J) -> Option<T> + Sync,
+    {
+        let tasks = self.plan_tasks(jobs, shape);
+        log::info!(
+            "Found {} methods, decompiling in parallel with Rayon ({} tasks)...",
+            jobs.len(),
+            tasks.len()
+        );
+
+        if hooks.is_cancelled() {
+            return Err(Error::Cancelled);
+        }
+
+        let total_methods = jobs.len();
+        let completed_methods = AtomicUsize::new(0);
+        hooks.report_progress(0, total_methods);
+
+        // 5. Decompile methods in parallel using Rayon
+        // This provides significant speedup for executables with many methods.
+        // Each task runs its methods in order on one thread from the pool.
+        // Benefits:
+        // - Scales with CPU cores (e.g., 8 cores → ~8x faster for 100+ methods)
+        // - Memory-safe: Rust's ownership prevents data races
+        // - Automatic work stealing: Rayon balances work across threads
+        let results: Vec<T> = self.install(|| {
+            tasks
+                .par_iter()
+                .flat_map_iter(|task| {
+                    jobs[task.clone()].iter().filter_map(|job| {
+                        // Skip remaining work once cancelled; in-flight methods still finish
+                        if hooks.is_cancelled() {
+                            return None;
+                        }
+
+                        let finished = process(job);
+
+                        let completed = completed_methods.fetch_add(1, Ordering::Relaxed) + 1;
+                        hooks.report_progress(completed, total_methods);
+
+                        finished
+                    })
+                })
+                .collect()
+        });
+
+        if hooks.is_cancelled() {
+            return Err(Error::Cancelled);
+        }
+
+        Ok(results)
+    }
+
+    /// Split jobs into contiguous runs, each processed serially by one task
+    ///
+    /// With [`Parallelism::Methods`] every method is its own task, except that
+    /// neighbouring methods smaller than the serial threshold are batched
+    /// until they reach it. With [`Parallelism::Objects`] each run of jobs of
+    /// the same group is one task.
+    fn plan_tasks<J, G: PartialEq>(
+        &self,
+        jobs: &[J],
+        shape: impl Fn(&J) -> (G, usize),
+    ) -> Vec<Range<usize>> {
+        let threshold = self.config.serial_threshold;
+        let mut tasks = Vec::new();
+        let mut start = 0;
+        let mut task_bytes = 0;
+        let mut task_group = None;
+
+        for (i, job) in jobs.iter().enumerate() {
+            let (group, bytes) = shape(job);
+            let split = match self.config.parallelism {
+                Parallelism::Methods => task_bytes >= threshold || bytes >= threshold,
+                Parallelism::Objects => task_group.as_ref().map_or(false, |g| *g != group),
+            };
+            if split && i > start {
+                tasks.push(start..i);
+                start = i;
+                task_bytes = 0;
+            }
+            task_bytes = task_bytes.saturating_add(bytes);
+            task_group = Some(group);
+        }
+        if start < jobs.len() {
+            tasks.push(start..jobs.len());
+        }
+
+        tasks
+    }
+
+    /// Run `op` on this decompiler's thread pool, or the current one if it has none
+    fn install<R: Send>(&self, op: impl FnOnce() -> R + Send) -> R {
+        match &self.pool {
+            Some(pool) => pool.install(op),
+            None => op(),
+        }
+    }
+
+    /// Fail if no method of a file could be decompiled
+    pub(super) fn require_methods<T>(methods: &[T]) -> Result<()> {
+        if methods.is_empty() {
+            return Err(Error::Decompilation(
+                "No decompilable methods found".to_string(),
+            ));
+        }
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::decompiler::DecompilerConfig;
+
+    #[test]
+    fn test_plan_tasks() {
+        let plan = |config: DecompilerConfig, jobs: &[(u32, usize)]| {
+            Decompiler::with_config(config)
+                .unwrap()
+                .plan_tasks(jobs, |&job| job)
+        };
+        let jobs = [(0, 10), (0, 10), (0, 500), (1, 10), (1, 10), (1, 10)];
+
+        let each = plan(DecompilerConfig::default(), &jobs);
+        assert_eq!(each.len(), jobs.len());
+
+        let batched = DecompilerConfig {
+            serial_threshold: 25,
+            ..Default::default()
+        };
+        assert_eq!(plan(batched, &jobs), vec![0..2, 2..3, 3..6]);
+
+        let objects = DecompilerConfig {
+            parallelism: Parallelism::Objects,
+            ..Default::default()
+        };
+        assert_eq!(plan(objects, &jobs), vec![0..3, 3..6]);
+        assert!(plan(DecompilerConfig::default(), &[] as &[(u32, usize)]).is_empty());
+    }
+}
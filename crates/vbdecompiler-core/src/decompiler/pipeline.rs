@@ -0,0 +1,248 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! The per-method pipeline: cache lookup, disassembly, lifting and code
+//! generation of one method on pooled scratch buffers
+
+use super::jobs::MethodJob;
+use super::Decompiler;
+use crate::budget::MethodBudget;
+use crate::cache::DecompileCache;
+use crate::index::MethodRefs;
+use crate::native::NativeImage;
+use crate::scratch::ScratchPool;
+use crate::stats::StatsCollector;
+use crate::vb;
+use std::time::Instant;
+
+/// Output of the pipeline for one method
+#[derive(Debug, Clone)]
+pub(crate) struct MethodOutput {
+    /// Generated function name
+    pub name: String,
+    pub code: String,
+    /// Set when the pipeline was asked for IR listings
+    pub ir: Option<String>,
+    /// Set when the pipeline was asked to build a
+    /// [`SymbolIndex`](crate::index::SymbolIndex)
+    pub refs: Option<MethodRefs>,
+}
+
+/// Shared per-method state: result cache, scratch buffers and stats sink
+#[derive(Clone, Copy)]
+pub(crate) struct Pipeline<'p> {
+    pub cache: Option<&'p DecompileCache>,
+    pub scratch: &'p ScratchPool,
+    pub stats: Option<&'p StatsCollector>,
+    /// Set for native-code files; methods are then disassembled as x86
+    pub native: Option<&'p NativeImage>,
+    /// Also render an IR listing of each method; bypasses cache lookups,
+    /// since listings are not cached
+    pub ir: bool,
+    /// Also collect each method's references for a
+    /// [`SymbolIndex`](crate::index::SymbolIndex);
+    /// bypasses cache lookups like `ir`
+    pub index: bool,
+    /// Limits each method is decompiled under
+    pub budget: MethodBudget,
+    /// Decode and lift P-Code in one pass; see
+    /// [`DecompilerConfig::fused`](super::DecompilerConfig::fused)
+    pub fused: bool,
+}
+
+impl Pipeline<'_> {
+    /// Whether cached results may stand in for running the pipeline
+    pub(super) fn reuses_cache(&self) -> bool {
+        !self.ir && !self.index
+    }
+}
+
+impl Decompiler {
+    /// Per-method state for one decompilation
+    pub(super) fn pipeline<'p>(&'p self, stats: Option<&'p StatsCollector>) -> Pipeline<'p> {
+        Pipeline {
+            cache: self.cache.as_ref(),
+            scratch: &self.scratch,
+            stats,
+            native: None,
+            ir: self.capture_ir,
+            index: self.build_index,
+            budget: self.config.budget,
+            fused: self.config.fused,
+        }
+    }
+
+    /// [`Self::decompile_method`] for a scheduled job
+    pub(super) fn decompile_job(
+        vb_file: &vb::VBFile,
+        pipeline: Pipeline<'_>,
+        job: &MethodJob<'_>,
+    ) -> Option<MethodOutput> {
+        Self::decompile_method(
+            vb_file,
+            pipeline,
+            job.object_index,
+            job.method_index,
+            job.object_name,
+            job.method_name,
+        )
+    }
+
+    /// Run the disassemble → lift → generate pipeline for a single method
+    ///
+    /// Returns the function name, generated code and (with `pipeline.ir`) IR
+    /// listing, or `None` if the method
+    /// has no P-Code (or, with `pipeline.native`, no entry point) or any
+    /// stage fails.
+    pub(crate) fn decompile_method(
+        vb_file: &vb::VBFile,
+        pipeline: Pipeline<'_>,
+        obj_idx: usize,
+        method_idx: usize,
+        obj_name: &str,
+        method_name: &str,
+    ) -> Option<MethodOutput> {
+        let Pipeline {
+            cache,
+            scratch,
+            stats,
+            native,
+            ir,
+            index,
+            budget,
+            fused,
+        } = pipeline;
+        log::debug!("  Processing method: {}_{}", obj_name, method_name);
+
+        if let Some(native) = native {
+            return Self::decompile_native_method(
+                vb_file,
+                native,
+                pipeline,
+                obj_idx,
+                method_idx,
+                obj_name,
+                method_name,
+            );
+        }
+
+        // Get P-Code for this specific method
+        let pcode_data = match vb_file.get_pcode_for_method(obj_idx, method_idx) {
+            Some(data) => data,
+            None => {
+                log::debug!("    No P-Code (native compiled)");
+                return None;
+            }
+        };
+
+        if pcode_data.is_empty() {
+            log::debug!("    Empty P-Code data");
+            return None;
+        }
+
+        // Reuse the method's code if its P-Code is unchanged since it was cached
+        let cache_key =
+            cache.map(|_| DecompileCache::method_key(pcode_data, obj_name, method_name));
+        if let (Some(cache), Some(key), true) = (cache, cache_key, pipeline.reuses_cache()) {
+            if let Some((name, code)) = cache.load_method(key) {
+                log::debug!(
+                    "    Reusing cached code ({} bytes of P-Code)",
+                    pcode_data.len()
+                );
+                if let Some(stats) = stats {
+                    stats.record_cached(1);
+                }
+                return Some(MethodOutput {
+                    name,
+                    code,
+                    ir: None,
+                    refs: None,
+                });
+            }
+        }
+
+        log::debug!(
+            "    P-Code found ({} bytes), disassembling...",
+            pcode_data.len()
+        );
+
+        // Each thread borrows pooled buffers; only the final code is copied out
+        let function_name = format!("{}_{}", obj_name, method_name);
+        let start = Instant::now();
+        let (code, listing, refs) = scratch.with(|scratch| {
+            scratch.set_budget(budget);
+            scratch.set_fused(fused);
+            let code = scratch.decompile(pcode_data, &function_name)?.to_string();
+            if let Some(stats) = stats {
+                let metrics = scratch.metrics();
+                stats.record_method(
+                    obj_name,
+                    method_name,
+                    pcode_data.len(),
+                    code.len(),
+                    metrics,
+                    start,
+                );
+            }
+            let listing = ir.then(|| scratch.ir_listing().to_string());
+            Some((code, listing, index.then(|| scratch.references())))
+        })?;
+
+        log::debug!("    Successfully decompiled {}", function_name);
+
+        if let (Some(cache), Some(key)) = (cache, cache_key) {
+            cache.store_method(key, &function_name, &code);
+        }
+
+        Some(MethodOutput {
+            name: function_name,
+            code,
+            ir: listing,
+            refs,
+        })
+    }
+
+    /// [`Self::decompile_method`] for a native-code method
+    ///
+    /// Not cached per method: there is no P-Code to key the entry on.
+    fn decompile_native_method(
+        vb_file: &vb::VBFile,
+        native: &NativeImage,
+        pipeline: Pipeline<'_>,
+        obj_idx: usize,
+        method_idx: usize,
+        obj_name: &str,
+        method_name: &str,
+    ) -> Option<MethodOutput> {
+        let Some(entry) = vb_file.native_entry_for_method(obj_idx, method_idx) else {
+            log::debug!("    No entry point in the method table");
+            return None;
+        };
+        log::debug!("    Native code at 0x{:08X}, disassembling...", entry);
+
+        let function_name = format!("{}_{}", obj_name, method_name);
+        let data = vb_file.pe_file().data();
+        let start = Instant::now();
+        let (code, listing, refs) = pipeline.scratch.with(|scratch| {
+            scratch.set_budget(pipeline.budget);
+            let code = scratch
+                .decompile_native(native, data, entry, &function_name)?
+                .to_string();
+            if let Some(stats) = pipeline.stats {
+                let metrics = scratch.metrics();
+                stats.record_method(obj_name, method_name, 0, code.len(), metrics, start);
+            }
+            let listing = pipeline.ir.then(|| scratch.ir_listing().to_string());
+            Some((code, listing, pipeline.index.then(|| scratch.references())))
+        })?;
+
+        log::debug!("    Successfully decompiled {}", function_name);
+        Some(MethodOutput {
+            name: function_name,
+            code,
+            ir: listing,
+            refs,
+        })
+    }
+}
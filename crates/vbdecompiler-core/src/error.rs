@@ -42,6 +42,12 @@ pub enum Error {
 
     #[error("Unsupported: {0}")]
     Unsupported(String),
+
+    #[error("Decompilation cancelled")]
+    Cancelled,
+
+    #[error("Method budget exceeded: {0}")]
+    BudgetExceeded(String),
 }
 
 impl Error {
@@ -0,0 +1,199 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Incremental re-decompilation
+//!
+//! Two builds of the same application usually share almost all of their
+//! methods. Methods are identified by their object and method names (see
+//! [`MethodKey`]) and compared by a hash of their P-Code bytes, so unchanged
+//! methods are never disassembled, lifted or generated again:
+//! - [`Decompiler::decompile_incremental`] decompiles a build against the
+//!   [`Snapshot`] of an earlier one, reusing the code of unchanged methods.
+//! - [`Decompiler::diff_files`] compares two executables and decompiles only
+//!   the methods that differ, on both sides.
+//!
+//! Both report only added, changed and removed methods. A method that fails
+//! to decompile is still tracked by its hash, with no code, so a failure is
+//! never mistaken for a removal; it is decompiled again by the next build.
+//!
+//! [`Decompiler::decompile_incremental`]: crate::Decompiler::decompile_incremental
+//! [`Decompiler::diff_files`]: crate::Decompiler::diff_files
+
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+
+/// Identity of a method across builds: object name, method name, and the
+/// number of earlier methods of the object with the same name
+///
+/// The count tells apart procedures that share a name, such as the Get and
+/// Let of a property, without tying the key to positions in the method
+/// table that shift whenever a method is added.
+pub(crate) type MethodKey<'a> = (&'a str, &'a str, usize);
+
+/// Key each `(object name, method name)` pair in table order
+pub(crate) fn method_keys<'a>(
+    names: impl IntoIterator<Item = (&'a str, &'a str)>,
+) -> Vec<MethodKey<'a>> {
+    let mut seen: HashMap<(&str, &str), usize> = HashMap::new();
+    names
+        .into_iter()
+        .map(|(object, method)| {
+            let count = seen.entry((object, method)).or_default();
+            *count += 1;
+            (object, method, *count - 1)
+        })
+        .collect()
+}
+
+/// One method of a [`Snapshot`]
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct SnapshotMethod {
+    pub object_name: String,
+    pub method_name: String,
+    /// Content hash of the method's P-Code
+    pub pcode_hash: u64,
+    /// Generated function name
+    pub name: String,
+    /// Generated VB6 code, or `None` if the method failed to decompile
+    pub code: Option<String>,
+}
+
+/// Every P-Code method of one build, in object/method table order
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct Snapshot {
+    pub project_name: String,
+    pub methods: Vec<SnapshotMethod>,
+}
+
+impl Snapshot {
+    /// Look up a method by name (the first, if several share it)
+    pub fn find(&self, object_name: &str, method_name: &str) -> Option<&SnapshotMethod> {
+        self.methods
+            .iter()
+            .find(|m| m.object_name == object_name && m.method_name == method_name)
+    }
+
+    /// Methods keyed by [`MethodKey`]
+    pub(crate) fn index(&self) -> HashMap<MethodKey<'_>, &SnapshotMethod> {
+        let names = self
+            .methods
+            .iter()
+            .map(|m| (m.object_name.as_str(), m.method_name.as_str()));
+        method_keys(names).into_iter().zip(&self.methods).collect()
+    }
+}
+
+/// How a method differs between two builds
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum ChangeKind {
+    /// Only in the newer build
+    Added,
+    /// In both builds with different P-Code, or decompiled again after
+    /// failing in the baseline
+    Changed,
+    /// Only in the older build
+    Removed,
+}
+
+/// A method that was added, changed or removed
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct MethodChange {
+    pub kind: ChangeKind,
+    pub object_name: String,
+    pub method_name: String,
+    /// Code in the older build (`None` for added methods or if it failed to decompile)
+    pub old_code: Option<String>,
+    /// Code in the newer build (`None` for removed methods or if it failed to decompile)
+    pub new_code: Option<String>,
+}
+
+/// Result of [`Decompiler::decompile_incremental`](crate::Decompiler::decompile_incremental)
+#[derive(Debug, Clone)]
+pub struct IncrementalResult {
+    /// All methods of the new build, for use as the next baseline
+    pub snapshot: Snapshot,
+    /// Methods that differ from the baseline: new-build order, then removals
+    pub changes: Vec<MethodChange>,
+    /// Number of methods whose code was reused from the baseline
+    pub reused: usize,
+}
+
+/// Result of [`Decompiler::diff_files`](crate::Decompiler::diff_files)
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct BuildDiff {
+    pub old_project: String,
+    pub new_project: String,
+    /// Methods that differ: new-build order, then removals in old-build order
+    pub changes: Vec<MethodChange>,
+    /// Number of P-Code methods identical in both builds
+    pub unchanged: usize,
+}
+
+impl BuildDiff {
+    /// Number of changes of the given kind
+    pub fn count(&self, kind: ChangeKind) -> usize {
+        self.changes.iter().filter(|c| c.kind == kind).count()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn method(object: &str, method: &str, hash: u64) -> SnapshotMethod {
+        SnapshotMethod {
+            object_name: object.to_string(),
+            method_name: method.to_string(),
+            pcode_hash: hash,
+            name: format!("{}_{}", object, method),
+            code: None,
+        }
+    }
+
+    #[test]
+    fn test_snapshot_lookup() {
+        let snapshot = Snapshot {
+            project_name: "Project1".to_string(),
+            methods: vec![method("Form1", "Load", 1), method("Module1", "Main", 2)],
+        };
+
+        assert_eq!(snapshot.find("Module1", "Main").unwrap().pcode_hash, 2);
+        assert!(snapshot.find("Form1", "Main").is_none());
+        assert_eq!(snapshot.index()[&("Form1", "Load", 0)].pcode_hash, 1);
+    }
+
+    #[test]
+    fn test_method_keys_number_shared_names() {
+        let snapshot = Snapshot {
+            project_name: "Project1".to_string(),
+            methods: vec![
+                method("Class1", "Value", 1),
+                method("Class1", "Init", 2),
+                method("Class1", "Value", 3),
+                method("Class2", "Value", 4),
+            ],
+        };
+
+        let index = snapshot.index();
+        assert_eq!(index.len(), 4);
+        assert_eq!(index[&("Class1", "Value", 0)].pcode_hash, 1);
+        assert_eq!(index[&("Class1", "Value", 1)].pcode_hash, 3);
+        assert_eq!(index[&("Class2", "Value", 0)].pcode_hash, 4);
+    }
+
+    #[test]
+    fn test_snapshot_method_code_is_optional() {
+        let json =
+            r#"{"object_name":"Form1","method_name":"Load","pcode_hash":1,"name":"Form1_Load"}"#;
+        let failed: SnapshotMethod = serde_json::from_str(json).unwrap();
+        assert_eq!(failed.code, None);
+    }
+
+    #[test]
+    fn test_change_kind_serializes_lowercase() {
+        let json = serde_json::to_string(&ChangeKind::Changed).unwrap();
+        assert_eq!(json, "\"changed\"");
+    }
+}
@@ -0,0 +1,573 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Cross-method index of calls, string constants and symbols
+//!
+//! While a method is still lifted in its scratch arena, [`collect`] records
+//! the names it calls and the string literals it uses into a [`MethodRefs`].
+//! An [`IndexBuilder`] then merges every method's references with the object
+//! and method names of the VB object table into a [`SymbolIndex`]: two sorted
+//! string tables plus sorted edge lists, so "who calls X", "what does X
+//! call" and "which methods use string Y" are binary searches instead of
+//! scans of the generated code.
+//!
+//! Symbols compare ASCII case-insensitively, as VB identifiers do; string
+//! constants compare exactly.
+
+use crate::ir::arena::{ArenaFunction, Constant, ExprData, ExprId, Stmt};
+use std::cmp::Ordering;
+use std::ops::Range;
+
+/// Strings packed end to end into one buffer
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct StringList {
+    text: String,
+    /// End offset of each string in `text`
+    ends: Vec<u32>,
+}
+
+impl StringList {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn push(&mut self, s: &str) {
+        self.text.push_str(s);
+        self.ends.push(self.text.len() as u32);
+    }
+
+    pub fn get(&self, index: usize) -> Option<&str> {
+        let end = *self.ends.get(index)? as usize;
+        let start = match index {
+            0 => 0,
+            _ => self.ends[index - 1] as usize,
+        };
+        Some(&self.text[start..end])
+    }
+
+    pub fn len(&self) -> usize {
+        self.ends.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.ends.is_empty()
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = &str> + '_ {
+        (0..self.len()).filter_map(move |i| self.get(i))
+    }
+
+    pub fn clear(&mut self) {
+        self.text.clear();
+        self.ends.clear();
+    }
+
+    /// Copy of the strings at `order`, in that order
+    fn permuted(&self, order: &[u32]) -> Self {
+        let mut sorted = Self {
+            text: String::with_capacity(self.text.len()),
+            ends: Vec::with_capacity(order.len()),
+        };
+        for &i in order {
+            sorted.push(self.get(i as usize).unwrap_or_default());
+        }
+        sorted
+    }
+}
+
+/// Names called and string constants used by one method, in lifting order
+///
+/// May contain duplicates; the [`IndexBuilder`] removes them.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct MethodRefs {
+    pub calls: StringList,
+    pub strings: StringList,
+}
+
+impl MethodRefs {
+    pub fn clear(&mut self) {
+        self.calls.clear();
+        self.strings.clear();
+    }
+}
+
+/// Record the call targets and string constants of `function` into `refs`
+///
+/// Only expressions reachable from a statement are visited, so operands the
+/// lifter discarded are not reported.
+pub fn collect(function: &ArenaFunction, refs: &mut MethodRefs) {
+    refs.clear();
+    let mut pending: Vec<ExprId> = Vec::new();
+
+    for block in function.blocks() {
+        for stmt in &block.statements {
+            match *stmt {
+                Stmt::Assign { value, .. } => pending.push(value),
+                Stmt::Store { address, value } => pending.extend([address, value]),
+                Stmt::Call {
+                    function: name,
+                    arguments,
+                } => {
+                    refs.calls.push(function.name(name));
+                    pending.extend_from_slice(function.list(arguments));
+                }
+                Stmt::Return { value } => pending.extend(value),
+                Stmt::Branch { condition, .. } => pending.push(condition),
+                Stmt::Nop | Stmt::Goto { .. } | Stmt::Label { .. } => {}
+            }
+
+            while let Some(id) = pending.pop() {
+                match function.expr(id).data {
+                    ExprData::Constant(Constant::String(s)) => {
+                        refs.strings.push(function.name(s));
+                    }
+                    ExprData::Call {
+                        function: name,
+                        arguments,
+                    } => {
+                        refs.calls.push(function.name(name));
+                        pending.extend_from_slice(function.list(arguments));
+                    }
+                    ExprData::Unary(operand) => pending.push(operand),
+                    ExprData::Binary { left, right } => pending.extend([left, right]),
+                    ExprData::MemberAccess { object, .. } => pending.push(object),
+                    ExprData::ArrayIndex { array, indices } => {
+                        pending.push(array);
+                        pending.extend_from_slice(function.list(indices));
+                    }
+                    ExprData::Cast { expr, .. } => pending.push(expr),
+                    ExprData::None | ExprData::Constant(_) | ExprData::Variable(_) => {}
+                }
+            }
+        }
+    }
+}
+
+/// What a symbol names; a name seen in several roles takes the greatest
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub enum SymbolKind {
+    /// Only ever called: a runtime function, API import or unresolved target
+    #[default]
+    External,
+    /// A generated method (`Object_Method`)
+    Method,
+    /// An entry of the VB object table
+    Object,
+}
+
+/// Symbol ids are positions in [`SymbolIndex::symbols`]; string ids are
+/// positions in [`SymbolIndex::strings`]
+pub type SymbolId = u32;
+pub type StringId = u32;
+
+/// Accumulates names and references, then sorts them into a [`SymbolIndex`]
+#[derive(Debug, Default)]
+pub struct IndexBuilder {
+    symbols: StringList,
+    kinds: Vec<SymbolKind>,
+    strings: StringList,
+    /// (caller, callee) as positions in `symbols`
+    calls: Vec<(u32, u32)>,
+    /// (string in `strings`, method in `symbols`)
+    uses: Vec<(u32, u32)>,
+}
+
+impl IndexBuilder {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn add_object(&mut self, name: &str) {
+        self.add_symbol(name, SymbolKind::Object);
+    }
+
+    /// Add a method, with the references collected while it was lifted if
+    /// it was decompiled
+    pub fn add_method(&mut self, name: &str, refs: Option<&MethodRefs>) {
+        let method = self.add_symbol(name, SymbolKind::Method);
+        let Some(refs) = refs else { return };
+
+        for callee in refs.calls.iter() {
+            let callee = self.add_symbol(callee, SymbolKind::External);
+            self.calls.push((method, callee));
+        }
+        for s in refs.strings.iter() {
+            self.uses.push((self.strings.len() as u32, method));
+            self.strings.push(s);
+        }
+    }
+
+    fn add_symbol(&mut self, name: &str, kind: SymbolKind) -> u32 {
+        self.symbols.push(name);
+        self.kinds.push(kind);
+        (self.symbols.len() - 1) as u32
+    }
+
+    /// Sort and deduplicate everything added
+    pub fn finish(self) -> SymbolIndex {
+        let (symbols, symbol_ids) = sort_unique(&self.symbols, symbol_order);
+        let mut kinds = vec![SymbolKind::External; symbols.len()];
+        for (position, &kind) in self.kinds.iter().enumerate() {
+            let kind_of = &mut kinds[symbol_ids[position] as usize];
+            *kind_of = (*kind_of).max(kind);
+        }
+
+        let (strings, string_ids) = sort_unique(&self.strings, str::cmp);
+
+        let calls = edges(&self.calls, |(caller, callee)| {
+            (symbol_ids[caller as usize], symbol_ids[callee as usize])
+        });
+        let uses = edges(&self.uses, |(string, method)| {
+            (string_ids[string as usize], symbol_ids[method as usize])
+        });
+
+        SymbolIndex {
+            symbols,
+            kinds,
+            strings,
+            callers: edges(&calls, |(caller, callee)| (callee, caller)),
+            calls,
+            strings_used: edges(&uses, |(string, method)| (method, string)),
+            uses,
+        }
+    }
+}
+
+/// Sort `list` by `order`, merging strings it considers equal
+///
+/// Returns the unique strings and the new position of every original string.
+fn sort_unique(
+    list: &StringList,
+    order: impl Fn(&str, &str) -> Ordering,
+) -> (StringList, Vec<u32>) {
+    let get = |i: u32| list.get(i as usize).unwrap_or_default();
+    let mut sorted: Vec<u32> = (0..list.len() as u32).collect();
+    // Stable, so the first spelling of a case-folded symbol is kept
+    sorted.sort_by(|&a, &b| order(get(a), get(b)));
+
+    let mut ids = vec![0; list.len()];
+    let mut unique: Vec<u32> = Vec::with_capacity(sorted.len());
+    for &i in &sorted {
+        match unique.last() {
+            Some(&last) if order(get(last), get(i)) == Ordering::Equal => {}
+            _ => unique.push(i),
+        }
+        ids[i as usize] = (unique.len() - 1) as u32;
+    }
+
+    (list.permuted(&unique), ids)
+}
+
+/// Map, sort and deduplicate an edge list
+fn edges(list: &[(u32, u32)], map: impl Fn((u32, u32)) -> (u32, u32)) -> Vec<(u32, u32)> {
+    let mut mapped: Vec<(u32, u32)> = list.iter().map(|&edge| map(edge)).collect();
+    mapped.sort_unstable();
+    mapped.dedup();
+    mapped
+}
+
+/// ASCII case-insensitive order of VB identifiers
+fn symbol_order(a: &str, b: &str) -> Ordering {
+    fold(a).cmp(fold(b))
+}
+
+fn fold(s: &str) -> impl Iterator<Item = u8> + '_ {
+    s.bytes().map(|b| b.to_ascii_lowercase())
+}
+
+/// Targets of the edges leaving `from` in an edge list sorted by source
+fn targets(edges: &[(u32, u32)], from: u32) -> impl Iterator<Item = u32> + '_ {
+    let start = edges.partition_point(|&(source, _)| source < from);
+    edges[start..]
+        .iter()
+        .take_while(move |&&(source, _)| source == from)
+        .map(|&(_, target)| target)
+}
+
+/// Compact, immutable call graph, string table and symbol table of a program
+///
+/// Built by [`Decompiler::set_build_index`](crate::Decompiler::set_build_index)
+/// during decompilation. Every edge is stored twice, sorted by each end, so
+/// both directions are a binary search.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct SymbolIndex {
+    /// Sorted by [`symbol_order`]
+    symbols: StringList,
+    kinds: Vec<SymbolKind>,
+    /// Sorted bytewise
+    strings: StringList,
+    /// (caller, callee)
+    calls: Vec<(SymbolId, SymbolId)>,
+    /// (callee, caller)
+    callers: Vec<(SymbolId, SymbolId)>,
+    /// (string, method)
+    uses: Vec<(StringId, SymbolId)>,
+    /// (method, string)
+    strings_used: Vec<(SymbolId, StringId)>,
+}
+
+impl SymbolIndex {
+    /// All symbols, in case-insensitive order
+    pub fn symbols(&self) -> &StringList {
+        &self.symbols
+    }
+
+    pub fn symbol(&self, id: SymbolId) -> Option<&str> {
+        self.symbols.get(id as usize)
+    }
+
+    pub fn kind(&self, id: SymbolId) -> Option<SymbolKind> {
+        self.kinds.get(id as usize).copied()
+    }
+
+    /// Id of the symbol spelled `name`, ignoring ASCII case
+    pub fn lookup(&self, name: &str) -> Option<SymbolId> {
+        let range = self.symbols_between(|s| symbol_order(s, name) != Ordering::Greater, name);
+        (!range.is_empty()).then_some(range.start)
+    }
+
+    /// Ids of the symbols starting with `prefix`, ignoring ASCII case
+    pub fn find_symbols(&self, prefix: &str) -> Range<SymbolId> {
+        self.symbols_between(
+            |s| {
+                symbol_order(s, prefix) == Ordering::Less
+                    || s.as_bytes()
+                        .get(..prefix.len())
+                        .map_or(false, |head| head.eq_ignore_ascii_case(prefix.as_bytes()))
+            },
+            prefix,
+        )
+    }
+
+    /// The symbols from the first not ordered before `key` up to the first
+    /// for which `through` is false
+    fn symbols_between(&self, through: impl Fn(&str) -> bool, key: &str) -> Range<SymbolId> {
+        let get = |i: u32| self.symbols.get(i as usize).unwrap_or_default();
+        let count = self.symbols.len();
+        let start = partition_point(count, |i| symbol_order(get(i), key) == Ordering::Less);
+        let end = partition_point(count, |i| through(get(i)));
+        start as SymbolId..end.max(start) as SymbolId
+    }
+
+    /// Symbols called by method `caller`, in id order
+    pub fn callees(&self, caller: SymbolId) -> impl Iterator<Item = SymbolId> + '_ {
+        targets(&self.calls, caller)
+    }
+
+    /// Methods calling `callee`, in id order
+    pub fn callers(&self, callee: SymbolId) -> impl Iterator<Item = SymbolId> + '_ {
+        targets(&self.callers, callee)
+    }
+
+    /// Number of caller → callee edges
+    pub fn call_count(&self) -> usize {
+        self.calls.len()
+    }
+
+    /// All distinct string constants, in byte order
+    pub fn strings(&self) -> &StringList {
+        &self.strings
+    }
+
+    pub fn string(&self, id: StringId) -> Option<&str> {
+        self.strings.get(id as usize)
+    }
+
+    /// Id of the string constant equal to `s`
+    pub fn lookup_string(&self, s: &str) -> Option<StringId> {
+        let count = self.strings.len();
+        let at = partition_point(count, |i| {
+            self.strings.get(i as usize).unwrap_or_default() < s
+        });
+        (self.strings.get(at) == Some(s)).then_some(at as StringId)
+    }
+
+    /// Ids of the string constants containing `needle`, in id order
+    ///
+    /// A scan of the distinct strings, which are far fewer and shorter than
+    /// the generated code.
+    pub fn find_strings<'i>(
+        &'i self,
+        needle: &'i str,
+        ignore_case: bool,
+    ) -> impl Iterator<Item = StringId> + 'i {
+        self.strings
+            .iter()
+            .enumerate()
+            .filter(move |(_, s)| match ignore_case {
+                false => s.contains(needle),
+                true => contains_ignore_ascii_case(s, needle),
+            })
+            .map(|(id, _)| id as StringId)
+    }
+
+    /// Methods using string constant `id`, in id order
+    pub fn string_users(&self, id: StringId) -> impl Iterator<Item = SymbolId> + '_ {
+        targets(&self.uses, id)
+    }
+
+    /// String constants used by method `method`, in id order
+    pub fn strings_of(&self, method: SymbolId) -> impl Iterator<Item = StringId> + '_ {
+        targets(&self.strings_used, method)
+    }
+}
+
+/// First index in `0..len` for which `pred` is false; `pred` must be
+/// true for a prefix of the range
+fn partition_point(len: usize, pred: impl Fn(u32) -> bool) -> usize {
+    let (mut low, mut high) = (0, len);
+    while low < high {
+        let mid = low + (high - low) / 2;
+        if pred(mid as u32) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    low
+}
+
+fn contains_ignore_ascii_case(haystack: &str, needle: &str) -> bool {
+    needle.is_empty()
+        || haystack
+            .as_bytes()
+            .windows(needle.len())
+            .any(|window| window.eq_ignore_ascii_case(needle.as_bytes()))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ir::TypeKind;
+
+    fn refs(calls: &[&str], strings: &[&str]) -> MethodRefs {
+        let mut refs = MethodRefs::default();
+        calls.iter().for_each(|name| refs.calls.push(name));
+        strings.iter().for_each(|s| refs.strings.push(s));
+        refs
+    }
+
+    fn sample() -> SymbolIndex {
+        let mut builder = IndexBuilder::new();
+        builder.add_object("Form1");
+        builder.add_method(
+            "Form1_Load",
+            Some(&refs(&["MsgBox", "Form1_Helper"], &["Hello"])),
+        );
+        builder.add_method(
+            "Form1_Helper",
+            Some(&refs(
+                &["msgbox", "__vbaStrCopy", "MsgBox"],
+                &["Hello", "World"],
+            )),
+        );
+        builder.add_method("Form1_Unload", None);
+        builder.finish()
+    }
+
+    fn names<'i>(index: &'i SymbolIndex, ids: impl Iterator<Item = SymbolId>) -> Vec<&'i str> {
+        ids.map(|id| index.symbol(id).unwrap()).collect()
+    }
+
+    #[test]
+    fn test_collect_calls_and_strings() {
+        let mut function = ArenaFunction::new("f".to_string(), TypeKind::Void);
+        let hello = function.string_const("Hello");
+        let args = function.push_list(&[hello]);
+        let len = function.intern("Len");
+        let call = function.call(len, args, TypeKind::Long);
+        let print = function.intern("Print");
+        let print_args = function.push_list(&[call]);
+        let block = function.block_mut(0).unwrap();
+        block.statements.push(Stmt::Call {
+            function: print,
+            arguments: print_args,
+        });
+
+        let mut collected = MethodRefs::default();
+        collect(&function, &mut collected);
+        assert_eq!(collected.calls.iter().collect::<Vec<_>>(), ["Print", "Len"]);
+        assert_eq!(collected.strings.iter().collect::<Vec<_>>(), ["Hello"]);
+    }
+
+    #[test]
+    fn test_symbols_merge_case_insensitively() {
+        let index = sample();
+        assert_eq!(
+            index.symbols().iter().collect::<Vec<_>>(),
+            [
+                "__vbaStrCopy",
+                "Form1",
+                "Form1_Helper",
+                "Form1_Load",
+                "Form1_Unload",
+                "MsgBox"
+            ]
+        );
+        let msgbox = index.lookup("MSGBOX").unwrap();
+        assert_eq!(index.symbol(msgbox), Some("MsgBox"));
+        assert_eq!(index.kind(msgbox), Some(SymbolKind::External));
+        let helper = index.lookup("form1_helper").unwrap();
+        assert_eq!(index.kind(helper), Some(SymbolKind::Method));
+        assert_eq!(index.lookup("Form1_Missing"), None);
+    }
+
+    #[test]
+    fn test_call_graph_both_directions() {
+        let index = sample();
+        let msgbox = index.lookup("MsgBox").unwrap();
+        assert_eq!(
+            names(&index, index.callers(msgbox)),
+            ["Form1_Helper", "Form1_Load"]
+        );
+
+        let helper = index.lookup("Form1_Helper").unwrap();
+        assert_eq!(names(&index, index.callers(helper)), ["Form1_Load"]);
+        assert_eq!(
+            names(&index, index.callees(helper)),
+            ["__vbaStrCopy", "MsgBox"]
+        );
+        assert_eq!(index.call_count(), 4);
+
+        let unload = index.lookup("Form1_Unload").unwrap();
+        assert_eq!(index.callees(unload).count(), 0);
+    }
+
+    #[test]
+    fn test_find_symbols_by_prefix() {
+        let index = sample();
+        assert_eq!(
+            names(&index, index.find_symbols("form1_")),
+            ["Form1_Helper", "Form1_Load", "Form1_Unload"]
+        );
+        assert_eq!(index.find_symbols("").len(), index.symbols().len());
+        assert!(index.find_symbols("Zz").is_empty());
+    }
+
+    #[test]
+    fn test_string_table() {
+        let index = sample();
+        assert_eq!(
+            index.strings().iter().collect::<Vec<_>>(),
+            ["Hello", "World"]
+        );
+
+        let hello = index.lookup_string("Hello").unwrap();
+        assert_eq!(
+            names(&index, index.string_users(hello)),
+            ["Form1_Helper", "Form1_Load"]
+        );
+        assert_eq!(index.lookup_string("hello"), None);
+
+        assert_eq!(index.find_strings("orl", false).collect::<Vec<_>>(), [1]);
+        assert_eq!(index.find_strings("HELLO", false).count(), 0);
+        assert_eq!(
+            index.find_strings("HELLO", true).collect::<Vec<_>>(),
+            [hello]
+        );
+
+        let load = index.lookup("Form1_Load").unwrap();
+        assert_eq!(index.strings_of(load).collect::<Vec<_>>(), [hello]);
+    }
+}
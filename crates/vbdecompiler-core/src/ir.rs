@@ -9,6 +9,9 @@
 //! - Expressions (operations, variables, constants)
 //! - Statements (assignments, calls, control flow)
 //! - Basic blocks and functions
+//! - A flat, index-based per-function form used by the lifter ([`arena`])
+
+pub mod arena;
 
 use std::fmt;
 
@@ -349,18 +352,27 @@ impl Expression {
     }
 
     /// Convert expression to VB6 source code string (simplified)
+    ///
+    /// Prefer formatting with `{}` into an existing buffer; the `Display`
+    /// impl writes nested expressions without intermediate strings.
     pub fn to_vb_string(&self) -> String {
+        self.to_string()
+    }
+}
+
+impl fmt::Display for Expression {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         match &self.data {
-            ExpressionData::None => String::from(""),
-            ExpressionData::Constant(val) => format!("{}", val),
-            ExpressionData::Variable(var) => format!("{}", var),
+            ExpressionData::None => Ok(()),
+            ExpressionData::Constant(val) => write!(f, "{}", val),
+            ExpressionData::Variable(var) => write!(f, "{}", var),
             ExpressionData::Unary(expr) => {
                 let op = match self.kind {
                     ExpressionKind::Negate => "-",
                     ExpressionKind::Not => "Not ",
                     _ => "",
                 };
-                format!("{}{}", op, expr.to_vb_string())
+                write!(f, "{}{}", op, expr)
             }
             ExpressionData::Binary { left, right } => {
                 let op = match self.kind {
@@ -382,37 +394,42 @@ impl Expression {
                     ExpressionKind::Concatenate => " & ",
                     _ => " ? ",
                 };
-                format!("({}{}{})", left.to_vb_string(), op, right.to_vb_string())
+                write!(f, "({}{}{})", left, op, right)
             }
             ExpressionData::Call {
                 function,
                 arguments,
             } => {
-                let args = arguments
-                    .iter()
-                    .map(|a| a.to_vb_string())
-                    .collect::<Vec<_>>()
-                    .join(", ");
-                format!("{}({})", function, args)
+                write!(f, "{}(", function)?;
+                write_list(f, arguments)?;
+                f.write_str(")")
             }
             ExpressionData::MemberAccess { object, member } => {
-                format!("{}.{}", object.to_vb_string(), member)
+                write!(f, "{}.{}", object, member)
             }
             ExpressionData::ArrayIndex { array, indices } => {
-                let idx = indices
-                    .iter()
-                    .map(|i| i.to_vb_string())
-                    .collect::<Vec<_>>()
-                    .join(", ");
-                format!("{}({})", array.to_vb_string(), idx)
+                write!(f, "{}(", array)?;
+                write_list(f, indices)?;
+                f.write_str(")")
             }
             ExpressionData::Cast { expr, target_type } => {
-                format!("CType({}, {})", expr.to_vb_string(), target_type)
+                write!(f, "CType({}, {})", expr, target_type)
             }
         }
     }
 }
 
+/// Write `items` separated by ", "
+fn write_list(f: &mut fmt::Formatter<'_>, items: &[Expression]) -> fmt::Result {
+    for (i, item) in items.iter().enumerate() {
+        if i > 0 {
+            f.write_str(", ")?;
+        }
+        write!(f, "{}", item)?;
+    }
+    Ok(())
+}
+
 /// Statement Kind - Types of IR statements
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum StatementKind {
@@ -529,52 +546,40 @@ impl Statement {
 
     /// Convert statement to VB6 source code string (simplified)
     pub fn to_vb_string(&self) -> String {
+        self.to_string()
+    }
+}
+
+impl fmt::Display for Statement {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         match &self.data {
-            StatementData::None => String::from("' NOP"),
-            StatementData::Assign { target, value } => {
-                format!("{} = {}", target, value.to_vb_string())
-            }
-            StatementData::Store { address, value } => {
-                format!("[{}] = {}", address.to_vb_string(), value.to_vb_string())
-            }
+            StatementData::None => f.write_str("' NOP"),
+            StatementData::Assign { target, value } => write!(f, "{} = {}", target, value),
+            StatementData::Store { address, value } => write!(f, "[{}] = {}", address, value),
             StatementData::Call {
                 function,
                 arguments,
             } => {
-                let args = arguments
-                    .iter()
-                    .map(|a| a.to_vb_string())
-                    .collect::<Vec<_>>()
-                    .join(", ");
-                if args.is_empty() {
-                    format!("{}", function)
-                } else {
-                    format!("{} {}", function, args)
+                f.write_str(function)?;
+                if !arguments.is_empty() {
+                    f.write_str(" ")?;
+                    write_list(f, arguments)?;
                 }
+                Ok(())
             }
             StatementData::Return { value } => {
                 if let Some(v) = value {
-                    format!("Return {}", v.to_vb_string())
+                    write!(f, "Return {}", v)
                 } else {
-                    String::from("Exit Sub")
+                    f.write_str("Exit Sub")
                 }
             }
             StatementData::Branch {
                 condition,
                 target_block,
-            } => {
-                format!(
-                    "If {} Then Goto Block{}",
-                    condition.to_vb_string(),
-                    target_block
-                )
-            }
-            StatementData::Goto { target_block } => {
-                format!("Goto Block{}", target_block)
-            }
-            StatementData::Label { label_id } => {
-                format!("Label{}:", label_id)
-            }
+            } => write!(f, "If {} Then Goto Block{}", condition, target_block),
+            StatementData::Goto { target_block } => write!(f, "Goto Block{}", target_block),
+            StatementData::Label { label_id } => write!(f, "Label{}:", label_id),
         }
     }
 }
@@ -659,6 +664,33 @@ impl Function {
     }
 }
 
+/// IR listing: signature and locals, then each block's statements under a label
+impl fmt::Display for Function {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "Function {}(", self.name)?;
+        for (i, param) in self.parameters.iter().enumerate() {
+            let separator = if i == 0 { "" } else { ", " };
+            write!(f, "{}{} As {}", separator, param, param.var_type)?;
+        }
+        writeln!(f, ") As {}", self.return_type)?;
+        for local in &self.local_variables {
+            writeln!(f, "    Dim {} As {}", local, local.var_type)?;
+        }
+
+        for block in &self.basic_blocks {
+            write!(f, "Block{}:", block.id)?;
+            if block.id == self.entry_block_id {
+                write!(f, " ; entry")?;
+            }
+            writeln!(f)?;
+            for statement in &block.statements {
+                writeln!(f, "    {}", statement)?;
+            }
+        }
+        Ok(())
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -694,4 +726,19 @@ mod tests {
         assert_eq!(stmt.kind, StatementKind::Assign);
         assert_eq!(stmt.to_vb_string(), "x = 10");
     }
+
+    #[test]
+    fn test_function_listing() {
+        let mut function = Function::new("Form1_Load".to_string(), Type::new(TypeKind::Void));
+        function.add_parameter(Variable::new(0, "a".to_string(), TypeKind::Integer));
+        let mut block = BasicBlock::new(0);
+        let x = Variable::new(1, "x".to_string(), TypeKind::Integer);
+        block.add_statement(Statement::assign(x, Expression::int_const(10)));
+        function.add_basic_block(block);
+
+        assert_eq!(
+            function.to_string(),
+            "Function Form1_Load(a As Integer) As Void\nBlock0: ; entry\n    x = 10\n"
+        );
+    }
 }
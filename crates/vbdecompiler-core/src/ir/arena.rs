@@ -0,0 +1,665 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Arena-backed IR for a single function
+//!
+//! The tree IR in [`crate::ir`] boxes every sub-expression and owns a `String`
+//! per name, so lifting a large method spends most of its time allocating and
+//! dropping nodes. [`ArenaFunction`] stores the same information flat:
+//!
+//! - Expressions live in one `Vec` and refer to each other by [`ExprId`]
+//! - Argument and index lists are ranges into one shared `Vec<ExprId>`
+//! - Names are interned once per function; names and string literals share
+//!   one text buffer ([`NameId`])
+//! - Blocks live in a dense `Vec` indexed by block id
+//!
+//! All node types are `Copy`; walking the arena never allocates.
+//! [`ArenaFunction::to_function`] converts to the tree IR for callers that
+//! still want it.
+
+use std::collections::HashMap;
+use std::fmt::{self, Write};
+
+use crate::cache;
+
+use super::{
+    BasicBlock, ConstantValue, Expression, ExpressionData, ExpressionKind, Function, Statement,
+    StatementData, StatementKind, Type, TypeKind, Variable,
+};
+
+/// Index of an expression in its function's expression arena
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct ExprId(u32);
+
+/// Index of an interned name or string literal
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct NameId(u32);
+
+/// A contiguous run of expression ids (call arguments, array indices)
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ExprList {
+    start: u32,
+    len: u32,
+}
+
+impl ExprList {
+    pub fn len(&self) -> usize {
+        self.len as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+}
+
+/// String storage for names and literals
+///
+/// All text lives in one buffer and ids are spans into it. Names go through
+/// [`Interner::intern`], which stores each distinct name once; literals go
+/// through [`Interner::push`], which skips the lookup since they rarely repeat.
+/// [`Interner::intern_fmt`] formats into a reused buffer, and the index is
+/// keyed by a hash of the text rather than a copy of it, so neither interning
+/// nor [`Interner::clear`] followed by re-use allocates once the buffers have
+/// grown.
+#[derive(Debug, Clone, Default)]
+pub struct Interner {
+    text: String,
+    spans: Vec<(u32, u32)>,
+    /// Content hash of each distinct name → its id
+    index: HashMap<u64, NameId>,
+    scratch: String,
+}
+
+impl Interner {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Intern `s`, returning the id of the existing copy if there is one
+    pub fn intern(&mut self, s: &str) -> NameId {
+        let hash = cache::content_hash(s.as_bytes());
+        match self.index.get(&hash) {
+            Some(&id) if self.resolve(id) == s => id,
+            // A hash collision only costs deduplication of the second name
+            Some(_) => self.push(s),
+            None => {
+                let id = self.push(s);
+                self.index.insert(hash, id);
+                id
+            }
+        }
+    }
+
+    /// Intern the formatted `args` (e.g. `format_args!("local{}", n)`)
+    pub fn intern_fmt(&mut self, args: fmt::Arguments<'_>) -> NameId {
+        let mut scratch = std::mem::take(&mut self.scratch);
+        scratch.clear();
+        let _ = scratch.write_fmt(args);
+        let id = self.intern(&scratch);
+        self.scratch = scratch;
+        id
+    }
+
+    /// Store `s` without deduplicating it
+    pub fn push(&mut self, s: &str) -> NameId {
+        let start = self.text.len() as u32;
+        self.text.push_str(s);
+        self.spans.push((start, s.len() as u32));
+        NameId((self.spans.len() - 1) as u32)
+    }
+
+    /// Look up a stored string
+    pub fn resolve(&self, id: NameId) -> &str {
+        let (start, len) = self.spans[id.0 as usize];
+        &self.text[start as usize..(start + len) as usize]
+    }
+
+    /// Remove all strings, keeping the allocated buffers
+    pub fn clear(&mut self) {
+        self.text.clear();
+        self.spans.clear();
+        self.index.clear();
+    }
+
+    pub fn len(&self) -> usize {
+        self.spans.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.spans.is_empty()
+    }
+
+    /// Heap bytes held by the buffers, used or not
+    pub fn allocated_bytes(&self) -> usize {
+        self.text.capacity()
+            + self.scratch.capacity()
+            + self.spans.capacity() * std::mem::size_of::<(u32, u32)>()
+            + self.index.capacity() * std::mem::size_of::<(u64, NameId)>()
+    }
+}
+
+/// Constant value with string literals interned
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Constant {
+    Integer(i64),
+    Float(f64),
+    String(NameId),
+    Boolean(bool),
+}
+
+/// Variable reference with an interned name
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct VarRef {
+    pub id: u32,
+    pub name: NameId,
+    pub var_type: TypeKind,
+}
+
+/// Expression payload; children are ids into the same arena
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ExprData {
+    None,
+    Constant(Constant),
+    Variable(VarRef),
+    Unary(ExprId),
+    Binary {
+        left: ExprId,
+        right: ExprId,
+    },
+    Call {
+        function: NameId,
+        arguments: ExprList,
+    },
+    MemberAccess {
+        object: ExprId,
+        member: NameId,
+    },
+    ArrayIndex {
+        array: ExprId,
+        indices: ExprList,
+    },
+    Cast {
+        expr: ExprId,
+        target_type: TypeKind,
+    },
+}
+
+/// Arena expression node
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct ExprNode {
+    pub kind: ExpressionKind,
+    pub expr_type: TypeKind,
+    pub data: ExprData,
+}
+
+/// Arena statement
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Stmt {
+    Nop,
+    Assign {
+        target: VarRef,
+        value: ExprId,
+    },
+    Store {
+        address: ExprId,
+        value: ExprId,
+    },
+    Call {
+        function: NameId,
+        arguments: ExprList,
+    },
+    Return {
+        value: Option<ExprId>,
+    },
+    Branch {
+        condition: ExprId,
+        target_block: u32,
+    },
+    Goto {
+        target_block: u32,
+    },
+    Label {
+        label_id: u32,
+    },
+}
+
+/// Arena basic block; its id is its index in [`ArenaFunction::blocks`]
+#[derive(Debug, Clone, Default)]
+pub struct Block {
+    pub statements: Vec<Stmt>,
+    pub successors: Vec<u32>,
+    pub predecessors: Vec<u32>,
+}
+
+impl Block {
+    pub fn add_successor(&mut self, block_id: u32) {
+        if !self.successors.contains(&block_id) {
+            self.successors.push(block_id);
+        }
+    }
+
+    pub fn add_predecessor(&mut self, block_id: u32) {
+        if !self.predecessors.contains(&block_id) {
+            self.predecessors.push(block_id);
+        }
+    }
+}
+
+/// A function whose expressions, names and blocks are stored in flat arenas
+#[derive(Debug, Clone)]
+pub struct ArenaFunction {
+    pub name: String,
+    pub return_type: TypeKind,
+    pub parameters: Vec<VarRef>,
+    pub local_variables: Vec<VarRef>,
+    pub entry_block_id: u32,
+    names: Interner,
+    exprs: Vec<ExprNode>,
+    lists: Vec<ExprId>,
+    /// Block storage; only the first `live_blocks` are part of the function,
+    /// the rest are kept from before a [`reset`](Self::reset) for re-use
+    blocks: Vec<Block>,
+    live_blocks: usize,
+}
+
+impl ArenaFunction {
+    /// Create a function containing only the (empty) entry block 0
+    pub fn new(name: String, return_type: TypeKind) -> Self {
+        Self {
+            name,
+            return_type,
+            parameters: Vec::new(),
+            local_variables: Vec::new(),
+            entry_block_id: 0,
+            names: Interner::new(),
+            exprs: Vec::new(),
+            lists: Vec::new(),
+            blocks: vec![Block::default()],
+            live_blocks: 1,
+        }
+    }
+
+    /// Create a function with room for roughly `instructions` P-Code
+    /// instructions' worth of expressions
+    pub fn with_capacity(name: String, return_type: TypeKind, instructions: usize) -> Self {
+        let mut function = Self::new(name, return_type);
+        function.exprs.reserve(instructions);
+        function
+    }
+
+    /// Empty the function back to a lone entry block, keeping every buffer
+    ///
+    /// Lets one function be lifted into repeatedly without reallocating its
+    /// arenas, interner or blocks.
+    pub fn reset(&mut self, name: &str, return_type: TypeKind) {
+        self.name.clear();
+        self.name.push_str(name);
+        self.return_type = return_type;
+        self.parameters.clear();
+        self.local_variables.clear();
+        self.entry_block_id = 0;
+        self.names.clear();
+        self.exprs.clear();
+        self.lists.clear();
+        for block in &mut self.blocks[..self.live_blocks] {
+            block.statements.clear();
+            block.successors.clear();
+            block.predecessors.clear();
+        }
+        self.live_blocks = 1;
+    }
+
+    /// Heap bytes held by the arenas, interner and blocks, including those
+    /// kept from before a [`reset`](Self::reset)
+    pub fn allocated_bytes(&self) -> usize {
+        let blocks: usize = self
+            .blocks
+            .iter()
+            .map(|block| {
+                block.statements.capacity() * std::mem::size_of::<Stmt>()
+                    + (block.successors.capacity() + block.predecessors.capacity())
+                        * std::mem::size_of::<u32>()
+            })
+            .sum();
+        self.name.capacity()
+            + (self.parameters.capacity() + self.local_variables.capacity())
+                * std::mem::size_of::<VarRef>()
+            + self.names.allocated_bytes()
+            + self.exprs.capacity() * std::mem::size_of::<ExprNode>()
+            + self.lists.capacity() * std::mem::size_of::<ExprId>()
+            + self.blocks.capacity() * std::mem::size_of::<Block>()
+            + blocks
+    }
+
+    pub fn intern(&mut self, s: &str) -> NameId {
+        self.names.intern(s)
+    }
+
+    pub fn intern_fmt(&mut self, args: fmt::Arguments<'_>) -> NameId {
+        self.names.intern_fmt(args)
+    }
+
+    pub fn name(&self, id: NameId) -> &str {
+        self.names.resolve(id)
+    }
+
+    pub fn push_expr(
+        &mut self,
+        kind: ExpressionKind,
+        expr_type: TypeKind,
+        data: ExprData,
+    ) -> ExprId {
+        let id = ExprId(self.exprs.len() as u32);
+        self.exprs.push(ExprNode {
+            kind,
+            expr_type,
+            data,
+        });
+        id
+    }
+
+    pub fn constant(&mut self, value: Constant, expr_type: TypeKind) -> ExprId {
+        self.push_expr(
+            ExpressionKind::Constant,
+            expr_type,
+            ExprData::Constant(value),
+        )
+    }
+
+    pub fn int_const(&mut self, value: i64) -> ExprId {
+        self.constant(Constant::Integer(value), TypeKind::Long)
+    }
+
+    pub fn string_const(&mut self, value: &str) -> ExprId {
+        let id = self.names.push(value);
+        self.constant(Constant::String(id), TypeKind::String)
+    }
+
+    pub fn variable(&mut self, var: VarRef) -> ExprId {
+        self.push_expr(
+            ExpressionKind::Variable,
+            var.var_type,
+            ExprData::Variable(var),
+        )
+    }
+
+    pub fn unary(
+        &mut self,
+        kind: ExpressionKind,
+        operand: ExprId,
+        result_type: TypeKind,
+    ) -> ExprId {
+        self.push_expr(kind, result_type, ExprData::Unary(operand))
+    }
+
+    pub fn binary(
+        &mut self,
+        kind: ExpressionKind,
+        left: ExprId,
+        right: ExprId,
+        result_type: TypeKind,
+    ) -> ExprId {
+        self.push_expr(kind, result_type, ExprData::Binary { left, right })
+    }
+
+    pub fn call(&mut self, function: NameId, arguments: ExprList, return_type: TypeKind) -> ExprId {
+        self.push_expr(
+            ExpressionKind::Call,
+            return_type,
+            ExprData::Call {
+                function,
+                arguments,
+            },
+        )
+    }
+
+    pub fn expr(&self, id: ExprId) -> &ExprNode {
+        &self.exprs[id.0 as usize]
+    }
+
+    pub fn expr_count(&self) -> usize {
+        self.exprs.len()
+    }
+
+    /// Store `items` contiguously and return their range
+    pub fn push_list(&mut self, items: &[ExprId]) -> ExprList {
+        let start = self.lists.len() as u32;
+        self.lists.extend_from_slice(items);
+        ExprList {
+            start,
+            len: items.len() as u32,
+        }
+    }
+
+    pub fn list(&self, list: ExprList) -> &[ExprId] {
+        let start = list.start as usize;
+        &self.lists[start..start + list.len as usize]
+    }
+
+    /// Append an empty block and return its id
+    pub fn add_block(&mut self) -> u32 {
+        if self.live_blocks == self.blocks.len() {
+            self.blocks.push(Block::default());
+        }
+        self.live_blocks += 1;
+        (self.live_blocks - 1) as u32
+    }
+
+    pub fn blocks(&self) -> &[Block] {
+        &self.blocks[..self.live_blocks]
+    }
+
+    pub fn block(&self, id: u32) -> Option<&Block> {
+        self.blocks().get(id as usize)
+    }
+
+    pub fn block_mut(&mut self, id: u32) -> Option<&mut Block> {
+        self.blocks[..self.live_blocks].get_mut(id as usize)
+    }
+
+    pub fn block_count(&self) -> usize {
+        self.live_blocks
+    }
+
+    /// Build the equivalent tree IR
+    pub fn to_function(&self) -> Function {
+        let mut function = Function::new(self.name.clone(), Type::new(self.return_type));
+        function.entry_block_id = self.entry_block_id;
+        function.parameters = self
+            .parameters
+            .iter()
+            .map(|v| self.to_variable(*v))
+            .collect();
+        function.local_variables = self
+            .local_variables
+            .iter()
+            .map(|v| self.to_variable(*v))
+            .collect();
+
+        for (id, block) in self.blocks().iter().enumerate() {
+            let mut tree_block = BasicBlock::new(id as u32);
+            tree_block.statements = block
+                .statements
+                .iter()
+                .map(|stmt| self.to_statement(stmt))
+                .collect();
+            tree_block.successors = block.successors.clone();
+            tree_block.predecessors = block.predecessors.clone();
+            function.add_basic_block(tree_block);
+        }
+
+        function
+    }
+
+    fn to_variable(&self, var: VarRef) -> Variable {
+        Variable::new(var.id, self.name(var.name).to_string(), var.var_type)
+    }
+
+    fn to_expressions(&self, list: ExprList) -> Vec<Expression> {
+        self.list(list)
+            .iter()
+            .map(|&e| self.to_expression(e))
+            .collect()
+    }
+
+    fn to_expression(&self, id: ExprId) -> Expression {
+        let node = self.expr(id);
+        let data = match node.data {
+            ExprData::None => ExpressionData::None,
+            ExprData::Constant(value) => ExpressionData::Constant(match value {
+                Constant::Integer(v) => ConstantValue::Integer(v),
+                Constant::Float(v) => ConstantValue::Float(v),
+                Constant::String(s) => ConstantValue::String(self.name(s).to_string()),
+                Constant::Boolean(b) => ConstantValue::Boolean(b),
+            }),
+            ExprData::Variable(var) => ExpressionData::Variable(self.to_variable(var)),
+            ExprData::Unary(operand) => {
+                ExpressionData::Unary(Box::new(self.to_expression(operand)))
+            }
+            ExprData::Binary { left, right } => ExpressionData::Binary {
+                left: Box::new(self.to_expression(left)),
+                right: Box::new(self.to_expression(right)),
+            },
+            ExprData::Call {
+                function,
+                arguments,
+            } => ExpressionData::Call {
+                function: self.name(function).to_string(),
+                arguments: self.to_expressions(arguments),
+            },
+            ExprData::MemberAccess { object, member } => ExpressionData::MemberAccess {
+                object: Box::new(self.to_expression(object)),
+                member: self.name(member).to_string(),
+            },
+            ExprData::ArrayIndex { array, indices } => ExpressionData::ArrayIndex {
+                array: Box::new(self.to_expression(array)),
+                indices: self.to_expressions(indices),
+            },
+            ExprData::Cast { expr, target_type } => ExpressionData::Cast {
+                expr: Box::new(self.to_expression(expr)),
+                target_type: Type::new(target_type),
+            },
+        };
+
+        Expression {
+            kind: node.kind,
+            expr_type: Type::new(node.expr_type),
+            data,
+        }
+    }
+
+    fn to_statement(&self, stmt: &Stmt) -> Statement {
+        match *stmt {
+            Stmt::Nop => Statement::nop(),
+            Stmt::Assign { target, value } => {
+                Statement::assign(self.to_variable(target), self.to_expression(value))
+            }
+            Stmt::Store { address, value } => Statement {
+                kind: StatementKind::Store,
+                data: StatementData::Store {
+                    address: self.to_expression(address),
+                    value: self.to_expression(value),
+                },
+            },
+            Stmt::Call {
+                function,
+                arguments,
+            } => Statement::call(
+                self.name(function).to_string(),
+                self.to_expressions(arguments),
+            ),
+            Stmt::Return { value } => Statement::return_stmt(value.map(|v| self.to_expression(v))),
+            Stmt::Branch {
+                condition,
+                target_block,
+            } => Statement::branch(self.to_expression(condition), target_block),
+            Stmt::Goto { target_block } => Statement::goto(target_block),
+            Stmt::Label { label_id } => Statement::label(label_id),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_interner_dedup() {
+        let mut names = Interner::new();
+        let a = names.intern("local1");
+        let b = names.intern_fmt(format_args!("local{}", 1));
+        let c = names.intern("local2");
+        assert_eq!(a, b);
+        assert_ne!(a, c);
+        assert_eq!(names.len(), 2);
+        assert_eq!(names.resolve(c), "local2");
+
+        let literal = names.push("local1");
+        assert_ne!(literal, a);
+        assert_eq!(names.resolve(literal), "local1");
+    }
+
+    #[test]
+    fn test_dense_blocks() {
+        let mut function = ArenaFunction::new("f".to_string(), TypeKind::Variant);
+        assert_eq!(function.add_block(), 1);
+        assert_eq!(function.add_block(), 2);
+        assert_eq!(function.block_count(), 3);
+        assert!(function.block(3).is_none());
+    }
+
+    #[test]
+    fn test_reset_keeps_buffers() {
+        let mut function = ArenaFunction::new("f".to_string(), TypeKind::Variant);
+        let x = function.intern("x");
+        let one = function.int_const(1);
+        let block = function.add_block();
+        function
+            .block_mut(block)
+            .unwrap()
+            .statements
+            .push(Stmt::Return { value: Some(one) });
+        function.block_mut(0).unwrap().add_successor(block);
+
+        function.reset("g", TypeKind::Long);
+        assert_eq!(function.name, "g");
+        assert_eq!(function.return_type, TypeKind::Long);
+        assert_eq!(function.block_count(), 1);
+        assert_eq!(function.expr_count(), 0);
+        assert!(function.block(0).unwrap().successors.is_empty());
+
+        // The kept block comes back empty, and names start over
+        assert_eq!(function.add_block(), 1);
+        assert!(function.block(1).unwrap().statements.is_empty());
+        assert_eq!(function.intern("y"), x);
+        assert_eq!(function.name(x), "y");
+    }
+
+    #[test]
+    fn test_to_function() {
+        let mut function = ArenaFunction::new("f".to_string(), TypeKind::Variant);
+        let one = function.int_const(1);
+        let two = function.int_const(2);
+        let sum = function.binary(ExpressionKind::Add, one, two, TypeKind::Variant);
+        let name = function.intern("x");
+        let target = VarRef {
+            id: 0,
+            name,
+            var_type: TypeKind::Integer,
+        };
+        let args = function.push_list(&[sum, one]);
+        let callee = function.intern("Foo");
+        let entry = function.block_mut(0).unwrap();
+        entry.statements.push(Stmt::Assign { target, value: sum });
+        entry.statements.push(Stmt::Call {
+            function: callee,
+            arguments: args,
+        });
+
+        let tree = function.to_function();
+        let stmts = &tree.get_block(0).unwrap().statements;
+        assert_eq!(stmts[0].to_vb_string(), "x = (1 + 2)");
+        assert_eq!(stmts[1].to_vb_string(), "Foo (1 + 2), 1");
+    }
+}
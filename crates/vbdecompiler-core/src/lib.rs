@@ -19,30 +19,65 @@
 //! - **pcode**: P-Code disassembler
 //! - **ir**: Intermediate representation
 //! - **decompiler**: Control flow structuring and code generation
+//! - **archive**: Seekable binary archive of decompiled methods
+//! - **budget**: Per-method size, instruction and time limits
+//! - **cache**: Opt-in on-disk result cache
+//! - **cfg**: Dominators, loops and structured control-flow recovery
+//! - **index**: Cross-method call graph, string table and symbol search
+//! - **incremental**: Method-level reuse and diffing between builds
+//! - **native**: Recursive-descent disassembly and lifting of native-code methods
+//! - **project**: Lazy, memoized per-method decompilation
+//! - **scan**: Vectorized multi-pattern signature scanner
+//! - **scratch**: Pooled per-thread buffers reused across methods and files
+//! - **stats**: Stage timings, counters and Chrome trace export
 //!
 //! # Example
 //!
 //! ```no_run
 //! use vbdecompiler_core::Decompiler;
 //!
-//! let mut decompiler = Decompiler::new();
+//! let decompiler = Decompiler::new();
 //! let result = decompiler.decompile_file("program.exe")?;
 //! println!("{}", result.vb6_code);
 //! # Ok::<(), Box<dyn std::error::Error>>(())
 //! ```
 
+pub mod archive;
+pub mod budget;
+pub mod cache;
+pub mod cfg;
 pub mod codegen;
 pub mod decompiler;
 pub mod error;
+pub mod incremental;
+pub mod index;
 pub mod ir;
 pub mod lifter;
+pub mod native;
 pub mod packer;
 pub mod pcode;
 pub mod pe;
+pub mod project;
+pub mod scan;
+pub mod scratch;
+pub mod stats;
 pub mod vb;
 pub mod x86;
 
-pub use decompiler::{DecompilationResult, Decompiler};
+pub use archive::{Archive, ArchiveRecord, ArchiveWriter, MappedArchive};
+pub use budget::MethodBudget;
+pub use decompiler::{
+    CancellationToken, DecompilationResult, DecompileHooks, DecompiledMethod, Decompiler,
+    DecompilerConfig, MethodFn, Parallelism,
+};
 pub use error::{Error, Result};
-pub use packer::{detect_packer, PackerDetection, PackerType};
-pub use x86::{X86Disassembler, X86Instruction};
+pub use incremental::{BuildDiff, ChangeKind, IncrementalResult, MethodChange, Snapshot};
+pub use index::{SymbolIndex, SymbolKind};
+pub use packer::{detect_packer, PackerDetection, PackerType, SectionEntropy};
+pub use pe::{PEFile, PackerCheck};
+pub use project::Project;
+pub use stats::{CountingAllocator, DecompileStats, StatsCollector};
+pub use x86::{
+    X86Decoded, X86Disassembler, X86Flow, X86Instruction, X86Listing, X86Operand, X86OperandKind,
+    X86Record,
+};
@@ -13,80 +13,207 @@
 //! - Lifter converts stack operations to temporary variables (t0, t1, t2, ...)
 //! - Creates BasicBlocks with CFG edges for branches
 //! - Maps P-Code types to VB types in the IR type system
+//! - Dispatches on each opcode's [`Lift`], assigned in the P-Code opcode table
+//!
+//! Lifting builds an [`ArenaFunction`]: expressions are pushed into one flat
+//! arena and the evaluation stack holds only their ids, so the number of heap
+//! allocations does not grow with the number of instructions.
 
 use crate::error::{Error, Result};
+use crate::ir::arena::{ArenaFunction, Constant, ExprId, ExprList, Stmt, VarRef};
 use crate::ir::*;
-use crate::pcode::{Instruction, OpcodeCategory, OperandValue, PCodeType};
-use std::collections::HashMap;
+use crate::pcode::{Disassembler, Instruction, Lift, OperandValue, PCodeType};
 
 /// P-Code to IR Lifter
+///
+/// Keeps its working buffers between calls, so a lifter reused with
+/// [`PCodeLifter::lift_into`] stops allocating once it has seen its largest
+/// method.
 pub struct PCodeLifter {
     last_error: Option<String>,
+    eval_stack: Vec<ExprId>,
+    address_to_block: Vec<(u32, u32)>,
+    block_order: Vec<usize>,
+    /// Pre-scanned branch targets of [`PCodeLifter::lift_stream`]
+    branch_targets: Vec<u32>,
 }
 
 impl PCodeLifter {
     pub fn new() -> Self {
-        Self { last_error: None }
+        Self {
+            last_error: None,
+            eval_stack: Vec::new(),
+            address_to_block: Vec::new(),
+            block_order: Vec::new(),
+            branch_targets: Vec::new(),
+        }
+    }
+
+    /// Heap bytes held by the working buffers, used or not
+    pub fn allocated_bytes(&self) -> usize {
+        self.eval_stack.capacity() * std::mem::size_of::<ExprId>()
+            + self.address_to_block.capacity() * std::mem::size_of::<(u32, u32)>()
+            + self.block_order.capacity() * std::mem::size_of::<usize>()
+            + self.branch_targets.capacity() * std::mem::size_of::<u32>()
     }
 
     /// Lift a sequence of P-Code instructions to an IR function
+    ///
+    /// Convenience wrapper over [`PCodeLifter::lift_arena`] that converts the
+    /// result to the tree IR.
     pub fn lift(
         &mut self,
         instructions: &[Instruction],
         function_name: String,
         start_address: u32,
     ) -> Result<Function> {
+        self.lift_arena(instructions, function_name, start_address)
+            .map(|function| function.to_function())
+    }
+
+    /// Lift a sequence of P-Code instructions to an arena-backed IR function
+    pub fn lift_arena(
+        &mut self,
+        instructions: &[Instruction],
+        function_name: String,
+        start_address: u32,
+    ) -> Result<ArenaFunction> {
+        let mut function =
+            ArenaFunction::with_capacity(function_name, TypeKind::Variant, instructions.len());
+        self.lift_into(instructions, &mut function, start_address)?;
+        Ok(function)
+    }
+
+    /// Lift a sequence of P-Code instructions into `function`
+    ///
+    /// `function` must be freshly created or [`reset`](ArenaFunction::reset);
+    /// reusing one function across methods keeps its arenas allocated.
+    pub fn lift_into(
+        &mut self,
+        instructions: &[Instruction],
+        function: &mut ArenaFunction,
+        _start_address: u32,
+    ) -> Result<()> {
         if instructions.is_empty() {
             return Err(Error::Decompilation("No instructions to lift".to_string()));
         }
 
         // Create lifting context
-        let mut ctx = LiftContext::new(function_name, start_address);
+        let mut ctx = LiftContext::new(function, self);
+        let result = self.lift_body(instructions, &mut ctx);
+        ctx.release(self);
+        result
+    }
 
+    /// Find block boundaries, then lift each instruction into its block
+    fn lift_body(&mut self, instructions: &[Instruction], ctx: &mut LiftContext) -> Result<()> {
         // First pass: identify basic block boundaries (branch targets)
+        ctx.create_target_blocks(instructions.iter().filter_map(branch_target));
+
+        // Second pass: lift instructions
         for instr in instructions {
-            if instr.is_branch {
-                if let Some(offset) = instr.branch_offset {
-                    if offset != 0 {
-                        let instr_len = instr.bytes.len() as u32;
-                        let target_addr = instr
-                            .address
-                            .wrapping_add(instr_len)
-                            .wrapping_add(offset as u32);
-                        ctx.get_or_create_block_for_address(target_addr);
-                    }
-                }
+            if self.lift_step(instr, ctx)? {
+                break;
             }
         }
 
-        // Second pass: lift instructions
-        for instr in instructions {
-            // Check if this address starts a new block
-            if let Some(&block_id) = ctx.address_to_block.get(&instr.address) {
-                if block_id != ctx.current_block_id {
-                    // Connect current block to new block
-                    if let Some(current_block) = ctx.function.get_block_mut(ctx.current_block_id) {
-                        if !current_block.statements.is_empty() {
-                            current_block.add_successor(block_id);
-                        }
+        Ok(())
+    }
+
+    /// Decode and lift a method in one pass, without an instruction buffer
+    ///
+    /// Block boundaries come from a [`Disassembler::scan_branches`] pre-scan,
+    /// after which each instruction is decoded and lifted straight into
+    /// `function`, so the working set is the IR arena plus the branch
+    /// targets. Builds the same IR as disassembling into a buffer and
+    /// calling [`Self::lift_into`]; the disassembler's limits apply to the
+    /// pre-scan. Returns the number of instructions decoded.
+    pub fn lift_stream(
+        &mut self,
+        mut disassembler: Disassembler<'_>,
+        function: &mut ArenaFunction,
+        start_address: u32,
+    ) -> Result<usize> {
+        let mut targets = std::mem::take(&mut self.branch_targets);
+        targets.clear();
+        let scanned = disassembler
+            .clone()
+            .scan_branches(start_address, &mut targets);
+        let result = scanned.and_then(|(count, len)| {
+            if count == 0 {
+                return Err(Error::Decompilation("No instructions to lift".to_string()));
+            }
+
+            let mut ctx = LiftContext::new(function, self);
+            ctx.create_target_blocks(targets.iter().copied());
+            let end = disassembler.offset() + len;
+            let mut address = start_address;
+            let mut lifted = Ok(());
+            while disassembler.offset() < end {
+                let step = disassembler.decode_next(address).and_then(|instr| {
+                    address += instr.bytes.len() as u32;
+                    self.lift_step(&instr, &mut ctx)
+                });
+                match step {
+                    Ok(false) => {}
+                    Ok(true) => break,
+                    Err(e) => {
+                        lifted = Err(e);
+                        break;
                     }
-                    ctx.current_block_id = block_id;
                 }
             }
+            ctx.release(self);
+            lifted.map(|()| count)
+        });
+        self.branch_targets = targets;
+        result
+    }
 
-            // Lift the instruction
-            if let Err(e) = self.lift_instruction(instr, &mut ctx) {
-                self.last_error = Some(format!("Failed to lift {}: {}", instr.mnemonic, e));
-                return Err(e);
+    /// Lift one instruction into the current block
+    ///
+    /// Returns whether lifting is done: the instruction returned and no
+    /// branch targets any later address.
+    fn lift_step(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<bool> {
+        // Check if this address starts a new block
+        if let Some(block_id) = ctx.block_for_address(instr.address) {
+            if block_id != ctx.current_block_id {
+                // Fall through unless the current block ends in a jump
+                if let Some(current_block) = ctx.function.block_mut(ctx.current_block_id) {
+                    if !matches!(
+                        current_block.statements.last(),
+                        Some(Stmt::Goto { .. } | Stmt::Return { .. })
+                    ) {
+                        current_block.add_successor(block_id);
+                    }
+                }
+                ctx.current_block_id = block_id;
             }
+        }
 
-            // Stop at return
-            if instr.is_return {
-                break;
+        // Lift the instruction
+        if let Err(e) = self.lift_instruction(instr, ctx) {
+            self.last_error = Some(format!("Failed to lift {}: {}", instr.mnemonic, e));
+            return Err(e);
+        }
+
+        // Code after a return is only reachable from a later branch target
+        let returned = matches!(
+            ctx.function
+                .block(ctx.current_block_id)
+                .and_then(|block| block.statements.last()),
+            Some(Stmt::Return { .. })
+        );
+        if instr.is_return || returned {
+            if !ctx.has_target_after(instr.address) {
+                return Ok(true);
+            }
+            if returned {
+                ctx.current_block_id = ctx.function.add_block();
             }
         }
 
-        Ok(ctx.function)
+        Ok(false)
     }
 
     /// Get last error message
@@ -95,229 +222,114 @@ impl PCodeLifter {
     }
 
     /// Lift a single instruction
+    ///
+    /// Dispatches on the [`Lift`] the opcode table assigns to the decoded
+    /// opcode, so no mnemonic is inspected.
     fn lift_instruction(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
-        // Route to specialized lifters based on category
-        match instr.category {
-            OpcodeCategory::Arithmetic => self.lift_arithmetic(instr, ctx),
-            OpcodeCategory::Comparison => self.lift_comparison(instr, ctx),
-            OpcodeCategory::Logical => self.lift_logical(instr, ctx),
-            OpcodeCategory::Stack | OpcodeCategory::Variable => self.lift_stack(instr, ctx),
-            OpcodeCategory::Memory | OpcodeCategory::Array => self.lift_memory(instr, ctx),
-            OpcodeCategory::ControlFlow => {
-                if instr.is_branch {
-                    self.lift_branch(instr, ctx)
-                } else if instr.is_return
-                    || instr.mnemonic.contains("Exit")
-                    || instr.mnemonic.contains("Return")
-                {
-                    self.lift_return(instr, ctx)
-                } else {
-                    Ok(()) // Ignore other control flow for now
-                }
-            }
-            OpcodeCategory::Call => self.lift_call(instr, ctx),
-            _ => Ok(()), // Ignore unknown categories
+        match instr.op.lift() {
+            Lift::Ignore => Ok(()),
+            Lift::Literal => self.lift_literal(instr, ctx),
+            Lift::LoadLocal(var_type) => self.lift_load_local(instr, var_type, ctx),
+            Lift::StoreLocal(var_type) => self.lift_store_local(instr, var_type, ctx),
+            Lift::Binary(op, result_type) => self.lift_binary(op, result_type, ctx),
+            Lift::Unary(op, result_type) => self.lift_unary(op, result_type, ctx),
+            Lift::Branch { negate } => self.lift_branch(instr, negate, ctx),
+            Lift::Return { value } => self.lift_return(value, ctx),
+            Lift::Call { returns } => self.lift_call(instr, returns, ctx),
         }
     }
 
-    /// Lift arithmetic operations
-    fn lift_arithmetic(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
-        // Map P-Code arithmetic to IR binary operations
-        let op = if instr.mnemonic.contains("Add") {
-            ExpressionKind::Add
-        } else if instr.mnemonic.contains("Sub") {
-            ExpressionKind::Subtract
-        } else if instr.mnemonic.contains("Mul") {
-            ExpressionKind::Multiply
-        } else if instr.mnemonic.contains("Div") {
-            ExpressionKind::Divide
-        } else if instr.mnemonic.contains("Idiv") {
-            ExpressionKind::IntDivide
-        } else if instr.mnemonic.contains("Mod") {
-            ExpressionKind::Modulo
-        } else if instr.mnemonic.contains("Concat") {
-            ExpressionKind::Concatenate
-        } else {
-            return Ok(()); // Unknown arithmetic, skip
-        };
-
+    /// Lift binary arithmetic, comparison and logical operations
+    fn lift_binary(
+        &mut self,
+        op: ExpressionKind,
+        result_type: TypeKind,
+        ctx: &mut LiftContext,
+    ) -> Result<()> {
         // Pop operands (right then left, since it's a stack)
         let right = ctx.pop_stack()?;
         let left = ctx.pop_stack()?;
 
-        // Create binary expression
-        let result = Expression::binary(op, left, right, Type::new(TypeKind::Variant));
-
-        // Push result
+        let result = ctx.function.binary(op, left, right, result_type);
         ctx.push_stack(result);
 
         Ok(())
     }
 
-    /// Lift comparison operations
-    fn lift_comparison(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
-        // Map P-Code comparison to IR comparison operations
-        let op = if instr.mnemonic.contains("Eq") {
-            ExpressionKind::Equal
-        } else if instr.mnemonic.contains("Ne") {
-            ExpressionKind::NotEqual
-        } else if instr.mnemonic.contains("Lt") {
-            ExpressionKind::LessThan
-        } else if instr.mnemonic.contains("Le") {
-            ExpressionKind::LessEqual
-        } else if instr.mnemonic.contains("Gt") {
-            ExpressionKind::GreaterThan
-        } else if instr.mnemonic.contains("Ge") {
-            ExpressionKind::GreaterEqual
-        } else {
-            return Ok(()); // Unknown comparison, skip
-        };
-
-        // Pop operands
-        let right = ctx.pop_stack()?;
-        let left = ctx.pop_stack()?;
-
-        // Create comparison expression
-        let result = Expression::binary(op, left, right, Type::new(TypeKind::Boolean));
-
-        // Push result
+    /// Lift unary operations such as negation
+    fn lift_unary(
+        &mut self,
+        op: ExpressionKind,
+        result_type: TypeKind,
+        ctx: &mut LiftContext,
+    ) -> Result<()> {
+        let operand = ctx.pop_stack()?;
+        let result = ctx.function.unary(op, operand, result_type);
         ctx.push_stack(result);
 
         Ok(())
     }
 
-    /// Lift logical operations
-    fn lift_logical(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
-        // Handle unary NOT
-        if instr.mnemonic.contains("Not") {
-            let operand = ctx.pop_stack()?;
-            let result = Expression {
-                kind: ExpressionKind::Not,
-                expr_type: Type::new(TypeKind::Boolean),
-                data: ExpressionData::Unary(Box::new(operand)),
-            };
-            ctx.push_stack(result);
-            return Ok(());
+    /// Lift literal pushes
+    fn lift_literal(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
+        if instr.operands.is_empty() {
+            return Err(Error::Decompilation("Literal with no operands".to_string()));
         }
 
-        // Map P-Code logical to IR logical operations
-        let op = if instr.mnemonic.contains("And") {
-            ExpressionKind::And
-        } else if instr.mnemonic.contains("Or") {
-            ExpressionKind::Or
-        } else if instr.mnemonic.contains("Xor") {
-            ExpressionKind::Xor
-        } else {
-            return Ok(()); // Unknown logical, skip
+        let operand = &instr.operands[0];
+        let function = &mut *ctx.function;
+        let expr = match &operand.value {
+            OperandValue::Byte(v) => function.int_const(*v as i64),
+            OperandValue::Int16(v) => function.int_const(*v as i64),
+            OperandValue::Int32(v) => function.int_const(*v as i64),
+            OperandValue::Float(v) => {
+                function.constant(Constant::Float(*v as f64), TypeKind::Single)
+            }
+            OperandValue::String(s) => function.string_const(s),
+            OperandValue::None => {
+                return Err(Error::Decompilation("Literal with None value".to_string()));
+            }
         };
 
-        // Binary logical operations
-        let right = ctx.pop_stack()?;
-        let left = ctx.pop_stack()?;
-
-        let result = Expression::binary(op, left, right, Type::new(TypeKind::Boolean));
-        ctx.push_stack(result);
-
+        ctx.push_stack(expr);
         Ok(())
     }
 
-    /// Lift stack operations (literals and variable loads/stores)
-    fn lift_stack(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
-        // Handle literal pushes
-        if instr.mnemonic.contains("Lit") {
-            if instr.operands.is_empty() {
-                return Err(Error::Decompilation("Literal with no operands".to_string()));
-            }
-
-            let operand = &instr.operands[0];
-            let expr = match &operand.value {
-                OperandValue::Byte(v) => Expression::int_const(*v as i64),
-                OperandValue::Int16(v) => Expression::int_const(*v as i64),
-                OperandValue::Int32(v) => Expression::int_const(*v as i64),
-                OperandValue::Float(v) => Expression::constant(
-                    ConstantValue::Float(*v as f64),
-                    Type::new(TypeKind::Single),
-                ),
-                OperandValue::String(s) => Expression::string_const(s.clone()),
-                OperandValue::None => {
-                    return Err(Error::Decompilation("Literal with None value".to_string()));
-                }
-            };
-
-            ctx.push_stack(expr);
-            return Ok(());
-        }
-
-        // Handle local variable loads
-        if instr.mnemonic.contains("LdLoc") || instr.mnemonic.contains("LoadLocal") {
-            if instr.operands.is_empty() {
-                return Err(Error::Decompilation(
-                    "LoadLocal with no operands".to_string(),
-                ));
-            }
-
-            let local_index = match &instr.operands[0].value {
-                OperandValue::Int16(v) => *v as u32,
-                OperandValue::Int32(v) => *v as u32,
-                OperandValue::Byte(v) => *v as u32,
-                _ => {
-                    return Err(Error::Decompilation(
-                        "LoadLocal with invalid index type".to_string(),
-                    ));
-                }
-            };
-            let var_name = format!("local{}", local_index);
-            let var_type = pcode_type_to_ir_type(instr.operands[0].data_type);
-
-            let var = Variable::new(local_index, var_name, var_type);
-            let expr = Expression::variable(var);
-            ctx.push_stack(expr);
-            return Ok(());
-        }
-
-        // Handle local variable stores
-        if instr.mnemonic.contains("StLoc") || instr.mnemonic.contains("StoreLocal") {
-            if instr.operands.is_empty() {
-                return Err(Error::Decompilation(
-                    "StoreLocal with no operands".to_string(),
-                ));
-            }
-
-            let value = ctx.pop_stack()?;
-
-            let local_index = match &instr.operands[0].value {
-                OperandValue::Int16(v) => *v as u32,
-                OperandValue::Int32(v) => *v as u32,
-                OperandValue::Byte(v) => *v as u32,
-                _ => {
-                    return Err(Error::Decompilation(
-                        "StoreLocal with invalid index type".to_string(),
-                    ));
-                }
-            };
-            let var_name = format!("local{}", local_index);
-            let var_type = pcode_type_to_ir_type(instr.operands[0].data_type);
-
-            let var = Variable::new(local_index, var_name, var_type);
-            let stmt = Statement::assign(var, value);
-
-            if let Some(block) = ctx.function.get_block_mut(ctx.current_block_id) {
-                block.add_statement(stmt);
-            }
-            return Ok(());
-        }
-
+    /// Lift local variable loads
+    fn lift_load_local(
+        &mut self,
+        instr: &Instruction,
+        var_type: TypeKind,
+        ctx: &mut LiftContext,
+    ) -> Result<()> {
+        let (local_index, var_type) = local_operand(instr, var_type, "LoadLocal")?;
+        let var = ctx.local(local_index, var_type);
+        let expr = ctx.function.variable(var);
+        ctx.push_stack(expr);
         Ok(())
     }
 
-    /// Lift memory operations
-    fn lift_memory(&mut self, _instr: &Instruction, _ctx: &mut LiftContext) -> Result<()> {
-        // Memory operations - to be implemented when needed
+    /// Lift local variable stores
+    fn lift_store_local(
+        &mut self,
+        instr: &Instruction,
+        var_type: TypeKind,
+        ctx: &mut LiftContext,
+    ) -> Result<()> {
+        let (local_index, var_type) = local_operand(instr, var_type, "StoreLocal")?;
+        let value = ctx.pop_stack()?;
+        let target = ctx.local(local_index, var_type);
+        ctx.add_statement(Stmt::Assign { target, value });
         Ok(())
     }
 
     /// Lift branch operations
-    fn lift_branch(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
+    fn lift_branch(
+        &mut self,
+        instr: &Instruction,
+        negate: bool,
+        ctx: &mut LiftContext,
+    ) -> Result<()> {
         // Calculate branch target address
         let branch_offset = instr
             .branch_offset
@@ -330,24 +342,32 @@ impl PCodeLifter {
             .wrapping_add(branch_offset as u32);
 
         if instr.is_conditional_branch {
-            // Pop condition from stack
-            let condition = ctx.pop_stack()?;
+            // Pop condition from stack; BranchF jumps when it is false
+            let mut condition = ctx.pop_stack()?;
+            if negate {
+                condition = ctx
+                    .function
+                    .unary(ExpressionKind::Not, condition, TypeKind::Boolean);
+            }
 
             // Get or create target block
             let target_block_id = ctx.get_or_create_block_for_address(target_addr);
 
             // Create branch statement
-            let stmt = Statement::branch(condition, target_block_id);
+            let stmt = Stmt::Branch {
+                condition,
+                target_block: target_block_id,
+            };
 
             // Add to current block
-            if let Some(block) = ctx.function.get_block_mut(ctx.current_block_id) {
-                block.add_statement(stmt);
+            if let Some(block) = ctx.function.block_mut(ctx.current_block_id) {
+                block.statements.push(stmt);
                 block.add_successor(target_block_id);
             }
 
             // Create fall-through block
-            let fall_through_id = ctx.create_new_block();
-            if let Some(block) = ctx.function.get_block_mut(ctx.current_block_id) {
+            let fall_through_id = ctx.function.add_block();
+            if let Some(block) = ctx.function.block_mut(ctx.current_block_id) {
                 block.add_successor(fall_through_id);
             }
             ctx.current_block_id = fall_through_id;
@@ -355,70 +375,63 @@ impl PCodeLifter {
             // Unconditional branch (goto)
             let target_block_id = ctx.get_or_create_block_for_address(target_addr);
 
-            let stmt = Statement::goto(target_block_id);
+            let stmt = Stmt::Goto {
+                target_block: target_block_id,
+            };
 
             // Add to current block
-            if let Some(block) = ctx.function.get_block_mut(ctx.current_block_id) {
-                block.add_statement(stmt);
+            if let Some(block) = ctx.function.block_mut(ctx.current_block_id) {
+                block.statements.push(stmt);
                 block.add_successor(target_block_id);
             }
 
             // Create new block for any following code
-            ctx.current_block_id = ctx.create_new_block();
+            ctx.current_block_id = ctx.function.add_block();
         }
 
         Ok(())
     }
 
     /// Lift call operations
-    fn lift_call(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
+    fn lift_call(
+        &mut self,
+        instr: &Instruction,
+        returns: bool,
+        ctx: &mut LiftContext,
+    ) -> Result<()> {
         // Extract function name/address
-        let func_name = if !instr.operands.is_empty() {
-            let operand = &instr.operands[0];
-            match &operand.value {
-                OperandValue::Int32(v) => format!("func_{}", v),
-                OperandValue::String(s) => s.clone(),
-                OperandValue::Int16(v) => format!("func_{}", v),
-                _ => "func_unknown".to_string(),
-            }
-        } else {
-            "func_unknown".to_string()
+        let function = &mut *ctx.function;
+        let func_name = match instr.operands.first().map(|operand| &operand.value) {
+            Some(OperandValue::Int32(v)) => function.intern_fmt(format_args!("func_{}", v)),
+            Some(OperandValue::String(s)) => function.intern(s),
+            Some(OperandValue::Int16(v)) => function.intern_fmt(format_args!("func_{}", v)),
+            _ => function.intern("func_unknown"),
         };
 
         // For now, create a simple call with no arguments
         // TODO: Pop arguments from stack based on calling convention
-        let args = Vec::new();
+        let args = ExprList::default();
 
-        // If this is a function call (not sub), create call expression and push result
-        if instr.mnemonic.contains("CallFunc") || instr.mnemonic.contains("CallI4") {
-            let call_expr = Expression::call(func_name, args, Type::new(TypeKind::Variant));
+        // Function calls push their result; subroutine calls become statements
+        if returns {
+            let call_expr = function.call(func_name, args, TypeKind::Variant);
             ctx.push_stack(call_expr);
         } else {
-            // It's a subroutine call, create a call statement
-            let stmt = Statement::call(func_name, args);
-            if let Some(block) = ctx.function.get_block_mut(ctx.current_block_id) {
-                block.add_statement(stmt);
-            }
+            ctx.add_statement(Stmt::Call {
+                function: func_name,
+                arguments: args,
+            });
         }
 
         Ok(())
     }
 
     /// Lift return operations
-    fn lift_return(&mut self, instr: &Instruction, ctx: &mut LiftContext) -> Result<()> {
-        // Check if this is a function return (with value) or sub return (no value)
-        let stmt = if instr.mnemonic.contains("ExitProc") {
-            // Sub return - no value
-            Statement::return_stmt(None)
-        } else {
-            // Function return - pop return value
-            let ret_value = ctx.pop_stack().ok();
-            Statement::return_stmt(ret_value)
-        };
+    fn lift_return(&mut self, value: bool, ctx: &mut LiftContext) -> Result<()> {
+        // Function returns pop their value; sub returns (ExitProc) have none
+        let value = if value { ctx.pop_stack().ok() } else { None };
 
-        if let Some(block) = ctx.function.get_block_mut(ctx.current_block_id) {
-            block.add_statement(stmt);
-        }
+        ctx.add_statement(Stmt::Return { value });
 
         Ok(())
     }
@@ -431,61 +444,152 @@ impl Default for PCodeLifter {
 }
 
 /// Context for lifting a single function
-struct LiftContext {
-    function: Function,
+struct LiftContext<'f> {
+    function: &'f mut ArenaFunction,
     current_block_id: u32,
-    eval_stack: Vec<Expression>,
-    next_block_id: u32,
-    address_to_block: HashMap<u32, u32>,
+    eval_stack: Vec<ExprId>,
+    /// `(address, block id)` pairs sorted by address
+    address_to_block: Vec<(u32, u32)>,
+    block_order: Vec<usize>,
 }
 
-impl LiftContext {
-    fn new(function_name: String, _start_address: u32) -> Self {
-        let mut function = Function::new(function_name, Type::new(TypeKind::Variant));
-
-        // Create entry block
-        let entry_block = BasicBlock::new(0);
-        function.add_basic_block(entry_block);
-        function.entry_block_id = 0;
-
-        Self {
+impl<'f> LiftContext<'f> {
+    /// Start lifting into `function`, borrowing the lifter's buffers
+    fn new(function: &'f mut ArenaFunction, lifter: &mut PCodeLifter) -> Self {
+        // Entry block 0 is created by the arena
+        let mut ctx = Self {
             function,
             current_block_id: 0,
-            eval_stack: Vec::new(),
-            next_block_id: 1,
-            address_to_block: HashMap::new(),
-        }
+            eval_stack: std::mem::take(&mut lifter.eval_stack),
+            address_to_block: std::mem::take(&mut lifter.address_to_block),
+            block_order: std::mem::take(&mut lifter.block_order),
+        };
+        ctx.eval_stack.clear();
+        ctx
     }
 
-    fn pop_stack(&mut self) -> Result<Expression> {
+    /// Hand the buffers back to the lifter for the next function
+    fn release(self, lifter: &mut PCodeLifter) {
+        lifter.eval_stack = self.eval_stack;
+        lifter.address_to_block = self.address_to_block;
+        lifter.block_order = self.block_order;
+    }
+
+    fn pop_stack(&mut self) -> Result<ExprId> {
         self.eval_stack
             .pop()
             .ok_or_else(|| Error::Decompilation("Stack underflow".to_string()))
     }
 
-    fn push_stack(&mut self, expr: Expression) {
+    fn push_stack(&mut self, expr: ExprId) {
         self.eval_stack.push(expr);
     }
 
-    fn create_new_block(&mut self) -> u32 {
-        let block_id = self.next_block_id;
-        self.next_block_id += 1;
+    fn add_statement(&mut self, stmt: Stmt) {
+        if let Some(block) = self.function.block_mut(self.current_block_id) {
+            block.statements.push(stmt);
+        }
+    }
 
-        let block = BasicBlock::new(block_id);
-        self.function.add_basic_block(block);
+    /// Reference to local variable `index`; the name is interned once
+    fn local(&mut self, index: u32, var_type: TypeKind) -> VarRef {
+        VarRef {
+            id: index,
+            name: self.function.intern_fmt(format_args!("local{}", index)),
+            var_type,
+        }
+    }
+
+    /// Create one block per distinct branch target
+    ///
+    /// `targets` are in instruction order. Block ids are handed out in order
+    /// of first reference, so the numbering matches a single forward scan
+    /// over the instructions.
+    fn create_target_blocks(&mut self, targets: impl Iterator<Item = u32>) {
+        let address_to_block = &mut self.address_to_block;
+        address_to_block.clear();
+        address_to_block.extend(targets.zip(0..));
+
+        // Keep the first reference to each address
+        let targets = address_to_block;
+        targets.sort_unstable();
+        targets.dedup_by_key(|&mut (address, _)| address);
+
+        let by_first_use = &mut self.block_order;
+        by_first_use.clear();
+        by_first_use.extend(0..targets.len());
+        by_first_use.sort_unstable_by_key(|&i| targets[i].1);
+        for &i in by_first_use.iter() {
+            targets[i].1 = self.function.add_block();
+        }
+    }
 
-        block_id
+    /// Whether a branch targets an address past `address`
+    fn has_target_after(&self, address: u32) -> bool {
+        self.address_to_block
+            .last()
+            .is_some_and(|&(target, _)| target > address)
+    }
+
+    fn block_for_address(&self, address: u32) -> Option<u32> {
+        self.address_to_block
+            .binary_search_by_key(&address, |&(a, _)| a)
+            .ok()
+            .map(|i| self.address_to_block[i].1)
     }
 
     fn get_or_create_block_for_address(&mut self, address: u32) -> u32 {
-        if let Some(&block_id) = self.address_to_block.get(&address) {
-            return block_id;
+        match self
+            .address_to_block
+            .binary_search_by_key(&address, |&(a, _)| a)
+        {
+            Ok(i) => self.address_to_block[i].1,
+            Err(i) => {
+                let block_id = self.function.add_block();
+                self.address_to_block.insert(i, (address, block_id));
+                block_id
+            }
         }
+    }
+}
 
-        let block_id = self.create_new_block();
-        self.address_to_block.insert(address, block_id);
-        block_id
+/// Target of a branch instruction with a non-zero offset
+fn branch_target(instr: &Instruction) -> Option<u32> {
+    if !instr.is_branch {
+        return None;
     }
+    let offset = instr.branch_offset.filter(|&offset| offset != 0)?;
+    let instr_len = instr.bytes.len() as u32;
+    // Skipped like in the pre-scan if it would be before address 0
+    instr
+        .address
+        .wrapping_add(instr_len)
+        .checked_add_signed(offset)
+}
+
+/// Local variable index named by an instruction's first operand, and its
+/// type: the operand's if the decoder knows it, otherwise `var_type`
+fn local_operand(instr: &Instruction, var_type: TypeKind, what: &str) -> Result<(u32, TypeKind)> {
+    let operand = instr
+        .operands
+        .first()
+        .ok_or_else(|| Error::Decompilation(format!("{} with no operands", what)))?;
+    let local_index = match &operand.value {
+        OperandValue::Int16(v) => *v as u32,
+        OperandValue::Int32(v) => *v as u32,
+        OperandValue::Byte(v) => *v as u32,
+        _ => {
+            return Err(Error::Decompilation(format!(
+                "{} with invalid index type",
+                what
+            )));
+        }
+    };
+    let var_type = match operand.data_type {
+        PCodeType::Unknown => var_type,
+        data_type => pcode_type_to_ir_type(data_type),
+    };
+    Ok((local_index, var_type))
 }
 
 /// Convert P-Code type to IR type
@@ -519,6 +623,87 @@ mod tests {
         assert!(result.is_err());
     }
 
+    #[test]
+    fn test_lift_branch_blocks() {
+        use crate::codegen::VB6CodeGenerator;
+        use crate::pcode::Disassembler;
+
+        // LitI2 1; LitI2 2; LtI2; BranchF +2; LitI2 3; ExitProc
+        let pcode = [0x5E, 1, 0x5E, 2, 0xA4, 0x1C, 2, 0, 0x5E, 3, 0x14];
+        let instructions = Disassembler::new(&pcode).disassemble(0).unwrap();
+
+        let mut lifter = PCodeLifter::new();
+        let arena = lifter
+            .lift_arena(&instructions, "test".to_string(), 0)
+            .unwrap();
+        // Entry, branch target, fall-through
+        assert_eq!(arena.block_count(), 3);
+        assert_eq!(arena.block(0).unwrap().successors, vec![1, 2]);
+        assert!(matches!(
+            arena.block(0).unwrap().statements[0],
+            Stmt::Branch {
+                target_block: 1,
+                ..
+            }
+        ));
+        // The empty fall-through block still continues at the target
+        assert_eq!(arena.block(2).unwrap().successors, vec![1]);
+
+        // Nothing happens on either path, so no If is left
+        let code = VB6CodeGenerator::new().generate_arena_function(&arena);
+        assert_eq!(
+            code,
+            "Function test() As Variant\n    Exit Function\nEnd Function"
+        );
+    }
+
+    #[test]
+    fn test_lift_continues_after_early_return() {
+        use crate::pcode::Disassembler;
+
+        // LitI2 1; BranchT +1; ExitProc; ExitProc
+        let pcode = [0x5E, 1, 0x1D, 1, 0, 0x14, 0x14];
+        let instructions = Disassembler::new(&pcode).disassemble(0).unwrap();
+        assert_eq!(instructions.len(), 4);
+
+        let arena = PCodeLifter::new()
+            .lift_arena(&instructions, "test".to_string(), 0)
+            .unwrap();
+        let returns = arena
+            .blocks()
+            .iter()
+            .flat_map(|block| &block.statements)
+            .filter(|stmt| matches!(stmt, Stmt::Return { .. }))
+            .count();
+        assert_eq!(returns, 2);
+    }
+
+    #[test]
+    fn test_lift_locals_and_negation() {
+        use crate::codegen::VB6CodeGenerator;
+        use crate::pcode::Disassembler;
+
+        // LitI2 5; FStI2 2; FLdI2 2; NegI2; FStI4 3; ExitProc
+        let pcode = [0x5E, 5, 0x6D, 2, 0x69, 2, 0x9A, 0x6E, 3, 0x14];
+        let instructions = Disassembler::new(&pcode).disassemble(0).unwrap();
+
+        let arena = PCodeLifter::new()
+            .lift_arena(&instructions, "test".to_string(), 0)
+            .unwrap();
+        let assigned: Vec<_> = arena.block(0).unwrap().statements[..2]
+            .iter()
+            .map(|stmt| match stmt {
+                Stmt::Assign { target, .. } => (target.id, target.var_type),
+                _ => panic!("expected an assignment"),
+            })
+            .collect();
+        assert_eq!(assigned, [(2, TypeKind::Integer), (3, TypeKind::Long)]);
+
+        let code = VB6CodeGenerator::new().generate_arena_function(&arena);
+        assert!(code.contains("local2 = 5"), "{}", code);
+        assert!(code.contains("local3 = -local2"), "{}", code);
+    }
+
     #[test]
     fn test_pcode_type_conversion() {
         assert_eq!(pcode_type_to_ir_type(PCodeType::Byte), TypeKind::Byte);
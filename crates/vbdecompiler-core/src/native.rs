@@ -0,0 +1,465 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Native-code methods: recursive-descent x86 disassembly and lifting
+//!
+//! In a natively compiled executable each method-table entry is the VA of an
+//! ordinary x86 function. [`NativeImage`] describes the executable sections
+//! of the file; [`NativeImage::disassemble_function`] follows a function's
+//! control flow from its entry, so data and padding between functions are
+//! never decoded, and [`lift_into`] turns the result into the arena IR that
+//! [`VB6CodeGenerator`](crate::codegen::VB6CodeGenerator) generates code from.
+//!
+//! The decompiler runs one task per method on its thread pool. All tasks
+//! share the image's bitmaps of decoded instruction starts, which counts the
+//! code covered so far and spots code shared between methods.
+//!
+//! Lifting is deliberately shallow: general-purpose registers become `Long`
+//! variables, `[ebp-N]` and `[ebp+N]` become locals and parameters, pushes
+//! become call arguments, and compare-and-branch pairs become conditions.
+//! Anything else is kept as a comment holding its assembly text.
+
+mod lift;
+
+pub use lift::lift_into;
+
+use crate::budget::{MethodBudget, DEADLINE_INTERVAL};
+use crate::error::{Error, Result};
+use crate::vb::VBFile;
+use iced_x86::{Decoder, DecoderOptions, FlowControl, Instruction, Mnemonic, OpKind, Register};
+use std::collections::{HashMap, HashSet};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::Instant;
+
+/// Section contains executable code
+const IMAGE_SCN_CNT_CODE: u32 = 0x0000_0020;
+/// Section can be executed
+const IMAGE_SCN_MEM_EXECUTE: u32 = 0x2000_0000;
+
+/// Executable bytes `[start, end)` of the image, by VA
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct CodeRegion {
+    start: u32,
+    end: u32,
+    /// File offset of `start`
+    offset: usize,
+}
+
+/// One bit per byte of each executable region, set atomically
+///
+/// Marks instruction starts decoded by any thread. Each region has its own
+/// bitmap, so regions far apart in the address space cost no more than
+/// their own bytes.
+struct VisitedMap {
+    /// Bitmap of each region, by the region's `[start, end)`
+    regions: Vec<(u32, u32, Vec<AtomicU64>)>,
+}
+
+impl VisitedMap {
+    fn new(regions: &[CodeRegion]) -> Self {
+        Self {
+            regions: regions
+                .iter()
+                .map(|r| {
+                    let bits = (r.end - r.start) as usize;
+                    let words = (0..bits.div_ceil(64)).map(|_| AtomicU64::new(0)).collect();
+                    (r.start, r.end, words)
+                })
+                .collect(),
+        }
+    }
+
+    /// Mark `va`, returning whether it was unmarked
+    ///
+    /// Addresses outside the regions are always reported as new.
+    fn claim(&self, va: u32) -> bool {
+        let Some((start, _, words)) = self
+            .regions
+            .iter()
+            .find(|&&(start, end, _)| start <= va && va < end)
+        else {
+            return true;
+        };
+        let bit = (va - start) as usize;
+        let mask = 1u64 << (bit % 64);
+        words[bit / 64].fetch_or(mask, Ordering::Relaxed) & mask == 0
+    }
+
+    /// Number of marked addresses
+    fn count(&self) -> usize {
+        self.regions
+            .iter()
+            .flat_map(|(_, _, words)| words)
+            .map(|w| w.load(Ordering::Relaxed).count_ones() as usize)
+            .sum()
+    }
+}
+
+/// What the disassembler and lifter need to know about a native executable
+///
+/// Holds no borrow of the file: the image bytes are passed to each call, so
+/// an image can live next to the [`VBFile`] it was built from.
+pub struct NativeImage {
+    regions: Vec<CodeRegion>,
+    /// Import name by the VA of its import address table slot
+    imports: HashMap<u32, String>,
+    /// `Object_Method` name by entry VA, for calls between methods
+    methods: HashMap<u32, String>,
+    decoded: VisitedMap,
+}
+
+/// Instructions reached from one entry point
+#[derive(Debug, Clone)]
+pub struct NativeFunction {
+    pub entry: u32,
+    /// Sorted by address
+    pub instructions: Vec<Instruction>,
+    /// Instructions another function had already decoded
+    pub shared: usize,
+}
+
+impl NativeFunction {
+    /// Bytes covered by the function's instructions
+    pub fn code_size(&self) -> usize {
+        self.instructions.iter().map(Instruction::len).sum()
+    }
+}
+
+impl NativeImage {
+    /// Collect the code sections, imports and method entry points of `vb_file`
+    pub fn new(vb_file: &VBFile) -> Self {
+        let pe = vb_file.pe_file();
+        let base = pe.image_base();
+        let file_len = pe.data().len();
+
+        let regions = pe
+            .sections()
+            .iter()
+            .filter(|s| s.characteristics & (IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE) != 0)
+            .filter_map(|s| {
+                let start = base.checked_add(s.virtual_address)?;
+                let len = match s.virtual_size {
+                    0 => s.size_of_raw_data,
+                    size => size.min(s.size_of_raw_data),
+                };
+                // Only bytes present in the file can be decoded; a header
+                // claiming more must not size the visited bitmaps
+                let present = file_len.saturating_sub(s.pointer_to_raw_data as usize);
+                let len = len.min(u32::try_from(present).unwrap_or(u32::MAX));
+                Some(CodeRegion {
+                    start,
+                    end: start.checked_add(len)?,
+                    offset: s.pointer_to_raw_data as usize,
+                })
+            })
+            .collect();
+
+        let imports = pe
+            .import_slots()
+            .filter_map(|(rva, name)| Some((base.checked_add(rva)?, name.to_string())))
+            .collect();
+
+        let mut methods = HashMap::new();
+        for (object_index, object) in vb_file.objects().iter().enumerate() {
+            for (method_index, method_name) in object.method_names.iter().enumerate() {
+                if let Some(entry) = vb_file.native_entry_for_method(object_index, method_index) {
+                    methods
+                        .entry(entry)
+                        .or_insert_with(|| format!("{}_{}", object.name, method_name));
+                }
+            }
+        }
+
+        Self::from_parts(regions, imports, methods)
+    }
+
+    fn from_parts(
+        regions: Vec<CodeRegion>,
+        imports: HashMap<u32, String>,
+        methods: HashMap<u32, String>,
+    ) -> Self {
+        let decoded = VisitedMap::new(&regions);
+        Self {
+            regions,
+            imports,
+            methods,
+            decoded,
+        }
+    }
+
+    /// Number of distinct instruction starts decoded so far, across all threads
+    pub fn decoded_instructions(&self) -> usize {
+        self.decoded.count()
+    }
+
+    /// Executable bytes of `data` from `va` to the end of its region
+    fn code_at<'d>(&self, data: &'d [u8], va: u32) -> Option<&'d [u8]> {
+        let region = self.regions.iter().find(|r| r.start <= va && va < r.end)?;
+        let start = region.offset.checked_add((va - region.start) as usize)?;
+        let end = region
+            .offset
+            .checked_add((region.end - region.start) as usize)?
+            .min(data.len());
+        data.get(start..end)
+    }
+
+    /// Recursively disassemble the function at `entry`
+    ///
+    /// Conditional branches are followed both ways and direct jumps to their
+    /// target; calls fall through. A path ends at a return, an indirect jump,
+    /// an interrupt, undecodable bytes or a jump out of the code sections. A
+    /// jump to another method's entry is a tail call and is not followed.
+    ///
+    /// A function that grows past `budget`'s instruction or byte limit is
+    /// taken to be a descent into data and abandoned with
+    /// [`Error::BudgetExceeded`], as is one still decoding at `deadline`.
+    pub fn disassemble_function(
+        &self,
+        data: &[u8],
+        entry: u32,
+        budget: &MethodBudget,
+        deadline: Option<Instant>,
+    ) -> Result<NativeFunction> {
+        if self.code_at(data, entry).is_none() {
+            return Err(Error::Decompilation(format!(
+                "Method entry 0x{:08X} is outside the code sections",
+                entry
+            )));
+        }
+
+        let mut instructions = Vec::new();
+        let mut seen = HashSet::new();
+        let mut pending = vec![entry];
+        let mut shared = 0;
+        let mut code_size = 0;
+
+        while let Some(start) = pending.pop() {
+            let Some(code) = self.code_at(data, start) else {
+                continue;
+            };
+            let mut decoder = Decoder::with_ip(32, code, u64::from(start), DecoderOptions::NONE);
+
+            // Decode one straight-line run
+            while decoder.can_decode() {
+                let ip = decoder.ip() as u32;
+                if !seen.insert(ip) {
+                    break;
+                }
+
+                let instr = decoder.decode();
+                if instr.is_invalid() {
+                    break;
+                }
+                if !self.decoded.claim(ip) {
+                    shared += 1;
+                }
+                instructions.push(instr);
+                code_size += instr.len();
+                budget.check_instructions(instructions.len())?;
+                budget.check_bytes(code_size)?;
+                if instructions.len() % DEADLINE_INTERVAL == 0 {
+                    MethodBudget::check_deadline(deadline)?;
+                }
+
+                match instr.flow_control() {
+                    FlowControl::Next | FlowControl::Call | FlowControl::IndirectCall => {}
+                    FlowControl::ConditionalBranch => {
+                        if let Some(target) = branch_target(&instr) {
+                            pending.push(target);
+                        }
+                    }
+                    FlowControl::UnconditionalBranch => {
+                        if let Some(target) = branch_target(&instr) {
+                            if !self.methods.contains_key(&target) {
+                                pending.push(target);
+                            }
+                        }
+                        break;
+                    }
+                    FlowControl::Return
+                    | FlowControl::IndirectBranch
+                    | FlowControl::Interrupt
+                    | FlowControl::XbeginXabortXend
+                    | FlowControl::Exception => break,
+                }
+            }
+        }
+
+        instructions.sort_unstable_by_key(Instruction::ip);
+        if shared > 0 {
+            log::debug!(
+                "    Function at 0x{:08X} shares {} instructions with other methods",
+                entry,
+                shared
+            );
+        }
+
+        Ok(NativeFunction {
+            entry,
+            instructions,
+            shared,
+        })
+    }
+
+    /// Name of the function called at `target`
+    ///
+    /// Method entries are named after their method, and a thunk that jumps
+    /// through an import slot after the import.
+    fn callee_name(&self, data: &[u8], target: u32) -> Option<&str> {
+        if let Some(name) = self.methods.get(&target) {
+            return Some(name);
+        }
+
+        let code = self.code_at(data, target)?;
+        let thunk = Decoder::with_ip(32, code, u64::from(target), DecoderOptions::NONE).decode();
+        if thunk.mnemonic() == Mnemonic::Jmp && thunk.op_kind(0) == OpKind::Memory {
+            return self.import_at(&thunk);
+        }
+        None
+    }
+
+    /// Import whose slot a `[disp32]` memory operand refers to
+    fn import_at(&self, instr: &Instruction) -> Option<&str> {
+        if instr.memory_base() != Register::None || instr.memory_index() != Register::None {
+            return None;
+        }
+        self.imports
+            .get(&instr.memory_displacement32())
+            .map(String::as_str)
+    }
+}
+
+/// Target of a direct near branch
+fn branch_target(instr: &Instruction) -> Option<u32> {
+    matches!(
+        instr.op_kind(0),
+        OpKind::NearBranch16 | OpKind::NearBranch32
+    )
+    .then(|| instr.near_branch_target() as u32)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    pub(super) const BASE: u32 = 0x0040_1000;
+
+    pub(super) fn image(methods: &[(u32, &str)], imports: &[(u32, &str)]) -> NativeImage {
+        NativeImage::from_parts(
+            vec![CodeRegion {
+                start: BASE,
+                end: BASE + 0x1000,
+                offset: 0,
+            }],
+            imports.iter().map(|&(va, n)| (va, n.to_string())).collect(),
+            methods.iter().map(|&(va, n)| (va, n.to_string())).collect(),
+        )
+    }
+
+    #[test]
+    fn test_visited_map_claims_once() {
+        let regions = [
+            CodeRegion {
+                start: 0x1000,
+                end: 0x1100,
+                offset: 0,
+            },
+            CodeRegion {
+                start: 0x7000_0000,
+                end: 0x7000_0040,
+                offset: 0x100,
+            },
+        ];
+        let map = VisitedMap::new(&regions);
+        assert!(map.claim(0x1000));
+        assert!(!map.claim(0x1000));
+        assert!(map.claim(0x10FF));
+        assert!(map.claim(0x7000_0000));
+        assert!(!map.claim(0x7000_0000));
+        // Outside the regions nothing is remembered
+        assert!(map.claim(0x2000));
+        assert!(map.claim(0x2000));
+        assert_eq!(map.count(), 3);
+
+        // Distant regions don't size one bitmap spanning the gap between them
+        let words: usize = map.regions.iter().map(|(_, _, w)| w.len()).sum();
+        assert_eq!(words, 4 + 1);
+    }
+
+    #[test]
+    fn test_descent_skips_data_after_return() {
+        // push ebp; mov ebp, esp; test eax, eax; je +1; inc eax; pop ebp; ret
+        // followed by bytes that are not code
+        let code = [
+            0x55, 0x8B, 0xEC, 0x85, 0xC0, 0x74, 0x01, 0x40, 0x5D, 0xC3, 0xFF, 0xFF, 0xFF,
+        ];
+        let image = image(&[], &[]);
+        let function = image
+            .disassemble_function(&code, BASE, &MethodBudget::default(), None)
+            .unwrap();
+
+        let ips: Vec<u32> = function
+            .instructions
+            .iter()
+            .map(|i| i.ip() as u32)
+            .collect();
+        assert_eq!(
+            ips,
+            [
+                BASE,
+                BASE + 1,
+                BASE + 3,
+                BASE + 5,
+                BASE + 7,
+                BASE + 8,
+                BASE + 9
+            ]
+        );
+        assert_eq!(function.code_size(), 10);
+        assert_eq!(function.shared, 0);
+
+        // A second function over the same code finds it already decoded
+        let again = image
+            .disassemble_function(&code, BASE + 3, &MethodBudget::default(), None)
+            .unwrap();
+        assert_eq!(again.shared, again.instructions.len());
+        assert_eq!(image.decoded_instructions(), 7);
+    }
+
+    #[test]
+    fn test_entry_outside_code() {
+        let image = image(&[], &[]);
+        let budget = MethodBudget::default();
+        assert!(image
+            .disassemble_function(&[0xC3], BASE + 0x2000, &budget, None)
+            .is_err());
+    }
+
+    #[test]
+    fn test_descent_stops_at_budget() {
+        // inc eax, repeated, then ret
+        let mut code = vec![0x40; 16];
+        code.push(0xC3);
+        let image = image(&[], &[]);
+
+        let instructions = MethodBudget {
+            max_instructions: 8,
+            ..MethodBudget::default()
+        };
+        let result = image.disassemble_function(&code, BASE, &instructions, None);
+        assert!(matches!(result, Err(Error::BudgetExceeded(_))));
+
+        let bytes = MethodBudget {
+            max_bytes: 4,
+            ..MethodBudget::default()
+        };
+        let result = image.disassemble_function(&code, BASE, &bytes, None);
+        assert!(matches!(result, Err(Error::BudgetExceeded(_))));
+
+        let function = image
+            .disassemble_function(&code, BASE, &MethodBudget::default(), None)
+            .unwrap();
+        assert_eq!(function.instructions.len(), 17);
+    }
+}
@@ -0,0 +1,715 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Lifting disassembled native functions into the arena IR
+
+use super::{branch_target, NativeFunction, NativeImage};
+use crate::error::{Error, Result};
+use crate::ir::arena::{ArenaFunction, ExprId, Stmt, VarRef};
+use crate::ir::{ExpressionKind, TypeKind};
+use iced_x86::{
+    ConditionCode, FlowControl, Formatter, Instruction, IntelFormatter, Mnemonic, OpKind, Register,
+};
+use std::collections::{HashMap, HashSet};
+
+/// Lift a disassembled function into `out`
+///
+/// `out` should be freshly [`reset`](ArenaFunction::reset); the entry block
+/// becomes block 0 and the others follow in address order. Fallthrough into
+/// a block that isn't written next becomes an explicit `GoTo`.
+pub fn lift_into(
+    image: &NativeImage,
+    data: &[u8],
+    function: &NativeFunction,
+    out: &mut ArenaFunction,
+) -> Result<()> {
+    let instructions = &function.instructions;
+    if instructions.is_empty() {
+        return Err(Error::Decompilation(format!(
+            "No instructions at 0x{:08X}",
+            function.entry
+        )));
+    }
+
+    // Block leaders: the entry, branch targets, and whatever follows a
+    // control transfer or a gap
+    let starts: HashSet<u32> = instructions.iter().map(|i| i.ip() as u32).collect();
+    let mut leaders = HashSet::from([function.entry]);
+    for (i, instr) in instructions.iter().enumerate() {
+        if i > 0 && instructions[i - 1].next_ip() != instr.ip() {
+            leaders.insert(instr.ip() as u32);
+        }
+        if !matches!(
+            instr.flow_control(),
+            FlowControl::Next | FlowControl::Call | FlowControl::IndirectCall
+        ) {
+            leaders.insert(instr.next_ip() as u32);
+        }
+        if let Some(target) = branch_target(instr) {
+            if instr.flow_control() != FlowControl::Call {
+                leaders.insert(target);
+            }
+        }
+    }
+    leaders.retain(|ip| starts.contains(ip));
+
+    let mut order: Vec<u32> = leaders.into_iter().collect();
+    order.sort_unstable();
+    let mut block_ids = HashMap::with_capacity(order.len());
+    block_ids.insert(function.entry, 0);
+    for &ip in order.iter().filter(|&&ip| ip != function.entry) {
+        block_ids.insert(ip, block_ids.len() as u32);
+        out.add_block();
+    }
+
+    let mut lifter = Lifter::new(image, data, out, &block_ids);
+    let mut first = 0;
+    for (i, block_start) in order.iter().enumerate() {
+        let end = match order.get(i + 1) {
+            Some(&next) => {
+                first + instructions[first..].partition_point(|x| (x.ip() as u32) < next)
+            }
+            None => instructions.len(),
+        };
+        let next = order.get(i + 1).copied();
+        lifter.lift_block(block_ids[block_start], &instructions[first..end], next);
+        first = end;
+    }
+    lifter.finish();
+
+    Ok(())
+}
+
+/// Variable a lifted operand lives in
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+enum VarKey {
+    Register(Register),
+    /// `[ebp + displacement]`
+    Frame(i32),
+}
+
+/// Operands of the last flag-setting instruction, compared by the next `jcc`
+#[derive(Debug, Clone, Copy)]
+struct Flags {
+    left: ExprId,
+    right: ExprId,
+}
+
+struct Lifter<'a> {
+    image: &'a NativeImage,
+    data: &'a [u8],
+    out: &'a mut ArenaFunction,
+    block_ids: &'a HashMap<u32, u32>,
+    formatter: IntelFormatter,
+    /// Assembly text of the instruction being kept as a comment
+    text: String,
+    vars: HashMap<VarKey, VarRef>,
+    /// Parameters by frame offset, ordered when the function is finished
+    params: Vec<(i32, VarRef)>,
+    /// Pushed call arguments, in push order
+    args: Vec<ExprId>,
+    flags: Option<Flags>,
+    /// Still in the entry block's register saves and frame setup
+    in_prologue: bool,
+}
+
+impl<'a> Lifter<'a> {
+    fn new(
+        image: &'a NativeImage,
+        data: &'a [u8],
+        out: &'a mut ArenaFunction,
+        block_ids: &'a HashMap<u32, u32>,
+    ) -> Self {
+        Self {
+            image,
+            data,
+            out,
+            block_ids,
+            formatter: IntelFormatter::new(),
+            text: String::new(),
+            vars: HashMap::new(),
+            params: Vec::new(),
+            args: Vec::new(),
+            flags: None,
+            in_prologue: true,
+        }
+    }
+
+    /// Lift one block; `next` is the leader that follows it in memory
+    fn lift_block(&mut self, id: u32, instructions: &[Instruction], next: Option<u32>) {
+        self.args.clear();
+        self.flags = None;
+        self.in_prologue = id == 0;
+
+        let Some((last, body)) = instructions.split_last() else {
+            return;
+        };
+        for instr in body {
+            self.lift_instruction(id, instr);
+        }
+
+        let falls_through = match last.flow_control() {
+            FlowControl::ConditionalBranch => {
+                match branch_target(last).and_then(|t| self.block_ids.get(&t)) {
+                    Some(&target) => {
+                        let condition = self.condition(last.condition_code());
+                        self.push(
+                            id,
+                            Stmt::Branch {
+                                condition,
+                                target_block: target,
+                            },
+                        );
+                        self.link(id, target);
+                    }
+                    None => self.comment(id, last),
+                }
+                true
+            }
+            FlowControl::UnconditionalBranch => {
+                match branch_target(last) {
+                    Some(target) => match self.block_ids.get(&target) {
+                        Some(&target) => {
+                            self.push(
+                                id,
+                                Stmt::Goto {
+                                    target_block: target,
+                                },
+                            );
+                            self.link(id, target);
+                        }
+                        None => {
+                            // Tail call into another function
+                            self.call(id, last, Some(target));
+                            self.push(id, Stmt::Return { value: None });
+                        }
+                    },
+                    None => self.comment(id, last),
+                }
+                false
+            }
+            FlowControl::Return => {
+                self.push(id, Stmt::Return { value: None });
+                false
+            }
+            FlowControl::IndirectBranch
+            | FlowControl::Interrupt
+            | FlowControl::XbeginXabortXend
+            | FlowControl::Exception => {
+                if last.mnemonic() != Mnemonic::Int3 {
+                    self.comment(id, last);
+                }
+                false
+            }
+            FlowControl::Next | FlowControl::Call | FlowControl::IndirectCall => {
+                self.lift_instruction(id, last);
+                true
+            }
+        };
+
+        // The next block in memory is only written next if its id follows
+        let fallthrough = next
+            .filter(|&ip| falls_through && ip == last.next_ip() as u32)
+            .and_then(|ip| self.block_ids.get(&ip).copied());
+        if let Some(target) = fallthrough {
+            if target != id + 1 {
+                self.push(
+                    id,
+                    Stmt::Goto {
+                        target_block: target,
+                    },
+                );
+            }
+            self.link(id, target);
+        }
+    }
+
+    /// Lift a non-terminating instruction, or keep it as a comment
+    fn lift_instruction(&mut self, id: u32, instr: &Instruction) {
+        let prologue = self.in_prologue;
+        self.in_prologue = prologue && is_frame_setup(instr);
+        if prologue && self.in_prologue {
+            return;
+        }
+
+        if !self.try_lift(id, instr) {
+            self.comment(id, instr);
+        }
+    }
+
+    fn try_lift(&mut self, id: u32, instr: &Instruction) -> bool {
+        // Stack pointer and frame pointer bookkeeping has no VB equivalent
+        if instr.op_count() > 0
+            && instr.op_kind(0) == OpKind::Register
+            && matches!(instr.op_register(0), Register::ESP | Register::EBP)
+            && instr.mnemonic() != Mnemonic::Push
+        {
+            return true;
+        }
+
+        match instr.mnemonic() {
+            Mnemonic::Nop | Mnemonic::Int3 | Mnemonic::Leave => true,
+            Mnemonic::Mov | Mnemonic::Movzx | Mnemonic::Movsx => {
+                let Some(value) = self.read(instr, 1) else {
+                    return false;
+                };
+                self.write(id, instr, value)
+            }
+            Mnemonic::Lea => {
+                let value = match frame_offset(instr) {
+                    Some(offset) => {
+                        let var = self.frame_var(offset);
+                        let var = self.out.variable(var);
+                        let list = self.out.push_list(&[var]);
+                        let name = self.out.intern("VarPtr");
+                        self.out.call(name, list, TypeKind::Long)
+                    }
+                    None => match self.address(instr) {
+                        Some(address) => address,
+                        None => return false,
+                    },
+                };
+                self.write(id, instr, value)
+            }
+            Mnemonic::Xor
+                if instr.op_kind(0) == OpKind::Register
+                    && instr.op_kind(1) == OpKind::Register
+                    && instr.op_register(0) == instr.op_register(1) =>
+            {
+                let zero = self.out.int_const(0);
+                self.write(id, instr, zero) && self.set_flags(instr)
+            }
+            Mnemonic::Add
+            | Mnemonic::Sub
+            | Mnemonic::And
+            | Mnemonic::Or
+            | Mnemonic::Xor
+            | Mnemonic::Imul
+                if instr.op_count() == 2 =>
+            {
+                let kind = match instr.mnemonic() {
+                    Mnemonic::Add => ExpressionKind::Add,
+                    Mnemonic::Sub => ExpressionKind::Subtract,
+                    Mnemonic::And => ExpressionKind::And,
+                    Mnemonic::Or => ExpressionKind::Or,
+                    Mnemonic::Xor => ExpressionKind::Xor,
+                    _ => ExpressionKind::Multiply,
+                };
+                let (Some(left), Some(right)) = (self.read(instr, 0), self.read(instr, 1)) else {
+                    return false;
+                };
+                let value = self.out.binary(kind, left, right, TypeKind::Long);
+                self.write(id, instr, value) && self.set_flags(instr)
+            }
+            Mnemonic::Inc | Mnemonic::Dec => {
+                let kind = if instr.mnemonic() == Mnemonic::Inc {
+                    ExpressionKind::Add
+                } else {
+                    ExpressionKind::Subtract
+                };
+                let Some(left) = self.read(instr, 0) else {
+                    return false;
+                };
+                let one = self.out.int_const(1);
+                let value = self.out.binary(kind, left, one, TypeKind::Long);
+                self.write(id, instr, value) && self.set_flags(instr)
+            }
+            Mnemonic::Neg | Mnemonic::Not => {
+                let kind = if instr.mnemonic() == Mnemonic::Neg {
+                    ExpressionKind::Negate
+                } else {
+                    ExpressionKind::Not
+                };
+                let Some(operand) = self.read(instr, 0) else {
+                    return false;
+                };
+                let value = self.out.unary(kind, operand, TypeKind::Long);
+                self.write(id, instr, value)
+            }
+            Mnemonic::Cmp => match (self.read(instr, 0), self.read(instr, 1)) {
+                (Some(left), Some(right)) => {
+                    self.flags = Some(Flags { left, right });
+                    true
+                }
+                _ => false,
+            },
+            Mnemonic::Test => {
+                let same = instr.op_kind(0) == OpKind::Register
+                    && instr.op_kind(1) == OpKind::Register
+                    && instr.op_register(0) == instr.op_register(1);
+                let (Some(left), Some(right)) = (self.read(instr, 0), self.read(instr, 1)) else {
+                    return false;
+                };
+                let left = if same {
+                    left
+                } else {
+                    self.out
+                        .binary(ExpressionKind::And, left, right, TypeKind::Long)
+                };
+                let right = self.out.int_const(0);
+                self.flags = Some(Flags { left, right });
+                true
+            }
+            Mnemonic::Push => match self.read(instr, 0) {
+                Some(value) => {
+                    self.args.push(value);
+                    true
+                }
+                None => false,
+            },
+            Mnemonic::Pop => match self.args.pop() {
+                Some(value) => self.write(id, instr, value),
+                // Restoring a register saved on entry
+                None => true,
+            },
+            Mnemonic::Call => {
+                self.call(id, instr, branch_target(instr));
+                true
+            }
+            _ => false,
+        }
+    }
+
+    /// Lift a call, or a tail jump, as `eax = callee(args)`
+    fn call(&mut self, id: u32, instr: &Instruction, target: Option<u32>) {
+        let mut args: Vec<ExprId> = self.args.drain(..).rev().collect();
+        self.flags = None;
+
+        let name = match target {
+            Some(target) => match self.image.callee_name(self.data, target) {
+                Some(name) => self.out.intern(name),
+                None => self.out.intern_fmt(format_args!("sub_{:08X}", target)),
+            },
+            None => match instr.op_kind(0) {
+                OpKind::Memory => match self.image.import_at(instr) {
+                    Some(name) => self.out.intern(name),
+                    // A COM method called through its object's vtable
+                    None => self
+                        .out
+                        .intern_fmt(format_args!("Vtbl_{:X}", instr.memory_displacement32())),
+                },
+                _ => match self.read(instr, 0) {
+                    Some(pointer) => {
+                        args.insert(0, pointer);
+                        self.out.intern("CallPtr")
+                    }
+                    None => {
+                        self.comment(id, instr);
+                        return;
+                    }
+                },
+            },
+        };
+
+        let list = self.out.push_list(&args);
+        let value = self.out.call(name, list, TypeKind::Long);
+        let target = self.var(VarKey::Register(Register::EAX));
+        self.push(id, Stmt::Assign { target, value });
+    }
+
+    /// Condition under which a `jcc` with `cc` is taken
+    fn condition(&mut self, cc: ConditionCode) -> ExprId {
+        let kind = match cc {
+            ConditionCode::e => Some(ExpressionKind::Equal),
+            ConditionCode::ne => Some(ExpressionKind::NotEqual),
+            ConditionCode::l | ConditionCode::b | ConditionCode::s => {
+                Some(ExpressionKind::LessThan)
+            }
+            ConditionCode::le | ConditionCode::be => Some(ExpressionKind::LessEqual),
+            ConditionCode::g | ConditionCode::a => Some(ExpressionKind::GreaterThan),
+            ConditionCode::ge | ConditionCode::ae | ConditionCode::ns => {
+                Some(ExpressionKind::GreaterEqual)
+            }
+            _ => None,
+        };
+
+        match (kind, self.flags) {
+            (Some(kind), Some(Flags { left, right })) => {
+                self.out.binary(kind, left, right, TypeKind::Boolean)
+            }
+            // Flags set by something that wasn't lifted
+            _ => {
+                let name = self.out.intern_fmt(format_args!("Cond_{:?}", cc));
+                let list = self.out.push_list(&[]);
+                self.out.call(name, list, TypeKind::Boolean)
+            }
+        }
+    }
+
+    /// Compare the destination of an arithmetic instruction against zero
+    fn set_flags(&mut self, instr: &Instruction) -> bool {
+        self.flags = self.read(instr, 0).map(|left| Flags {
+            left,
+            right: self.out.int_const(0),
+        });
+        true
+    }
+
+    /// Value of operand `op`, or None if it can't be expressed
+    fn read(&mut self, instr: &Instruction, op: u32) -> Option<ExprId> {
+        match instr.op_kind(op) {
+            OpKind::Register => {
+                let var = self.register_var(instr.op_register(op))?;
+                Some(self.out.variable(var))
+            }
+            OpKind::Immediate8
+            | OpKind::Immediate16
+            | OpKind::Immediate32
+            | OpKind::Immediate8to16
+            | OpKind::Immediate8to32 => {
+                Some(self.out.int_const(instr.immediate(op) as u32 as i32 as i64))
+            }
+            OpKind::Memory => match frame_offset(instr) {
+                Some(offset) => {
+                    let var = self.frame_var(offset);
+                    Some(self.out.variable(var))
+                }
+                None => {
+                    let address = self.address(instr)?;
+                    Some(
+                        self.out
+                            .unary(ExpressionKind::Load, address, TypeKind::Long),
+                    )
+                }
+            },
+            _ => None,
+        }
+    }
+
+    /// Assign `value` to the first operand
+    fn write(&mut self, id: u32, instr: &Instruction, value: ExprId) -> bool {
+        let stmt = match instr.op_kind(0) {
+            OpKind::Register => match self.register_var(instr.op_register(0)) {
+                Some(target) => Stmt::Assign { target, value },
+                None => return false,
+            },
+            OpKind::Memory => match frame_offset(instr) {
+                Some(offset) => Stmt::Assign {
+                    target: self.frame_var(offset),
+                    value,
+                },
+                None => match self.address(instr) {
+                    Some(address) => Stmt::Store { address, value },
+                    None => return false,
+                },
+            },
+            _ => return false,
+        };
+        self.push(id, stmt);
+        true
+    }
+
+    /// `base + index * scale + displacement` of the memory operand
+    fn address(&mut self, instr: &Instruction) -> Option<ExprId> {
+        let mut address = None;
+        if instr.memory_base() != Register::None {
+            let base = self.register_var(instr.memory_base())?;
+            address = Some(self.out.variable(base));
+        }
+        if instr.memory_index() != Register::None {
+            let index = self.register_var(instr.memory_index())?;
+            let mut index = self.out.variable(index);
+            let scale = instr.memory_index_scale();
+            if scale > 1 {
+                let scale = self.out.int_const(i64::from(scale));
+                index = self
+                    .out
+                    .binary(ExpressionKind::Multiply, index, scale, TypeKind::Long);
+            }
+            address = Some(match address {
+                Some(base) => self
+                    .out
+                    .binary(ExpressionKind::Add, base, index, TypeKind::Long),
+                None => index,
+            });
+        }
+
+        let displacement = instr.memory_displacement32();
+        Some(match address {
+            // An absolute address
+            None => self.out.int_const(i64::from(displacement)),
+            Some(address) if displacement == 0 => address,
+            Some(address) => {
+                let signed = displacement as i32;
+                let kind = if signed < 0 {
+                    ExpressionKind::Subtract
+                } else {
+                    ExpressionKind::Add
+                };
+                let offset = self.out.int_const(i64::from(signed.unsigned_abs()));
+                self.out.binary(kind, address, offset, TypeKind::Long)
+            }
+        })
+    }
+
+    fn register_var(&mut self, register: Register) -> Option<VarRef> {
+        register_name(register)?;
+        Some(self.var(VarKey::Register(register)))
+    }
+
+    fn frame_var(&mut self, offset: i32) -> VarRef {
+        self.var(VarKey::Frame(offset))
+    }
+
+    /// Variable for `key`, declared the first time it is used
+    fn var(&mut self, key: VarKey) -> VarRef {
+        if let Some(&var) = self.vars.get(&key) {
+            return var;
+        }
+
+        let name = match key {
+            VarKey::Register(register) => self.out.intern(register_name(register).unwrap_or("reg")),
+            VarKey::Frame(offset) if offset < 0 => self
+                .out
+                .intern_fmt(format_args!("var_{:X}", offset.unsigned_abs())),
+            VarKey::Frame(offset) => self.out.intern_fmt(format_args!("arg_{:X}", offset)),
+        };
+        let var = VarRef {
+            id: self.vars.len() as u32,
+            name,
+            var_type: TypeKind::Long,
+        };
+        self.vars.insert(key, var);
+        match key {
+            VarKey::Frame(offset) if offset >= 0 => self.params.push((offset, var)),
+            _ => self.out.local_variables.push(var),
+        }
+        var
+    }
+
+    /// Keep an instruction as a comment line
+    fn comment(&mut self, id: u32, instr: &Instruction) {
+        self.text.clear();
+        self.formatter.format(instr, &mut self.text);
+        let name = self.out.intern_fmt(format_args!("' {}", self.text));
+        let arguments = self.out.push_list(&[]);
+        self.push(
+            id,
+            Stmt::Call {
+                function: name,
+                arguments,
+            },
+        );
+    }
+
+    fn push(&mut self, id: u32, stmt: Stmt) {
+        if let Some(block) = self.out.block_mut(id) {
+            block.statements.push(stmt);
+        }
+    }
+
+    fn link(&mut self, from: u32, to: u32) {
+        if let Some(block) = self.out.block_mut(from) {
+            block.add_successor(to);
+        }
+        if let Some(block) = self.out.block_mut(to) {
+            block.add_predecessor(from);
+        }
+    }
+
+    /// Declare the parameters in stack order
+    fn finish(mut self) {
+        self.params.sort_unstable_by_key(|&(offset, _)| offset);
+        self.out
+            .parameters
+            .extend(self.params.iter().map(|&(_, var)| var));
+    }
+}
+
+/// Variable name of a general-purpose register that holds values
+fn register_name(register: Register) -> Option<&'static str> {
+    Some(match register {
+        Register::EAX => "eax",
+        Register::ECX => "ecx",
+        Register::EDX => "edx",
+        Register::EBX => "ebx",
+        Register::ESI => "esi",
+        Register::EDI => "edi",
+        _ => return None,
+    })
+}
+
+/// Offset of a `[ebp + displacement]` operand
+fn frame_offset(instr: &Instruction) -> Option<i32> {
+    (instr.memory_base() == Register::EBP && instr.memory_index() == Register::None)
+        .then(|| instr.memory_displacement32() as i32)
+}
+
+/// Whether an instruction saves registers or sets up the stack frame
+fn is_frame_setup(instr: &Instruction) -> bool {
+    let register = |op| instr.op_kind(op) == OpKind::Register;
+    match instr.mnemonic() {
+        Mnemonic::Push => register(0),
+        Mnemonic::Mov | Mnemonic::Sub | Mnemonic::And => {
+            register(0) && matches!(instr.op_register(0), Register::ESP | Register::EBP)
+        }
+        _ => false,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::budget::MethodBudget;
+    use crate::codegen::VB6CodeGenerator;
+    use crate::native::tests::{image, BASE};
+
+    fn decompile(image: &NativeImage, code: &[u8], entry: u32) -> String {
+        let function = image
+            .disassemble_function(code, entry, &MethodBudget::default(), None)
+            .unwrap();
+        let mut out = ArenaFunction::new("Form1_Load".to_string(), TypeKind::Void);
+        lift_into(image, code, &function, &mut out).unwrap();
+        let mut text = String::new();
+        VB6CodeGenerator::new()
+            .write_arena_function(&out, &mut text)
+            .unwrap();
+        text
+    }
+
+    #[test]
+    fn test_lift_branch_locals_and_calls() {
+        // push ebp; mov ebp, esp
+        // mov eax, [ebp+8]; cmp eax, 5; jne skip
+        // push 1; call [iat]; mov [ebp-4], eax
+        // skip: call method; pop ebp; ret
+        let mut code = vec![0x55, 0x8B, 0xEC];
+        code.extend([0x8B, 0x45, 0x08, 0x83, 0xF8, 0x05, 0x75, 0x0B]);
+        code.extend([0x6A, 0x01, 0xFF, 0x15]);
+        code.extend(0x0040_3000u32.to_le_bytes());
+        code.extend([0x89, 0x45, 0xFC]);
+        code.push(0xE8);
+        let skip = BASE + code.len() as u32 - 1;
+        let method = BASE + 0x100;
+        code.extend((method as i32 - (skip as i32 + 5)).to_le_bytes());
+        code.extend([0x5D, 0xC3]);
+        code.resize(0x101, 0xCC);
+        code.push(0xC3);
+
+        let image = image(
+            &[(method, "Module1_Helper")],
+            &[(0x0040_3000, "__vbaStrCopy")],
+        );
+        let text = decompile(&image, &code, BASE);
+
+        assert!(text.starts_with("Sub Form1_Load(arg_8 As Long)\n"));
+        assert!(text.contains("Dim eax As Long\n"));
+        assert!(text.contains("Dim var_4 As Long\n"));
+        assert!(text.contains("eax = arg_8\n"));
+        assert!(text.contains("    If (eax = 5) Then\n        eax = __vbaStrCopy(1)\n"));
+        assert!(text.contains("        var_4 = eax\n    End If\n"));
+        assert!(!text.contains("GoTo"));
+        assert!(text.contains("eax = Module1_Helper()\n"));
+        assert!(text.contains("Exit Sub\n"));
+        assert!(text.ends_with("End Sub"));
+    }
+
+    #[test]
+    fn test_lift_keeps_unknown_instructions_as_comments() {
+        // cpuid; ret
+        let code = [0x0F, 0xA2, 0xC3];
+        let text = decompile(&image(&[], &[]), &code, BASE);
+        assert!(text.contains("' cpuid\n"));
+    }
+}
@@ -3,6 +3,7 @@
 //! This module detects common executable packers/compressors used with VB executables.
 //! Detection methods include:
 //! - Section name analysis (UPX, ASPack, PECompact signatures)
+//! - Stub banners found by the shared signature scanner
 //! - Entropy analysis (high entropy indicates compression/encryption)
 //! - Import table characteristics
 //!
@@ -14,7 +15,12 @@
 //! - FSG (Fast Small Good) - Small free packer
 //! - Petite - Fast packer
 
+use crate::scan::{self, ImageMarkers, Marker};
+use goblin::pe::section_table::SectionTable;
 use goblin::pe::PE;
+use rayon::prelude::*;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::OnceLock;
 use thiserror::Error;
 
 /// Error type for packer detection
@@ -109,7 +115,7 @@ impl PackerType {
 }
 
 /// Packer detection result
-#[derive(Debug)]
+#[derive(Debug, Clone)]
 pub struct PackerDetection {
     /// Detected packer type
     pub packer: PackerType,
@@ -127,6 +133,9 @@ pub enum DetectionMethod {
     /// Section name signature
     SectionName,
 
+    /// Byte signature left in the unpacking stub
+    Signature,
+
     /// High entropy analysis
     Entropy,
 
@@ -140,7 +149,34 @@ pub enum DetectionMethod {
 /// High entropy threshold (0-8 scale, 8 = maximum entropy)
 const HIGH_ENTROPY_THRESHOLD: f64 = 7.2;
 
+/// Entropy of each section's raw data (`None` if it has none in the file),
+/// filled in lazily so no section is measured twice
+pub(crate) type SectionEntropyCache = [OnceLock<Option<f64>>];
+
+/// Shannon entropy of one section's raw data
+#[derive(Debug, Clone, PartialEq)]
+pub struct SectionEntropy {
+    /// Section name with trailing NULs removed
+    pub name: String,
+    pub virtual_address: u32,
+    /// Size of the section's raw data in the file
+    pub raw_size: u32,
+    /// Entropy on the 0-8 scale, or `None` if the section has no raw data
+    pub entropy: Option<f64>,
+}
+
+impl SectionEntropy {
+    /// Whether the entropy is above the packer detection threshold
+    pub fn is_high(&self) -> bool {
+        self.entropy.map_or(false, |e| e > HIGH_ENTROPY_THRESHOLD)
+    }
+}
+
 /// Detect if a PE executable is packed
+///
+/// Parses the headers itself; when a [`PEFile`](crate::pe::PEFile) exists
+/// already, use [`PEFile::packer`](crate::pe::PEFile::packer) instead, which
+/// reuses its parse.
 pub fn detect_packer(pe_data: &[u8]) -> Result<Option<PackerDetection>, PackerError> {
     // Try lightweight section name detection first (doesn't parse full PE)
     // This works even on packed files where resources are corrupted
@@ -148,33 +184,36 @@ pub fn detect_packer(pe_data: &[u8]) -> Result<Option<PackerDetection>, PackerEr
         return Ok(Some(detection));
     }
 
+    let markers = scan::scan_image(pe_data);
+
     // Now try full PE parse for more sophisticated detection
-    // Use parse_unchecked to skip resource validation
     let pe = match PE::parse(pe_data) {
         Ok(pe) => pe,
         Err(_) => {
             // If full parse fails (e.g., corrupted resources in packed file),
-            // fall back to basic entropy analysis on the whole file
-            return Ok(detect_by_raw_entropy(pe_data));
+            // fall back to stub banners and basic entropy analysis on the whole file
+            return Ok(detect_by_signatures(&markers).or_else(|| detect_by_raw_entropy(pe_data)));
         }
     };
 
-    // Try section name detection with full PE
-    if let Some(detection) = detect_by_section_names(&pe) {
-        return Ok(Some(detection));
-    }
-
-    // Try entropy analysis (medium confidence)
-    if let Some(detection) = detect_by_entropy(&pe, pe_data) {
-        return Ok(Some(detection));
-    }
-
-    // Try import table analysis (low confidence)
-    if let Some(detection) = detect_by_imports(&pe) {
-        return Ok(Some(detection));
-    }
+    let entropy = new_entropy_cache(&pe.sections);
+    Ok(detect_packer_parsed(&pe, pe_data, &markers, &entropy))
+}
 
-    Ok(None)
+/// Detect a packer from an already parsed PE and its signature scan
+pub(crate) fn detect_packer_parsed(
+    pe: &PE,
+    pe_data: &[u8],
+    markers: &ImageMarkers,
+    entropy: &SectionEntropyCache,
+) -> Option<PackerDetection> {
+    // Section names (high confidence), then stub banners, which survive renamed sections
+    detect_by_section_names(pe)
+        .or_else(|| detect_by_signatures(markers))
+        // Entropy analysis (medium confidence)
+        .or_else(|| detect_by_entropy(&pe.sections, pe_data, entropy))
+        // Import table analysis (low confidence)
+        .or_else(|| detect_by_imports(pe))
 }
 
 /// Detect packer by section names
@@ -379,6 +418,23 @@ fn detect_by_section_names_raw(pe_data: &[u8]) -> Option<PackerDetection> {
     None
 }
 
+/// Detect packer by banners the scanner found in the image
+fn detect_by_signatures(markers: &ImageMarkers) -> Option<PackerDetection> {
+    let packer = if markers.get(Marker::UpxBanner).is_some() {
+        PackerType::UPX
+    } else if markers.get(Marker::PECompactBanner).is_some() {
+        PackerType::PECompact
+    } else {
+        return None;
+    };
+
+    Some(PackerDetection {
+        packer,
+        confidence: 0.85,
+        method: DetectionMethod::Signature,
+    })
+}
+
 /// Detect packer by whole-file entropy (fallback when PE parse fails)
 fn detect_by_raw_entropy(pe_data: &[u8]) -> Option<PackerDetection> {
     // Sample first 64KB for performance
@@ -397,35 +453,43 @@ fn detect_by_raw_entropy(pe_data: &[u8]) -> Option<PackerDetection> {
 }
 
 /// Detect packer by entropy analysis
-fn detect_by_entropy(pe: &PE, pe_data: &[u8]) -> Option<PackerDetection> {
-    let mut high_entropy_count = 0;
-    let mut total_sections = 0;
-
-    for section in &pe.sections {
-        if section.size_of_raw_data == 0 {
-            continue;
-        }
-
-        let start = section.pointer_to_raw_data as usize;
-        let size = section.size_of_raw_data as usize;
+///
+/// Sections are measured in parallel, largest first, and measuring stops as
+/// soon as the outcome of the majority vote can no longer change.
+fn detect_by_entropy(
+    sections: &[SectionTable],
+    pe_data: &[u8],
+    cache: &SectionEntropyCache,
+) -> Option<PackerDetection> {
+    let mut candidates: Vec<usize> = (0..sections.len())
+        .filter(|&i| section_data(&sections[i], pe_data).is_some())
+        .collect();
+    candidates.sort_by_key(|&i| std::cmp::Reverse(sections[i].size_of_raw_data));
+
+    // Packed if more than 60% of the sections have high entropy
+    let total = candidates.len();
+    let is_packed = |high: usize| high * 5 > total * 3;
+    let high = AtomicUsize::new(0);
+    let low = AtomicUsize::new(0);
+    let settled = || {
+        let high = high.load(Ordering::Relaxed);
+        let low = low.load(Ordering::Relaxed);
+        is_packed(high) || !is_packed(total - low)
+    };
 
-        // Bounds check
-        if start >= pe_data.len() || start + size > pe_data.len() {
-            continue;
+    candidates.par_iter().for_each(|&i| {
+        if settled() {
+            return;
         }
-
-        let section_data = &pe_data[start..start + size];
-        let section_entropy = calculate_shannon_entropy(section_data);
-
-        total_sections += 1;
-
-        if section_entropy > HIGH_ENTROPY_THRESHOLD {
-            high_entropy_count += 1;
+        let entropy = cache[i].get_or_init(|| measure_section(&sections[i], pe_data));
+        if entropy.map_or(false, |e| e > HIGH_ENTROPY_THRESHOLD) {
+            high.fetch_add(1, Ordering::Relaxed);
+        } else {
+            low.fetch_add(1, Ordering::Relaxed);
         }
-    }
+    });
 
-    // If most sections have high entropy, likely packed
-    if total_sections > 0 && high_entropy_count as f64 / total_sections as f64 > 0.6 {
+    if total > 0 && is_packed(high.into_inner()) {
         return Some(PackerDetection {
             packer: PackerType::Unknown,
             confidence: 0.70,
@@ -436,6 +500,45 @@ fn detect_by_entropy(pe: &PE, pe_data: &[u8]) -> Option<PackerDetection> {
     None
 }
 
+/// Empty entropy cache for `sections`
+pub(crate) fn new_entropy_cache(sections: &[SectionTable]) -> Vec<OnceLock<Option<f64>>> {
+    sections.iter().map(|_| OnceLock::new()).collect()
+}
+
+/// Entropy of every section, measuring those not yet in `cache` in parallel
+pub(crate) fn section_entropy(
+    sections: &[SectionTable],
+    pe_data: &[u8],
+    cache: &SectionEntropyCache,
+) -> Vec<SectionEntropy> {
+    sections
+        .par_iter()
+        .zip(cache)
+        .map(|(section, slot)| SectionEntropy {
+            name: String::from_utf8_lossy(&section.name)
+                .trim_end_matches('\0')
+                .to_string(),
+            virtual_address: section.virtual_address,
+            raw_size: section.size_of_raw_data,
+            entropy: *slot.get_or_init(|| measure_section(section, pe_data)),
+        })
+        .collect()
+}
+
+/// Raw data of a section, if it is non-empty and inside the file
+fn section_data<'d>(section: &SectionTable, pe_data: &'d [u8]) -> Option<&'d [u8]> {
+    if section.size_of_raw_data == 0 {
+        return None;
+    }
+    let start = section.pointer_to_raw_data as usize;
+    let end = start.checked_add(section.size_of_raw_data as usize)?;
+    pe_data.get(start..end)
+}
+
+fn measure_section(section: &SectionTable, pe_data: &[u8]) -> Option<f64> {
+    section_data(section, pe_data).map(calculate_shannon_entropy)
+}
+
 /// Detect packer by import table characteristics
 fn detect_by_imports(pe: &PE) -> Option<PackerDetection> {
     // Packers often have very few imports
@@ -461,12 +564,7 @@ fn calculate_shannon_entropy(data: &[u8]) -> f64 {
         return 0.0;
     }
 
-    // Count byte frequencies
-    let mut freq = [0u32; 256];
-    for &byte in data {
-        freq[byte as usize] += 1;
-    }
-
+    let freq = byte_histogram(data);
     let len = data.len() as f64;
     let mut entropy = 0.0;
 
@@ -480,6 +578,36 @@ fn calculate_shannon_entropy(data: &[u8]) -> f64 {
     entropy
 }
 
+/// Count byte frequencies
+///
+/// A single table serializes on runs of equal bytes (each increment waits for
+/// the previous store to the same counter), so each byte lane of a 32-bit word
+/// goes to its own sub-histogram. The four tables are summed at the end in a
+/// loop the compiler vectorizes.
+fn byte_histogram(data: &[u8]) -> [u32; 256] {
+    let mut sub = [[0u32; 256]; 4];
+
+    let mut chunks = data.chunks_exact(16);
+    for chunk in &mut chunks {
+        for word in chunk.chunks_exact(4) {
+            let word = u32::from_le_bytes([word[0], word[1], word[2], word[3]]);
+            sub[0][(word & 0xFF) as usize] += 1;
+            sub[1][((word >> 8) & 0xFF) as usize] += 1;
+            sub[2][((word >> 16) & 0xFF) as usize] += 1;
+            sub[3][(word >> 24) as usize] += 1;
+        }
+    }
+    for (i, &byte) in chunks.remainder().iter().enumerate() {
+        sub[i & 3][byte as usize] += 1;
+    }
+
+    let mut freq = [0u32; 256];
+    for (i, count) in freq.iter_mut().enumerate() {
+        *count = sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+    }
+    freq
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -514,6 +642,31 @@ mod tests {
         assert_eq!(entropy, 0.0);
     }
 
+    #[test]
+    fn test_byte_histogram_matches_scalar() {
+        let data: Vec<u8> = (0..1000u32).map(|i| (i * i % 251) as u8).collect();
+        // Lengths around the 16-byte chunking
+        for len in [0, 1, 15, 16, 17, 63, 1000] {
+            let mut expected = [0u32; 256];
+            for &byte in &data[..len] {
+                expected[byte as usize] += 1;
+            }
+            assert_eq!(byte_histogram(&data[..len]), expected, "length {}", len);
+        }
+    }
+
+    #[test]
+    fn test_detect_by_upx_banner() {
+        let mut data = vec![0u8; 1024];
+        let banner = b"$Info: This file is packed with the UPX executable packer";
+        data[512..512 + banner.len()].copy_from_slice(banner);
+
+        let detection = detect_by_signatures(&scan::scan_image(&data)).unwrap();
+        assert_eq!(detection.packer, PackerType::UPX);
+        assert_eq!(detection.method, DetectionMethod::Signature);
+        assert!(detect_by_signatures(&scan::scan_image(&[0u8; 1024])).is_none());
+    }
+
     #[test]
     fn test_packer_type_name() {
         assert_eq!(PackerType::UPX.name(), "UPX");
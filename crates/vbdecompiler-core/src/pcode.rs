@@ -7,8 +7,18 @@
 //! Decodes Visual Basic P-Code (bytecode) into instruction representations.
 //! P-Code is a stack-based bytecode format with variable-length instructions.
 
+mod drive;
+mod table;
+
+pub use table::{Lift, Opcode};
+
 use crate::error::{Error, Result};
+use drive::ScanStep;
+use std::borrow::Cow;
 use std::fmt;
+use std::ops::Deref;
+use std::time::Instant;
+use table::{get_opcode_info, is_extended_opcode, DecodeSpec, OperandKind};
 
 /// P-Code opcode category
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -60,17 +70,20 @@ impl PCodeType {
 }
 
 /// P-Code operand value
+///
+/// String literals borrow from the P-Code bytes and are only copied when they
+/// are not valid UTF-8.
 #[derive(Debug, Clone)]
-pub enum OperandValue {
+pub enum OperandValue<'a> {
     None,
     Byte(u8),
     Int16(i16),
     Int32(i32),
     Float(f32),
-    String(String),
+    String(Cow<'a, str>),
 }
 
-impl fmt::Display for OperandValue {
+impl fmt::Display for OperandValue<'_> {
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         match self {
             Self::None => write!(f, ""),
@@ -85,26 +98,81 @@ impl fmt::Display for OperandValue {
 
 /// P-Code instruction operand
 #[derive(Debug, Clone)]
-pub struct Operand {
-    pub value: OperandValue,
+pub struct Operand<'a> {
+    pub value: OperandValue<'a>,
     pub data_type: PCodeType,
 }
 
-impl Operand {
-    fn new(value: OperandValue, data_type: PCodeType) -> Self {
+impl<'a> Operand<'a> {
+    fn new(value: OperandValue<'a>, data_type: PCodeType) -> Self {
         Self { value, data_type }
     }
+
+    const fn none() -> Self {
+        Self {
+            value: OperandValue::None,
+            data_type: PCodeType::Unknown,
+        }
+    }
+}
+
+/// Maximum number of operands any opcode format decodes
+pub const MAX_OPERANDS: usize = 4;
+
+/// Inline, fixed-capacity operand list (derefs to a slice)
+#[derive(Debug, Clone)]
+pub struct Operands<'a> {
+    items: [Operand<'a>; MAX_OPERANDS],
+    len: usize,
+}
+
+impl<'a> Operands<'a> {
+    const fn new() -> Self {
+        Self {
+            items: [
+                Operand::none(),
+                Operand::none(),
+                Operand::none(),
+                Operand::none(),
+            ],
+            len: 0,
+        }
+    }
+
+    fn push(&mut self, operand: Operand<'a>) -> Result<()> {
+        let slot = self
+            .items
+            .get_mut(self.len)
+            .ok_or_else(|| Error::parse("Too many operands"))?;
+        *slot = operand;
+        self.len += 1;
+        Ok(())
+    }
+}
+
+impl<'a> Deref for Operands<'a> {
+    type Target = [Operand<'a>];
+
+    fn deref(&self) -> &Self::Target {
+        &self.items[..self.len]
+    }
 }
 
 /// P-Code instruction representation
+///
+/// Borrows its raw bytes and string operands from the disassembled P-Code;
+/// decoding an instruction performs no heap allocation.
 #[derive(Debug, Clone)]
-pub struct Instruction {
+pub struct Instruction<'a> {
     pub address: u32,
     pub opcode: u8,
     pub extended_opcode: Option<u8>,
-    pub mnemonic: String,
-    pub operands: Vec<Operand>,
-    pub bytes: Vec<u8>,
+    /// Table id of `opcode`; the lifter dispatches on it
+    pub op: Opcode,
+    /// Mnemonic from the opcode table (`"Extended"` for 0xFB-0xFF prefixes)
+    pub mnemonic: &'static str,
+    pub operands: Operands<'a>,
+    pub bytes: &'a [u8],
     pub category: OpcodeCategory,
     pub stack_delta: i32,
     pub is_branch: bool,
@@ -114,16 +182,17 @@ pub struct Instruction {
     pub branch_offset: Option<i32>,
 }
 
-impl Instruction {
+impl<'a> Instruction<'a> {
     /// Create a new instruction
     fn new(address: u32, opcode: u8) -> Self {
         Self {
             address,
             opcode,
             extended_opcode: None,
-            mnemonic: String::new(),
-            operands: Vec::new(),
-            bytes: Vec::new(),
+            op: Opcode::Unknown,
+            mnemonic: "",
+            operands: Operands::new(),
+            bytes: &[],
             category: OpcodeCategory::Unknown,
             stack_delta: 0,
             is_branch: false,
@@ -143,10 +212,15 @@ impl Instruction {
             .collect::<Vec<_>>()
             .join(", ");
 
+        let mnemonic: Cow<'_, str> = match self.extended_opcode {
+            Some(ext) => Cow::Owned(format!("Extended_{:02X}_{:02X}", self.opcode, ext)),
+            None => Cow::Borrowed(self.mnemonic),
+        };
+
         if operands_str.is_empty() {
-            format!("{:08X}  {}", self.address, self.mnemonic)
+            format!("{:08X}  {}", self.address, mnemonic)
         } else {
-            format!("{:08X}  {}  {}", self.address, self.mnemonic, operands_str)
+            format!("{:08X}  {}  {}", self.address, mnemonic, operands_str)
         }
     }
 
@@ -160,192 +234,82 @@ impl Instruction {
     }
 }
 
-/// Opcode information entry
-#[derive(Clone, Copy)]
-struct OpcodeInfo {
-    mnemonic: &'static str,
-    format: &'static str,
-    category: OpcodeCategory,
-    stack_delta: i32,
-    is_branch: bool,
-    is_conditional_branch: bool,
-    is_call: bool,
-    is_return: bool,
+/// P-Code disassembler over a borrowed byte slice
+///
+/// Instructions borrow from the slice, so P-Code can be decoded straight out
+/// of the PE image without copying.
+#[derive(Clone)]
+pub struct Disassembler<'a> {
+    data: &'a [u8],
+    offset: usize,
+    /// Most instructions one call may decode
+    max_instructions: usize,
+    deadline: Option<Instant>,
 }
 
-impl OpcodeInfo {
-    const fn new(
-        mnemonic: &'static str,
-        format: &'static str,
-        category: OpcodeCategory,
-        stack_delta: i32,
-    ) -> Self {
+impl<'a> Disassembler<'a> {
+    /// Create a new disassembler for the given P-Code bytes
+    pub fn new(data: &'a [u8]) -> Self {
         Self {
-            mnemonic,
-            format,
-            category,
-            stack_delta,
-            is_branch: false,
-            is_conditional_branch: false,
-            is_call: false,
-            is_return: false,
+            data,
+            offset: 0,
+            max_instructions: usize::MAX,
+            deadline: None,
         }
     }
 
-    const fn with_branch(mut self, conditional: bool) -> Self {
-        self.is_branch = true;
-        self.is_conditional_branch = conditional;
+    /// Fail with [`Error::BudgetExceeded`] after decoding more than `max` instructions
+    pub fn with_instruction_limit(mut self, max: usize) -> Self {
+        self.max_instructions = max;
         self
     }
 
-    const fn with_call(mut self) -> Self {
-        self.is_call = true;
+    /// Fail with [`Error::BudgetExceeded`] once `deadline` has passed
+    ///
+    /// Checked every [`DEADLINE_INTERVAL`](crate::budget::DEADLINE_INTERVAL) instructions.
+    pub fn with_deadline(mut self, deadline: Option<Instant>) -> Self {
+        self.deadline = deadline;
         self
     }
 
-    const fn with_return(mut self) -> Self {
-        self.is_return = true;
-        self
-    }
-}
-
-/// Get opcode information for standard opcodes (0x00-0xFA)
-fn get_opcode_info(opcode: u8) -> &'static OpcodeInfo {
-    // Define only the most common/important opcodes
-    // This is a subset - expand as needed
-    static OPCODES: [OpcodeInfo; 256] = {
-        let mut table = [OpcodeInfo::new("Unknown", "", OpcodeCategory::Unknown, 0); 256];
-
-        // Control flow
-        table[0x13] =
-            OpcodeInfo::new("ExitProcHresult", "", OpcodeCategory::ControlFlow, 0).with_return();
-        table[0x14] = OpcodeInfo::new("ExitProc", "", OpcodeCategory::ControlFlow, 0).with_return();
-        table[0x1C] =
-            OpcodeInfo::new("BranchF", "l", OpcodeCategory::ControlFlow, -1).with_branch(true);
-        table[0x1D] =
-            OpcodeInfo::new("BranchT", "l", OpcodeCategory::ControlFlow, -1).with_branch(true);
-        table[0x1E] =
-            OpcodeInfo::new("Branch", "l", OpcodeCategory::ControlFlow, 0).with_branch(false);
-        table[0x4B] = OpcodeInfo::new("OnErrorGoto", "l", OpcodeCategory::ControlFlow, 0);
-
-        // Stack operations - literals
-        table[0x1B] = OpcodeInfo::new("LitStr", "z", OpcodeCategory::Stack, 1);
-        table[0x27] = OpcodeInfo::new("LitVar_Missing", "", OpcodeCategory::Stack, 1);
-        table[0x28] = OpcodeInfo::new("LitVarI2", "a%", OpcodeCategory::Stack, 1);
-        table[0x3A] = OpcodeInfo::new("LitVarStr", "az", OpcodeCategory::Stack, 1);
-        table[0x5E] = OpcodeInfo::new("LitI2", "a%", OpcodeCategory::Stack, 1);
-        table[0x5F] = OpcodeInfo::new("LitI4", "d&", OpcodeCategory::Stack, 1);
-        table[0x60] = OpcodeInfo::new("LitR4", "f!", OpcodeCategory::Stack, 1);
-        table[0x61] = OpcodeInfo::new("LitR8", "g#", OpcodeCategory::Stack, 1);
-        table[0xA7] = OpcodeInfo::new("LitVarI2_Byte", "b%", OpcodeCategory::Stack, 1);
-
-        // Variable operations
-        table[0x04] = OpcodeInfo::new("FLdRfVar", "a", OpcodeCategory::Variable, 1);
-        table[0x43] = OpcodeInfo::new("FStStrCopy", "a", OpcodeCategory::String, -1);
-        table[0x62] = OpcodeInfo::new("FLdPrThis", "", OpcodeCategory::Variable, 1);
-        table[0x69] = OpcodeInfo::new("FLdI2", "a", OpcodeCategory::Variable, 1);
-        table[0x6A] = OpcodeInfo::new("FLdI4", "a", OpcodeCategory::Variable, 1);
-        table[0x6D] = OpcodeInfo::new("FStI2", "a", OpcodeCategory::Variable, -1);
-        table[0x6E] = OpcodeInfo::new("FStI4", "a", OpcodeCategory::Variable, -1);
-
-        // Function/method calls
-        table[0x05] = OpcodeInfo::new("ImpAdLdRf", "c", OpcodeCategory::Call, 1);
-        table[0x09] = OpcodeInfo::new("ImpAdCallHresult", "", OpcodeCategory::Call, 0).with_call();
-        table[0x0A] = OpcodeInfo::new("ImpAdCallFPR4", "x", OpcodeCategory::Call, 0).with_call();
-        table[0x0D] = OpcodeInfo::new("VCallHresult", "v", OpcodeCategory::Call, 0).with_call();
-        table[0x7F] = OpcodeInfo::new("CallHresult", "n", OpcodeCategory::Call, 0).with_call();
-        table[0x80] = OpcodeInfo::new("CallI2", "n", OpcodeCategory::Call, 1).with_call();
-        table[0x81] = OpcodeInfo::new("CallI4", "n", OpcodeCategory::Call, 1).with_call();
-
-        // String operations
-        table[0x2A] = OpcodeInfo::new("ConcatStr", "", OpcodeCategory::String, -1);
-        table[0x2F] = OpcodeInfo::new("FFree1Str", "", OpcodeCategory::String, 0);
-        table[0x32] = OpcodeInfo::new("FFreeStr", "", OpcodeCategory::String, 0);
-        table[0x33] = OpcodeInfo::new("LdFixedStr", "z", OpcodeCategory::String, 1);
-        table[0x34] = OpcodeInfo::new("CStr2Ansi", "", OpcodeCategory::String, 0);
-        table[0x4A] = OpcodeInfo::new("FnLenStr", "", OpcodeCategory::String, 0);
-
-        // Array operations
-        table[0x3B] = OpcodeInfo::new("Ary1StStrCopy", "", OpcodeCategory::Array, -2);
-        table[0x40] = OpcodeInfo::new("Ary1LdRf", "", OpcodeCategory::Array, 0);
-        table[0x41] = OpcodeInfo::new("Ary1LdPr", "", OpcodeCategory::Array, 0);
-
-        // Memory management
-        table[0x1A] = OpcodeInfo::new("FFree1Ad", "", OpcodeCategory::Memory, 0);
-        table[0x29] = OpcodeInfo::new("FFreeAd", "", OpcodeCategory::Memory, 0);
-        table[0x35] = OpcodeInfo::new("FFree1Var", "", OpcodeCategory::Memory, 0);
-        table[0x36] = OpcodeInfo::new("FFreeVar", "", OpcodeCategory::Memory, 0);
-
-        // Arithmetic
-        table[0x95] = OpcodeInfo::new("AddI2", "", OpcodeCategory::Arithmetic, -1);
-        table[0x96] = OpcodeInfo::new("SubI2", "", OpcodeCategory::Arithmetic, -1);
-        table[0x97] = OpcodeInfo::new("MulI2", "", OpcodeCategory::Arithmetic, -1);
-        table[0x9A] = OpcodeInfo::new("NegI2", "", OpcodeCategory::Arithmetic, 0);
-
-        // Comparison
-        table[0xA0] = OpcodeInfo::new("EqI2", "", OpcodeCategory::Comparison, -1);
-        table[0xA1] = OpcodeInfo::new("NeI2", "", OpcodeCategory::Comparison, -1);
-        table[0xA2] = OpcodeInfo::new("LeI2", "", OpcodeCategory::Comparison, -1);
-        table[0xA3] = OpcodeInfo::new("GeI2", "", OpcodeCategory::Comparison, -1);
-        table[0xA4] = OpcodeInfo::new("LtI2", "", OpcodeCategory::Comparison, -1);
-        table[0xA5] = OpcodeInfo::new("GtI2", "", OpcodeCategory::Comparison, -1);
-
-        table
-    };
-
-    &OPCODES[opcode as usize]
-}
-
-/// Check if opcode is extended (0xFB-0xFF)
-fn is_extended_opcode(opcode: u8) -> bool {
-    opcode >= 0xFB
-}
-
-/// P-Code disassembler
-pub struct Disassembler {
-    data: Vec<u8>,
-    offset: usize,
-}
-
-impl Disassembler {
-    /// Create a new disassembler for the given P-Code bytes
-    pub fn new(data: Vec<u8>) -> Self {
-        Self { data, offset: 0 }
-    }
-
     /// Disassemble all instructions starting from the current offset
-    pub fn disassemble(&mut self, address: u32) -> Result<Vec<Instruction>> {
+    pub fn disassemble(&mut self, address: u32) -> Result<Vec<Instruction<'a>>> {
         let mut instructions = Vec::new();
-        let mut current_address = address;
-
-        while self.offset < self.data.len() {
-            match self.disassemble_one(current_address) {
-                Ok(instr) => {
-                    current_address += instr.bytes.len() as u32;
-
-                    // Check if this is a return instruction
-                    let is_return = instr.is_return;
-
-                    instructions.push(instr);
+        self.disassemble_into(address, &mut instructions)?;
+        Ok(instructions)
+    }
 
-                    // Stop at procedure exit
-                    if is_return {
-                        break;
-                    }
-                }
-                Err(e) => {
-                    // If we encounter an error, stop disassembly
-                    eprintln!("Disassembly error at offset {}: {}", self.offset, e);
-                    break;
-                }
-            }
-        }
+    /// Disassemble like [`disassemble`](Self::disassemble), appending to `instructions`
+    ///
+    /// Lets callers decoding many methods reuse one instruction buffer.
+    pub fn disassemble_into(
+        &mut self,
+        address: u32,
+        instructions: &mut Vec<Instruction<'a>>,
+    ) -> Result<()> {
+        self.drive(address, None, |this, address| {
+            let instr = this.disassemble_one(address)?;
+            let step = ScanStep {
+                branch_offset: instr.branch_offset,
+                is_branch: instr.is_branch,
+                is_return: instr.is_return,
+            };
+            instructions.push(instr);
+            Ok(step)
+        })?;
+        Ok(())
+    }
 
-        Ok(instructions)
+    /// Decode the instruction at the current offset as `address`
+    ///
+    /// Applies no stop rule or limits; [`Self::scan_branches`] finds where a
+    /// procedure ends.
+    pub fn decode_next(&mut self, address: u32) -> Result<Instruction<'a>> {
+        self.disassemble_one(address)
     }
 
     /// Disassemble a single instruction at the current offset
-    fn disassemble_one(&mut self, address: u32) -> Result<Instruction> {
+    fn disassemble_one(&mut self, address: u32) -> Result<Instruction<'a>> {
         let start_offset = self.offset;
 
         if self.offset >= self.data.len() {
@@ -360,12 +324,14 @@ impl Disassembler {
         if is_extended_opcode(opcode) {
             let ext_opcode = self.read_byte()?;
             instr.extended_opcode = Some(ext_opcode);
-            instr.mnemonic = format!("Extended_{:02X}_{:02X}", opcode, ext_opcode);
+            instr.op = Opcode::Extended;
+            instr.mnemonic = Opcode::Extended.mnemonic();
             instr.category = OpcodeCategory::Unknown;
         } else {
             // Standard opcode
             let opcode_info = get_opcode_info(opcode);
-            instr.mnemonic = opcode_info.mnemonic.to_string();
+            instr.op = opcode_info.op;
+            instr.mnemonic = opcode_info.op.mnemonic();
             instr.category = opcode_info.category;
             instr.stack_delta = opcode_info.stack_delta;
             instr.is_branch = opcode_info.is_branch;
@@ -373,168 +339,147 @@ impl Disassembler {
             instr.is_call = opcode_info.is_call;
             instr.is_return = opcode_info.is_return;
 
-            // Decode operands based on format string
-            self.decode_operands(&mut instr, opcode_info.format)?;
+            // Decode operands from the precompiled layout
+            self.decode_operands(&mut instr, &opcode_info.decode)?;
         }
 
-        // Copy raw bytes
-        instr.bytes = self.data[start_offset..self.offset].to_vec();
+        // Borrow raw bytes
+        instr.bytes = &self.data[start_offset..self.offset];
 
         Ok(instr)
     }
 
-    /// Decode operands based on format string
-    fn decode_operands(&mut self, instr: &mut Instruction, format: &str) -> Result<()> {
-        for ch in format.bytes() {
-            match ch {
-                b'a' => {
-                    // Byte argument
-                    let val = self.read_byte()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Byte(val), PCodeType::Unknown));
-                }
-                b'b' => {
-                    // Byte literal
-                    let val = self.read_byte()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Byte(val), PCodeType::Byte));
-                }
-                b'c' => {
-                    // Control reference (2 bytes)
-                    let val = self.read_i16()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Int16(val), PCodeType::Unknown));
-                }
-                b'd' => {
-                    // 32-bit integer literal
-                    let val = self.read_i32()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Int32(val), PCodeType::Long));
-                }
-                b'f' => {
-                    // 32-bit float literal
-                    let val = self.read_f32()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Float(val), PCodeType::Single));
-                }
-                b'l' => {
-                    // Branch offset (2 bytes, signed)
-                    let offset = self.read_i16()?;
-                    instr.branch_offset = Some(offset as i32);
-                    instr.operands.push(Operand::new(
-                        OperandValue::Int16(offset),
-                        PCodeType::Unknown,
-                    ));
-                }
-                b'n' => {
-                    // Call argument count (2 bytes)
-                    let val = self.read_i16()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Int16(val), PCodeType::Unknown));
-                }
-                b'v' => {
-                    // VTable entry (2 bytes)
-                    let val = self.read_i16()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Int16(val), PCodeType::Unknown));
-                }
-                b'x' => {
-                    // Extended argument
-                    let val = self.read_byte()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::Byte(val), PCodeType::Unknown));
-                }
-                b'z' => {
-                    // Null-terminated string
-                    let s = self.read_string()?;
-                    instr
-                        .operands
-                        .push(Operand::new(OperandValue::String(s), PCodeType::String));
-                }
-                b'%' | b'&' | b'!' | b'#' | b'~' => {
-                    // Type suffix - already captured in previous operand
-                }
-                _ => {
-                    // Unknown format character - skip
-                }
+    /// Decode operands using the opcode's precompiled layout
+    fn decode_operands(&mut self, instr: &mut Instruction<'a>, spec: &DecodeSpec) -> Result<()> {
+        if !spec.has_string {
+            // Fast path: one bounds check, then fixed-width reads
+            let operand_bytes = self.take(spec.fixed_len)?;
+            let mut pos = 0;
+            for &kind in spec.kinds() {
+                let width = kind.width();
+                Self::push_fixed(instr, kind, &operand_bytes[pos..pos + width])?;
+                pos += width;
+            }
+            return Ok(());
+        }
+
+        for &kind in spec.kinds() {
+            if kind == OperandKind::Str {
+                let s = self.read_string()?;
+                instr
+                    .operands
+                    .push(Operand::new(OperandValue::String(s), PCodeType::String))?;
+            } else {
+                let bytes = self.take(kind.width())?;
+                Self::push_fixed(instr, kind, bytes)?;
             }
         }
 
         Ok(())
     }
 
-    /// Read a single byte
-    fn read_byte(&mut self) -> Result<u8> {
-        if self.offset >= self.data.len() {
-            return Err(Error::parse("Unexpected end of data"));
-        }
-        let val = self.data[self.offset];
-        self.offset += 1;
-        Ok(val)
+    /// Decode one fixed-width operand from exactly `kind.width()` bytes
+    fn push_fixed(instr: &mut Instruction<'a>, kind: OperandKind, bytes: &[u8]) -> Result<()> {
+        let operand = match kind {
+            OperandKind::ArgByte | OperandKind::ExtArg => {
+                Operand::new(OperandValue::Byte(bytes[0]), PCodeType::Unknown)
+            }
+            OperandKind::LitByte => Operand::new(OperandValue::Byte(bytes[0]), PCodeType::Byte),
+            OperandKind::ControlRef | OperandKind::ArgCount | OperandKind::VTable => {
+                let val = i16::from_le_bytes([bytes[0], bytes[1]]);
+                Operand::new(OperandValue::Int16(val), PCodeType::Unknown)
+            }
+            OperandKind::Branch => {
+                let offset = i16::from_le_bytes([bytes[0], bytes[1]]);
+                instr.branch_offset = Some(offset as i32);
+                Operand::new(OperandValue::Int16(offset), PCodeType::Unknown)
+            }
+            OperandKind::LitI4 => {
+                let val = i32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]);
+                Operand::new(OperandValue::Int32(val), PCodeType::Long)
+            }
+            OperandKind::LitR4 => {
+                let val = f32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]);
+                Operand::new(OperandValue::Float(val), PCodeType::Single)
+            }
+            OperandKind::Str => unreachable!("strings are not fixed-width"),
+        };
+
+        instr.operands.push(operand)
     }
 
-    /// Read a 16-bit signed integer (little-endian)
-    fn read_i16(&mut self) -> Result<i16> {
-        if self.offset + 2 > self.data.len() {
-            return Err(Error::parse("Unexpected end of data"));
+    /// Advance past the next instruction without decoding its operands
+    ///
+    /// Returns the instruction length in bytes. Useful for scanning to a branch
+    /// target or counting instructions when operand values are not needed.
+    pub fn skip_one(&mut self) -> Result<usize> {
+        let start_offset = self.offset;
+        let opcode = self.read_byte()?;
+
+        if is_extended_opcode(opcode) {
+            self.read_byte()?;
+        } else {
+            let spec = &get_opcode_info(opcode).decode;
+            if spec.has_string {
+                for &kind in spec.kinds() {
+                    if kind == OperandKind::Str {
+                        self.skip_string()?;
+                    } else {
+                        self.take(kind.width())?;
+                    }
+                }
+            } else {
+                self.take(spec.fixed_len)?;
+            }
         }
-        let val = i16::from_le_bytes([self.data[self.offset], self.data[self.offset + 1]]);
-        self.offset += 2;
-        Ok(val)
+
+        Ok(self.offset - start_offset)
     }
 
-    /// Read a 32-bit signed integer (little-endian)
-    fn read_i32(&mut self) -> Result<i32> {
-        if self.offset + 4 > self.data.len() {
-            return Err(Error::parse("Unexpected end of data"));
-        }
-        let val = i32::from_le_bytes([
-            self.data[self.offset],
-            self.data[self.offset + 1],
-            self.data[self.offset + 2],
-            self.data[self.offset + 3],
-        ]);
-        self.offset += 4;
-        Ok(val)
+    /// Current offset into the P-Code bytes
+    pub fn offset(&self) -> usize {
+        self.offset
+    }
+
+    /// Consume `len` bytes, failing if fewer remain
+    fn take(&mut self, len: usize) -> Result<&'a [u8]> {
+        let data = self.data;
+        let bytes = data
+            .get(self.offset..self.offset + len)
+            .ok_or_else(|| Error::parse("Unexpected end of data"))?;
+        self.offset += len;
+        Ok(bytes)
     }
 
-    /// Read a 32-bit float (little-endian)
-    fn read_f32(&mut self) -> Result<f32> {
-        if self.offset + 4 > self.data.len() {
+    /// Read a single byte
+    fn read_byte(&mut self) -> Result<u8> {
+        if self.offset >= self.data.len() {
             return Err(Error::parse("Unexpected end of data"));
         }
-        let val = f32::from_le_bytes([
-            self.data[self.offset],
-            self.data[self.offset + 1],
-            self.data[self.offset + 2],
-            self.data[self.offset + 3],
-        ]);
-        self.offset += 4;
+        let val = self.data[self.offset];
+        self.offset += 1;
         Ok(val)
     }
 
     /// Read a null-terminated string
-    fn read_string(&mut self) -> Result<String> {
+    fn read_string(&mut self) -> Result<Cow<'a, str>> {
+        let data = self.data;
         let start = self.offset;
-        while self.offset < self.data.len() && self.data[self.offset] != 0 {
-            self.offset += 1;
-        }
+        self.skip_string()?;
 
-        if self.offset >= self.data.len() {
-            return Err(Error::parse("Unterminated string"));
-        }
+        // Exclude the null terminator
+        Ok(String::from_utf8_lossy(&data[start..self.offset - 1]))
+    }
 
-        let s = String::from_utf8_lossy(&self.data[start..self.offset]).to_string();
-        self.offset += 1; // Skip null terminator
-        Ok(s)
+    /// Skip a null-terminated string, including the terminator
+    fn skip_string(&mut self) -> Result<()> {
+        let rest = &self.data[self.offset.min(self.data.len())..];
+        let len = rest
+            .iter()
+            .position(|&b| b == 0)
+            .ok_or_else(|| Error::parse("Unterminated string"))?;
+        self.offset += len + 1;
+        Ok(())
     }
 }
 
@@ -545,7 +490,7 @@ mod tests {
     #[test]
     fn test_exit_proc_opcode() {
         let data = vec![0x14]; // ExitProc
-        let mut disasm = Disassembler::new(data);
+        let mut disasm = Disassembler::new(&data);
         let result = disasm.disassemble(0x1000).unwrap();
 
         assert_eq!(result.len(), 1);
@@ -556,7 +501,7 @@ mod tests {
     #[test]
     fn test_branch_opcode() {
         let data = vec![0x1E, 0x10, 0x00]; // Branch +16
-        let mut disasm = Disassembler::new(data);
+        let mut disasm = Disassembler::new(&data);
         let result = disasm.disassemble(0x1000).unwrap();
 
         assert_eq!(result.len(), 1);
@@ -568,11 +513,62 @@ mod tests {
     #[test]
     fn test_lit_i2_opcode() {
         let data = vec![0x5E, 0x2A, 0x14]; // LitI2 42, ExitProc (removed extra byte)
-        let mut disasm = Disassembler::new(data);
+        let mut disasm = Disassembler::new(&data);
         let result = disasm.disassemble(0x1000).unwrap();
 
         assert_eq!(result.len(), 2);
         assert_eq!(result[0].mnemonic, "LitI2");
         assert_eq!(result[0].operands.len(), 1);
     }
+
+    #[test]
+    fn test_instruction_borrows_input() {
+        // LitStr "Hi", ExitProc
+        let data = vec![0x1B, b'H', b'i', 0x00, 0x14];
+        let mut disasm = Disassembler::new(&data);
+        let result = disasm.disassemble(0x1000).unwrap();
+
+        assert_eq!(result.len(), 2);
+        assert_eq!(result[0].bytes, &data[..4]);
+        assert_eq!(result[0].bytes.as_ptr(), data.as_ptr());
+        match &result[0].operands[0].value {
+            OperandValue::String(Cow::Borrowed(s)) => assert_eq!(*s, "Hi"),
+            other => panic!("expected borrowed string, got {:?}", other),
+        }
+    }
+
+    #[test]
+    fn test_skip_matches_decode() {
+        // LitI4 7, LitVarStr 1 "ab", Branch -2, FFree1Str, ExitProc
+        let data = vec![
+            0x5F, 0x07, 0x00, 0x00, 0x00, 0x3A, 0x01, b'a', b'b', 0x00, 0x1E, 0xFE, 0xFF, 0x2F,
+            0x14,
+        ];
+        let decoded = Disassembler::new(&data).disassemble(0).unwrap();
+
+        let mut skipper = Disassembler::new(&data);
+        for instr in &decoded {
+            assert_eq!(skipper.skip_one().unwrap(), instr.bytes.len());
+        }
+        assert_eq!(skipper.offset(), data.len());
+        assert_eq!(decoded[2].branch_offset, Some(-2));
+    }
+
+    #[test]
+    fn test_truncated_operand() {
+        let data = vec![0x5F, 0x07, 0x00]; // LitI4 missing two bytes
+        assert!(Disassembler::new(&data).skip_one().is_err());
+        assert!(Disassembler::new(&data).disassemble(0).unwrap().is_empty());
+    }
+
+    #[test]
+    fn test_extended_opcode_text() {
+        let data = vec![0xFB, 0x12];
+        let mut disasm = Disassembler::new(&data);
+        let result = disasm.disassemble(0).unwrap();
+
+        assert_eq!(result[0].mnemonic, "Extended");
+        assert_eq!(result[0].extended_opcode, Some(0x12));
+        assert!(result[0].to_string().contains("Extended_FB_12"));
+    }
 }
@@ -0,0 +1,215 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! The decode loop shared by disassembly and the branch pre-scan
+//!
+//! [`Disassembler::disassemble_into`] and [`Disassembler::scan_branches`]
+//! both run the loop here, so they stop at the same instruction and apply
+//! the same instruction and time limits.
+
+use super::table::{get_opcode_info, is_extended_opcode, OperandKind};
+use super::Disassembler;
+use crate::budget::{expired, DEADLINE_INTERVAL};
+use crate::error::{Error, Result};
+
+/// Control-flow shape of one decoded instruction, as the disassembly loop needs it
+#[derive(Default)]
+pub(super) struct ScanStep {
+    pub(super) branch_offset: Option<i32>,
+    pub(super) is_branch: bool,
+    pub(super) is_return: bool,
+}
+
+impl<'a> Disassembler<'a> {
+    /// Find where [`disassemble_into`](Self::disassemble_into) would stop,
+    /// collecting branch targets without decoding other operands
+    ///
+    /// Applies the same stop rule and limits, and appends the target of each
+    /// branch with a non-zero offset to `targets` in instruction order.
+    /// Returns the number of instructions and bytes that would be decoded.
+    pub fn scan_branches(
+        &mut self,
+        address: u32,
+        targets: &mut Vec<u32>,
+    ) -> Result<(usize, usize)> {
+        self.drive(address, Some(targets), |this, _| this.scan_one())
+    }
+
+    /// Decode instructions from the current offset until the procedure ends
+    ///
+    /// `step` decodes the instruction at the given address. Stops at a return
+    /// that no branch jumps past, or before an instruction that fails to
+    /// decode. Returns the number of instructions and bytes decoded.
+    pub(super) fn drive(
+        &mut self,
+        address: u32,
+        mut targets: Option<&mut Vec<u32>>,
+        mut step: impl FnMut(&mut Self, u32) -> Result<ScanStep>,
+    ) -> Result<(usize, usize)> {
+        let start = self.offset;
+        let mut current_address = address;
+        // Address just past the method's bytes
+        let end = address.saturating_add((self.data.len() - start) as u32);
+        // Furthest forward branch target inside the method seen so far
+        let mut furthest = address;
+        let mut decoded = 0;
+
+        while self.offset < self.data.len() {
+            if decoded == self.max_instructions {
+                return Err(Error::BudgetExceeded(format!(
+                    "more than {} instructions",
+                    self.max_instructions
+                )));
+            }
+            if decoded % DEADLINE_INTERVAL == 0 && expired(self.deadline) {
+                return Err(Error::BudgetExceeded(format!(
+                    "time limit passed after {} instructions",
+                    decoded
+                )));
+            }
+
+            let instr_start = self.offset;
+            let shape = match step(self, current_address) {
+                Ok(shape) => shape,
+                Err(e) => {
+                    // Keep what was decoded before the bad instruction
+                    log::warn!("Disassembly error at offset {}: {}", instr_start, e);
+                    self.offset = instr_start;
+                    break;
+                }
+            };
+            decoded += 1;
+            current_address += (self.offset - instr_start) as u32;
+
+            // A target before address 0 is bogus and ignored; one past the
+            // end must not keep a return from ending the method
+            let target = shape
+                .branch_offset
+                .and_then(|offset| Some((offset, current_address.checked_add_signed(offset)?)));
+            if let Some((offset, target)) = target {
+                if target < end {
+                    furthest = furthest.max(target);
+                }
+                if let Some(targets) = targets.as_deref_mut() {
+                    if shape.is_branch && offset != 0 {
+                        targets.push(target);
+                    }
+                }
+            }
+
+            // Stop at procedure exit, unless a branch jumps past it
+            if shape.is_return && current_address > furthest {
+                break;
+            }
+        }
+
+        Ok((decoded, self.offset - start))
+    }
+
+    /// Advance past the next instruction, reading only what
+    /// [`Self::scan_branches`] needs
+    fn scan_one(&mut self) -> Result<ScanStep> {
+        let opcode = self.read_byte()?;
+        if is_extended_opcode(opcode) {
+            self.read_byte()?;
+            return Ok(ScanStep::default());
+        }
+
+        let info = get_opcode_info(opcode);
+        let mut step = ScanStep {
+            branch_offset: None,
+            is_branch: info.is_branch,
+            is_return: info.is_return,
+        };
+        for &kind in info.decode.kinds() {
+            match kind {
+                OperandKind::Str => self.skip_string()?,
+                OperandKind::Branch => {
+                    let bytes = self.take(2)?;
+                    step.branch_offset = Some(i16::from_le_bytes([bytes[0], bytes[1]]) as i32);
+                }
+                _ => {
+                    self.take(kind.width())?;
+                }
+            }
+        }
+
+        Ok(step)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::time::Instant;
+
+    #[test]
+    fn test_instruction_limit() {
+        // LitI2 1, LitI2 2, ExitProc
+        let data = vec![0x5E, 0x01, 0x5E, 0x02, 0x14];
+        let decoded = Disassembler::new(&data)
+            .with_instruction_limit(3)
+            .disassemble(0)
+            .unwrap();
+        assert_eq!(decoded.len(), 3);
+
+        let result = Disassembler::new(&data)
+            .with_instruction_limit(2)
+            .disassemble(0);
+        assert!(matches!(result, Err(Error::BudgetExceeded(_))));
+
+        let expired = Disassembler::new(&data)
+            .with_deadline(Some(Instant::now()))
+            .disassemble(0);
+        assert!(matches!(expired, Err(Error::BudgetExceeded(_))));
+    }
+
+    #[test]
+    fn test_scan_matches_disassemble() {
+        // LitI2 1, BranchT +1, ExitProc, OnErrorGoto 0, ExitProc, trailing LitI2
+        let data = vec![
+            0x5E, 0x01, 0x1D, 0x01, 0x00, 0x14, 0x4B, 0x00, 0x00, 0x14, 0x5E,
+        ];
+        let decoded = Disassembler::new(&data).disassemble(0).unwrap();
+
+        let mut targets = Vec::new();
+        let mut scanner = Disassembler::new(&data);
+        let (count, len) = scanner.scan_branches(0, &mut targets).unwrap();
+        assert_eq!(count, decoded.len());
+        assert_eq!(len, decoded.iter().map(|i| i.bytes.len()).sum::<usize>());
+        assert_eq!(targets, vec![6]);
+
+        // Decoding one instruction at a time gives the same instructions
+        let mut disasm = Disassembler::new(&data);
+        for instr in &decoded {
+            let next = disasm.decode_next(instr.address).unwrap();
+            assert_eq!(next.bytes, instr.bytes);
+            assert_eq!(next.op, instr.op);
+        }
+
+        // A truncated instruction ends the scan before it
+        let truncated = [0x5E, 0x01, 0x5F, 0x07];
+        let (count, len) = Disassembler::new(&truncated)
+            .scan_branches(0, &mut targets)
+            .unwrap();
+        assert_eq!((count, len), (1, 2));
+    }
+
+    #[test]
+    fn test_bogus_targets_do_not_extend_method() {
+        // Branch -100 (before address 0), ExitProc, trailing LitI2
+        let backward = [0x1E, 0x9C, 0xFF, 0x14, 0x5E, 0x01];
+        let mut targets = Vec::new();
+        let (count, _) = Disassembler::new(&backward)
+            .scan_branches(0, &mut targets)
+            .unwrap();
+        assert_eq!(count, 2);
+        assert!(targets.is_empty());
+
+        // LitI2 1, BranchT +1000 (past the end), ExitProc, trailing LitI2
+        let forward = [0x5E, 0x01, 0x1D, 0xE8, 0x03, 0x14, 0x5E, 0x02];
+        let decoded = Disassembler::new(&forward).disassemble(0).unwrap();
+        assert_eq!(decoded.len(), 3);
+    }
+}
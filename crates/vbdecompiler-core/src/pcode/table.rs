@@ -0,0 +1,368 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! The opcode table
+//!
+//! One `opcode_table!` row per standard opcode gives its [`Opcode`] id,
+//! mnemonic, operand layout, control-flow flags and [`Lift`] kind. Operand
+//! layouts are compiled from format strings at build time.
+
+use super::OpcodeCategory;
+use crate::ir::{ExpressionKind, TypeKind};
+
+/// Operand encoding, compiled from an opcode format character
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum OperandKind {
+    /// `a` - byte argument
+    ArgByte,
+    /// `b` - byte literal
+    LitByte,
+    /// `c` - control reference (2 bytes)
+    ControlRef,
+    /// `d` - 32-bit integer literal
+    LitI4,
+    /// `f` - 32-bit float literal
+    LitR4,
+    /// `l` - signed branch offset (2 bytes)
+    Branch,
+    /// `n` - call argument count (2 bytes)
+    ArgCount,
+    /// `v` - vtable entry (2 bytes)
+    VTable,
+    /// `x` - extended argument (1 byte)
+    ExtArg,
+    /// `z` - null-terminated string
+    Str,
+}
+
+impl OperandKind {
+    /// Map a format character to its operand kind
+    ///
+    /// Type suffixes (`%`, `&`, `!`, `#`, `~`) and unknown characters decode
+    /// nothing and yield `None`.
+    const fn from_format(ch: u8) -> Option<Self> {
+        match ch {
+            b'a' => Some(Self::ArgByte),
+            b'b' => Some(Self::LitByte),
+            b'c' => Some(Self::ControlRef),
+            b'd' => Some(Self::LitI4),
+            b'f' => Some(Self::LitR4),
+            b'l' => Some(Self::Branch),
+            b'n' => Some(Self::ArgCount),
+            b'v' => Some(Self::VTable),
+            b'x' => Some(Self::ExtArg),
+            b'z' => Some(Self::Str),
+            _ => None,
+        }
+    }
+
+    /// Encoded width in bytes (0 for variable-length strings)
+    pub(super) const fn width(self) -> usize {
+        match self {
+            Self::ArgByte | Self::LitByte | Self::ExtArg => 1,
+            Self::ControlRef | Self::Branch | Self::ArgCount | Self::VTable => 2,
+            Self::LitI4 | Self::LitR4 => 4,
+            Self::Str => 0,
+        }
+    }
+}
+
+/// Per-opcode operand layout, compiled from the format string at build time
+#[derive(Debug, Clone, Copy)]
+pub(super) struct DecodeSpec {
+    kinds: [OperandKind; MAX_OPERANDS],
+    count: usize,
+    /// Total width of all fixed-size operands
+    pub(super) fixed_len: usize,
+    /// Whether any operand is a variable-length string
+    pub(super) has_string: bool,
+}
+
+impl DecodeSpec {
+    const fn compile(format: &str) -> Self {
+        let bytes = format.as_bytes();
+        let mut spec = Self {
+            kinds: [OperandKind::ArgByte; MAX_OPERANDS],
+            count: 0,
+            fixed_len: 0,
+            has_string: false,
+        };
+
+        let mut i = 0;
+        while i < bytes.len() {
+            if let Some(kind) = OperandKind::from_format(bytes[i]) {
+                assert!(
+                    spec.count < MAX_OPERANDS,
+                    "opcode format has too many operands"
+                );
+                spec.kinds[spec.count] = kind;
+                spec.count += 1;
+                spec.fixed_len += kind.width();
+                if matches!(kind, OperandKind::Str) {
+                    spec.has_string = true;
+                }
+            }
+            i += 1;
+        }
+
+        spec
+    }
+
+    pub(super) fn kinds(&self) -> &[OperandKind] {
+        &self.kinds[..self.count]
+    }
+}
+
+/// What the lifter does with an opcode
+///
+/// Chosen per opcode in the opcode table, so the lifter dispatches on this
+/// instead of inspecting mnemonics.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Lift {
+    /// No IR effect (yet)
+    Ignore,
+    /// Push the first operand as a constant
+    Literal,
+    /// Push the local variable indexed by the first operand, of the given type
+    LoadLocal(TypeKind),
+    /// Pop a value into the local variable indexed by the first operand, of
+    /// the given type
+    StoreLocal(TypeKind),
+    /// Pop two values and push the operation on them, of the given type
+    Binary(ExpressionKind, TypeKind),
+    /// Pop one value and push the operation on it, of the given type
+    Unary(ExpressionKind, TypeKind),
+    /// Jump by the branch offset; conditional branches pop their condition
+    /// and jump when it is true, or false if `negate`
+    Branch { negate: bool },
+    /// Leave the procedure, popping a return value if `value`
+    Return { value: bool },
+    /// Call; functions push their result, subroutines become a statement
+    Call { returns: bool },
+}
+
+/// Opcode information entry
+#[derive(Clone, Copy)]
+pub(super) struct OpcodeInfo {
+    pub(super) op: Opcode,
+    pub(super) decode: DecodeSpec,
+    pub(super) category: OpcodeCategory,
+    pub(super) stack_delta: i32,
+    pub(super) is_branch: bool,
+    pub(super) is_conditional_branch: bool,
+    pub(super) is_call: bool,
+    pub(super) is_return: bool,
+}
+
+impl OpcodeInfo {
+    const fn new(
+        op: Opcode,
+        format: &'static str,
+        category: OpcodeCategory,
+        stack_delta: i32,
+    ) -> Self {
+        Self {
+            op,
+            decode: DecodeSpec::compile(format),
+            category,
+            stack_delta,
+            is_branch: false,
+            is_conditional_branch: false,
+            is_call: false,
+            is_return: false,
+        }
+    }
+
+    const fn with_branch(mut self, conditional: bool) -> Self {
+        self.is_branch = true;
+        self.is_conditional_branch = conditional;
+        self
+    }
+
+    const fn with_call(mut self) -> Self {
+        self.is_call = true;
+        self
+    }
+
+    const fn with_return(mut self) -> Self {
+        self.is_return = true;
+        self
+    }
+}
+
+/// Build [`Opcode`], its mnemonics and lifting, and the decode table from
+/// one row per opcode:
+///
+/// `byte => Mnemonic(format, category, stack delta) [.flags()], lifting;`
+macro_rules! opcode_table {
+    ($(
+        $byte:literal => $name:ident($format:literal, $category:ident, $delta:expr)
+            $(.$flag:ident($($arg:expr),*))*, $lift:expr;
+    )*) => {
+        /// Compact id of a decoded opcode, handed to the lifter
+        #[allow(non_camel_case_types)]
+        #[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+        #[repr(u8)]
+        pub enum Opcode {
+            /// Standard opcode missing from the table
+            Unknown,
+            /// 0xFB-0xFF prefix; see
+            /// [`Instruction::extended_opcode`](super::Instruction::extended_opcode)
+            Extended,
+            $($name,)*
+        }
+
+        impl Opcode {
+            pub const fn mnemonic(self) -> &'static str {
+                match self {
+                    Self::Unknown => "Unknown",
+                    Self::Extended => "Extended",
+                    $(Self::$name => stringify!($name),)*
+                }
+            }
+
+            /// How the lifter translates this opcode
+            pub const fn lift(self) -> Lift {
+                match self {
+                    Self::Unknown | Self::Extended => Lift::Ignore,
+                    $(Self::$name => $lift,)*
+                }
+            }
+        }
+
+        /// Decode table for standard opcodes (0x00-0xFA)
+        static OPCODES: [OpcodeInfo; 256] = {
+            let mut table =
+                [OpcodeInfo::new(Opcode::Unknown, "", OpcodeCategory::Unknown, 0); 256];
+            $(
+                table[$byte] =
+                    OpcodeInfo::new(Opcode::$name, $format, OpcodeCategory::$category, $delta)
+                        $(.$flag($($arg),*))*;
+            )*
+            table
+        };
+    };
+}
+
+// Only the most common/important opcodes; this is a subset - expand as needed
+opcode_table! {
+    // Control flow
+    0x13 => ExitProcHresult("", ControlFlow, 0).with_return(), Lift::Return { value: false };
+    0x14 => ExitProc("", ControlFlow, 0).with_return(), Lift::Return { value: false };
+    0x1C => BranchF("l", ControlFlow, -1).with_branch(true), Lift::Branch { negate: true };
+    0x1D => BranchT("l", ControlFlow, -1).with_branch(true), Lift::Branch { negate: false };
+    0x1E => Branch("l", ControlFlow, 0).with_branch(false), Lift::Branch { negate: false };
+    0x4B => OnErrorGoto("l", ControlFlow, 0), Lift::Ignore;
+
+    // Stack operations - literals
+    0x1B => LitStr("z", Stack, 1), Lift::Literal;
+    0x27 => LitVar_Missing("", Stack, 1), Lift::Literal;
+    0x28 => LitVarI2("a%", Stack, 1), Lift::Literal;
+    0x3A => LitVarStr("az", Stack, 1), Lift::Literal;
+    0x5E => LitI2("a%", Stack, 1), Lift::Literal;
+    0x5F => LitI4("d&", Stack, 1), Lift::Literal;
+    0x60 => LitR4("f!", Stack, 1), Lift::Literal;
+    0x61 => LitR8("g#", Stack, 1), Lift::Literal;
+    0xA7 => LitVarI2_Byte("b%", Stack, 1), Lift::Literal;
+
+    // Variable operations
+    0x04 => FLdRfVar("a", Variable, 1), Lift::Ignore;
+    0x43 => FStStrCopy("a", String, -1), Lift::Ignore;
+    0x62 => FLdPrThis("", Variable, 1), Lift::Ignore;
+    0x69 => FLdI2("a", Variable, 1), Lift::LoadLocal(TypeKind::Integer);
+    0x6A => FLdI4("a", Variable, 1), Lift::LoadLocal(TypeKind::Long);
+    0x6D => FStI2("a", Variable, -1), Lift::StoreLocal(TypeKind::Integer);
+    0x6E => FStI4("a", Variable, -1), Lift::StoreLocal(TypeKind::Long);
+
+    // Function/method calls
+    0x05 => ImpAdLdRf("c", Call, 1), Lift::Call { returns: false };
+    0x09 => ImpAdCallHresult("", Call, 0).with_call(), Lift::Call { returns: false };
+    0x0A => ImpAdCallFPR4("x", Call, 0).with_call(), Lift::Call { returns: false };
+    0x0D => VCallHresult("v", Call, 0).with_call(), Lift::Call { returns: false };
+    0x7F => CallHresult("n", Call, 0).with_call(), Lift::Call { returns: false };
+    0x80 => CallI2("n", Call, 1).with_call(), Lift::Call { returns: false };
+    0x81 => CallI4("n", Call, 1).with_call(), Lift::Call { returns: true };
+
+    // String operations
+    0x2A => ConcatStr("", String, -1), Lift::Ignore;
+    0x2F => FFree1Str("", String, 0), Lift::Ignore;
+    0x32 => FFreeStr("", String, 0), Lift::Ignore;
+    0x33 => LdFixedStr("z", String, 1), Lift::Ignore;
+    0x34 => CStr2Ansi("", String, 0), Lift::Ignore;
+    0x4A => FnLenStr("", String, 0), Lift::Ignore;
+
+    // Array operations
+    0x3B => Ary1StStrCopy("", Array, -2), Lift::Ignore;
+    0x40 => Ary1LdRf("", Array, 0), Lift::Ignore;
+    0x41 => Ary1LdPr("", Array, 0), Lift::Ignore;
+
+    // Memory management
+    0x1A => FFree1Ad("", Memory, 0), Lift::Ignore;
+    0x29 => FFreeAd("", Memory, 0), Lift::Ignore;
+    0x35 => FFree1Var("", Memory, 0), Lift::Ignore;
+    0x36 => FFreeVar("", Memory, 0), Lift::Ignore;
+
+    // Arithmetic
+    0x95 => AddI2("", Arithmetic, -1), Lift::Binary(ExpressionKind::Add, TypeKind::Variant);
+    0x96 => SubI2("", Arithmetic, -1), Lift::Binary(ExpressionKind::Subtract, TypeKind::Variant);
+    0x97 => MulI2("", Arithmetic, -1), Lift::Binary(ExpressionKind::Multiply, TypeKind::Variant);
+    0x9A => NegI2("", Arithmetic, 0), Lift::Unary(ExpressionKind::Negate, TypeKind::Variant);
+
+    // Comparison
+    0xA0 => EqI2("", Comparison, -1), Lift::Binary(ExpressionKind::Equal, TypeKind::Boolean);
+    0xA1 => NeI2("", Comparison, -1), Lift::Binary(ExpressionKind::NotEqual, TypeKind::Boolean);
+    0xA2 => LeI2("", Comparison, -1), Lift::Binary(ExpressionKind::LessEqual, TypeKind::Boolean);
+    0xA3 => GeI2("", Comparison, -1), Lift::Binary(ExpressionKind::GreaterEqual, TypeKind::Boolean);
+    0xA4 => LtI2("", Comparison, -1), Lift::Binary(ExpressionKind::LessThan, TypeKind::Boolean);
+    0xA5 => GtI2("", Comparison, -1), Lift::Binary(ExpressionKind::GreaterThan, TypeKind::Boolean);
+}
+
+/// Get opcode information for standard opcodes (0x00-0xFA)
+pub(super) fn get_opcode_info(opcode: u8) -> &'static OpcodeInfo {
+    &OPCODES[opcode as usize]
+}
+
+/// Check if opcode is extended (0xFB-0xFF)
+pub(super) fn is_extended_opcode(opcode: u8) -> bool {
+    opcode >= 0xFB
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::pcode::Disassembler;
+
+    #[test]
+    fn test_decode_spec_compile() {
+        let spec = DecodeSpec::compile("az");
+        assert_eq!(spec.kinds(), &[OperandKind::ArgByte, OperandKind::Str]);
+        assert_eq!(spec.fixed_len, 1);
+        assert!(spec.has_string);
+
+        // Type suffixes decode nothing
+        let spec = DecodeSpec::compile("d&");
+        assert_eq!(spec.kinds(), &[OperandKind::LitI4]);
+        assert_eq!(spec.fixed_len, 4);
+        assert!(!spec.has_string);
+    }
+
+    #[test]
+    fn test_opcode_table() {
+        let info = get_opcode_info(0xA2);
+        assert_eq!(info.op, Opcode::LeI2);
+        assert_eq!(info.op.mnemonic(), "LeI2");
+        assert_eq!(
+            info.op.lift(),
+            Lift::Binary(ExpressionKind::LessEqual, TypeKind::Boolean)
+        );
+        assert_eq!(Opcode::BranchF.lift(), Lift::Branch { negate: true });
+        assert_eq!(get_opcode_info(0xFA).op, Opcode::Unknown);
+        assert_eq!(std::mem::size_of::<Opcode>(), 1);
+
+        let data = vec![0x81, 0x02, 0x00, 0xFB, 0x12];
+        let result = Disassembler::new(&data).disassemble(0).unwrap();
+        assert_eq!(result[0].op, Opcode::CallI4);
+        assert_eq!(result[1].op, Opcode::Extended);
+    }
+}
@@ -11,91 +11,284 @@
 //! - Resource sections
 //! - Packer detection
 
+use crate::cache::ContentHasher;
 use crate::error::{Error, Result};
-use crate::packer::detect_packer;
+use crate::packer::{self, PackerDetection, SectionEntropy};
+use crate::scan::{self, ImageMarkers};
+use crate::stats::{self, Stage, StatsCollector};
 use goblin::pe::{section_table::SectionTable, PE};
 use std::path::Path;
+use std::sync::OnceLock;
 
 /// Maximum size for a single read operation (100MB)
 const MAX_READ_SIZE: usize = 100 * 1024 * 1024;
 
+/// Types that can be read from any bytes of the image
+///
+/// # Safety
+///
+/// Implementors must be valid for every bit pattern and have no padding, as
+/// the `#[repr(C, packed)]` structures of integers and byte arrays in
+/// [`crate::vb`] are.
+pub(crate) unsafe trait Pod: Copy {}
+
+// SAFETY: every bit pattern is a valid integer
+unsafe impl Pod for u32 {}
+
+/// Part of the RVA space owned by one section
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct SectionSpan {
+    start: u32,
+    end: u32,
+    /// Index into the section table
+    section: usize,
+}
+
+/// Backing storage for the raw file image
+enum Backing {
+    /// Heap buffer owned by the PEFile
+    Owned(Vec<u8>),
+    /// Private copy-on-write mapping of the file; patches never reach the disk
+    Mapped(memmap2::MmapMut),
+    /// Caller-owned buffer that outlives the PEFile (see `PEFile::from_borrowed`)
+    Borrowed(&'static [u8]),
+}
+
+impl Backing {
+    fn as_slice(&self) -> &[u8] {
+        match self {
+            Backing::Owned(data) => data,
+            Backing::Mapped(map) => map,
+            Backing::Borrowed(data) => data,
+        }
+    }
+
+    /// Writable view of the image, or `None` for read-only borrowed buffers
+    fn as_mut_slice(&mut self) -> Option<&mut [u8]> {
+        match self {
+            Backing::Owned(data) => Some(data),
+            Backing::Mapped(map) => Some(map),
+            Backing::Borrowed(_) => None,
+        }
+    }
+}
+
+/// When a [`PEFile`] runs packer detection
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub enum PackerCheck {
+    /// Detect while parsing and reject packed files
+    #[default]
+    Eager,
+    /// Accept the file; detect on the first call to [`PEFile::packer`]
+    Lazy,
+    /// Never detect, for callers that have already triaged the file
+    Skip,
+}
+
 /// PE file parser
 pub struct PEFile {
-    /// Raw file data
-    data: Vec<u8>,
-    /// Parsed PE structure from goblin
+    /// Parsed PE structure from goblin (declared first so it drops before `data`)
     pe: PE<'static>,
+    /// Raw file data
+    data: Backing,
     /// Image base address
     image_base: u32,
     /// Entry point RVA
     entry_point: u32,
+    packer_check: PackerCheck,
+    /// Signature scan of the image, shared by packer detection and VB parsing
+    markers: OnceLock<ImageMarkers>,
+    /// Packer detection result, computed from `pe` on first use
+    packer: OnceLock<Option<PackerDetection>>,
+    /// Per-section entropy, shared by packer detection and `section_entropy`
+    entropy: Vec<OnceLock<Option<f64>>>,
+    /// Disjoint section spans sorted by RVA (see [`Self::section_by_rva`])
+    section_index: Vec<SectionSpan>,
+    /// Resource directory entry removed before parsing, with its original bytes
+    removed_resources: Option<(std::ops::Range<usize>, [u8; 8])>,
 }
 
 impl PEFile {
-    /// Parse a PE file from a path
+    /// Parse a PE file from a path, rejecting packed files
+    ///
+    /// The file is memory-mapped copy-on-write rather than read into memory;
+    /// if mapping fails it falls back to reading the whole file.
     pub fn from_path(path: impl AsRef<Path>) -> Result<Self> {
-        let data = std::fs::read(path.as_ref())?;
-        Self::from_bytes(data)
+        Self::from_path_with(path, PackerCheck::Eager)
     }
 
-    /// Parse a PE file from bytes
-    pub fn from_bytes(mut data: Vec<u8>) -> Result<Self> {
-        if data.len() < 64 {
+    /// Parse a PE file from a path with the given packer detection mode
+    pub fn from_path_with(path: impl AsRef<Path>, packer_check: PackerCheck) -> Result<Self> {
+        Self::from_path_staged(path.as_ref(), packer_check, None)
+    }
+
+    /// [`Self::from_path_with`], timing the read and the parse as separate stages
+    pub(crate) fn from_path_staged(
+        path: &Path,
+        packer_check: PackerCheck,
+        stats: Option<&StatsCollector>,
+    ) -> Result<Self> {
+        let data = stats::timed(stats, Stage::Read, || Self::read_path(path))?;
+        stats::timed(stats, Stage::PeParse, || {
+            Self::from_backing(data, packer_check)
+        })
+    }
+
+    /// Map a file, or read it if mapping fails
+    fn read_path(path: &Path) -> Result<Backing> {
+        let file = std::fs::File::open(path)?;
+
+        if file.metadata()?.len() < 64 {
             return Err(Error::invalid_pe("File too small to contain DOS header"));
         }
 
-        // DOS signature check
-        if &data[0..2] != b"MZ" {
-            return Err(Error::invalid_pe("Invalid DOS signature"));
+        // SAFETY: The mapping is private, so our writes are never visible to other
+        // processes. Like every mmap-based reader we assume the file is not
+        // truncated by another process while mapped.
+        match unsafe { memmap2::MmapOptions::new().map_copy(&file) } {
+            Ok(map) => Ok(Backing::Mapped(map)),
+            Err(e) => {
+                log::debug!("Memory mapping failed ({}), reading file instead", e);
+                Ok(Backing::Owned(std::fs::read(path)?))
+            }
+        }
+    }
+
+    /// Parse a PE file from bytes, rejecting packed files
+    pub fn from_bytes(data: Vec<u8>) -> Result<Self> {
+        Self::from_bytes_with(data, PackerCheck::Eager)
+    }
+
+    /// Parse a PE file from bytes with the given packer detection mode
+    pub fn from_bytes_with(data: Vec<u8>, packer_check: PackerCheck) -> Result<Self> {
+        Self::from_backing(Backing::Owned(data), packer_check)
+    }
+
+    /// Parse a PE file from a caller-owned buffer without copying it
+    ///
+    /// # Safety
+    /// The returned `PEFile` (and anything built from it, such as a `VBFile`)
+    /// must be dropped before `data` is freed or modified.
+    pub(crate) unsafe fn from_borrowed(data: &[u8], packer_check: PackerCheck) -> Result<Self> {
+        let data: &'static [u8] = std::slice::from_raw_parts(data.as_ptr(), data.len());
+        Self::from_backing(Backing::Borrowed(data), packer_check)
+    }
+
+    fn from_backing(mut data: Backing, packer_check: PackerCheck) -> Result<Self> {
+        let bytes = data.as_slice();
+
+        if bytes.len() < 64 {
+            return Err(Error::invalid_pe("File too small to contain DOS header"));
         }
 
-        // Check for packers early
-        if let Ok(Some(detection)) = detect_packer(&data) {
-            log::warn!(
-                "Packed executable detected: {} (confidence: {:.0}%)",
-                detection.packer.name(),
-                detection.confidence * 100.0
-            );
-            log::warn!("Unpacking instructions:");
-            log::warn!("{}", detection.packer.unpack_instructions());
-
-            return Err(Error::invalid_pe(format!(
-                "Packed executable detected ({}). Please unpack before decompilation.\n{}",
-                detection.packer.name(),
-                detection.packer.unpack_instructions()
-            )));
+        // DOS signature check
+        if &bytes[0..2] != b"MZ" {
+            return Err(Error::invalid_pe("Invalid DOS signature"));
         }
 
         // VB6 executables often have non-standard resource structures that goblin can't parse,
         // but resources aren't needed for VB decompilation (we only need headers, sections, imports).
-        // Proactively remove the resource directory to avoid parsing issues.
-        if let Some(fixed_data) = Self::try_remove_resource_directory(&data) {
+        // Proactively remove the resource directory to avoid parsing issues. Owned and mapped
+        // images are patched in place; read-only borrowed buffers are only copied if goblin
+        // actually rejects them below.
+        let resource_dir = Self::resource_directory_entry(bytes);
+        let removed_resources = resource_dir.clone().map(|range| {
+            let mut original = [0u8; 8];
+            original.copy_from_slice(&bytes[range.clone()]);
+            (range, original)
+        });
+        if let (Some(range), Some(bytes)) = (resource_dir.clone(), data.as_mut_slice()) {
+            bytes[range].fill(0);
             log::debug!("Removed resource directory to avoid VB6 compatibility issues");
-            data = fixed_data;
         }
 
+        let parsed = match Self::parse_pe(&data) {
+            Err(_) if resource_dir.is_some() && matches!(data, Backing::Borrowed(_)) => {
+                log::debug!("Retrying parse on a copy without the resource directory");
+                let mut copy = data.as_slice().to_vec();
+                copy[resource_dir.unwrap()].fill(0);
+                data = Backing::Owned(copy);
+                Self::parse_pe(&data)
+            }
+            parsed => parsed,
+        };
+
+        let pe = match parsed {
+            Ok(pe) => pe,
+            // Packed files often fail to parse; report the packer rather than the parse error
+            Err(e) if packer_check == PackerCheck::Eager => {
+                if let Ok(Some(detection)) = packer::detect_packer(data.as_slice()) {
+                    return Err(Self::packed_error(&detection));
+                }
+                return Err(e);
+            }
+            Err(e) => return Err(e),
+        };
+
+        // Check for packers before validating, reusing the parse above
+        let markers = OnceLock::new();
+        let packer = OnceLock::new();
+        let entropy = packer::new_entropy_cache(&pe.sections);
+        if packer_check == PackerCheck::Eager {
+            let image_markers = scan::scan_image(data.as_slice());
+            if let Some(detection) =
+                packer::detect_packer_parsed(&pe, data.as_slice(), &image_markers, &entropy)
+            {
+                return Err(Self::packed_error(&detection));
+            }
+            let _ = markers.set(image_markers);
+            let _ = packer.set(None);
+        }
+
+        // Continue with rest of validation
+        let mut pe_file = Self::validate_and_create(data, pe)?;
+        pe_file.packer_check = packer_check;
+        pe_file.markers = markers;
+        pe_file.packer = packer;
+        pe_file.entropy = entropy;
+        pe_file.removed_resources = removed_resources;
+        Ok(pe_file)
+    }
+
+    /// Log and build the error for a packed executable
+    fn packed_error(detection: &PackerDetection) -> Error {
+        log::warn!(
+            "Packed executable detected: {} (confidence: {:.0}%)",
+            detection.packer.name(),
+            detection.confidence * 100.0
+        );
+        log::warn!("Unpacking instructions:");
+        log::warn!("{}", detection.packer.unpack_instructions());
+
+        Error::invalid_pe(format!(
+            "Packed executable detected ({}). Please unpack before decompilation.\n{}",
+            detection.packer.name(),
+            detection.packer.unpack_instructions()
+        ))
+    }
+
+    /// Parse the PE structure with goblin
+    fn parse_pe(data: &Backing) -> Result<PE<'static>> {
         // Try parsing with permissive mode
         let mut opts = goblin::pe::options::ParseOptions::default();
         opts.parse_mode = goblin::options::ParseMode::Permissive;
 
         // Parse PE using goblin
         // SAFETY: We need to transmute the lifetime to 'static to store the PE struct.
-        // The PE struct holds references into the data vector, and we ensure both live
-        // for the same lifetime by storing them together in PEFile.
-        let pe: PE<'static> = unsafe {
-            let data_ptr = data.as_ptr();
-            let data_len = data.len();
-            let static_slice = std::slice::from_raw_parts(data_ptr, data_len);
+        // The PE struct holds references into the backing buffer, whose heap or mapped
+        // storage never moves; both are stored together in PEFile and `pe` drops first.
+        unsafe {
+            let bytes = data.as_slice();
+            let static_slice = std::slice::from_raw_parts(bytes.as_ptr(), bytes.len());
             goblin::pe::PE::parse_with_opts(static_slice, &opts)
-                .map_err(|e| Error::invalid_pe(format!("Failed to parse PE file: {}", e)))?
-        };
-
-        // Continue with rest of validation
-        Self::validate_and_create(data, pe)
+                .map_err(|e| Error::invalid_pe(format!("Failed to parse PE file: {}", e)))
+        }
     }
 
-    /// Try to remove the resource directory entry from PE optional header
-    fn try_remove_resource_directory(data: &[u8]) -> Option<Vec<u8>> {
+    /// Locate a non-empty resource directory entry in the PE optional header
+    ///
+    /// Returns the byte range of the entry (8 bytes: RVA + Size).
+    fn resource_directory_entry(data: &[u8]) -> Option<std::ops::Range<usize>> {
         if data.len() < 0x3c + 4 {
             return None;
         }
@@ -106,25 +299,21 @@ impl PEFile {
                 as usize;
 
         // Optional header starts after PE signature (4 bytes) + COFF header (20 bytes)
-        let opt_header_offset = pe_offset + 4 + 20;
+        let opt_header_offset = pe_offset.checked_add(4 + 20)?;
         // Resource directory entry is at offset 112 in optional header (for PE32)
         let resource_dir_offset = opt_header_offset + 112;
+        let range = resource_dir_offset..resource_dir_offset.checked_add(8)?;
 
-        if data.len() < resource_dir_offset + 8 {
+        let entry = data.get(range.clone())?;
+        if entry.iter().all(|&b| b == 0) {
             return None;
         }
 
-        // Create a copy and zero out resource directory entry (8 bytes: RVA + Size)
-        let mut data_copy = data.to_vec();
-        for i in resource_dir_offset..resource_dir_offset + 8 {
-            data_copy[i] = 0;
-        }
-
-        Some(data_copy)
+        Some(range)
     }
 
     /// Validate PE and create PEFile struct (extracted to reduce duplication)
-    fn validate_and_create(data: Vec<u8>, pe: PE<'static>) -> Result<Self> {
+    fn validate_and_create(data: Backing, pe: PE<'static>) -> Result<Self> {
         // Validate PE type
         if !pe.is_lib && pe.header.optional_header.is_none() {
             return Err(Error::invalid_pe("Invalid PE optional header"));
@@ -151,14 +340,59 @@ impl PEFile {
             return Err(Error::invalid_pe("Only x86 executables are supported"));
         }
 
+        let section_index = Self::build_section_index(&pe.sections);
         Ok(Self {
-            data,
             pe,
+            data,
             image_base,
             entry_point,
+            packer_check: PackerCheck::Eager,
+            markers: OnceLock::new(),
+            packer: OnceLock::new(),
+            entropy: Vec::new(),
+            section_index,
+            removed_resources: None,
         })
     }
 
+    /// Split the sections' RVA ranges into disjoint spans sorted by start
+    ///
+    /// Where sections overlap, the one earlier in the table owns the overlap,
+    /// as it did for a linear scan of the table.
+    fn build_section_index(sections: &[SectionTable]) -> Vec<SectionSpan> {
+        let mut spans: Vec<SectionSpan> = Vec::with_capacity(sections.len());
+        for (section, s) in sections.iter().enumerate() {
+            let start = s.virtual_address;
+            let end = start.saturating_add(s.virtual_size);
+
+            // Claim only the parts no earlier section owns; spans stay sorted
+            let mut cursor = start;
+            let mut at = spans.partition_point(|span| span.end <= start);
+            while cursor < end {
+                let next = spans.get(at).map_or(end, |span| span.start.min(end));
+                if cursor < next {
+                    spans.insert(
+                        at,
+                        SectionSpan {
+                            start: cursor,
+                            end: next,
+                            section,
+                        },
+                    );
+                    at += 1;
+                }
+                match spans.get(at) {
+                    Some(span) if span.start < end => {
+                        cursor = cursor.max(span.end);
+                        at += 1;
+                    }
+                    _ => break,
+                }
+            }
+        }
+        spans
+    }
+
     /// Get the image base address
     pub fn image_base(&self) -> u32 {
         self.image_base
@@ -170,8 +404,26 @@ impl PEFile {
     }
 
     /// Get raw file data
+    ///
+    /// The resource directory entry is zeroed; see [`Self::content_hash`].
     pub fn data(&self) -> &[u8] {
-        &self.data
+        self.data.as_slice()
+    }
+
+    /// [`content_hash`](crate::cache::content_hash) of the file as read, before the resource
+    /// directory entry was removed from [`Self::data`]
+    pub fn content_hash(&self) -> u64 {
+        let data = self.data();
+        let mut hasher = ContentHasher::new();
+        match &self.removed_resources {
+            Some((range, original)) => {
+                hasher.write(&data[..range.start]);
+                hasher.write(original);
+                hasher.write(&data[range.end..]);
+            }
+            None => hasher.write(data),
+        }
+        hasher.finish()
     }
 
     /// Check if this is a DLL
@@ -198,12 +450,12 @@ impl PEFile {
     }
 
     /// Get a section containing the given RVA
+    ///
+    /// A binary search of the index built at load time.
     pub fn section_by_rva(&self, rva: u32) -> Option<&SectionTable> {
-        self.pe.sections.iter().find(|s| {
-            let start = s.virtual_address;
-            let end = start + s.virtual_size;
-            rva >= start && rva < end
-        })
+        let at = self.section_index.partition_point(|span| span.start <= rva);
+        let span = self.section_index[..at].last()?;
+        (rva < span.end).then(|| &self.pe.sections[span.section])
     }
 
     /// Convert RVA to file offset
@@ -219,6 +471,52 @@ impl PEFile {
         Some(file_offset as usize)
     }
 
+    /// Signature scan of the whole image (see [`crate::scan::scan_image`])
+    pub fn markers(&self) -> &ImageMarkers {
+        self.markers.get_or_init(|| scan::scan_image(self.data()))
+    }
+
+    /// Packer detected in this file, reusing the parsed headers
+    ///
+    /// Files opened with [`PackerCheck::Eager`] are never packed (they fail
+    /// to open instead); with [`PackerCheck::Skip`] this is always `None`.
+    pub fn packer(&self) -> Option<&PackerDetection> {
+        if self.packer_check == PackerCheck::Skip {
+            return None;
+        }
+        self.packer
+            .get_or_init(|| {
+                packer::detect_packer_parsed(&self.pe, self.data(), self.markers(), &self.entropy)
+            })
+            .as_ref()
+    }
+
+    /// Packer check this file was opened with
+    pub fn packer_check(&self) -> PackerCheck {
+        self.packer_check
+    }
+
+    /// Shannon entropy of every section's raw data
+    ///
+    /// Sections already measured by packer detection are not measured again;
+    /// the rest are measured in parallel.
+    pub fn section_entropy(&self) -> Vec<SectionEntropy> {
+        packer::section_entropy(self.sections(), self.data(), &self.entropy)
+    }
+
+    /// Convert a file offset to an RVA
+    ///
+    /// Returns None if the offset is not inside the mapped raw data of a section.
+    pub fn offset_to_rva(&self, offset: usize) -> Option<u32> {
+        let offset = u32::try_from(offset).ok()?;
+        self.sections().iter().find_map(|s| {
+            let delta = offset.checked_sub(s.pointer_to_raw_data)?;
+            (delta < s.size_of_raw_data.min(s.virtual_size))
+                .then(|| s.virtual_address.checked_add(delta))
+                .flatten()
+        })
+    }
+
     /// Read data at a given RVA
     ///
     /// Returns None if the RVA is invalid or if the requested size exceeds MAX_READ_SIZE.
@@ -231,20 +529,47 @@ impl PEFile {
         // Convert RVA to file offset
         let offset = self.rva_to_offset(rva)?;
 
+        let data = self.data();
+
         // Check bounds
-        if offset >= self.data.len() {
+        if offset >= data.len() {
             return None;
         }
 
         // Clamp size to available data
-        let available = self.data.len() - offset;
+        let available = data.len() - offset;
         let size = size.min(available);
 
         if size == 0 {
             return None;
         }
 
-        Some(&self.data[offset..offset + size])
+        Some(&data[offset..offset + size])
+    }
+
+    /// Convert a virtual address to an RVA; None below the image base
+    pub fn va_to_rva(&self, va: u32) -> Option<u32> {
+        va.checked_sub(self.image_base)
+    }
+
+    /// Exactly `len` bytes at an RVA, borrowed from the image
+    ///
+    /// Unlike [`Self::read_at_rva`] this never returns a short slice.
+    pub fn slice_at_rva(&self, rva: u32, len: usize) -> Option<&[u8]> {
+        let offset = self.rva_to_offset(rva)?;
+        self.data().get(offset..offset.checked_add(len)?)
+    }
+
+    /// Exactly `len` bytes at a virtual address, borrowed from the image
+    pub fn slice_at_va(&self, va: u32, len: usize) -> Option<&[u8]> {
+        self.slice_at_rva(self.va_to_rva(va)?, len)
+    }
+
+    /// Read a `T` at an RVA, or None if it doesn't fit in the image
+    pub(crate) fn read_pod<T: Pod>(&self, rva: u32) -> Option<T> {
+        let bytes = self.slice_at_rva(rva, std::mem::size_of::<T>())?;
+        // SAFETY: `bytes` holds size_of::<T>() bytes and any bytes are a valid `T`
+        Some(unsafe { std::ptr::read_unaligned(bytes.as_ptr().cast::<T>()) })
     }
 
     /// Read data at a given RVA into a vector
@@ -271,6 +596,17 @@ impl PEFile {
         dlls
     }
 
+    /// Imported function names with the RVA of their import address table slot
+    ///
+    /// Native code calls an import indirectly through its slot, so this maps
+    /// call operands back to names.
+    pub fn import_slots(&self) -> impl Iterator<Item = (u32, &str)> + '_ {
+        self.pe
+            .imports
+            .iter()
+            .filter_map(|import| Some((u32::try_from(import.offset).ok()?, &*import.name)))
+    }
+
     /// Get imported functions from a specific DLL
     pub fn imports_from_dll(&self, dll_name: &str) -> Vec<String> {
         self.pe
@@ -299,4 +635,79 @@ mod tests {
         let result = PEFile::from_bytes(data);
         assert!(result.is_err());
     }
+
+    #[test]
+    fn test_borrowed_file_too_small() {
+        let data = [0x4D, 0x5A];
+        let result = unsafe { PEFile::from_borrowed(&data, PackerCheck::Eager) };
+        assert!(result.is_err());
+    }
+
+    fn section(virtual_address: u32, virtual_size: u32) -> SectionTable {
+        SectionTable {
+            virtual_address,
+            virtual_size,
+            ..Default::default()
+        }
+    }
+
+    #[test]
+    fn test_section_index() {
+        let span = |start, end, section| SectionSpan {
+            start,
+            end,
+            section,
+        };
+
+        // Out of order, with a gap and an empty section
+        let sections = [
+            section(0x3000, 0x1000),
+            section(0x1000, 0x1000),
+            section(0x2800, 0),
+        ];
+        assert_eq!(
+            PEFile::build_section_index(&sections),
+            vec![span(0x1000, 0x2000, 1), span(0x3000, 0x4000, 0)]
+        );
+
+        // Overlaps go to the earlier section, which may be split around a later one
+        let sections = [
+            section(0x2000, 0x1000),
+            section(0x1000, 0x4000),
+            section(0x1800, 0x1000),
+            section(0xFFFF_F000, 0x2000),
+        ];
+        assert_eq!(
+            PEFile::build_section_index(&sections),
+            vec![
+                span(0x1000, 0x2000, 1),
+                span(0x2000, 0x3000, 0),
+                span(0x3000, 0x5000, 1),
+                span(0xFFFF_F000, 0xFFFF_FFFF, 3),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_resource_directory_entry() {
+        // e_lfanew = 0x40, resource entry at 0x40 + 24 + 112 = 0xC8
+        let mut data = vec![0u8; 0xD0];
+        data[0x3c] = 0x40;
+        assert_eq!(PEFile::resource_directory_entry(&data), None);
+
+        data[0xC8] = 0x10;
+        assert_eq!(PEFile::resource_directory_entry(&data), Some(0xC8..0xD0));
+    }
+
+    #[test]
+    fn test_content_hash_includes_resource_directory() {
+        let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/corpus");
+        let mut data = std::fs::read(corpus.join("synthetic-small.exe")).unwrap();
+        let pe_offset = u32::from_le_bytes(data[0x3c..0x40].try_into().unwrap()) as usize;
+        data[pe_offset + 24 + 112..][..8].copy_from_slice(&[0x00, 0x30, 0, 0, 0x10, 0, 0, 0]);
+
+        let pe = PEFile::from_bytes_with(data.clone(), PackerCheck::Skip).unwrap();
+        assert_ne!(pe.data(), &data[..]);
+        assert_eq!(pe.content_hash(), crate::cache::content_hash(&data));
+    }
 }
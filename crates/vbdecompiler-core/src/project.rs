@@ -0,0 +1,168 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Lazily decompiled project
+//!
+//! Two-phase alternative to [`Decompiler::decompile_file`]: opening a project
+//! only parses the PE and VB structures, and each method is disassembled,
+//! lifted and generated the first time it is requested. Results are memoized,
+//! and methods may be requested concurrently from several threads.
+
+use crate::budget::MethodBudget;
+use crate::cache::DecompileCache;
+use crate::decompiler::{Decompiler, MethodOutput, Pipeline};
+use crate::error::{Error, Result};
+use crate::native::NativeImage;
+use crate::packer::SectionEntropy;
+use crate::pe::PackerCheck;
+use crate::scratch::ScratchPool;
+use crate::vb::{VBFile, VBObject};
+use std::sync::{Arc, OnceLock};
+
+/// An opened VB executable whose methods are decompiled on demand
+pub struct Project {
+    vb_file: VBFile,
+    cache: Option<DecompileCache>,
+    scratch: Arc<ScratchPool>,
+    budget: MethodBudget,
+    fused: bool,
+    /// Code sections and imports of a native-code executable
+    native: Option<NativeImage>,
+    /// Index of each object's first method in `methods`
+    method_offsets: Vec<usize>,
+    /// Memoized `(function_name, code)` per method; `None` if it can't be decompiled
+    methods: Vec<OnceLock<Option<MethodOutput>>>,
+}
+
+impl Project {
+    /// Parse the PE and VB structures of `path` without decompiling anything
+    pub fn open(path: &str) -> Result<Self> {
+        Ok(Self::from_vb_file(
+            Decompiler::load(path, PackerCheck::Eager)?,
+            None,
+            Arc::new(ScratchPool::new()),
+            MethodBudget::default(),
+            false,
+        ))
+    }
+
+    pub(crate) fn from_vb_file(
+        vb_file: VBFile,
+        cache: Option<DecompileCache>,
+        scratch: Arc<ScratchPool>,
+        budget: MethodBudget,
+        fused: bool,
+    ) -> Self {
+        let mut method_offsets = Vec::with_capacity(vb_file.objects().len());
+        let mut total = 0;
+        for object in vb_file.objects() {
+            method_offsets.push(total);
+            total += object.method_count();
+        }
+
+        let native = vb_file.is_native_code().then(|| NativeImage::new(&vb_file));
+
+        Self {
+            vb_file,
+            cache,
+            scratch,
+            budget,
+            fused,
+            native,
+            method_offsets,
+            methods: (0..total).map(|_| OnceLock::new()).collect(),
+        }
+    }
+
+    /// Project name, or "Unknown"
+    pub fn project_name(&self) -> String {
+        self.vb_file
+            .project_name()
+            .unwrap_or_else(|| "Unknown".to_string())
+    }
+
+    /// Whether the executable contains P-Code
+    pub fn is_pcode(&self) -> bool {
+        self.vb_file.is_pcode()
+    }
+
+    /// Object/method tree
+    pub fn objects(&self) -> &[VBObject] {
+        self.vb_file.objects()
+    }
+
+    /// Entropy of each PE section, reusing what packer detection measured
+    pub fn section_entropy(&self) -> Vec<SectionEntropy> {
+        self.vb_file.pe_file().section_entropy()
+    }
+
+    /// Total number of methods across all objects
+    pub fn method_count(&self) -> usize {
+        self.methods.len()
+    }
+
+    /// Decompile a single method, or return its memoized result
+    ///
+    /// Returns the generated VB6 code. Failures are memoized as well, so a
+    /// method that cannot be decompiled is only attempted once.
+    pub fn decompile_method(&self, object_index: usize, method_index: usize) -> Result<&str> {
+        let object = self
+            .objects()
+            .get(object_index)
+            .ok_or_else(|| Error::Decompilation(format!("No object {}", object_index)))?;
+        let method_name = object.method_names.get(method_index).ok_or_else(|| {
+            Error::Decompilation(format!("No method {} in {}", method_index, object.name))
+        })?;
+
+        let slot = &self.methods[self.method_offsets[object_index] + method_index];
+        let result = slot.get_or_init(|| {
+            Decompiler::decompile_method(
+                &self.vb_file,
+                Pipeline {
+                    cache: self.cache.as_ref(),
+                    scratch: &self.scratch,
+                    stats: None,
+                    native: self.native.as_ref(),
+                    ir: false,
+                    index: false,
+                    budget: self.budget,
+                    fused: self.fused,
+                },
+                object_index,
+                method_index,
+                &object.name,
+                method_name,
+            )
+        });
+
+        match result {
+            Some(output) => Ok(&output.code),
+            None => Err(Error::Decompilation(format!(
+                "{}.{} could not be decompiled",
+                object.name, method_name
+            ))),
+        }
+    }
+
+    /// Whether a method has already been decompiled (successfully or not)
+    pub fn is_decompiled(&self, object_index: usize, method_index: usize) -> bool {
+        self.method_offsets
+            .get(object_index)
+            .and_then(|offset| self.methods.get(offset + method_index))
+            .map_or(false, |slot| slot.get().is_some())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_open_missing_file() {
+        assert!(matches!(
+            Project::open("/nonexistent/file.exe"),
+            Err(Error::Io(_))
+        ));
+    }
+}
@@ -0,0 +1,463 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Vectorized multi-pattern signature scanner
+//!
+//! Finds every occurrence of a small set of byte patterns in one pass. Each
+//! vector step compares the first two bytes of every pattern against 16 or 32
+//! positions at once (AVX2/SSE2 on x86-64, NEON on AArch64, scalar elsewhere)
+//! and only verifies the full pattern at the rare candidate positions, so large
+//! images are scanned at close to memory bandwidth.
+//!
+//! [`scan_image`] runs the built-in [`Marker`] set (VB header, VB runtime
+//! imports, packer stubs) used by VB parsing and packer detection.
+
+use std::ops::ControlFlow;
+use std::sync::OnceLock;
+
+/// A pattern occurrence
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Match {
+    /// Index of the pattern in the scanner's pattern list
+    pub pattern: usize,
+    /// Offset of the first byte of the occurrence
+    pub offset: usize,
+}
+
+/// Vector instruction set selected at construction
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum SimdLevel {
+    // Only selected on other architectures, and by tests
+    #[cfg_attr(any(target_arch = "x86_64", target_arch = "aarch64"), allow(dead_code))]
+    Scalar,
+    #[cfg(target_arch = "x86_64")]
+    Sse2,
+    #[cfg(target_arch = "x86_64")]
+    Avx2,
+    #[cfg(target_arch = "aarch64")]
+    Neon,
+}
+
+impl SimdLevel {
+    fn detect() -> Self {
+        #[cfg(target_arch = "x86_64")]
+        {
+            if is_x86_feature_detected!("avx2") {
+                return Self::Avx2;
+            }
+            // SSE2 is part of the x86-64 baseline
+            Self::Sse2
+        }
+        #[cfg(target_arch = "aarch64")]
+        {
+            // NEON is part of the AArch64 baseline
+            Self::Neon
+        }
+        #[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+        {
+            Self::Scalar
+        }
+    }
+}
+
+/// Multi-pattern scanner over a fixed set of byte patterns
+pub struct Scanner<'p> {
+    patterns: Vec<&'p [u8]>,
+    /// Distinct leading byte pairs tested by the vector kernels
+    pairs: Vec<[u8; 2]>,
+    /// Whether any pattern starts with the byte (scalar filter)
+    first_byte: [bool; 256],
+    level: SimdLevel,
+}
+
+impl<'p> Scanner<'p> {
+    /// Create a scanner for `patterns`
+    ///
+    /// # Panics
+    ///
+    /// Panics if a pattern is shorter than two bytes.
+    pub fn new(patterns: &[&'p [u8]]) -> Self {
+        Self::with_level(patterns, SimdLevel::detect())
+    }
+
+    fn with_level(patterns: &[&'p [u8]], level: SimdLevel) -> Self {
+        let mut pairs = Vec::new();
+        let mut first_byte = [false; 256];
+        for pattern in patterns {
+            assert!(
+                pattern.len() >= 2,
+                "scan patterns must be at least two bytes"
+            );
+            let pair = [pattern[0], pattern[1]];
+            if !pairs.contains(&pair) {
+                pairs.push(pair);
+            }
+            first_byte[pattern[0] as usize] = true;
+        }
+
+        Self {
+            patterns: patterns.to_vec(),
+            pairs,
+            first_byte,
+            level,
+        }
+    }
+
+    /// Report every occurrence of every pattern in offset order
+    ///
+    /// Occurrences at the same offset are reported in pattern order. Scanning
+    /// stops as soon as `on_match` returns [`ControlFlow::Break`].
+    pub fn scan(&self, haystack: &[u8], mut on_match: impl FnMut(Match) -> ControlFlow<()>) {
+        if self.patterns.is_empty() {
+            return;
+        }
+
+        let mut verify = |offset: usize| {
+            let rest = &haystack[offset..];
+            for (pattern, bytes) in self.patterns.iter().enumerate() {
+                if rest.starts_with(bytes) {
+                    on_match(Match { pattern, offset })?;
+                }
+            }
+            ControlFlow::Continue(())
+        };
+
+        // Vector kernels cover a prefix and hand the tail to the scalar loop
+        let tail = match self.level {
+            SimdLevel::Scalar => ControlFlow::Continue(0),
+            // SAFETY: the level was selected from the CPU features at runtime
+            // (or is part of the target baseline)
+            #[cfg(target_arch = "x86_64")]
+            SimdLevel::Sse2 => unsafe { x86::candidates_sse2(&self.pairs, haystack, &mut verify) },
+            #[cfg(target_arch = "x86_64")]
+            SimdLevel::Avx2 => unsafe { x86::candidates_avx2(&self.pairs, haystack, &mut verify) },
+            #[cfg(target_arch = "aarch64")]
+            SimdLevel::Neon => unsafe { neon::candidates(&self.pairs, haystack, &mut verify) },
+        };
+
+        if let ControlFlow::Continue(start) = tail {
+            for offset in start..haystack.len().saturating_sub(1) {
+                if self.first_byte[haystack[offset] as usize] && verify(offset).is_break() {
+                    return;
+                }
+            }
+        }
+    }
+
+    /// First occurrence of any pattern
+    pub fn find_first(&self, haystack: &[u8]) -> Option<Match> {
+        let mut found = None;
+        self.scan(haystack, |m| {
+            found = Some(m);
+            ControlFlow::Break(())
+        });
+        found
+    }
+}
+
+/// Offset of the first occurrence of `needle` (at least two bytes) in `haystack`
+pub fn find(haystack: &[u8], needle: &[u8]) -> Option<usize> {
+    Scanner::new(&[needle])
+        .find_first(haystack)
+        .map(|m| m.offset)
+}
+
+#[cfg(target_arch = "x86_64")]
+mod x86 {
+    use std::arch::x86_64::*;
+    use std::ops::ControlFlow;
+
+    /// Call `on_candidate` for each offset whose first two bytes equal a pair
+    ///
+    /// Returns the first offset not examined.
+    #[target_feature(enable = "sse2")]
+    pub(super) unsafe fn candidates_sse2(
+        pairs: &[[u8; 2]],
+        data: &[u8],
+        on_candidate: &mut impl FnMut(usize) -> ControlFlow<()>,
+    ) -> ControlFlow<(), usize> {
+        const WIDTH: usize = 16;
+        let ptr = data.as_ptr();
+        let mut i = 0;
+        // Loads at i and i + 1 must both stay in bounds
+        while i + WIDTH < data.len() {
+            let first = _mm_loadu_si128(ptr.add(i) as *const __m128i);
+            let second = _mm_loadu_si128(ptr.add(i + 1) as *const __m128i);
+            let mut hits = _mm_setzero_si128();
+            for &[a, b] in pairs {
+                let eq_a = _mm_cmpeq_epi8(first, _mm_set1_epi8(a as i8));
+                let eq_b = _mm_cmpeq_epi8(second, _mm_set1_epi8(b as i8));
+                hits = _mm_or_si128(hits, _mm_and_si128(eq_a, eq_b));
+            }
+
+            let mut bits = _mm_movemask_epi8(hits) as u32;
+            while bits != 0 {
+                on_candidate(i + bits.trailing_zeros() as usize)?;
+                bits &= bits - 1;
+            }
+            i += WIDTH;
+        }
+        ControlFlow::Continue(i)
+    }
+
+    /// AVX2 variant of [`candidates_sse2`]
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn candidates_avx2(
+        pairs: &[[u8; 2]],
+        data: &[u8],
+        on_candidate: &mut impl FnMut(usize) -> ControlFlow<()>,
+    ) -> ControlFlow<(), usize> {
+        const WIDTH: usize = 32;
+        let ptr = data.as_ptr();
+        let mut i = 0;
+        while i + WIDTH < data.len() {
+            let first = _mm256_loadu_si256(ptr.add(i) as *const __m256i);
+            let second = _mm256_loadu_si256(ptr.add(i + 1) as *const __m256i);
+            let mut hits = _mm256_setzero_si256();
+            for &[a, b] in pairs {
+                let eq_a = _mm256_cmpeq_epi8(first, _mm256_set1_epi8(a as i8));
+                let eq_b = _mm256_cmpeq_epi8(second, _mm256_set1_epi8(b as i8));
+                hits = _mm256_or_si256(hits, _mm256_and_si256(eq_a, eq_b));
+            }
+
+            let mut bits = _mm256_movemask_epi8(hits) as u32;
+            while bits != 0 {
+                on_candidate(i + bits.trailing_zeros() as usize)?;
+                bits &= bits - 1;
+            }
+            i += WIDTH;
+        }
+        // Finish with SSE2 so at most 16 bytes are left to the scalar loop
+        let ControlFlow::Continue(rest) =
+            candidates_sse2(pairs, &data[i..], &mut |offset| on_candidate(i + offset))
+        else {
+            return ControlFlow::Break(());
+        };
+        ControlFlow::Continue(i + rest)
+    }
+}
+
+#[cfg(target_arch = "aarch64")]
+mod neon {
+    use std::arch::aarch64::*;
+    use std::ops::ControlFlow;
+
+    /// Call `on_candidate` for each offset whose first two bytes equal a pair
+    ///
+    /// Returns the first offset not examined.
+    #[target_feature(enable = "neon")]
+    pub(super) unsafe fn candidates(
+        pairs: &[[u8; 2]],
+        data: &[u8],
+        on_candidate: &mut impl FnMut(usize) -> ControlFlow<()>,
+    ) -> ControlFlow<(), usize> {
+        const WIDTH: usize = 16;
+        let ptr = data.as_ptr();
+        let mut i = 0;
+        while i + WIDTH < data.len() {
+            let first = vld1q_u8(ptr.add(i));
+            let second = vld1q_u8(ptr.add(i + 1));
+            let mut hits = vdupq_n_u8(0);
+            for &[a, b] in pairs {
+                let eq = vandq_u8(
+                    vceqq_u8(first, vdupq_n_u8(a)),
+                    vceqq_u8(second, vdupq_n_u8(b)),
+                );
+                hits = vorrq_u8(hits, eq);
+            }
+
+            // No movemask on NEON: test for any hit, then walk the lanes
+            if vmaxvq_u8(hits) != 0 {
+                let mut lanes = [0u8; WIDTH];
+                vst1q_u8(lanes.as_mut_ptr(), hits);
+                for (lane, &hit) in lanes.iter().enumerate() {
+                    if hit != 0 {
+                        on_candidate(i + lane)?;
+                    }
+                }
+            }
+            i += WIDTH;
+        }
+        ControlFlow::Continue(i)
+    }
+}
+
+/// Signatures located by [`scan_image`]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Marker {
+    /// "VB5!" magic at the start of the VB header
+    VbHeader,
+    /// VB6 runtime import
+    Msvbvm60,
+    /// VB5 runtime import
+    Msvbvm50,
+    /// Banner left in the stub by UPX
+    UpxBanner,
+    /// Banner left in the stub by PECompact 2.x
+    PECompactBanner,
+}
+
+impl Marker {
+    /// Every marker, in pattern order
+    pub const ALL: [Marker; 5] = [
+        Marker::VbHeader,
+        Marker::Msvbvm60,
+        Marker::Msvbvm50,
+        Marker::UpxBanner,
+        Marker::PECompactBanner,
+    ];
+
+    /// Bytes searched for
+    pub const fn pattern(self) -> &'static [u8] {
+        match self {
+            Marker::VbHeader => b"VB5!",
+            Marker::Msvbvm60 => b"MSVBVM60.DLL",
+            Marker::Msvbvm50 => b"MSVBVM50.DLL",
+            Marker::UpxBanner => b"$Info: This file is packed with the UPX",
+            Marker::PECompactBanner => b"PECompact2",
+        }
+    }
+}
+
+/// First file offset of each [`Marker`] in an image
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ImageMarkers {
+    offsets: [Option<usize>; Marker::ALL.len()],
+}
+
+impl ImageMarkers {
+    /// File offset of the first occurrence of `marker`
+    pub fn get(&self, marker: Marker) -> Option<usize> {
+        self.offsets[marker as usize]
+    }
+}
+
+/// Locate every built-in [`Marker`] in one pass over `data`
+///
+/// Stops early once all markers have been seen.
+pub fn scan_image(data: &[u8]) -> ImageMarkers {
+    static SCANNER: OnceLock<Scanner<'static>> = OnceLock::new();
+    let scanner = SCANNER.get_or_init(|| {
+        let patterns: Vec<&'static [u8]> = Marker::ALL.iter().map(|m| m.pattern()).collect();
+        Scanner::new(&patterns)
+    });
+
+    let mut markers = ImageMarkers::default();
+    let mut remaining = Marker::ALL.len();
+    scanner.scan(data, |m| {
+        let slot = &mut markers.offsets[m.pattern];
+        if slot.is_none() {
+            *slot = Some(m.offset);
+            remaining -= 1;
+            if remaining == 0 {
+                return ControlFlow::Break(());
+            }
+        }
+        ControlFlow::Continue(())
+    });
+    markers
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn naive(patterns: &[&[u8]], haystack: &[u8]) -> Vec<Match> {
+        let mut matches = Vec::new();
+        for offset in 0..haystack.len() {
+            for (pattern, bytes) in patterns.iter().enumerate() {
+                if haystack[offset..].starts_with(bytes) {
+                    matches.push(Match { pattern, offset });
+                }
+            }
+        }
+        matches
+    }
+
+    fn collect(scanner: &Scanner, haystack: &[u8]) -> Vec<Match> {
+        let mut matches = Vec::new();
+        scanner.scan(haystack, |m| {
+            matches.push(m);
+            ControlFlow::Continue(())
+        });
+        matches
+    }
+
+    #[test]
+    fn test_find_single_pattern() {
+        assert_eq!(find(b"xxVB5!yy", b"VB5!"), Some(2));
+        assert_eq!(find(b"VB5", b"VB5!"), None);
+        assert_eq!(find(b"", b"VB5!"), None);
+    }
+
+    #[test]
+    fn test_match_at_end() {
+        // 40 bytes exercises the vector loop and the scalar tail
+        let mut data = vec![0u8; 36];
+        data.extend_from_slice(b"VB5!");
+        assert_eq!(find(&data, b"VB5!"), Some(36));
+    }
+
+    #[test]
+    fn test_all_levels_match_naive() {
+        let patterns: &[&[u8]] = &[b"VB5!", b"VBA", b"UPX!", b"\0\0\0"];
+        let mut data = Vec::new();
+        for i in 0..300u32 {
+            data.push((i * 7 % 13) as u8);
+            if i % 17 == 0 {
+                data.extend_from_slice(b"VB5!");
+            }
+            if i % 29 == 0 {
+                data.extend_from_slice(b"UPX!\0\0\0\0");
+            }
+        }
+
+        let mut levels = vec![SimdLevel::Scalar, SimdLevel::detect()];
+        #[cfg(target_arch = "x86_64")]
+        levels.push(SimdLevel::Sse2);
+
+        for level in levels {
+            let scanner = Scanner::with_level(patterns, level);
+            // Every length, so each pattern straddles every vector boundary
+            for len in 0..data.len() {
+                assert_eq!(
+                    collect(&scanner, &data[..len]),
+                    naive(patterns, &data[..len]),
+                    "{:?} at length {}",
+                    level,
+                    len
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn test_scan_stops_on_break() {
+        let scanner = Scanner::new(&[b"ab"]);
+        let mut seen = 0;
+        scanner.scan(&b"ab".repeat(100), |_| {
+            seen += 1;
+            if seen == 3 {
+                ControlFlow::Break(())
+            } else {
+                ControlFlow::Continue(())
+            }
+        });
+        assert_eq!(seen, 3);
+    }
+
+    #[test]
+    fn test_scan_image_markers() {
+        let mut image = vec![0u8; 4096];
+        image[100..112].copy_from_slice(b"MSVBVM60.DLL");
+        image[2000..2004].copy_from_slice(b"VB5!");
+        image[3000..3004].copy_from_slice(b"VB5!");
+
+        let markers = scan_image(&image);
+        assert_eq!(markers.get(Marker::VbHeader), Some(2000));
+        assert_eq!(markers.get(Marker::Msvbvm60), Some(100));
+        assert_eq!(markers.get(Marker::Msvbvm50), None);
+        assert_eq!(markers.get(Marker::UpxBanner), None);
+    }
+}
@@ -0,0 +1,462 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Reusable per-thread working memory for the method pipeline
+//!
+//! Decompiling a method needs an instruction buffer, the lifter's stacks, an
+//! IR arena and an output string. A [`ScratchPool`] keeps one
+//! [`MethodScratch`] per concurrently running thread and hands them out
+//! again for later methods and later files, so a long-lived [`Decompiler`]
+//! reaches a steady state where the pipeline itself no longer allocates;
+//! only the returned code is copied out.
+//!
+//! [`Decompiler`]: crate::Decompiler
+
+use crate::budget::MethodBudget;
+use crate::codegen::VB6CodeGenerator;
+use crate::index::{self, MethodRefs};
+use crate::ir::arena::ArenaFunction;
+use crate::ir::TypeKind;
+use crate::lifter::PCodeLifter;
+use crate::native::{self, NativeImage};
+use crate::pcode::{Disassembler, Instruction};
+use crate::stats::MethodMetrics;
+use std::sync::Mutex;
+use std::time::Instant;
+
+/// Buffers larger than this many bytes are released instead of kept, so one
+/// huge method does not pin its memory for the life of the pool
+const MAX_RETAINED_BYTES: usize = 4 << 20;
+
+/// Working state for decompiling one method at a time
+pub struct MethodScratch {
+    /// Always empty between methods; see [`recycle`]
+    instructions: Vec<Instruction<'static>>,
+    lifter: PCodeLifter,
+    function: ArenaFunction,
+    generator: VB6CodeGenerator,
+    code: String,
+    /// IR listing rendered on request by [`Self::ir_listing`]
+    ir: String,
+    metrics: MethodMetrics,
+    budget: MethodBudget,
+    /// Decode and lift in one pass; see [`Self::set_fused`]
+    fused: bool,
+}
+
+impl MethodScratch {
+    pub fn new() -> Self {
+        Self {
+            instructions: Vec::new(),
+            lifter: PCodeLifter::new(),
+            function: ArenaFunction::new(String::new(), TypeKind::Variant),
+            generator: VB6CodeGenerator::new(),
+            code: String::new(),
+            ir: String::new(),
+            metrics: MethodMetrics::default(),
+            budget: MethodBudget::default(),
+            fused: false,
+        }
+    }
+
+    /// Limits applied to the following methods
+    pub fn set_budget(&mut self, budget: MethodBudget) {
+        self.budget = budget;
+    }
+
+    /// Decode and lift the following P-Code methods in one pass
+    ///
+    /// See [`PCodeLifter::lift_stream`]: no instruction buffer is filled, so
+    /// per-method memory is bounded by the IR arena. The generated code is
+    /// the same either way.
+    pub fn set_fused(&mut self, fused: bool) {
+        self.fused = fused;
+    }
+
+    /// Run the disassemble → lift → generate pipeline over `pcode`
+    ///
+    /// Returns the generated code, borrowed from the scratch buffer until the
+    /// next call, or `None` if any stage fails or the method is over budget.
+    pub fn decompile(&mut self, pcode: &[u8], function_name: &str) -> Option<&str> {
+        if self.fused {
+            let generated = self.run_fused(pcode, function_name);
+            self.trim();
+            return generated.then_some(self.code.as_str());
+        }
+
+        let mut instructions = recycle(std::mem::take(&mut self.instructions));
+        let generated = self.run(pcode, function_name, &mut instructions);
+        self.instructions = recycle(instructions);
+        self.trim();
+
+        generated.then_some(self.code.as_str())
+    }
+
+    /// Disassemble, lift and generate the native function at `entry`
+    ///
+    /// `data` is the image `native` was built from. Returns the generated
+    /// code like [`Self::decompile`], with a `Sub` named `function_name`.
+    pub fn decompile_native(
+        &mut self,
+        native: &NativeImage,
+        data: &[u8],
+        entry: u32,
+        function_name: &str,
+    ) -> Option<&str> {
+        self.metrics = MethodMetrics::default();
+
+        let start = Instant::now();
+        let deadline = self.budget.deadline(start);
+        let disassembled = native.disassemble_function(data, entry, &self.budget, deadline);
+        let lift_start = Instant::now();
+        self.metrics.disassemble = lift_start - start;
+        let function = match disassembled {
+            Ok(function) => function,
+            Err(e) => {
+                log::warn!("    Failed to disassemble: {}", e);
+                return None;
+            }
+        };
+        self.metrics.instructions = function.instructions.len();
+
+        self.reset_function(function_name, TypeKind::Void);
+        let lifted = native::lift_into(native, data, &function, &mut self.function);
+        let codegen_start = Instant::now();
+        self.metrics.lift = codegen_start - lift_start;
+        if let Err(e) = lifted.and_then(|()| MethodBudget::check_deadline(deadline)) {
+            log::warn!("    Failed to lift: {}", e);
+            return None;
+        }
+
+        self.generate(function.code_size(), codegen_start);
+        self.trim();
+        Some(self.code.as_str())
+    }
+
+    /// IR listing of the function lifted by the last successful decompile
+    pub fn ir_listing(&mut self) -> &str {
+        use std::fmt::Write;
+
+        self.ir.clear();
+        let _ = write!(self.ir, "{}", self.function.to_function());
+        self.ir.as_str()
+    }
+
+    /// Calls and string constants of the function lifted by the last
+    /// successful decompile
+    pub fn references(&self) -> MethodRefs {
+        let mut refs = MethodRefs::default();
+        index::collect(&self.function, &mut refs);
+        refs
+    }
+
+    /// Stage timings and instruction count of the last [`Self::decompile`]
+    pub fn metrics(&self) -> &MethodMetrics {
+        &self.metrics
+    }
+
+    fn run<'a>(
+        &mut self,
+        pcode: &'a [u8],
+        function_name: &str,
+        instructions: &mut Vec<Instruction<'a>>,
+    ) -> bool {
+        self.metrics = MethodMetrics::default();
+        if let Err(e) = self.budget.check_bytes(pcode.len()) {
+            log::warn!("    Skipped: {}", e);
+            return false;
+        }
+
+        // Disassemble P-Code
+        let start = Instant::now();
+        let deadline = self.budget.deadline(start);
+        let disassembled = Disassembler::new(pcode)
+            .with_instruction_limit(self.budget.max_instructions)
+            .with_deadline(deadline)
+            .disassemble_into(0, instructions);
+        let lift_start = Instant::now();
+        self.metrics.disassemble = lift_start - start;
+        self.metrics.instructions = instructions.len();
+        if let Err(e) = disassembled {
+            log::warn!("    Failed to disassemble: {}", e);
+            return false;
+        }
+
+        if instructions.is_empty() {
+            log::warn!("    No instructions found");
+            return false;
+        }
+
+        log::trace!("    Disassembled {} instructions", instructions.len());
+
+        // Lift P-Code to IR
+        self.reset_function(function_name, TypeKind::Variant);
+        let lifted = self.lifter.lift_into(instructions, &mut self.function, 0);
+        let codegen_start = Instant::now();
+        self.metrics.lift = codegen_start - lift_start;
+        if let Err(e) = lifted.and_then(|()| MethodBudget::check_deadline(deadline)) {
+            log::warn!("    Failed to lift: {}", e);
+            return false;
+        }
+
+        log::trace!("    Lifted to IR: {} blocks", self.function.block_count());
+
+        self.generate(pcode.len(), codegen_start);
+        true
+    }
+
+    /// [`Self::run`] without an instruction buffer
+    ///
+    /// Decoding is interleaved with lifting, so both are timed as lifting.
+    fn run_fused(&mut self, pcode: &[u8], function_name: &str) -> bool {
+        self.metrics = MethodMetrics::default();
+        if let Err(e) = self.budget.check_bytes(pcode.len()) {
+            log::warn!("    Skipped: {}", e);
+            return false;
+        }
+
+        let start = Instant::now();
+        let deadline = self.budget.deadline(start);
+        let disassembler = Disassembler::new(pcode)
+            .with_instruction_limit(self.budget.max_instructions)
+            .with_deadline(deadline);
+        self.reset_function(function_name, TypeKind::Variant);
+        let lifted = self.lifter.lift_stream(disassembler, &mut self.function, 0);
+        let codegen_start = Instant::now();
+        self.metrics.lift = codegen_start - start;
+        let instructions = match lifted.and_then(|count| {
+            MethodBudget::check_deadline(deadline)?;
+            Ok(count)
+        }) {
+            Ok(count) => count,
+            Err(e) => {
+                log::warn!("    Failed to lift: {}", e);
+                return false;
+            }
+        };
+        self.metrics.instructions = instructions;
+
+        log::trace!(
+            "    Lifted {} instructions to IR: {} blocks",
+            instructions,
+            self.function.block_count()
+        );
+
+        self.generate(pcode.len(), codegen_start);
+        true
+    }
+
+    /// Generate VB6 code from the lifted function
+    ///
+    /// The output is rarely shorter than the `input_len` bytes it came from.
+    fn generate(&mut self, input_len: usize, start: Instant) {
+        self.code.clear();
+        self.code.reserve(input_len);
+        let _ = self
+            .generator
+            .write_arena_function(&self.function, &mut self.code);
+        self.metrics.codegen = start.elapsed();
+    }
+
+    /// Empty the IR function for the next method, first releasing it if it
+    /// grew past [`MAX_RETAINED_BYTES`]
+    ///
+    /// Done here rather than in [`Self::trim`] because the function must
+    /// outlive the decompile for [`Self::ir_listing`] and
+    /// [`Self::references`].
+    fn reset_function(&mut self, name: &str, return_type: TypeKind) {
+        if self.function.allocated_bytes() > MAX_RETAINED_BYTES {
+            self.function = ArenaFunction::new(String::new(), return_type);
+        }
+        self.function.reset(name, return_type);
+    }
+
+    /// Release output and working buffers that grew past
+    /// [`MAX_RETAINED_BYTES`]
+    fn trim(&mut self) {
+        let instruction_limit = MAX_RETAINED_BYTES / std::mem::size_of::<Instruction<'_>>();
+        if self.instructions.capacity() > instruction_limit {
+            self.instructions = Vec::new();
+        }
+        if self.code.capacity() > MAX_RETAINED_BYTES {
+            self.code = String::new();
+        }
+        if self.ir.capacity() > MAX_RETAINED_BYTES {
+            self.ir = String::new();
+        }
+        if self.lifter.allocated_bytes() > MAX_RETAINED_BYTES {
+            self.lifter = PCodeLifter::new();
+        }
+    }
+}
+
+impl Default for MethodScratch {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Empty an instruction buffer so it can hold instructions of another lifetime
+///
+/// An empty `Vec` borrows nothing, and collecting its (empty) iterator back
+/// into a `Vec` of the same layout reuses the allocation in place.
+fn recycle<'b>(mut instructions: Vec<Instruction<'_>>) -> Vec<Instruction<'b>> {
+    instructions.clear();
+    instructions
+        .into_iter()
+        .map(|_| unreachable!("buffer was cleared"))
+        .collect()
+}
+
+/// Free list of [`MethodScratch`] shared by all worker threads
+///
+/// Each method takes a scratch for the duration of its pipeline run, so the
+/// pool holds at most one scratch per thread that ever ran concurrently.
+#[derive(Default)]
+pub struct ScratchPool {
+    free: Mutex<Vec<MethodScratch>>,
+}
+
+impl ScratchPool {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Run `f` with a scratch from the pool, returning it afterwards
+    ///
+    /// A scratch is created if none is free. If `f` panics, its scratch is
+    /// dropped rather than returned.
+    pub fn with<R>(&self, f: impl FnOnce(&mut MethodScratch) -> R) -> R {
+        let mut scratch = self.lock().pop().unwrap_or_default();
+        let result = f(&mut scratch);
+        self.lock().push(scratch);
+        result
+    }
+
+    /// Number of idle scratches
+    pub fn idle(&self) -> usize {
+        self.lock().len()
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, Vec<MethodScratch>> {
+        // A panic while holding the lock cannot leave the free list inconsistent
+        self.free.lock().unwrap_or_else(|e| e.into_inner())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// LitI2 1; ExitProc
+    const PCODE: [u8; 3] = [0x5E, 0x01, 0x14];
+
+    #[test]
+    fn test_recycle_keeps_allocation() {
+        let pcode = PCODE;
+        let mut instructions = Vec::with_capacity(16);
+        Disassembler::new(&pcode)
+            .disassemble_into(0, &mut instructions)
+            .unwrap();
+        let capacity = instructions.capacity();
+
+        let recycled: Vec<Instruction<'static>> = recycle(instructions);
+        assert!(recycled.is_empty());
+        assert_eq!(recycled.capacity(), capacity);
+    }
+
+    #[test]
+    fn test_scratch_output_matches_fresh_pipeline() {
+        let mut lifter = PCodeLifter::new();
+        let instructions = Disassembler::new(&PCODE).disassemble(0).unwrap();
+        let function = lifter
+            .lift_arena(&instructions, "Form1_Load".to_string(), 0)
+            .unwrap();
+        let mut expected = String::new();
+        VB6CodeGenerator::new()
+            .write_arena_function(&function, &mut expected)
+            .unwrap();
+
+        let mut scratch = MethodScratch::new();
+        assert_eq!(
+            scratch.decompile(&PCODE, "Form1_Load"),
+            Some(expected.as_str())
+        );
+        // A second run over the reused buffers gives the same code
+        assert_eq!(
+            scratch.decompile(&PCODE, "Form1_Load"),
+            Some(expected.as_str())
+        );
+        assert_eq!(scratch.decompile(&[], "Empty"), None);
+    }
+
+    #[test]
+    fn test_pool_reuses_scratch() {
+        let pool = ScratchPool::new();
+        assert_eq!(pool.idle(), 0);
+
+        let first = pool.with(|scratch| scratch.decompile(&PCODE, "A").map(str::len));
+        assert!(first.is_some());
+        assert_eq!(pool.idle(), 1);
+
+        pool.with(|_| assert_eq!(pool.idle(), 0));
+        assert_eq!(pool.idle(), 1);
+    }
+
+    #[test]
+    fn test_budget_skips_method() {
+        let mut scratch = MethodScratch::new();
+        scratch.set_budget(MethodBudget {
+            max_bytes: 2,
+            ..MethodBudget::default()
+        });
+        assert_eq!(scratch.decompile(&PCODE, "Big"), None);
+
+        scratch.set_budget(MethodBudget {
+            max_instructions: 1,
+            ..MethodBudget::default()
+        });
+        assert_eq!(scratch.decompile(&PCODE, "Long"), None);
+
+        scratch.set_budget(MethodBudget::default());
+        assert!(scratch.decompile(&PCODE, "Form1_Load").is_some());
+    }
+
+    #[test]
+    fn test_oversized_function_released() {
+        let mut scratch = MethodScratch::new();
+        let expected = scratch.decompile(&PCODE, "Form1_Load").unwrap().to_string();
+
+        let exprs = MAX_RETAINED_BYTES / std::mem::size_of::<crate::ir::arena::ExprNode>() + 1;
+        scratch.function = ArenaFunction::with_capacity(String::new(), TypeKind::Variant, exprs);
+        assert!(scratch.function.allocated_bytes() > MAX_RETAINED_BYTES);
+
+        assert_eq!(
+            scratch.decompile(&PCODE, "Form1_Load"),
+            Some(expected.as_str())
+        );
+        assert!(scratch.function.allocated_bytes() <= MAX_RETAINED_BYTES);
+    }
+
+    #[test]
+    fn test_fused_matches_buffered() {
+        // LitI2 1; LitI2 2; LtI2; BranchF +2; LitI2 3; ExitProc
+        let pcode = [0x5E, 1, 0x5E, 2, 0xA4, 0x1C, 2, 0, 0x5E, 3, 0x14];
+        let mut scratch = MethodScratch::new();
+        let expected = scratch.decompile(&pcode, "Test").unwrap().to_string();
+        let listing = scratch.ir_listing().to_string();
+
+        scratch.set_fused(true);
+        assert_eq!(scratch.decompile(&pcode, "Test"), Some(expected.as_str()));
+        assert_eq!(scratch.ir_listing(), listing);
+        assert_eq!(scratch.metrics().instructions, 6);
+        assert_eq!(scratch.decompile(&[], "Empty"), None);
+
+        scratch.set_budget(MethodBudget {
+            max_instructions: 5,
+            ..MethodBudget::default()
+        });
+        assert_eq!(scratch.decompile(&pcode, "Test"), None);
+    }
+}
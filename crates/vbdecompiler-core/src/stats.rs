@@ -0,0 +1,511 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Timing and counter instrumentation
+//!
+//! Pass a [`StatsCollector`] in [`DecompileHooks::stats`] to measure a
+//! decompilation: wall time per pipeline stage, instruction/byte counts,
+//! allocation counts and the slowest methods. Recording a method costs a few
+//! relaxed atomic adds; a lock is only taken for methods slow enough to make
+//! the slowest-N list, or when a trace was requested.
+//!
+//! With [`StatsCollector::with_trace`] every stage is also kept as a span and
+//! can be written in the Chrome trace event format
+//! ([`StatsCollector::write_chrome_trace`]) for `chrome://tracing` or Perfetto.
+//!
+//! Allocation counts need [`CountingAllocator`] installed as the global
+//! allocator of the final binary; without it they are reported as `None`.
+//!
+//! [`DecompileHooks::stats`]: crate::DecompileHooks::stats
+
+use serde::Serialize;
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::io::{self, Write};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+use std::time::{Duration, Instant};
+
+/// Number of slowest methods kept by default
+pub const DEFAULT_SLOWEST: usize = 10;
+
+/// A timed pipeline stage
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Stage {
+    /// Opening and mapping (or reading) the file
+    Read,
+    PeParse,
+    VbParse,
+    Disassemble,
+    Lift,
+    Codegen,
+}
+
+impl Stage {
+    const COUNT: usize = 6;
+
+    fn name(self) -> &'static str {
+        match self {
+            Stage::Read => "read",
+            Stage::PeParse => "pe_parse",
+            Stage::VbParse => "vb_parse",
+            Stage::Disassemble => "disassemble",
+            Stage::Lift => "lift",
+            Stage::Codegen => "codegen",
+        }
+    }
+}
+
+/// Per-stage measurements of one method, filled in by the pipeline
+#[derive(Debug, Clone, Copy, Default)]
+pub struct MethodMetrics {
+    pub instructions: usize,
+    pub disassemble: Duration,
+    pub lift: Duration,
+    pub codegen: Duration,
+}
+
+impl MethodMetrics {
+    fn total(&self) -> Duration {
+        self.disassemble + self.lift + self.codegen
+    }
+}
+
+/// Cost of one method, as listed in [`DecompileStats::slowest`]
+#[derive(Debug, Clone, Serialize)]
+pub struct MethodTiming {
+    pub object_name: String,
+    pub method_name: String,
+    pub total_ns: u64,
+    pub disassemble_ns: u64,
+    pub lift_ns: u64,
+    pub codegen_ns: u64,
+    pub instructions: u64,
+    pub pcode_bytes: u64,
+}
+
+/// Total time spent in each stage
+///
+/// File stages are wall time. Method stages are summed over all methods, so
+/// with several worker threads they can exceed the overall wall time.
+#[derive(Debug, Clone, Copy, Default, Serialize)]
+pub struct StageTimes {
+    pub read_ns: u64,
+    pub pe_parse_ns: u64,
+    pub vb_parse_ns: u64,
+    pub disassemble_ns: u64,
+    pub lift_ns: u64,
+    pub codegen_ns: u64,
+}
+
+/// Measurements of a decompilation, from [`StatsCollector::finish`]
+#[derive(Debug, Clone, Default, Serialize)]
+pub struct DecompileStats {
+    /// Time from the collector's creation to `finish`
+    pub wall_ns: u64,
+    pub stages: StageTimes,
+    /// Methods run through the pipeline
+    pub methods: u64,
+    /// Methods served from the result cache
+    pub cached_methods: u64,
+    pub instructions: u64,
+    pub pcode_bytes: u64,
+    /// Bytes of generated code
+    pub code_bytes: u64,
+    /// Heap allocations made meanwhile by any thread (requires [`CountingAllocator`])
+    pub allocations: Option<u64>,
+    /// Bytes requested by those allocations
+    pub allocated_bytes: Option<u64>,
+    /// The slowest methods, slowest first
+    pub slowest: Vec<MethodTiming>,
+}
+
+/// One span of a Chrome trace
+struct TraceEvent {
+    name: String,
+    category: &'static str,
+    start: Duration,
+    duration: Duration,
+    thread: u64,
+}
+
+/// Thread-safe sink for the measurements of one decompilation
+pub struct StatsCollector {
+    started: Instant,
+    stage_ns: [AtomicU64; Stage::COUNT],
+    methods: AtomicU64,
+    cached_methods: AtomicU64,
+    instructions: AtomicU64,
+    pcode_bytes: AtomicU64,
+    code_bytes: AtomicU64,
+    allocations_at_start: Option<(u64, u64)>,
+    slowest_limit: usize,
+    /// Shortest total in a full `slowest` list; faster methods skip the lock
+    slowest_floor: AtomicU64,
+    slowest: Mutex<Vec<MethodTiming>>,
+    trace: Option<Mutex<Vec<TraceEvent>>>,
+}
+
+impl StatsCollector {
+    /// Start measuring, keeping the [`DEFAULT_SLOWEST`] slowest methods
+    pub fn new() -> Self {
+        Self {
+            started: Instant::now(),
+            stage_ns: Default::default(),
+            methods: AtomicU64::new(0),
+            cached_methods: AtomicU64::new(0),
+            instructions: AtomicU64::new(0),
+            pcode_bytes: AtomicU64::new(0),
+            code_bytes: AtomicU64::new(0),
+            allocations_at_start: allocation_counts(),
+            slowest_limit: DEFAULT_SLOWEST,
+            slowest_floor: AtomicU64::new(0),
+            slowest: Mutex::new(Vec::new()),
+            trace: None,
+        }
+    }
+
+    /// Keep the `n` slowest methods instead of [`DEFAULT_SLOWEST`]
+    pub fn with_slowest(mut self, n: usize) -> Self {
+        self.slowest_limit = n;
+        self
+    }
+
+    /// Also record every stage as a span for [`Self::write_chrome_trace`]
+    pub fn with_trace(mut self) -> Self {
+        self.trace = Some(Mutex::new(Vec::new()));
+        self
+    }
+
+    /// Run `f` as `stage`, adding its wall time
+    pub(crate) fn time<R>(&self, stage: Stage, f: impl FnOnce() -> R) -> R {
+        let start = Instant::now();
+        let result = f();
+        let duration = start.elapsed();
+        self.add_stage(stage, duration);
+        self.trace(|| stage.name().to_string(), "file", start, duration);
+        result
+    }
+
+    /// Record a method that went through the pipeline, started at `start`
+    pub(crate) fn record_method(
+        &self,
+        object_name: &str,
+        method_name: &str,
+        pcode_bytes: usize,
+        code_bytes: usize,
+        metrics: &MethodMetrics,
+        start: Instant,
+    ) {
+        self.methods.fetch_add(1, Ordering::Relaxed);
+        self.instructions
+            .fetch_add(metrics.instructions as u64, Ordering::Relaxed);
+        self.pcode_bytes
+            .fetch_add(pcode_bytes as u64, Ordering::Relaxed);
+        self.code_bytes
+            .fetch_add(code_bytes as u64, Ordering::Relaxed);
+        self.add_stage(Stage::Disassemble, metrics.disassemble);
+        self.add_stage(Stage::Lift, metrics.lift);
+        self.add_stage(Stage::Codegen, metrics.codegen);
+
+        let total = metrics.total();
+        if self.trace.is_some() {
+            let name = || format!("{}.{}", object_name, method_name);
+            self.trace(name, "method", start, total);
+            let lift_start = start + metrics.disassemble;
+            let codegen_start = lift_start + metrics.lift;
+            self.trace(
+                || Stage::Disassemble.name().to_string(),
+                "stage",
+                start,
+                metrics.disassemble,
+            );
+            self.trace(
+                || Stage::Lift.name().to_string(),
+                "stage",
+                lift_start,
+                metrics.lift,
+            );
+            self.trace(
+                || Stage::Codegen.name().to_string(),
+                "stage",
+                codegen_start,
+                metrics.codegen,
+            );
+        }
+
+        let total_ns = nanos(total);
+        if self.slowest_limit == 0 || total_ns <= self.slowest_floor.load(Ordering::Relaxed) {
+            return;
+        }
+
+        let mut slowest = self.slowest.lock().unwrap_or_else(|e| e.into_inner());
+        let at = slowest.partition_point(|m| m.total_ns >= total_ns);
+        if at >= self.slowest_limit {
+            return;
+        }
+        slowest.insert(
+            at,
+            MethodTiming {
+                object_name: object_name.to_string(),
+                method_name: method_name.to_string(),
+                total_ns,
+                disassemble_ns: nanos(metrics.disassemble),
+                lift_ns: nanos(metrics.lift),
+                codegen_ns: nanos(metrics.codegen),
+                instructions: metrics.instructions as u64,
+                pcode_bytes: pcode_bytes as u64,
+            },
+        );
+        slowest.truncate(self.slowest_limit);
+        if slowest.len() == self.slowest_limit {
+            let floor = slowest.last().map_or(0, |m| m.total_ns);
+            self.slowest_floor.store(floor, Ordering::Relaxed);
+        }
+    }
+
+    /// Record a method whose code came from the result cache
+    pub(crate) fn record_cached(&self, count: usize) {
+        self.cached_methods
+            .fetch_add(count as u64, Ordering::Relaxed);
+    }
+
+    /// Measurements so far
+    pub fn finish(&self) -> DecompileStats {
+        let stage = |stage: Stage| self.stage_ns[stage as usize].load(Ordering::Relaxed);
+        let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        let allocations = match (self.allocations_at_start, allocation_counts()) {
+            (Some((count, bytes)), Some((count_now, bytes_now))) => {
+                Some((count_now - count, bytes_now - bytes))
+            }
+            _ => None,
+        };
+
+        DecompileStats {
+            wall_ns: nanos(self.started.elapsed()),
+            stages: StageTimes {
+                read_ns: stage(Stage::Read),
+                pe_parse_ns: stage(Stage::PeParse),
+                vb_parse_ns: stage(Stage::VbParse),
+                disassemble_ns: stage(Stage::Disassemble),
+                lift_ns: stage(Stage::Lift),
+                codegen_ns: stage(Stage::Codegen),
+            },
+            methods: load(&self.methods),
+            cached_methods: load(&self.cached_methods),
+            instructions: load(&self.instructions),
+            pcode_bytes: load(&self.pcode_bytes),
+            code_bytes: load(&self.code_bytes),
+            allocations: allocations.map(|(count, _)| count),
+            allocated_bytes: allocations.map(|(_, bytes)| bytes),
+            slowest: self
+                .slowest
+                .lock()
+                .unwrap_or_else(|e| e.into_inner())
+                .clone(),
+        }
+    }
+
+    /// Write the recorded spans as a Chrome trace (JSON object format)
+    ///
+    /// Writes an empty trace unless the collector was created
+    /// [`with_trace`](Self::with_trace).
+    pub fn write_chrome_trace(&self, out: &mut dyn Write) -> io::Result<()> {
+        let events = match &self.trace {
+            Some(trace) => trace.lock().unwrap_or_else(|e| e.into_inner()),
+            None => return out.write_all(b"{\"traceEvents\":[]}\n"),
+        };
+
+        out.write_all(b"{\"traceEvents\":[\n")?;
+        for (i, event) in events.iter().enumerate() {
+            let record = serde_json::json!({
+                "name": event.name,
+                "cat": event.category,
+                "ph": "X",
+                "ts": micros(event.start),
+                "dur": micros(event.duration),
+                "pid": 1,
+                "tid": event.thread,
+            });
+            let separator = if i + 1 < events.len() { ",\n" } else { "\n" };
+            write!(out, "{}{}", record, separator)?;
+        }
+        out.write_all(b"],\"displayTimeUnit\":\"ms\"}\n")
+    }
+
+    fn add_stage(&self, stage: Stage, duration: Duration) {
+        self.stage_ns[stage as usize].fetch_add(nanos(duration), Ordering::Relaxed);
+    }
+
+    fn trace(
+        &self,
+        name: impl FnOnce() -> String,
+        category: &'static str,
+        start: Instant,
+        duration: Duration,
+    ) {
+        if let Some(trace) = &self.trace {
+            let event = TraceEvent {
+                name: name(),
+                category,
+                start: start.saturating_duration_since(self.started),
+                duration,
+                thread: thread_id(),
+            };
+            trace.lock().unwrap_or_else(|e| e.into_inner()).push(event);
+        }
+    }
+}
+
+impl Default for StatsCollector {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Run `f` as `stage` if there is a collector, otherwise just run it
+pub(crate) fn timed<R>(stats: Option<&StatsCollector>, stage: Stage, f: impl FnOnce() -> R) -> R {
+    match stats {
+        Some(stats) => stats.time(stage, f),
+        None => f(),
+    }
+}
+
+fn nanos(duration: Duration) -> u64 {
+    u64::try_from(duration.as_nanos()).unwrap_or(u64::MAX)
+}
+
+fn micros(duration: Duration) -> f64 {
+    duration.as_secs_f64() * 1e6
+}
+
+/// Small sequential id of the calling thread, for trace rows
+fn thread_id() -> u64 {
+    static NEXT: AtomicU64 = AtomicU64::new(1);
+    thread_local! {
+        static ID: u64 = NEXT.fetch_add(1, Ordering::Relaxed);
+    }
+    ID.with(|id| *id)
+}
+
+static ALLOCATIONS: AtomicU64 = AtomicU64::new(0);
+static ALLOCATED_BYTES: AtomicU64 = AtomicU64::new(0);
+
+/// Global allocator wrapper that counts allocations for [`DecompileStats`]
+///
+/// Install it in the final binary:
+///
+/// ```ignore
+/// #[global_allocator]
+/// static ALLOC: CountingAllocator = CountingAllocator::new(std::alloc::System);
+/// ```
+pub struct CountingAllocator<A = System>(A);
+
+impl<A> CountingAllocator<A> {
+    pub const fn new(inner: A) -> Self {
+        Self(inner)
+    }
+
+    fn count(size: usize) {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        ALLOCATED_BYTES.fetch_add(size as u64, Ordering::Relaxed);
+    }
+}
+
+// SAFETY: every call is forwarded unchanged to the wrapped allocator
+unsafe impl<A: GlobalAlloc> GlobalAlloc for CountingAllocator<A> {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        Self::count(layout.size());
+        self.0.alloc(layout)
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        Self::count(layout.size());
+        self.0.alloc_zeroed(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        self.0.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        Self::count(new_size);
+        self.0.realloc(ptr, layout, new_size)
+    }
+}
+
+/// Process-wide `(allocations, bytes)` so far, if [`CountingAllocator`] is installed
+pub fn allocation_counts() -> Option<(u64, u64)> {
+    // Any process has allocated by the time it can ask, so zero means "not installed"
+    match ALLOCATIONS.load(Ordering::Relaxed) {
+        0 => None,
+        count => Some((count, ALLOCATED_BYTES.load(Ordering::Relaxed))),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn metrics(micros: u64) -> MethodMetrics {
+        MethodMetrics {
+            instructions: 4,
+            disassemble: Duration::from_micros(micros),
+            lift: Duration::from_micros(micros),
+            codegen: Duration::from_micros(micros),
+        }
+    }
+
+    #[test]
+    fn test_counts_and_slowest() {
+        let stats = StatsCollector::new().with_slowest(2);
+        let start = Instant::now();
+        for (i, cost) in [5, 30, 10, 20].into_iter().enumerate() {
+            let name = format!("M{}", i);
+            stats.record_method("Form1", &name, 100, 50, &metrics(cost), start);
+        }
+        stats.record_cached(3);
+
+        let result = stats.finish();
+        assert_eq!(result.methods, 4);
+        assert_eq!(result.cached_methods, 3);
+        assert_eq!(result.instructions, 16);
+        assert_eq!(result.pcode_bytes, 400);
+        assert_eq!(result.code_bytes, 200);
+        assert_eq!(result.stages.lift_ns, 65_000);
+        let slowest: Vec<&str> = result
+            .slowest
+            .iter()
+            .map(|m| m.method_name.as_str())
+            .collect();
+        assert_eq!(slowest, ["M1", "M3"]);
+        assert_eq!(result.slowest[0].total_ns, 90_000);
+    }
+
+    #[test]
+    fn test_chrome_trace() {
+        let stats = StatsCollector::new().with_trace();
+        stats.time(Stage::VbParse, || ());
+        stats.record_method("Form1", "Load", 10, 10, &metrics(1), Instant::now());
+
+        let mut out = Vec::new();
+        stats.write_chrome_trace(&mut out).unwrap();
+        let trace: serde_json::Value = serde_json::from_slice(&out).unwrap();
+        let events = trace["traceEvents"].as_array().unwrap();
+        let names: Vec<&str> = events.iter().map(|e| e["name"].as_str().unwrap()).collect();
+        assert_eq!(
+            names,
+            ["vb_parse", "Form1.Load", "disassemble", "lift", "codegen"]
+        );
+        assert!(events.iter().all(|e| e["ph"] == "X"));
+    }
+
+    #[test]
+    fn test_trace_disabled_is_empty() {
+        let stats = StatsCollector::new();
+        stats.time(Stage::Read, || ());
+        let mut out = Vec::new();
+        stats.write_chrome_trace(&mut out).unwrap();
+        assert_eq!(out, b"{\"traceEvents\":[]}\n");
+    }
+}
@@ -11,7 +11,8 @@
 //! - Method tables and P-Code
 
 use crate::error::{Error, Result};
-use crate::pe::PEFile;
+use crate::pe::{PEFile, Pod};
+use crate::scan::{self, Marker};
 
 /// VB5/6 Magic signature
 const VB5_MAGIC: &[u8; 4] = b"VB5!";
@@ -180,6 +181,24 @@ struct VBMethodName {
     dw_flags: u32,       // 0x04 - Flags
 }
 
+// SAFETY: packed structures of integers and byte arrays only
+unsafe impl Pod for VBHeader {}
+unsafe impl Pod for VBProjectInfo {}
+unsafe impl Pod for VBObjectTableHeader {}
+unsafe impl Pod for VBPublicObjectDescriptor {}
+unsafe impl Pod for VBObjectInfo {}
+unsafe impl Pod for VBOptionalObjectInfo {}
+unsafe impl Pod for VBProcDescInfo {}
+unsafe impl Pod for VBMethodName {}
+
+/// Location of a method's P-Code, decoded once from its [`VBProcDescInfo`]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct MethodProc {
+    /// RVA of the P-Code, which follows the descriptor
+    pcode_rva: u32,
+    size: u16,
+}
+
 /// High-level VB Object representation
 #[derive(Debug, Clone)]
 pub struct VBObject {
@@ -190,6 +209,12 @@ pub struct VBObject {
     descriptor: VBPublicObjectDescriptor,
     info: Option<VBObjectInfo>,
     optional_info: Option<VBOptionalObjectInfo>,
+    /// One entry per method in the object info's method table; None where
+    /// the descriptor is unreadable or has no P-Code
+    procs: Vec<Option<MethodProc>>,
+    /// Native-code files only: the entry VA of each method in the method
+    /// table; None where the slot is empty or unreadable
+    entries: Vec<Option<u32>>,
 }
 
 impl VBObject {
@@ -279,53 +304,22 @@ impl VBFile {
 
     /// Find the VB5! signature in the PE file
     fn find_vb_header(&mut self) -> Result<()> {
-        // Search for "VB5!" signature in all sections
-        log::debug!(
-            "Searching for VB5! signature in {} sections",
-            self.pe_file.sections().len()
-        );
-        for (idx, section) in self.pe_file.sections().iter().enumerate() {
-            let start_rva = section.virtual_address;
-            let section_size = section.virtual_size as usize;
+        // The image's signature scan (shared with packer detection) gives the
+        // first VB5!; the first one that lies inside a section wins
+        let data = self.pe_file.data();
+        let mut next = self.pe_file.markers().get(Marker::VbHeader);
+        while let Some(offset) = next {
+            if let Some(rva) = self.pe_file.offset_to_rva(offset) {
+                self.vb_header_rva = rva;
+                log::info!("Found VB5! at RVA 0x{:X} (file offset 0x{:X})", rva, offset);
+                return Ok(());
+            }
 
             log::debug!(
-                "  Checking section {}: RVA=0x{:X}, size=0x{:X}",
-                idx,
-                start_rva,
-                section_size
+                "  VB5! at file offset 0x{:X} is outside every section",
+                offset
             );
-
-            // Limit section size to avoid hanging on corrupt huge sections
-            // VB header is typically in smaller sections, so 10MB is more than enough
-            let size_to_read = section_size.min(10 * 1024 * 1024);
-            if size_to_read < section_size {
-                log::warn!(
-                    "    Section {} size (0x{:X}) exceeds limit, only reading first 10MB",
-                    idx,
-                    section_size
-                );
-            }
-
-            // Read section data
-            if let Some(data) = self.pe_file.read_at_rva(start_rva, size_to_read) {
-                log::debug!("    Read {} bytes from section {}", data.len(), idx);
-                // Search for VB5! signature
-                for i in 0..data.len().saturating_sub(4) {
-                    if &data[i..i + 4] == VB5_MAGIC {
-                        self.vb_header_rva = start_rva + i as u32;
-                        log::info!(
-                            "Found VB5! at RVA 0x{:X} (section {} offset 0x{:X})",
-                            self.vb_header_rva,
-                            idx,
-                            i
-                        );
-                        return Ok(());
-                    }
-                }
-                log::debug!("    VB5! not found in section {}", idx);
-            } else {
-                log::debug!("    Could not read section {}", idx);
-            }
+            next = scan::find(&data[offset + 1..], VB5_MAGIC).map(|i| offset + 1 + i);
         }
 
         Err(Error::invalid_vb("VB5! signature not found"))
@@ -444,6 +438,8 @@ impl VBFile {
             descriptor,
             info: None,
             optional_info: None,
+            procs: Vec::new(),
+            entries: Vec::new(),
         };
 
         // Parse object name
@@ -474,9 +470,57 @@ impl VBFile {
         // Parse method names
         self.parse_method_names(&mut obj)?;
 
+        // Decode the method table once, for get_pcode_for_method or
+        // native_entry_for_method
+        if let Some(info) = &obj.info {
+            if self.is_native_code {
+                obj.entries = self.parse_method_entries(info);
+            } else {
+                obj.procs = self.parse_method_procs(info);
+            }
+        }
+
         Ok(obj)
     }
 
+    /// Decode the method table of an object
+    fn parse_method_procs(&self, info: &VBObjectInfo) -> Vec<Option<MethodProc>> {
+        if info.lp_methods == 0 {
+            return Vec::new();
+        }
+
+        const DESC_SIZE: u32 = size_of::<VBProcDescInfo>() as u32;
+        let method_table_rva = self.va_to_rva(info.lp_methods);
+        (0..u32::from(info.w_method_count))
+            .map(|i| {
+                let proc_desc_rva = method_table_rva.checked_add(i * DESC_SIZE)?;
+                let proc_desc = self.pe_file.read_pod::<VBProcDescInfo>(proc_desc_rva)?;
+                (proc_desc.w_proc_size != 0).then_some(MethodProc {
+                    pcode_rva: proc_desc_rva.checked_add(DESC_SIZE)?,
+                    size: proc_desc.w_proc_size,
+                })
+            })
+            .collect()
+    }
+
+    /// Decode the method table of a native-code object
+    ///
+    /// Native methods are compiled functions, so the table is a plain array
+    /// of their entry VAs rather than of procedure descriptors.
+    fn parse_method_entries(&self, info: &VBObjectInfo) -> Vec<Option<u32>> {
+        if info.lp_methods == 0 {
+            return Vec::new();
+        }
+
+        let method_table_rva = self.va_to_rva(info.lp_methods);
+        (0..u32::from(info.w_method_count))
+            .map(|i| {
+                let slot_rva = method_table_rva.checked_add(i * 4)?;
+                self.pe_file.read_pod::<u32>(slot_rva).filter(|&va| va != 0)
+            })
+            .collect()
+    }
+
     /// Parse method names for an object
     fn parse_method_names(&self, obj: &mut VBObject) -> Result<()> {
         if obj.descriptor.dw_method_count == 0 || obj.descriptor.lp_method_names_array == 0 {
@@ -506,24 +550,14 @@ impl VBFile {
     }
 
     /// Read a structure at an RVA
-    fn read_struct<T: Copy>(&self, rva: u32) -> Result<T> {
-        let size = size_of::<T>();
-        let data = self.pe_file.read_at_rva(rva, size).ok_or_else(|| {
-            Error::invalid_vb(format!("Failed to read structure at RVA 0x{:X}", rva))
-        })?;
-
-        if data.len() < size {
-            return Err(Error::invalid_vb(format!(
-                "Insufficient data at RVA 0x{:X}: expected {} bytes, got {}",
-                rva,
-                size,
-                data.len()
-            )));
-        }
-
-        // SAFETY: We've verified the size matches and T is Copy.
-        // The packed repr ensures no alignment issues.
-        unsafe { Ok(std::ptr::read_unaligned(data.as_ptr() as *const T)) }
+    fn read_struct<T: Pod>(&self, rva: u32) -> Result<T> {
+        self.pe_file.read_pod(rva).ok_or_else(|| {
+            Error::invalid_vb(format!(
+                "Failed to read {} bytes of structure at RVA 0x{:X}",
+                size_of::<T>(),
+                rva
+            ))
+        })
     }
 
     /// Read a null-terminated string at an RVA
@@ -538,7 +572,8 @@ impl VBFile {
 
     /// Convert Virtual Address to Relative Virtual Address
     fn va_to_rva(&self, va: u32) -> u32 {
-        va.saturating_sub(self.pe_file.image_base())
+        // Addresses below the image base land in the headers and fail to read
+        self.pe_file.va_to_rva(va).unwrap_or(0)
     }
 
     /// Check if this is a valid VB file
@@ -572,40 +607,29 @@ impl VBFile {
     }
 
     /// Get P-Code bytes for a specific method
-    pub fn get_pcode_for_method(
-        &self,
-        object_index: usize,
-        method_index: usize,
-    ) -> Option<Vec<u8>> {
+    ///
+    /// The slice borrows directly from the PE image; nothing is copied.
+    pub fn get_pcode_for_method(&self, object_index: usize, method_index: usize) -> Option<&[u8]> {
         if !self.is_pcode() {
             return None;
         }
 
-        let obj = self.objects.get(object_index)?;
-        let info = obj.info.as_ref()?;
-
-        if info.lp_methods == 0 || method_index >= info.w_method_count as usize {
-            return None;
-        }
-
-        // Read procedure descriptor
-        let method_table_rva = self.va_to_rva(info.lp_methods);
-        let proc_desc_rva =
-            method_table_rva + (method_index as u32 * size_of::<VBProcDescInfo>() as u32);
-
-        let proc_desc = self.read_struct::<VBProcDescInfo>(proc_desc_rva).ok()?;
+        let proc = self
+            .objects
+            .get(object_index)?
+            .procs
+            .get(method_index)?
+            .as_ref()?;
+        self.pe_file.read_at_rva(proc.pcode_rva, proc.size as usize)
+    }
 
-        if proc_desc.w_proc_size == 0 {
+    /// Get the entry VA of a native-compiled method
+    pub fn native_entry_for_method(&self, object_index: usize, method_index: usize) -> Option<u32> {
+        if !self.is_native_code() {
             return None;
         }
 
-        // P-Code follows the descriptor
-        let pcode_rva = proc_desc_rva + size_of::<VBProcDescInfo>() as u32;
-        let pcode_bytes = self
-            .pe_file
-            .read_at_rva(pcode_rva, proc_desc.w_proc_size as usize)?;
-
-        Some(pcode_bytes.to_vec())
+        *self.objects.get(object_index)?.entries.get(method_index)?
     }
 
     /// Get the underlying PE file
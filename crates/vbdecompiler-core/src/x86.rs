@@ -7,7 +7,9 @@
 //! Provides x86 disassembly for native-compiled VB executables
 
 use crate::error::{Error, Result};
-use iced_x86::{Decoder, DecoderOptions, Formatter, IntelFormatter};
+use iced_x86::{
+    Decoder, DecoderOptions, FlowControl, Formatter, Instruction, IntelFormatter, OpKind,
+};
 
 /// x86 instruction representation
 #[derive(Debug, Clone)]
@@ -22,9 +24,200 @@ pub struct X86Instruction {
     pub length: usize,
 }
 
+/// Compact instruction record within an [`X86Listing`]
+///
+/// Refers to the input code and the listing's text buffer by offset instead of
+/// owning its bytes and text. The layout is C-compatible so the FFI can hand
+/// records out directly.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct X86Record {
+    /// Address of instruction
+    pub address: u64,
+    /// Offset of the instruction bytes in the disassembled code
+    pub code_offset: usize,
+    /// Offset of the assembly text in [`X86Listing::text`]
+    pub text_offset: usize,
+    /// Instruction length in bytes
+    pub length: u32,
+    /// Length of the assembly text in bytes, excluding the NUL terminator
+    pub text_len: u32,
+}
+
+/// Disassembly of a whole buffer: fixed-size records plus one shared text buffer
+///
+/// Each record's text is NUL-terminated inside `text`, so it can also be used
+/// as a C string.
+#[derive(Debug, Clone, Default)]
+pub struct X86Listing {
+    pub records: Vec<X86Record>,
+    pub text: String,
+}
+
+impl X86Listing {
+    /// Assembly text of a record
+    pub fn text_of(&self, record: &X86Record) -> &str {
+        &self.text[record.text_offset..record.text_offset + record.text_len as usize]
+    }
+}
+
+/// How an instruction affects control flow, in [`X86Decoded::flow`]
+#[repr(u32)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum X86Flow {
+    /// Execution continues with the next instruction
+    Next = 0,
+    /// Unconditional direct or indirect jump
+    Branch = 1,
+    ConditionalBranch = 2,
+    Call = 3,
+    Return = 4,
+    /// Interrupts, exceptions and anything else that stops the linear flow
+    Other = 5,
+}
+
+/// Kind of an [`X86Operand`]
+#[repr(u32)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum X86OperandKind {
+    /// Unused operand slot
+    None = 0,
+    Register = 1,
+    Immediate = 2,
+    Memory = 3,
+    /// Direct near branch target
+    Branch = 4,
+    /// Far branches and the implicit memory operands of string instructions
+    Other = 5,
+}
+
+/// One operand of an [`X86Decoded`]
+///
+/// Registers are iced-x86 `Register` values; 0 means none.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct X86Operand {
+    /// [`X86OperandKind`] as u32
+    pub kind: u32,
+    /// The register, or the base register of a memory operand
+    pub register: u32,
+    /// Index register of a memory operand
+    pub index: u32,
+    /// Scale of the index register (1, 2, 4 or 8)
+    pub scale: u32,
+    /// Immediate value, memory displacement or branch target
+    pub value: u64,
+}
+
+/// Most operands an [`X86Decoded`] records
+pub const X86_MAX_OPERANDS: usize = 4;
+
+/// Decoded instruction without its text
+///
+/// Produced by [`X86Disassembler::decode`] for analyses that never look at
+/// assembly text; [`X86Disassembler::format`] formats one on demand. The
+/// layout is C-compatible so the FFI can hand records out directly.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct X86Decoded {
+    /// Address of instruction
+    pub address: u64,
+    /// Target of a direct branch or call, or 0
+    pub branch_target: u64,
+    /// Offset of the instruction bytes in the decoded code
+    pub code_offset: usize,
+    /// Instruction length in bytes
+    pub length: u32,
+    /// iced-x86 `Mnemonic` value
+    pub mnemonic: u32,
+    /// [`X86Flow`] as u32
+    pub flow: u32,
+    /// Number of operands, of which the first [`X86_MAX_OPERANDS`] are kept
+    pub operand_count: u32,
+    pub operands: [X86Operand; X86_MAX_OPERANDS],
+}
+
+impl X86Decoded {
+    fn new(instr: &Instruction, code_offset: usize) -> Self {
+        let flow = match instr.flow_control() {
+            FlowControl::Next => X86Flow::Next,
+            FlowControl::UnconditionalBranch | FlowControl::IndirectBranch => X86Flow::Branch,
+            FlowControl::ConditionalBranch => X86Flow::ConditionalBranch,
+            FlowControl::Call | FlowControl::IndirectCall => X86Flow::Call,
+            FlowControl::Return => X86Flow::Return,
+            FlowControl::Interrupt | FlowControl::XbeginXabortXend | FlowControl::Exception => {
+                X86Flow::Other
+            }
+        };
+
+        let mut decoded = Self {
+            address: instr.ip(),
+            branch_target: 0,
+            code_offset,
+            length: instr.len() as u32,
+            mnemonic: instr.mnemonic() as u32,
+            flow: flow as u32,
+            operand_count: instr.op_count(),
+            operands: [X86Operand {
+                kind: X86OperandKind::None as u32,
+                register: 0,
+                index: 0,
+                scale: 0,
+                value: 0,
+            }; X86_MAX_OPERANDS],
+        };
+
+        let count = (instr.op_count() as usize).min(X86_MAX_OPERANDS);
+        for (i, operand) in decoded.operands[..count].iter_mut().enumerate() {
+            let op = i as u32;
+            match instr.op_kind(op) {
+                OpKind::Register => {
+                    operand.kind = X86OperandKind::Register as u32;
+                    operand.register = instr.op_register(op) as u32;
+                }
+                OpKind::NearBranch16 | OpKind::NearBranch32 | OpKind::NearBranch64 => {
+                    operand.kind = X86OperandKind::Branch as u32;
+                    operand.value = instr.near_branch_target();
+                    decoded.branch_target = operand.value;
+                }
+                OpKind::Immediate8
+                | OpKind::Immediate8_2nd
+                | OpKind::Immediate16
+                | OpKind::Immediate32
+                | OpKind::Immediate64
+                | OpKind::Immediate8to16
+                | OpKind::Immediate8to32
+                | OpKind::Immediate8to64
+                | OpKind::Immediate32to64 => {
+                    operand.kind = X86OperandKind::Immediate as u32;
+                    operand.value = instr.immediate(op);
+                }
+                OpKind::Memory => {
+                    operand.kind = X86OperandKind::Memory as u32;
+                    operand.register = instr.memory_base() as u32;
+                    operand.index = instr.memory_index() as u32;
+                    operand.scale = instr.memory_index_scale();
+                    operand.value = instr.memory_displacement64();
+                }
+                _ => operand.kind = X86OperandKind::Other as u32,
+            }
+        }
+
+        decoded
+    }
+}
+
 /// x86 Disassembler using iced-x86
+///
+/// Keeps its formatter and buffers between calls, so a long-lived
+/// disassembler (such as the one behind an FFI handle) sets them up once.
 pub struct X86Disassembler {
     bitness: u32,
+    formatter: IntelFormatter,
+    /// Text of the last [`Self::format`]
+    text: String,
+    /// Records of the last [`Self::decode`]
+    decoded: Vec<X86Decoded>,
 }
 
 impl X86Disassembler {
@@ -33,7 +226,12 @@ impl X86Disassembler {
     /// # Arguments
     /// * `bitness` - 16, 32, or 64 bit mode (VB is typically 32-bit)
     pub fn new(bitness: u32) -> Self {
-        Self { bitness }
+        Self {
+            bitness,
+            formatter: IntelFormatter::new(),
+            text: String::new(),
+            decoded: Vec::new(),
+        }
     }
 
     /// Create a 32-bit disassembler (default for VB executables)
@@ -41,6 +239,10 @@ impl X86Disassembler {
         Self::new(32)
     }
 
+    fn decoder<'c>(&self, code: &'c [u8], address: u64) -> Decoder<'c> {
+        Decoder::with_ip(self.bitness, code, address, DecoderOptions::NONE)
+    }
+
     /// Disassemble bytes at given address
     ///
     /// # Arguments
@@ -49,24 +251,21 @@ impl X86Disassembler {
     ///
     /// # Returns
     /// Vector of disassembled instructions
-    pub fn disassemble(&self, code: &[u8], address: u64) -> Result<Vec<X86Instruction>> {
-        let mut decoder = Decoder::with_ip(self.bitness, code, address, DecoderOptions::NONE);
-        let mut formatter = IntelFormatter::new();
-        let mut output = String::new();
+    pub fn disassemble(&mut self, code: &[u8], address: u64) -> Result<Vec<X86Instruction>> {
+        let mut decoder = self.decoder(code, address);
         let mut instructions = Vec::new();
 
         for instr in &mut decoder {
-            output.clear();
-            formatter.format(&instr, &mut output);
+            self.text.clear();
+            self.formatter.format(&instr, &mut self.text);
 
             let len = instr.len();
-            let mut bytes = vec![0u8; len];
-            bytes.copy_from_slice(&code[(instr.ip() - address) as usize..][..len]);
+            let offset = (instr.ip() - address) as usize;
 
             instructions.push(X86Instruction {
                 address: instr.ip(),
-                bytes,
-                text: output.clone(),
+                bytes: code[offset..offset + len].to_vec(),
+                text: self.text.clone(),
                 length: len,
             });
         }
@@ -74,28 +273,87 @@ impl X86Disassembler {
         Ok(instructions)
     }
 
-    /// Disassemble a single instruction
-    pub fn disassemble_one(&self, code: &[u8], address: u64) -> Result<X86Instruction> {
-        let mut decoder = Decoder::with_ip(self.bitness, code, address, DecoderOptions::NONE);
-        let mut formatter = IntelFormatter::new();
-        let mut output = String::new();
-
-        if let Some(instr) = decoder.iter().next() {
-            formatter.format(&instr, &mut output);
+    /// Disassemble bytes at given address into a compact listing
+    ///
+    /// Unlike [`disassemble`](Self::disassemble), no per-instruction allocations
+    /// are made: instruction bytes are referenced by offset into `code` and all
+    /// text is formatted straight into one buffer.
+    pub fn disassemble_listing(&mut self, code: &[u8], address: u64) -> Result<X86Listing> {
+        let mut decoder = self.decoder(code, address);
+
+        // Rough guesses (~3 bytes and ~24 chars per instruction) to avoid regrowth
+        let mut listing = X86Listing {
+            records: Vec::with_capacity(code.len() / 3),
+            text: String::with_capacity(code.len() * 8),
+        };
 
-            let len = instr.len();
-            let mut bytes = vec![0u8; len];
-            bytes.copy_from_slice(&code[..len]);
+        for instr in &mut decoder {
+            let text_offset = listing.text.len();
+            self.formatter.format(&instr, &mut listing.text);
+            let text_len = listing.text.len() - text_offset;
+            listing.text.push('\0');
 
-            Ok(X86Instruction {
+            listing.records.push(X86Record {
                 address: instr.ip(),
-                bytes,
-                text: output,
-                length: len,
-            })
-        } else {
-            Err(Error::Decompilation("No instruction decoded".to_string()))
+                code_offset: (instr.ip() - address) as usize,
+                text_offset,
+                length: instr.len() as u32,
+                text_len: text_len as u32,
+            });
+        }
+
+        Ok(listing)
+    }
+
+    /// Decode bytes at given address without formatting any text
+    ///
+    /// The records are borrowed from the disassembler until the next call and
+    /// their buffer is reused, so repeated passes over an image don't allocate.
+    /// Format a record when it is displayed with
+    /// `format(&code[record.code_offset..], record.address)`.
+    pub fn decode(&mut self, code: &[u8], address: u64) -> &[X86Decoded] {
+        let mut decoder = self.decoder(code, address);
+        self.decoded.clear();
+        // Same guess as disassemble_listing
+        self.decoded.reserve(code.len() / 3);
+
+        for instr in &mut decoder {
+            self.decoded
+                .push(X86Decoded::new(&instr, (instr.ip() - address) as usize));
         }
+
+        &self.decoded
+    }
+
+    /// Assembly text of the instruction at the start of `code`
+    ///
+    /// The text is borrowed from the disassembler until the next call.
+    pub fn format(&mut self, code: &[u8], address: u64) -> Result<&str> {
+        let instr = self.decode_first(code, address)?;
+        self.text.clear();
+        self.formatter.format(&instr, &mut self.text);
+        Ok(&self.text)
+    }
+
+    /// Disassemble a single instruction
+    pub fn disassemble_one(&mut self, code: &[u8], address: u64) -> Result<X86Instruction> {
+        let instr = self.decode_first(code, address)?;
+        let len = instr.len();
+        let text = self.format(code, address)?.to_string();
+
+        Ok(X86Instruction {
+            address: instr.ip(),
+            bytes: code[..len].to_vec(),
+            text,
+            length: len,
+        })
+    }
+
+    fn decode_first(&self, code: &[u8], address: u64) -> Result<Instruction> {
+        self.decoder(code, address)
+            .iter()
+            .next()
+            .ok_or_else(|| Error::Decompilation("No instruction decoded".to_string()))
     }
 }
 
@@ -111,7 +369,7 @@ mod tests {
 
     #[test]
     fn test_disassemble_mov_ret() {
-        let disasm = X86Disassembler::new_32bit();
+        let mut disasm = X86Disassembler::new_32bit();
 
         // MOV EAX, 42; RET
         let code = vec![0xB8, 0x2A, 0x00, 0x00, 0x00, 0xC3];
@@ -133,7 +391,7 @@ mod tests {
 
     #[test]
     fn test_disassemble_push_pop() {
-        let disasm = X86Disassembler::new_32bit();
+        let mut disasm = X86Disassembler::new_32bit();
 
         // PUSH EBP; MOV EBP, ESP; POP EBP
         let code = vec![0x55, 0x89, 0xE5, 0x5D];
@@ -156,7 +414,7 @@ mod tests {
 
     #[test]
     fn test_disassemble_one() {
-        let disasm = X86Disassembler::new_32bit();
+        let mut disasm = X86Disassembler::new_32bit();
 
         // MOV EAX, 42
         let code = vec![0xB8, 0x2A, 0x00, 0x00, 0x00];
@@ -169,14 +427,95 @@ mod tests {
 
     #[test]
     fn test_empty_code() {
-        let disasm = X86Disassembler::new_32bit();
+        let mut disasm = X86Disassembler::new_32bit();
         let instructions = disasm.disassemble(&[], 0).unwrap();
         assert_eq!(instructions.len(), 0);
     }
 
+    #[test]
+    fn test_listing_matches_disassemble() {
+        let mut disasm = X86Disassembler::new_32bit();
+
+        // PUSH EBP; MOV EBP, ESP; MOV EAX, 42; POP EBP; RET
+        let code = vec![0x55, 0x89, 0xE5, 0xB8, 0x2A, 0x00, 0x00, 0x00, 0x5D, 0xC3];
+        let instructions = disasm.disassemble(&code, 0x401000).unwrap();
+        let listing = disasm.disassemble_listing(&code, 0x401000).unwrap();
+
+        assert_eq!(listing.records.len(), instructions.len());
+        for (record, instr) in listing.records.iter().zip(&instructions) {
+            assert_eq!(record.address, instr.address);
+            assert_eq!(record.length as usize, instr.length);
+            assert_eq!(
+                &code[record.code_offset..record.code_offset + instr.length],
+                &instr.bytes[..]
+            );
+            assert_eq!(listing.text_of(record), instr.text);
+            assert_eq!(
+                listing.text.as_bytes()[record.text_offset + record.text_len as usize],
+                0
+            );
+        }
+    }
+
+    #[test]
+    fn test_decode_matches_listing() {
+        let mut disasm = X86Disassembler::new_32bit();
+
+        // PUSH EBP; MOV EBP, ESP; CALL +0; JE +2; MOV EAX, [EBP+8]; RET
+        let code = vec![
+            0x55, 0x8B, 0xEC, 0xE8, 0x00, 0x00, 0x00, 0x00, 0x74, 0x02, 0x8B, 0x45, 0x08, 0xC3,
+        ];
+        let listing = disasm.disassemble_listing(&code, 0x401000).unwrap();
+        let decoded = disasm.decode(&code, 0x401000).to_vec();
+
+        assert_eq!(decoded.len(), listing.records.len());
+        for (decoded, record) in decoded.iter().zip(&listing.records) {
+            assert_eq!(decoded.address, record.address);
+            assert_eq!(decoded.code_offset, record.code_offset);
+            assert_eq!(decoded.length, record.length);
+
+            // Formatting on demand gives the listing's text
+            let text = disasm
+                .format(&code[decoded.code_offset..], decoded.address)
+                .unwrap();
+            assert_eq!(text, listing.text_of(record));
+        }
+
+        let call = &decoded[2];
+        assert_eq!(call.flow, X86Flow::Call as u32);
+        assert_eq!(call.branch_target, 0x401008);
+        assert_eq!(call.operands[0].kind, X86OperandKind::Branch as u32);
+
+        let je = &decoded[3];
+        assert_eq!(je.flow, X86Flow::ConditionalBranch as u32);
+        assert_eq!(je.branch_target, 0x40100C);
+
+        let load = &decoded[4];
+        assert_eq!(load.operand_count, 2);
+        assert_eq!(load.operands[0].kind, X86OperandKind::Register as u32);
+        assert_eq!(load.operands[1].kind, X86OperandKind::Memory as u32);
+        assert_eq!(load.operands[1].value, 8);
+
+        assert_eq!(decoded[5].flow, X86Flow::Return as u32);
+    }
+
+    #[test]
+    fn test_decode_reuses_buffer() {
+        let mut disasm = X86Disassembler::new_32bit();
+        let code = vec![0x90; 64];
+
+        let capacity = {
+            assert_eq!(disasm.decode(&code, 0).len(), 64);
+            disasm.decoded.capacity()
+        };
+        assert_eq!(disasm.decode(&code[..8], 0).len(), 8);
+        assert_eq!(disasm.decoded.capacity(), capacity);
+        assert!(disasm.format(&[], 0).is_err());
+    }
+
     #[test]
     fn test_64bit_mode() {
-        let disasm = X86Disassembler::new(64);
+        let mut disasm = X86Disassembler::new(64);
 
         // MOV RAX, 0x123456789ABCDEF0
         let code = vec![0x48, 0xB8, 0xF0, 0xDE, 0xBC, 0x9A, 0x78, 0x56, 0x34, 0x12];
@@ -0,0 +1,117 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Cost of crossing the C ABI
+//!
+//! Measures the FFI entry points the GUI uses, including result marshalling
+//! and freeing, so they can be compared against the core pipeline stages:
+//!
+//! ```text
+//! cargo bench -p vbdecompiler-ffi --bench marshalling > marshalling.jsonl
+//! ```
+
+#[allow(dead_code)]
+#[path = "../../vbdecompiler-core/benches/support/mod.rs"]
+mod support;
+
+use std::ffi::CString;
+use std::ptr;
+
+use support::harness::{self, Harness};
+use support::synth;
+use vbdecompiler_ffi::*;
+
+fn main() {
+    let harness = Harness::from_env();
+    let handle = vbdecompiler_new();
+
+    for spec in synth::CORPUS {
+        let path = harness::corpus_dir().join(format!("{}.exe", spec.name));
+        let data = std::fs::read(&path).unwrap_or_else(|e| {
+            eprintln!(
+                "{}: {} (regenerate with `cargo run --example gen-bench-corpus`)",
+                path.display(),
+                e
+            );
+            std::process::exit(1);
+        });
+
+        harness.bench("ffi_decompile_buffer", spec.name, data.len(), || {
+            let mut result = ptr::null_mut();
+            let rc = vbdecompiler_decompile_buffer(handle, data.as_ptr(), data.len(), &mut result);
+            assert_eq!(rc, 0, "corpus file decompiles");
+            vbdecompiler_free_result(result);
+        });
+
+        let c_path = CString::new(path.to_string_lossy().into_owned()).unwrap();
+        harness.bench("ffi_project_open", spec.name, data.len(), || {
+            let mut project = ptr::null_mut();
+            let rc = vbdecompiler_open_project(handle, c_path.as_ptr(), &mut project);
+            assert_eq!(rc, 0, "corpus file opens");
+            vbdecompiler_project_free(project);
+        });
+
+        harness.bench("ffi_project_method", spec.name, data.len(), || {
+            // Open per iteration: decompiled methods are memoized by the project
+            let mut project = ptr::null_mut();
+            vbdecompiler_open_project(handle, c_path.as_ptr(), &mut project);
+            let mut total = 0;
+            for obj in 0..vbdecompiler_project_object_count(project) {
+                for method in 0..vbdecompiler_project_method_count(project, obj) {
+                    let mut code = ptr::null();
+                    let mut code_len = 0;
+                    vbdecompiler_project_decompile_method(
+                        project,
+                        obj,
+                        method,
+                        &mut code,
+                        &mut code_len,
+                    );
+                    total += code_len;
+                }
+            }
+            vbdecompiler_project_free(project);
+            total
+        });
+    }
+
+    vbdecompiler_free(handle);
+    bench_x86(&harness);
+}
+
+/// Per-instruction results versus the single-arena listing
+fn bench_x86(harness: &Harness) {
+    // push ebp; mov ebp, esp; mov eax, [ebp+8]; add eax, 1; pop ebp; ret
+    const BLOCK: &[u8] = &[
+        0x55, 0x89, 0xE5, 0x8B, 0x45, 0x08, 0x83, 0xC0, 0x01, 0x5D, 0xC3,
+    ];
+    let code = BLOCK.repeat(64 * 1024 / BLOCK.len());
+    let input = "x86-64k";
+    let disasm = x86_disassembler_new();
+
+    harness.bench("ffi_x86_disassemble", input, code.len(), || {
+        let mut results = ptr::null_mut();
+        let mut count = 0;
+        x86_disassemble(
+            disasm,
+            code.as_ptr(),
+            code.len(),
+            0x401000,
+            &mut results,
+            &mut count,
+        );
+        x86_disassembler_free_results(results, count);
+        count
+    });
+
+    harness.bench("ffi_x86_disassemble_batch", input, code.len(), || {
+        let mut listing = ptr::null_mut();
+        let count =
+            x86_disassemble_batch(disasm, code.as_ptr(), code.len(), 0x401000, &mut listing);
+        x86_listing_free(listing);
+        count
+    });
+
+    x86_disassembler_free(disasm);
+}
@@ -0,0 +1,155 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Read access to memory-mapped method archives
+
+use std::ffi::CStr;
+use std::os::raw::{c_char, c_int};
+use std::ptr;
+use vbdecompiler_core::MappedArchive;
+
+/// Opaque handle to a memory-mapped method archive
+#[repr(C)]
+pub struct VBArchiveHandle {
+    _private: [u8; 0],
+}
+
+/// One method of an archive
+///
+/// Strings point into the mapping, are NUL-terminated and stay valid until
+/// the archive is freed.
+#[repr(C)]
+pub struct VBArchiveRecord {
+    pub object_index: u32,
+    pub method_index: u32,
+    pub object_name: *const c_char,
+    pub object_name_len: usize,
+    pub method_name: *const c_char,
+    pub method_name_len: usize,
+    pub code: *const c_char,
+    pub code_len: usize,
+    /// IR listing, or NULL if the record has none
+    pub ir: *const c_char,
+    pub ir_len: usize,
+    /// 0 for native methods, which have no P-Code
+    pub pcode_hash: u64,
+    pub has_pcode_hash: bool,
+}
+
+fn archive_ref<'a>(archive: *const VBArchiveHandle) -> Option<&'a MappedArchive> {
+    unsafe { (archive as *const MappedArchive).as_ref() }
+}
+
+/// Map an archive written by `vbdc decompile --format binary`
+///
+/// Only the header and trailer are read. On success `*archive` must be freed
+/// with vbdecompiler_archive_free.
+/// Returns 0 on success, -1 invalid argument, -2 invalid UTF-8, -3 unreadable or not an archive
+#[no_mangle]
+pub extern "C" fn vbdecompiler_archive_open(
+    path: *const c_char,
+    archive: *mut *mut VBArchiveHandle,
+) -> c_int {
+    if path.is_null() || archive.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let path_str = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -2, // Invalid UTF-8
+    };
+
+    match MappedArchive::open(path_str) {
+        Ok(opened) => {
+            unsafe {
+                *archive = Box::into_raw(Box::new(opened)) as *mut VBArchiveHandle;
+            }
+            0 // Success
+        }
+        Err(_) => -3, // Not an archive
+    }
+}
+
+/// Unmap an archive, invalidating every record read from it
+#[no_mangle]
+pub extern "C" fn vbdecompiler_archive_free(archive: *mut VBArchiveHandle) {
+    if !archive.is_null() {
+        unsafe {
+            let _ = Box::from_raw(archive as *mut MappedArchive);
+        }
+    }
+}
+
+/// Number of methods in an archive (0 for an invalid handle)
+#[no_mangle]
+pub extern "C" fn vbdecompiler_archive_count(archive: *const VBArchiveHandle) -> usize {
+    archive_ref(archive).map_or(0, |archive| archive.len())
+}
+
+/// Project name, NUL-terminated and borrowed from the mapping, or NULL
+#[no_mangle]
+pub extern "C" fn vbdecompiler_archive_project_name(
+    archive: *const VBArchiveHandle,
+) -> *const c_char {
+    match archive_ref(archive) {
+        // The name is stored with its NUL
+        Some(archive) => archive.project_name().as_ptr() as *const c_char,
+        None => ptr::null(),
+    }
+}
+
+/// Position of a method in the archive, or -1 if it is absent
+///
+/// Binary search over the index; no other record is read.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_archive_find(
+    archive: *const VBArchiveHandle,
+    object_index: u32,
+    method_index: u32,
+) -> i64 {
+    archive_ref(archive)
+        .and_then(|archive| archive.find(object_index, method_index))
+        .map_or(-1, |position| position as i64)
+}
+
+/// Read the method at `position` (in object/method index order)
+///
+/// Returns 0 on success, -1 invalid argument or position, -3 corrupt record
+#[no_mangle]
+pub extern "C" fn vbdecompiler_archive_record(
+    archive: *const VBArchiveHandle,
+    position: usize,
+    record: *mut VBArchiveRecord,
+) -> c_int {
+    let archive = match archive_ref(archive) {
+        Some(archive) if !record.is_null() && position < archive.len() => archive,
+        _ => return -1, // Invalid argument
+    };
+
+    let method = match archive.record(position) {
+        Ok(method) => method,
+        Err(_) => return -3, // Corrupt record
+    };
+    let ir = method.ir.unwrap_or("");
+    unsafe {
+        *record = VBArchiveRecord {
+            object_index: method.object_index,
+            method_index: method.method_index,
+            object_name: method.object_name.as_ptr() as *const c_char,
+            object_name_len: method.object_name.len(),
+            method_name: method.method_name.as_ptr() as *const c_char,
+            method_name_len: method.method_name.len(),
+            code: method.code.as_ptr() as *const c_char,
+            code_len: method.code.len(),
+            ir: match method.ir {
+                Some(_) => ir.as_ptr() as *const c_char,
+                None => ptr::null(),
+            },
+            ir_len: ir.len(),
+            pcode_hash: method.pcode_hash.unwrap_or(0),
+            has_pcode_hash: method.pcode_hash.is_some(),
+        };
+    }
+    0 // Success
+}
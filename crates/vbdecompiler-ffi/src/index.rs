@@ -0,0 +1,215 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Queries on the call graph, string table and symbol index
+
+use std::ffi::CStr;
+use std::os::raw::{c_char, c_int};
+use std::ptr;
+use vbdecompiler_core::{SymbolIndex, SymbolKind};
+
+/// Opaque handle to the call graph, string table and symbols of a program
+///
+/// Symbol and string ids run from 0 to the respective count - 1, in sorted
+/// order. Strings returned from an index are UTF-8, NOT NUL-terminated, and
+/// stay valid until the index is freed.
+#[repr(C)]
+pub struct VBIndexHandle {
+    _private: [u8; 0],
+}
+
+/// Only ever called: a runtime function, API import or unresolved target
+pub const VB_SYMBOL_EXTERNAL: c_int = 0;
+/// A generated method (`Object_Method`)
+pub const VB_SYMBOL_METHOD: c_int = 1;
+/// An entry of the VB object table
+pub const VB_SYMBOL_OBJECT: c_int = 2;
+
+fn index_ref<'a>(index: *const VBIndexHandle) -> Option<&'a SymbolIndex> {
+    unsafe { (index as *const SymbolIndex).as_ref() }
+}
+
+/// Borrow a NUL-terminated UTF-8 argument
+fn str_arg<'a>(s: *const c_char) -> Option<&'a str> {
+    if s.is_null() {
+        return None;
+    }
+    unsafe { CStr::from_ptr(s) }.to_str().ok()
+}
+
+/// Write up to `capacity` ids to `out` and return how many there are in total
+///
+/// Callers may pass a NULL `out` with capacity 0 to size their buffer.
+fn fill_ids(ids: impl Iterator<Item = u32>, out: *mut u32, capacity: usize) -> usize {
+    let mut total = 0;
+    for id in ids {
+        if total < capacity && !out.is_null() {
+            unsafe {
+                *out.add(total) = id;
+            }
+        }
+        total += 1;
+    }
+    total
+}
+
+/// Hand out a borrowed string as pointer and length
+fn borrowed_str(s: Option<&str>, len: *mut usize) -> *const c_char {
+    if !len.is_null() {
+        unsafe {
+            *len = s.map_or(0, str::len);
+        }
+    }
+    s.map_or(ptr::null(), |s| s.as_ptr() as *const c_char)
+}
+
+/// Free an index detached from its result (set `result->index` to NULL first)
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_free(index: *mut VBIndexHandle) {
+    if !index.is_null() {
+        unsafe {
+            let _ = Box::from_raw(index as *mut SymbolIndex);
+        }
+    }
+}
+
+/// Number of symbols (0 for an invalid handle)
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_symbol_count(index: *const VBIndexHandle) -> usize {
+    index_ref(index).map_or(0, |index| index.symbols().len())
+}
+
+/// Name of symbol `id`, borrowed from the index, or NULL; its length is stored in `*len`
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_symbol(
+    index: *const VBIndexHandle,
+    id: u32,
+    len: *mut usize,
+) -> *const c_char {
+    borrowed_str(index_ref(index).and_then(|index| index.symbol(id)), len)
+}
+
+/// Kind of symbol `id` (a VB_SYMBOL_* value), or -1 if it is absent
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_symbol_kind(index: *const VBIndexHandle, id: u32) -> c_int {
+    match index_ref(index).and_then(|index| index.kind(id)) {
+        Some(SymbolKind::External) => VB_SYMBOL_EXTERNAL,
+        Some(SymbolKind::Method) => VB_SYMBOL_METHOD,
+        Some(SymbolKind::Object) => VB_SYMBOL_OBJECT,
+        None => -1,
+    }
+}
+
+/// Id of the symbol named `name`, ignoring ASCII case, or -1 if it is absent
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_lookup(
+    index: *const VBIndexHandle,
+    name: *const c_char,
+) -> i64 {
+    match (index_ref(index), str_arg(name)) {
+        (Some(index), Some(name)) => index.lookup(name).map_or(-1, i64::from),
+        _ => -1,
+    }
+}
+
+/// Number of symbols starting with `prefix`, ignoring ASCII case
+///
+/// Matching ids are consecutive; the first is stored in `*first`.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_find_symbols(
+    index: *const VBIndexHandle,
+    prefix: *const c_char,
+    first: *mut u32,
+) -> usize {
+    let range = match (index_ref(index), str_arg(prefix)) {
+        (Some(index), Some(prefix)) => index.find_symbols(prefix),
+        _ => 0..0,
+    };
+    if !first.is_null() {
+        unsafe {
+            *first = range.start;
+        }
+    }
+    range.len()
+}
+
+/// Symbols called by method `caller`
+///
+/// Writes up to `capacity` ids to `callees`; returns the total number.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_callees(
+    index: *const VBIndexHandle,
+    caller: u32,
+    callees: *mut u32,
+    capacity: usize,
+) -> usize {
+    index_ref(index).map_or(0, |index| {
+        fill_ids(index.callees(caller), callees, capacity)
+    })
+}
+
+/// Methods calling symbol `callee`
+///
+/// Writes up to `capacity` ids to `callers`; returns the total number.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_callers(
+    index: *const VBIndexHandle,
+    callee: u32,
+    callers: *mut u32,
+    capacity: usize,
+) -> usize {
+    index_ref(index).map_or(0, |index| {
+        fill_ids(index.callers(callee), callers, capacity)
+    })
+}
+
+/// Number of distinct string constants (0 for an invalid handle)
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_string_count(index: *const VBIndexHandle) -> usize {
+    index_ref(index).map_or(0, |index| index.strings().len())
+}
+
+/// String constant `id`, borrowed from the index, or NULL; its length is stored in `*len`
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_string(
+    index: *const VBIndexHandle,
+    id: u32,
+    len: *mut usize,
+) -> *const c_char {
+    borrowed_str(index_ref(index).and_then(|index| index.string(id)), len)
+}
+
+/// String constants containing `needle`
+///
+/// Writes up to `capacity` ids to `strings`; returns the total number.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_find_strings(
+    index: *const VBIndexHandle,
+    needle: *const c_char,
+    ignore_case: bool,
+    strings: *mut u32,
+    capacity: usize,
+) -> usize {
+    match (index_ref(index), str_arg(needle)) {
+        (Some(index), Some(needle)) => {
+            fill_ids(index.find_strings(needle, ignore_case), strings, capacity)
+        }
+        _ => 0,
+    }
+}
+
+/// Methods using string constant `id`
+///
+/// Writes up to `capacity` symbol ids to `methods`; returns the total number.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_index_string_users(
+    index: *const VBIndexHandle,
+    id: u32,
+    methods: *mut u32,
+    capacity: usize,
+) -> usize {
+    index_ref(index).map_or(0, |index| {
+        fill_ids(index.string_users(id), methods, capacity)
+    })
+}
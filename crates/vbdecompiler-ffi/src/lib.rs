@@ -7,10 +7,33 @@
 //! This crate provides a C-compatible interface to the Rust core library,
 //! allowing the C++/Qt GUI to call into the Rust decompiler.
 
+mod archive;
+mod index;
+mod project;
+mod x86;
+
+pub use archive::*;
+pub use index::*;
+pub use project::*;
+pub use x86::*;
+
 use std::ffi::{CStr, CString};
-use std::os::raw::{c_char, c_int};
+use std::os::raw::{c_char, c_int, c_void};
+use std::path::PathBuf;
 use std::ptr;
-use vbdecompiler_core::{Decompiler, X86Disassembler};
+use std::sync::Mutex;
+use vbdecompiler_core::{
+    CancellationToken, DecompilationResult, DecompileHooks, DecompileStats, DecompiledMethod,
+    Decompiler, DecompilerConfig, Error, MethodFn, Parallelism, Result as CoreResult,
+    StatsCollector,
+};
+
+// Count allocations so results can report them (see VBDecompileStats). Off by
+// default: a library must not replace its host's allocator
+#[cfg(feature = "count-allocations")]
+#[global_allocator]
+static ALLOCATOR: vbdecompiler_core::CountingAllocator =
+    vbdecompiler_core::CountingAllocator::new(std::alloc::System);
 
 /// Opaque handle to a Decompiler instance
 #[repr(C)]
@@ -18,6 +41,47 @@ pub struct VBDecompilerHandle {
     _private: [u8; 0],
 }
 
+/// Cost of one of the slowest methods of a decompilation
+#[repr(C)]
+pub struct VBMethodTiming {
+    /// Object name (owned by the result)
+    pub object_name: *mut c_char,
+    /// Method name (owned by the result)
+    pub method_name: *mut c_char,
+    pub total_ns: u64,
+    pub disassemble_ns: u64,
+    pub lift_ns: u64,
+    pub codegen_ns: u64,
+    pub instructions: u64,
+    pub pcode_bytes: u64,
+}
+
+/// Timings and counters of a decompilation
+///
+/// Method stage times are summed over all worker threads.
+#[repr(C)]
+pub struct VBDecompileStats {
+    pub wall_ns: u64,
+    pub read_ns: u64,
+    pub pe_parse_ns: u64,
+    pub vb_parse_ns: u64,
+    pub disassemble_ns: u64,
+    pub lift_ns: u64,
+    pub codegen_ns: u64,
+    pub methods: u64,
+    pub cached_methods: u64,
+    pub instructions: u64,
+    pub pcode_bytes: u64,
+    pub code_bytes: u64,
+    /// Heap allocations made meanwhile, or -1 if not counted
+    pub allocations: i64,
+    /// Bytes requested by those allocations, or -1 if not counted
+    pub allocated_bytes: i64,
+    /// The slowest methods, slowest first (owned by the result)
+    pub slowest: *mut VBMethodTiming,
+    pub slowest_count: usize,
+}
+
 /// Result structure for C FFI
 #[repr(C)]
 pub struct VBDecompilationResult {
@@ -31,8 +95,48 @@ pub struct VBDecompilationResult {
     pub object_count: usize,
     /// Number of methods
     pub method_count: usize,
+    /// Where the time went
+    pub stats: VBDecompileStats,
+    /// Call graph, string table and symbols, or NULL unless enabled with
+    /// vbdecompiler_set_build_index (freed with the result unless detached)
+    pub index: *mut VBIndexHandle,
 }
 
+/// Opaque handle to a cancellation token
+#[repr(C)]
+pub struct VBCancelToken {
+    _private: [u8; 0],
+}
+
+/// Progress callback: `(user_data, completed_methods, total_methods)`
+///
+/// Invoked from decompiler worker threads, possibly concurrently.
+pub type VBProgressCallback =
+    Option<extern "C" fn(user_data: *mut c_void, completed: usize, total: usize)>;
+
+/// A single decompiled method handed to a [`VBMethodCallback`]
+///
+/// All pointers are borrowed and only valid for the duration of the callback.
+/// Strings are UTF-8 and NOT NUL-terminated; use the accompanying lengths.
+#[repr(C)]
+pub struct VBMethodChunk {
+    pub object_index: usize,
+    pub method_index: usize,
+    pub object_name: *const c_char,
+    pub object_name_len: usize,
+    pub method_name: *const c_char,
+    pub method_name_len: usize,
+    pub code: *const c_char,
+    pub code_len: usize,
+}
+
+/// Method callback: `(user_data, chunk)`
+///
+/// Invoked once per decompiled method, in completion order. Calls are
+/// serialized, but may come from any decompiler worker thread.
+pub type VBMethodCallback =
+    Option<extern "C" fn(user_data: *mut c_void, chunk: *const VBMethodChunk)>;
+
 /// Create a new decompiler instance
 #[no_mangle]
 pub extern "C" fn vbdecompiler_new() -> *mut VBDecompilerHandle {
@@ -40,6 +144,67 @@ pub extern "C" fn vbdecompiler_new() -> *mut VBDecompilerHandle {
     Box::into_raw(decompiler) as *mut VBDecompilerHandle
 }
 
+/// Split decompilation into one task per method ([`VBDecompilerConfig::parallelism`])
+pub const VB_PARALLEL_METHODS: c_int = 0;
+/// Split decompilation into one task per object
+pub const VB_PARALLEL_OBJECTS: c_int = 1;
+
+/// Threading settings for [`vbdecompiler_new_with_config`]
+///
+/// Zero-initialized settings match [`vbdecompiler_new`].
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct VBDecompilerConfig {
+    /// Dedicated worker threads; 0 shares the process-wide pool
+    pub threads: usize,
+    /// Worker stack size in bytes; 0 for the default
+    pub stack_size: usize,
+    /// Methods with less P-Code than this many bytes run serially, batched together
+    pub serial_threshold: usize,
+    /// `VB_PARALLEL_METHODS` or `VB_PARALLEL_OBJECTS`
+    pub parallelism: c_int,
+}
+
+/// Fill `config` with the default settings
+#[no_mangle]
+pub extern "C" fn vbdecompiler_config_default(config: *mut VBDecompilerConfig) {
+    if !config.is_null() {
+        unsafe { *config = VBDecompilerConfig::default() };
+    }
+}
+
+/// Create a decompiler instance with the given threading settings
+///
+/// Returns NULL if `config` is NULL or invalid, or the thread pool could not
+/// be started.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_new_with_config(
+    config: *const VBDecompilerConfig,
+) -> *mut VBDecompilerHandle {
+    if config.is_null() {
+        return ptr::null_mut();
+    }
+    let config = unsafe { *config };
+
+    let parallelism = match config.parallelism {
+        VB_PARALLEL_METHODS => Parallelism::Methods,
+        VB_PARALLEL_OBJECTS => Parallelism::Objects,
+        _ => return ptr::null_mut(),
+    };
+    let config = DecompilerConfig {
+        threads: config.threads,
+        stack_size: config.stack_size,
+        serial_threshold: config.serial_threshold,
+        parallelism,
+        ..Default::default()
+    };
+
+    match Decompiler::with_config(config) {
+        Ok(decompiler) => Box::into_raw(Box::new(decompiler)) as *mut VBDecompilerHandle,
+        Err(_) => ptr::null_mut(),
+    }
+}
+
 /// Free a decompiler instance
 #[no_mangle]
 pub extern "C" fn vbdecompiler_free(handle: *mut VBDecompilerHandle) {
@@ -50,6 +215,51 @@ pub extern "C" fn vbdecompiler_free(handle: *mut VBDecompilerHandle) {
     }
 }
 
+/// Enable the on-disk result cache in `dir`, or disable it if `dir` is NULL
+///
+/// Returns 0 on success, -1 for a NULL handle, -2 for invalid UTF-8
+#[no_mangle]
+pub extern "C" fn vbdecompiler_set_cache_dir(
+    handle: *mut VBDecompilerHandle,
+    dir: *const c_char,
+) -> c_int {
+    if handle.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &mut *(handle as *mut Decompiler) };
+
+    if dir.is_null() {
+        decompiler.set_cache_dir(None);
+        return 0;
+    }
+
+    match unsafe { CStr::from_ptr(dir) }.to_str() {
+        Ok(s) => {
+            decompiler.set_cache_dir(Some(PathBuf::from(s)));
+            0
+        }
+        Err(_) => -2, // Invalid UTF-8
+    }
+}
+
+/// Build a symbol index into every following result ([`VBDecompilationResult::index`])
+///
+/// Returns 0 on success, -1 for a NULL handle
+#[no_mangle]
+pub extern "C" fn vbdecompiler_set_build_index(
+    handle: *mut VBDecompilerHandle,
+    build_index: bool,
+) -> c_int {
+    if handle.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &mut *(handle as *mut Decompiler) };
+    decompiler.set_build_index(build_index);
+    0
+}
+
 /// Decompile a file
 ///
 /// Returns 0 on success, non-zero error code on failure
@@ -71,31 +281,332 @@ pub extern "C" fn vbdecompiler_decompile_file(
         Err(_) => return -2, // Invalid UTF-8
     };
 
-    match decompiler.decompile_file(path_str) {
+    let stats = StatsCollector::new();
+    let hooks = DecompileHooks {
+        stats: Some(&stats),
+        ..Default::default()
+    };
+
+    match decompiler.decompile_file_with_hooks(path_str, &hooks) {
         Ok(res) => {
-            let c_result = Box::new(VBDecompilationResult {
-                project_name: match CString::new(res.project_name) {
-                    Ok(s) => s.into_raw(),
-                    Err(_) => ptr::null_mut(),
-                },
-                vb6_code: match CString::new(res.vb6_code) {
-                    Ok(s) => s.into_raw(),
-                    Err(_) => ptr::null_mut(),
-                },
-                is_pcode: res.is_pcode,
-                object_count: res.object_count,
-                method_count: res.method_count,
-            });
+            unsafe {
+                *result = into_c_result(res, &stats);
+            }
+            0 // Success
+        }
+        Err(_) => -3, // Decompilation error
+    }
+}
+
+/// Decompile a file with progress reporting and cooperative cancellation
+///
+/// `progress` and `token` may be NULL. The token must stay alive until this call returns.
+/// Returns 0 on success, -4 if cancelled, other codes as vbdecompiler_decompile_file
+#[no_mangle]
+pub extern "C" fn vbdecompiler_decompile_file_with_progress(
+    handle: *mut VBDecompilerHandle,
+    path: *const c_char,
+    progress: VBProgressCallback,
+    user_data: *mut c_void,
+    token: *const VBCancelToken,
+    result: *mut *mut VBDecompilationResult,
+) -> c_int {
+    if handle.is_null() || path.is_null() || result.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &mut *(handle as *mut Decompiler) };
 
+    let path_str = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -2, // Invalid UTF-8
+    };
+
+    let cancel = if token.is_null() {
+        None
+    } else {
+        Some(unsafe { &*(token as *const CancellationToken) })
+    };
+
+    // The caller guarantees user_data may be used from any thread
+    let user_data = UserData(user_data);
+    let report = move |completed: usize, total: usize| {
+        if let Some(callback) = progress {
+            callback(user_data.get(), completed, total);
+        }
+    };
+
+    let stats = StatsCollector::new();
+    let hooks = DecompileHooks {
+        progress: Some(&report),
+        cancel,
+        stats: Some(&stats),
+    };
+
+    match decompiler.decompile_file_with_hooks(path_str, &hooks) {
+        Ok(res) => {
             unsafe {
-                *result = Box::into_raw(c_result);
+                *result = into_c_result(res, &stats);
             }
             0 // Success
         }
+        Err(Error::Cancelled) => -4,
         Err(_) => -3, // Decompilation error
     }
 }
 
+/// Decompile a VB executable file, streaming each method to `on_method` as it finishes
+///
+/// The returned result has a NULL `vb6_code`; the code is only delivered via
+/// the callback. Returns 0 on success, -4 if cancelled, other negative values on error.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_decompile_file_streaming(
+    handle: *mut VBDecompilerHandle,
+    path: *const c_char,
+    on_method: VBMethodCallback,
+    progress: VBProgressCallback,
+    user_data: *mut c_void,
+    token: *const VBCancelToken,
+    result: *mut *mut VBDecompilationResult,
+) -> c_int {
+    if handle.is_null() || path.is_null() || result.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &mut *(handle as *mut Decompiler) };
+
+    let path_str = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -2, // Invalid UTF-8
+    };
+
+    decompile_streaming(
+        on_method,
+        progress,
+        user_data,
+        token,
+        result,
+        |deliver, hooks| decompiler.decompile_file_streaming(path_str, deliver, hooks),
+    )
+}
+
+/// Decompile a VB executable held in a caller-owned buffer (e.g. from QFile::map)
+///
+/// The buffer is parsed in place and not copied. It must stay valid and
+/// unmodified until this returns.
+/// Returns 0 on success, non-zero error code on failure
+/// On success, result must be freed with vbdecompiler_free_result
+#[no_mangle]
+pub extern "C" fn vbdecompiler_decompile_buffer(
+    handle: *mut VBDecompilerHandle,
+    data: *const u8,
+    data_len: usize,
+    result: *mut *mut VBDecompilationResult,
+) -> c_int {
+    if handle.is_null() || data.is_null() || result.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &mut *(handle as *mut Decompiler) };
+    let buffer = unsafe { std::slice::from_raw_parts(data, data_len) };
+
+    let stats = StatsCollector::new();
+    let hooks = DecompileHooks {
+        stats: Some(&stats),
+        ..Default::default()
+    };
+
+    match decompiler.decompile_bytes_with_hooks(buffer, &hooks) {
+        Ok(res) => {
+            unsafe {
+                *result = into_c_result(res, &stats);
+            }
+            0 // Success
+        }
+        Err(_) => -3, // Decompilation error
+    }
+}
+
+/// Streaming variant of [`vbdecompiler_decompile_buffer`]
+///
+/// See [`vbdecompiler_decompile_file_streaming`] for callback semantics.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_decompile_buffer_streaming(
+    handle: *mut VBDecompilerHandle,
+    data: *const u8,
+    data_len: usize,
+    on_method: VBMethodCallback,
+    progress: VBProgressCallback,
+    user_data: *mut c_void,
+    token: *const VBCancelToken,
+    result: *mut *mut VBDecompilationResult,
+) -> c_int {
+    if handle.is_null() || data.is_null() || result.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &mut *(handle as *mut Decompiler) };
+    let buffer = unsafe { std::slice::from_raw_parts(data, data_len) };
+
+    decompile_streaming(
+        on_method,
+        progress,
+        user_data,
+        token,
+        result,
+        |deliver, hooks| decompiler.decompile_bytes_streaming(buffer, deliver, hooks),
+    )
+}
+
+/// Shared body of the streaming entry points: adapts the C callbacks and maps the result
+fn decompile_streaming(
+    on_method: VBMethodCallback,
+    progress: VBProgressCallback,
+    user_data: *mut c_void,
+    token: *const VBCancelToken,
+    result: *mut *mut VBDecompilationResult,
+    run: impl FnOnce(&MethodFn<'_>, &DecompileHooks<'_>) -> CoreResult<DecompilationResult>,
+) -> c_int {
+    let on_method = match on_method {
+        Some(callback) => callback,
+        None => return -1, // Invalid argument
+    };
+
+    let cancel = if token.is_null() {
+        None
+    } else {
+        Some(unsafe { &*(token as *const CancellationToken) })
+    };
+
+    // The caller guarantees user_data may be used from any thread
+    let user_data = UserData(user_data);
+    let report = move |completed: usize, total: usize| {
+        if let Some(callback) = progress {
+            callback(user_data.get(), completed, total);
+        }
+    };
+
+    // Serialize method callbacks so C consumers need no locking of their own
+    let serialize = Mutex::new(());
+    let deliver = |method: &DecompiledMethod<'_>| {
+        let chunk = VBMethodChunk {
+            object_index: method.object_index,
+            method_index: method.method_index,
+            object_name: method.object_name.as_ptr() as *const c_char,
+            object_name_len: method.object_name.len(),
+            method_name: method.method_name.as_ptr() as *const c_char,
+            method_name_len: method.method_name.len(),
+            code: method.code.as_ptr() as *const c_char,
+            code_len: method.code.len(),
+        };
+
+        let _guard = serialize.lock().unwrap_or_else(|e| e.into_inner());
+        on_method(user_data.get(), &chunk);
+    };
+
+    let stats = StatsCollector::new();
+    let hooks = DecompileHooks {
+        progress: Some(&report),
+        cancel,
+        stats: Some(&stats),
+    };
+
+    match run(&deliver, &hooks) {
+        Ok(res) => {
+            let c_result = into_c_result(res, &stats);
+            unsafe {
+                // Nothing was accumulated; don't hand out an empty string
+                if !(*c_result).vb6_code.is_null() {
+                    let _ = CString::from_raw((*c_result).vb6_code);
+                    (*c_result).vb6_code = ptr::null_mut();
+                }
+                *result = c_result;
+            }
+            0 // Success
+        }
+        Err(Error::Cancelled) => -4,
+        Err(_) => -3, // Decompilation error
+    }
+}
+
+/// Caller-owned context pointer handed back to C callbacks
+#[derive(Clone, Copy)]
+struct UserData(*mut c_void);
+
+// SAFETY: The C API contract requires callbacks and their user data to be thread-safe.
+unsafe impl Send for UserData {}
+unsafe impl Sync for UserData {}
+
+impl UserData {
+    fn get(self) -> *mut c_void {
+        self.0
+    }
+}
+
+/// Convert a core result and its measurements into a heap-allocated C result
+fn into_c_result(res: DecompilationResult, stats: &StatsCollector) -> *mut VBDecompilationResult {
+    let c_result = Box::new(VBDecompilationResult {
+        project_name: match CString::new(res.project_name) {
+            Ok(s) => s.into_raw(),
+            Err(_) => ptr::null_mut(),
+        },
+        vb6_code: match CString::new(res.vb6_code) {
+            Ok(s) => s.into_raw(),
+            Err(_) => ptr::null_mut(),
+        },
+        is_pcode: res.is_pcode,
+        object_count: res.object_count,
+        method_count: res.method_count,
+        stats: into_c_stats(stats.finish()),
+        index: res.index.map_or(ptr::null_mut(), |index| {
+            Box::into_raw(Box::new(index)) as *mut VBIndexHandle
+        }),
+    });
+
+    Box::into_raw(c_result)
+}
+
+/// Convert measurements to their C form; the slowest-method array is freed
+/// by vbdecompiler_free_result
+fn into_c_stats(stats: DecompileStats) -> VBDecompileStats {
+    let owned = |s: String| CString::new(s).map_or(ptr::null_mut(), CString::into_raw);
+    let counted = |value: Option<u64>| value.map_or(-1, |v| i64::try_from(v).unwrap_or(i64::MAX));
+    let slowest: Box<[VBMethodTiming]> = stats
+        .slowest
+        .into_iter()
+        .map(|m| VBMethodTiming {
+            object_name: owned(m.object_name),
+            method_name: owned(m.method_name),
+            total_ns: m.total_ns,
+            disassemble_ns: m.disassemble_ns,
+            lift_ns: m.lift_ns,
+            codegen_ns: m.codegen_ns,
+            instructions: m.instructions,
+            pcode_bytes: m.pcode_bytes,
+        })
+        .collect();
+    let slowest_count = slowest.len();
+
+    VBDecompileStats {
+        wall_ns: stats.wall_ns,
+        read_ns: stats.stages.read_ns,
+        pe_parse_ns: stats.stages.pe_parse_ns,
+        vb_parse_ns: stats.stages.vb_parse_ns,
+        disassemble_ns: stats.stages.disassemble_ns,
+        lift_ns: stats.stages.lift_ns,
+        codegen_ns: stats.stages.codegen_ns,
+        methods: stats.methods,
+        cached_methods: stats.cached_methods,
+        instructions: stats.instructions,
+        pcode_bytes: stats.pcode_bytes,
+        code_bytes: stats.code_bytes,
+        allocations: counted(stats.allocations),
+        allocated_bytes: counted(stats.allocated_bytes),
+        slowest: Box::into_raw(slowest) as *mut VBMethodTiming,
+        slowest_count,
+    }
+}
+
 /// Free a decompilation result
 #[no_mangle]
 pub extern "C" fn vbdecompiler_free_result(result: *mut VBDecompilationResult) {
@@ -108,6 +619,16 @@ pub extern "C" fn vbdecompiler_free_result(result: *mut VBDecompilationResult) {
             if !res.vb6_code.is_null() {
                 let _ = CString::from_raw(res.vb6_code);
             }
+            vbdecompiler_index_free(res.index);
+
+            let slowest = ptr::slice_from_raw_parts_mut(res.stats.slowest, res.stats.slowest_count);
+            for timing in Box::from_raw(slowest).iter() {
+                for name in [timing.object_name, timing.method_name] {
+                    if !name.is_null() {
+                        let _ = CString::from_raw(name);
+                    }
+                }
+            }
         }
     }
 }
@@ -122,129 +643,37 @@ pub extern "C" fn vbdecompiler_free_string(s: *mut c_char) {
     }
 }
 
-/// Get last error message (returns NULL if no error)
+/// Create a new cancellation token
 #[no_mangle]
-pub extern "C" fn vbdecompiler_last_error() -> *const c_char {
-    // TODO: Implement thread-local error storage
-    ptr::null()
+pub extern "C" fn vbdecompiler_cancel_token_new() -> *mut VBCancelToken {
+    let token = Box::new(CancellationToken::new());
+    Box::into_raw(token) as *mut VBCancelToken
 }
 
-// ============================================================================
-// X86 Disassembler FFI
-// ============================================================================
-
-/// Opaque handle to an X86Disassembler instance
-#[repr(C)]
-pub struct X86DisassemblerHandle {
-    _private: [u8; 0],
-}
-
-/// X86 instruction result
-#[repr(C)]
-pub struct X86InstructionResult {
-    /// Address of instruction
-    pub address: u64,
-    /// Instruction text (must be freed with vbdecompiler_free_string)
-    pub text: *mut c_char,
-    /// Instruction length in bytes
-    pub length: usize,
-    /// Instruction bytes (up to 15 bytes for x86)
-    pub bytes: [u8; 15],
-    /// Actual number of bytes in the instruction
-    pub bytes_count: usize,
-}
-
-/// Create a new x86 disassembler (32-bit mode)
-#[no_mangle]
-pub extern "C" fn x86_disassembler_new() -> *mut X86DisassemblerHandle {
-    let disasm = Box::new(X86Disassembler::new_32bit());
-    Box::into_raw(disasm) as *mut X86DisassemblerHandle
-}
-
-/// Create a new x86 disassembler with specific bitness
+/// Request cancellation of every decompilation using this token
+///
+/// Safe to call from any thread while a decompilation is running.
 #[no_mangle]
-pub extern "C" fn x86_disassembler_new_with_bitness(bitness: u32) -> *mut X86DisassemblerHandle {
-    let disasm = Box::new(X86Disassembler::new(bitness));
-    Box::into_raw(disasm) as *mut X86DisassemblerHandle
+pub extern "C" fn vbdecompiler_cancel_token_cancel(token: *const VBCancelToken) {
+    if !token.is_null() {
+        let token = unsafe { &*(token as *const CancellationToken) };
+        token.cancel();
+    }
 }
 
-/// Free an x86 disassembler instance
+/// Free a cancellation token
 #[no_mangle]
-pub extern "C" fn x86_disassembler_free(handle: *mut X86DisassemblerHandle) {
-    if !handle.is_null() {
+pub extern "C" fn vbdecompiler_cancel_token_free(token: *mut VBCancelToken) {
+    if !token.is_null() {
         unsafe {
-            let _ = Box::from_raw(handle as *mut X86Disassembler);
-        }
-    }
-}
-
-/// Disassemble bytes
-///
-/// Returns number of instructions disassembled, or -1 on error
-/// results array must be freed with x86_disassembler_free_results
-#[no_mangle]
-pub extern "C" fn x86_disassemble(
-    handle: *mut X86DisassemblerHandle,
-    code: *const u8,
-    code_len: usize,
-    address: u64,
-    results: *mut *mut X86InstructionResult,
-    count: *mut usize,
-) -> c_int {
-    if handle.is_null() || code.is_null() || results.is_null() || count.is_null() {
-        return -1;
-    }
-
-    let disasm = unsafe { &*(handle as *const X86Disassembler) };
-    let code_slice = unsafe { std::slice::from_raw_parts(code, code_len) };
-
-    match disasm.disassemble(code_slice, address) {
-        Ok(instructions) => {
-            let mut c_results = Vec::with_capacity(instructions.len());
-
-            for instr in instructions {
-                let mut bytes = [0u8; 15];
-                let bytes_count = instr.bytes.len().min(15);
-                bytes[..bytes_count].copy_from_slice(&instr.bytes[..bytes_count]);
-
-                let text = match CString::new(instr.text) {
-                    Ok(s) => s.into_raw(),
-                    Err(_) => ptr::null_mut(),
-                };
-
-                c_results.push(X86InstructionResult {
-                    address: instr.address,
-                    text,
-                    length: instr.length,
-                    bytes,
-                    bytes_count,
-                });
-            }
-
-            let len = c_results.len();
-            unsafe {
-                *count = len;
-                *results = c_results.as_mut_ptr();
-            }
-            std::mem::forget(c_results);
-
-            len as c_int
+            let _ = Box::from_raw(token as *mut CancellationToken);
         }
-        Err(_) => -1,
     }
 }
 
-/// Free disassembly results
+/// Get last error message (returns NULL if no error)
 #[no_mangle]
-pub extern "C" fn x86_disassembler_free_results(results: *mut X86InstructionResult, count: usize) {
-    if !results.is_null() && count > 0 {
-        unsafe {
-            let results_vec = Vec::from_raw_parts(results, count, count);
-            for result in results_vec {
-                if !result.text.is_null() {
-                    let _ = CString::from_raw(result.text);
-                }
-            }
-        }
-    }
+pub extern "C" fn vbdecompiler_last_error() -> *const c_char {
+    // TODO: Implement thread-local error storage
+    ptr::null()
 }
@@ -0,0 +1,214 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Lazy, per-method decompilation of an opened project
+
+use super::VBDecompilerHandle;
+use std::ffi::{CStr, CString};
+use std::os::raw::{c_char, c_int};
+use std::ptr;
+use vbdecompiler_core::{Decompiler, Project, SectionEntropy};
+
+/// Opaque handle to a lazily decompiled project
+#[repr(C)]
+pub struct VBProjectHandle {
+    _private: [u8; 0],
+}
+
+/// Open a file for lazy, per-method decompilation
+///
+/// Only the PE and VB structures are parsed. On success `*project` must be
+/// freed with vbdecompiler_project_free.
+/// Returns 0 on success, -1 invalid argument, -2 invalid UTF-8, -3 parse error
+#[no_mangle]
+pub extern "C" fn vbdecompiler_open_project(
+    handle: *mut VBDecompilerHandle,
+    path: *const c_char,
+    project: *mut *mut VBProjectHandle,
+) -> c_int {
+    if handle.is_null() || path.is_null() || project.is_null() {
+        return -1; // Invalid argument
+    }
+
+    let decompiler = unsafe { &*(handle as *const Decompiler) };
+
+    let path_str = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -2, // Invalid UTF-8
+    };
+
+    match decompiler.open(path_str) {
+        Ok(opened) => {
+            unsafe {
+                *project = Box::into_raw(Box::new(opened)) as *mut VBProjectHandle;
+            }
+            0 // Success
+        }
+        Err(_) => -3, // Parse error
+    }
+}
+
+/// Free a project and every code string it handed out
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_free(project: *mut VBProjectHandle) {
+    if !project.is_null() {
+        unsafe {
+            let _ = Box::from_raw(project as *mut Project);
+        }
+    }
+}
+
+/// Entropy of one PE section
+#[repr(C)]
+pub struct VBSectionEntropy {
+    /// Section name, NUL-terminated
+    pub name: [c_char; 9],
+    pub virtual_address: u32,
+    /// Size of the section's raw data in the file
+    pub raw_size: u32,
+    /// Shannon entropy on the 0-8 scale, or -1.0 if the section has no raw data
+    pub entropy: f64,
+    /// Whether the entropy is above the packer detection threshold
+    pub is_high: bool,
+}
+
+impl From<&SectionEntropy> for VBSectionEntropy {
+    fn from(section: &SectionEntropy) -> Self {
+        let mut name = [0 as c_char; 9];
+        for (dst, &src) in name.iter_mut().zip(section.name.as_bytes().iter().take(8)) {
+            *dst = src as c_char;
+        }
+
+        Self {
+            name,
+            virtual_address: section.virtual_address,
+            raw_size: section.raw_size,
+            entropy: section.entropy.unwrap_or(-1.0),
+            is_high: section.is_high(),
+        }
+    }
+}
+
+/// Per-section entropy of a project's executable
+///
+/// Writes up to `capacity` entries to `sections` (which may be NULL when
+/// `capacity` is 0) and returns the total number of sections. Sections that
+/// packer detection already measured are not measured again.
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_section_entropy(
+    project: *const VBProjectHandle,
+    sections: *mut VBSectionEntropy,
+    capacity: usize,
+) -> usize {
+    let project = match project_ref(project) {
+        Some(project) => project,
+        None => return 0,
+    };
+
+    let entropy = project.section_entropy();
+    if !sections.is_null() {
+        for (i, section) in entropy.iter().take(capacity).enumerate() {
+            unsafe {
+                sections.add(i).write(section.into());
+            }
+        }
+    }
+    entropy.len()
+}
+
+/// Borrow a project handle
+fn project_ref<'a>(project: *const VBProjectHandle) -> Option<&'a Project> {
+    unsafe { (project as *const Project).as_ref() }
+}
+
+/// Copy a string into a C string, dropping any interior NUL
+fn to_c_string(s: &str) -> *mut c_char {
+    CString::new(s.replace('\0', ""))
+        .map(CString::into_raw)
+        .unwrap_or(ptr::null_mut())
+}
+
+/// Project name (must be freed with vbdecompiler_free_string), or NULL
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_name(project: *const VBProjectHandle) -> *mut c_char {
+    match project_ref(project) {
+        Some(project) => to_c_string(&project.project_name()),
+        None => ptr::null_mut(),
+    }
+}
+
+/// Number of objects in the project
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_object_count(project: *const VBProjectHandle) -> usize {
+    project_ref(project).map_or(0, |project| project.objects().len())
+}
+
+/// Name of an object (must be freed with vbdecompiler_free_string), or NULL
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_object_name(
+    project: *const VBProjectHandle,
+    object_index: usize,
+) -> *mut c_char {
+    match project_ref(project).and_then(|project| project.objects().get(object_index)) {
+        Some(object) => to_c_string(&object.name),
+        None => ptr::null_mut(),
+    }
+}
+
+/// Number of methods of an object (0 for an invalid index)
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_method_count(
+    project: *const VBProjectHandle,
+    object_index: usize,
+) -> usize {
+    project_ref(project)
+        .and_then(|project| project.objects().get(object_index))
+        .map_or(0, |object| object.method_count())
+}
+
+/// Name of a method (must be freed with vbdecompiler_free_string), or NULL
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_method_name(
+    project: *const VBProjectHandle,
+    object_index: usize,
+    method_index: usize,
+) -> *mut c_char {
+    match project_ref(project)
+        .and_then(|project| project.objects().get(object_index))
+        .and_then(|object| object.method_names.get(method_index))
+    {
+        Some(name) => to_c_string(name),
+        None => ptr::null_mut(),
+    }
+}
+
+/// Decompile a single method, or return its memoized code
+///
+/// `*code` is borrowed UTF-8, NOT NUL-terminated, and stays valid until the
+/// project is freed. Safe to call from several threads at once.
+/// Returns 0 on success, -1 invalid argument, -3 if the method can't be decompiled
+#[no_mangle]
+pub extern "C" fn vbdecompiler_project_decompile_method(
+    project: *const VBProjectHandle,
+    object_index: usize,
+    method_index: usize,
+    code: *mut *const c_char,
+    code_len: *mut usize,
+) -> c_int {
+    let project = match project_ref(project) {
+        Some(project) if !code.is_null() && !code_len.is_null() => project,
+        _ => return -1, // Invalid argument
+    };
+
+    match project.decompile_method(object_index, method_index) {
+        Ok(text) => {
+            unsafe {
+                *code = text.as_ptr() as *const c_char;
+                *code_len = text.len();
+            }
+            0 // Success
+        }
+        Err(_) => -3, // Decompilation error
+    }
+}
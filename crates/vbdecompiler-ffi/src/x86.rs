@@ -0,0 +1,271 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+//! Standalone x86 disassembly
+
+use std::ffi::CString;
+use std::os::raw::{c_char, c_int};
+use std::ptr;
+use vbdecompiler_core::{X86Decoded, X86Disassembler, X86Record};
+
+/// Opaque handle to an X86Disassembler instance
+///
+/// Every call takes the disassembler mutably to reuse its decode and format
+/// buffers, so a handle must not be shared between threads without the
+/// caller serializing calls.
+#[repr(C)]
+pub struct X86DisassemblerHandle {
+    _private: [u8; 0],
+}
+
+/// X86 instruction result
+#[repr(C)]
+pub struct X86InstructionResult {
+    /// Address of instruction
+    pub address: u64,
+    /// Instruction text (must be freed with vbdecompiler_free_string)
+    pub text: *mut c_char,
+    /// Instruction length in bytes
+    pub length: usize,
+    /// Instruction bytes (up to 15 bytes for x86)
+    pub bytes: [u8; 15],
+    /// Actual number of bytes in the instruction
+    pub bytes_count: usize,
+}
+
+/// Create a new x86 disassembler (32-bit mode)
+#[no_mangle]
+pub extern "C" fn x86_disassembler_new() -> *mut X86DisassemblerHandle {
+    let disasm = Box::new(X86Disassembler::new_32bit());
+    Box::into_raw(disasm) as *mut X86DisassemblerHandle
+}
+
+/// Create a new x86 disassembler with specific bitness
+#[no_mangle]
+pub extern "C" fn x86_disassembler_new_with_bitness(bitness: u32) -> *mut X86DisassemblerHandle {
+    let disasm = Box::new(X86Disassembler::new(bitness));
+    Box::into_raw(disasm) as *mut X86DisassemblerHandle
+}
+
+/// Free an x86 disassembler instance
+#[no_mangle]
+pub extern "C" fn x86_disassembler_free(handle: *mut X86DisassemblerHandle) {
+    if !handle.is_null() {
+        unsafe {
+            let _ = Box::from_raw(handle as *mut X86Disassembler);
+        }
+    }
+}
+
+/// Disassemble bytes
+///
+/// Returns number of instructions disassembled, or -1 on error
+/// results array must be freed with x86_disassembler_free_results
+#[no_mangle]
+pub extern "C" fn x86_disassemble(
+    handle: *mut X86DisassemblerHandle,
+    code: *const u8,
+    code_len: usize,
+    address: u64,
+    results: *mut *mut X86InstructionResult,
+    count: *mut usize,
+) -> c_int {
+    if handle.is_null() || code.is_null() || results.is_null() || count.is_null() {
+        return -1;
+    }
+
+    let disasm = unsafe { &mut *(handle as *mut X86Disassembler) };
+    let code_slice = unsafe { std::slice::from_raw_parts(code, code_len) };
+
+    match disasm.disassemble(code_slice, address) {
+        Ok(instructions) => {
+            let mut c_results = Vec::with_capacity(instructions.len());
+
+            for instr in instructions {
+                let mut bytes = [0u8; 15];
+                let bytes_count = instr.bytes.len().min(15);
+                bytes[..bytes_count].copy_from_slice(&instr.bytes[..bytes_count]);
+
+                let text = match CString::new(instr.text) {
+                    Ok(s) => s.into_raw(),
+                    Err(_) => ptr::null_mut(),
+                };
+
+                c_results.push(X86InstructionResult {
+                    address: instr.address,
+                    text,
+                    length: instr.length,
+                    bytes,
+                    bytes_count,
+                });
+            }
+
+            let len = c_results.len();
+            unsafe {
+                *count = len;
+                *results = c_results.as_mut_ptr();
+            }
+            std::mem::forget(c_results);
+
+            len as c_int
+        }
+        Err(_) => -1,
+    }
+}
+
+/// Free disassembly results
+#[no_mangle]
+pub extern "C" fn x86_disassembler_free_results(results: *mut X86InstructionResult, count: usize) {
+    if !results.is_null() && count > 0 {
+        unsafe {
+            let results_vec = Vec::from_raw_parts(results, count, count);
+            for result in results_vec {
+                if !result.text.is_null() {
+                    let _ = CString::from_raw(result.text);
+                }
+            }
+        }
+    }
+}
+
+/// Batch disassembly result: fixed-size records plus one shared text buffer
+///
+/// Instruction bytes are not copied; use `code + record.code_offset` on the
+/// caller's input buffer. Record text lives at `text + record.text_offset` and
+/// is NUL-terminated. Freed as a whole with x86_listing_free.
+#[repr(C)]
+pub struct X86Listing {
+    /// Instruction records
+    pub records: *mut X86Record,
+    /// Number of records
+    pub count: usize,
+    /// Text buffer shared by all records
+    pub text: *mut c_char,
+    /// Size of the text buffer in bytes
+    pub text_len: usize,
+}
+
+/// Disassemble bytes into a single arena
+///
+/// Returns number of instructions disassembled, or -1 on error
+/// listing must be freed with x86_listing_free
+#[no_mangle]
+pub extern "C" fn x86_disassemble_batch(
+    handle: *mut X86DisassemblerHandle,
+    code: *const u8,
+    code_len: usize,
+    address: u64,
+    listing: *mut *mut X86Listing,
+) -> c_int {
+    if handle.is_null() || code.is_null() || listing.is_null() {
+        return -1;
+    }
+
+    let disasm = unsafe { &mut *(handle as *mut X86Disassembler) };
+    let code_slice = unsafe { std::slice::from_raw_parts(code, code_len) };
+
+    match disasm.disassemble_listing(code_slice, address) {
+        Ok(result) => {
+            // Boxed slices have len == capacity, so the free side can rebuild them
+            let records = Box::into_raw(result.records.into_boxed_slice());
+            let text = Box::into_raw(result.text.into_bytes().into_boxed_slice());
+
+            let c_listing = Box::new(X86Listing {
+                records: records as *mut X86Record,
+                count: records.len(),
+                text: text as *mut c_char,
+                text_len: text.len(),
+            });
+
+            let count = c_listing.count;
+            unsafe {
+                *listing = Box::into_raw(c_listing);
+            }
+
+            count as c_int
+        }
+        Err(_) => -1,
+    }
+}
+
+/// Decode bytes without formatting any text
+///
+/// Returns number of instructions decoded, or -1 on error. The records are
+/// owned by the handle and stay valid until its next call; nothing is freed.
+#[no_mangle]
+pub extern "C" fn x86_decode(
+    handle: *mut X86DisassemblerHandle,
+    code: *const u8,
+    code_len: usize,
+    address: u64,
+    records: *mut *const X86Decoded,
+    count: *mut usize,
+) -> c_int {
+    if handle.is_null() || code.is_null() || records.is_null() || count.is_null() {
+        return -1;
+    }
+
+    let disasm = unsafe { &mut *(handle as *mut X86Disassembler) };
+    let code_slice = unsafe { std::slice::from_raw_parts(code, code_len) };
+
+    let decoded = disasm.decode(code_slice, address);
+    unsafe {
+        *records = decoded.as_ptr();
+        *count = decoded.len();
+    }
+    decoded.len() as c_int
+}
+
+/// Format the instruction at the start of `code` into `buffer`
+///
+/// Writes at most `buffer_len - 1` bytes plus a NUL. Returns the full text
+/// length (like snprintf), or -1 if nothing could be decoded.
+#[no_mangle]
+pub extern "C" fn x86_format(
+    handle: *mut X86DisassemblerHandle,
+    code: *const u8,
+    code_len: usize,
+    address: u64,
+    buffer: *mut c_char,
+    buffer_len: usize,
+) -> c_int {
+    if handle.is_null() || code.is_null() || (buffer.is_null() && buffer_len > 0) {
+        return -1;
+    }
+
+    let disasm = unsafe { &mut *(handle as *mut X86Disassembler) };
+    let code_slice = unsafe { std::slice::from_raw_parts(code, code_len) };
+
+    match disasm.format(code_slice, address) {
+        Ok(text) => {
+            if buffer_len > 0 {
+                let copied = text.len().min(buffer_len - 1);
+                unsafe {
+                    ptr::copy_nonoverlapping(text.as_ptr(), buffer as *mut u8, copied);
+                    *buffer.add(copied) = 0;
+                }
+            }
+            text.len() as c_int
+        }
+        Err(_) => -1,
+    }
+}
+
+/// Free a batch disassembly listing
+#[no_mangle]
+pub extern "C" fn x86_listing_free(listing: *mut X86Listing) {
+    if !listing.is_null() {
+        unsafe {
+            let listing = Box::from_raw(listing);
+            let _ = Box::from_raw(ptr::slice_from_raw_parts_mut(
+                listing.records,
+                listing.count,
+            ));
+            let _ = Box::from_raw(ptr::slice_from_raw_parts_mut(
+                listing.text as *mut u8,
+                listing.text_len,
+            ));
+        }
+    }
+}
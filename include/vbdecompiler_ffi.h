@@ -24,6 +24,89 @@ extern "C" {
  */
 typedef struct VBDecompilerHandle VBDecompilerHandle;
 
+/**
+ * Opaque handle to a cancellation token
+ */
+typedef struct VBCancelToken VBCancelToken;
+
+/**
+ * Progress callback
+ *
+ * Invoked from decompiler worker threads (possibly concurrently) with the
+ * number of methods processed so far and the total number of methods.
+ */
+typedef void (*VBProgressCallback)(void* user_data, size_t completed, size_t total);
+
+/**
+ * A single decompiled method
+ *
+ * All pointers are borrowed and only valid during the callback. Strings are
+ * UTF-8 and NOT NUL-terminated; use the accompanying lengths.
+ */
+typedef struct {
+    size_t object_index;
+    size_t method_index;
+    const char* object_name;
+    size_t object_name_len;
+    const char* method_name;
+    size_t method_name_len;
+    const char* code;
+    size_t code_len;
+} VBMethodChunk;
+
+/**
+ * Method callback
+ *
+ * Invoked once per decompiled method in completion order. Calls are
+ * serialized but may arrive on any decompiler worker thread.
+ */
+typedef void (*VBMethodCallback)(void* user_data, const VBMethodChunk* chunk);
+
+/**
+ * Cost of one of the slowest methods of a decompilation
+ */
+typedef struct {
+    char* object_name;  // Owned by the result
+    char* method_name;  // Owned by the result
+    uint64_t total_ns;
+    uint64_t disassemble_ns;
+    uint64_t lift_ns;
+    uint64_t codegen_ns;
+    uint64_t instructions;
+    uint64_t pcode_bytes;
+} VBMethodTiming;
+
+/**
+ * Timings and counters of a decompilation
+ *
+ * Method stage times (disassemble, lift, codegen) are summed over all worker
+ * threads, so they may exceed wall_ns.
+ */
+typedef struct {
+    uint64_t wall_ns;
+    uint64_t read_ns;
+    uint64_t pe_parse_ns;
+    uint64_t vb_parse_ns;
+    uint64_t disassemble_ns;
+    uint64_t lift_ns;
+    uint64_t codegen_ns;
+    uint64_t methods;         // Methods run through the pipeline
+    uint64_t cached_methods;  // Methods reused from the cache
+    uint64_t instructions;
+    uint64_t pcode_bytes;
+    uint64_t code_bytes;
+    int64_t allocations;      // Process-wide heap allocations meanwhile, or -1
+                              // unless built with the count-allocations feature
+    int64_t allocated_bytes;  // Bytes requested by them, or -1
+    VBMethodTiming* slowest;  // Slowest first; owned by the result
+    size_t slowest_count;
+} VBDecompileStats;
+
+/**
+ * Opaque handle to the call graph, string table and symbols of a program
+ */
+typedef struct VBIndexHandle VBIndexHandle;
+
 /**
  * Decompilation result structure
  */
@@ -33,6 +116,9 @@ typedef struct {
     bool is_pcode;
     size_t object_count;
     size_t method_count;
+    VBDecompileStats stats;  // Freed with the result
+    VBIndexHandle* index;    // NULL unless vbdecompiler_set_build_index is on; freed
+                             // with the result unless detached (set to NULL)
 } VBDecompilationResult;
 
 /**
@@ -42,6 +128,39 @@ typedef struct {
  */
 VBDecompilerHandle* vbdecompiler_new(void);
 
+/** One task per method (small methods may be batched) */
+#define VB_PARALLEL_METHODS 0
+/** One task per object; suits binaries with a few huge forms */
+#define VB_PARALLEL_OBJECTS 1
+
+/**
+ * Threading settings for vbdecompiler_new_with_config
+ *
+ * Zero-initialized settings behave like vbdecompiler_new.
+ */
+typedef struct {
+    size_t threads;           // Dedicated worker threads; 0 shares the process-wide pool
+    size_t stack_size;        // Worker stack size in bytes; 0 for the default
+    size_t serial_threshold;  // Methods with less P-Code than this many bytes run serially
+    int parallelism;          // VB_PARALLEL_METHODS or VB_PARALLEL_OBJECTS
+} VBDecompilerConfig;
+
+/**
+ * Fill a config with the default settings
+ *
+ * @param config Config to initialize
+ */
+void vbdecompiler_config_default(VBDecompilerConfig* config);
+
+/**
+ * Create a new decompiler instance with its own threading settings
+ *
+ * @param config Threading settings
+ * @return Opaque handle to decompiler, must be freed with vbdecompiler_free;
+ *         NULL if config is NULL or invalid, or the thread pool failed to start
+ */
+VBDecompilerHandle* vbdecompiler_new_with_config(const VBDecompilerConfig* config);
+
 /**
  * Free a decompiler instance
  * 
@@ -49,6 +168,30 @@ VBDecompilerHandle* vbdecompiler_new(void);
  */
 void vbdecompiler_free(VBDecompilerHandle* handle);
 
+/**
+ * Enable or disable the on-disk result cache
+ *
+ * Results are keyed by file content and decompiler version, and methods
+ * whose P-Code is unchanged are reused across builds.
+ *
+ * @param handle Decompiler handle
+ * @param dir Cache directory (UTF-8), or NULL to disable caching
+ * @return 0 on success, -1 for invalid handle, -2 for invalid UTF-8
+ */
+int vbdecompiler_set_cache_dir(VBDecompilerHandle* handle, const char* dir);
+
+/**
+ * Build a symbol index into every following result
+ *
+ * References are collected while methods are decompiled; cached results are
+ * not reused while this is on.
+ *
+ * @param handle Decompiler handle
+ * @param build_index Whether to fill VBDecompilationResult::index
+ * @return 0 on success, -1 for invalid handle
+ */
+int vbdecompiler_set_build_index(VBDecompilerHandle* handle, bool build_index);
+
 /**
  * Decompile a VB executable file
  * 
@@ -66,6 +209,105 @@ int vbdecompiler_decompile_file(
     VBDecompilationResult** result
 );
 
+/**
+ * Decompile a VB executable file with progress reporting and cancellation
+ *
+ * Intended to be called from a background thread; the token may be cancelled
+ * from any other thread while this call is running.
+ *
+ * @param handle Decompiler handle
+ * @param path Path to VB executable (.exe, .dll, .ocx)
+ * @param progress Progress callback (may be NULL)
+ * @param user_data Opaque pointer passed to the progress callback
+ * @param token Cancellation token (may be NULL), must outlive this call
+ * @param result Output pointer for decompilation result (must be freed with vbdecompiler_free_result)
+ * @return 0 on success, negative error code on failure
+ *         -1: Invalid argument (NULL pointer)
+ *         -2: Invalid UTF-8 in path
+ *         -3: Decompilation error
+ *         -4: Cancelled
+ */
+int vbdecompiler_decompile_file_with_progress(
+    VBDecompilerHandle* handle,
+    const char* path,
+    VBProgressCallback progress,
+    void* user_data,
+    const VBCancelToken* token,
+    VBDecompilationResult** result
+);
+
+/**
+ * Decompile a VB executable file, streaming each method as it completes
+ *
+ * The code is delivered only through on_method; the returned result has a
+ * NULL vb6_code, so the full listing is never held in one allocation.
+ *
+ * @param handle Decompiler handle
+ * @param path Path to executable file
+ * @param on_method Method callback (required)
+ * @param progress Progress callback (may be NULL)
+ * @param user_data Opaque pointer passed to both callbacks
+ * @param token Cancellation token (may be NULL)
+ * @param result Output result (must be freed with vbdecompiler_free_result)
+ * @return 0 on success, negative on error:
+ *         -1: Invalid argument
+ *         -2: Invalid UTF-8 in path
+ *         -3: Decompilation error
+ *         -4: Cancelled
+ */
+int vbdecompiler_decompile_file_streaming(
+    VBDecompilerHandle* handle,
+    const char* path,
+    VBMethodCallback on_method,
+    VBProgressCallback progress,
+    void* user_data,
+    const VBCancelToken* token,
+    VBDecompilationResult** result
+);
+
+/**
+ * Decompile a VB executable held in memory
+ *
+ * The buffer (e.g. from QFile::map) is parsed in place without copying and
+ * must stay valid and unmodified until the call returns.
+ *
+ * @param handle Decompiler handle
+ * @param data Executable image
+ * @param data_len Size of the image in bytes
+ * @param result Output result (must be freed with vbdecompiler_free_result)
+ * @return 0 on success, negative on error:
+ *         -1: Invalid argument
+ *         -3: Decompilation error
+ */
+int vbdecompiler_decompile_buffer(
+    VBDecompilerHandle* handle,
+    const uint8_t* data,
+    size_t data_len,
+    VBDecompilationResult** result
+);
+
+/**
+ * Decompile a VB executable held in memory, streaming each method as it completes
+ *
+ * Combines vbdecompiler_decompile_buffer with the callback semantics of
+ * vbdecompiler_decompile_file_streaming.
+ *
+ * @return 0 on success, negative on error:
+ *         -1: Invalid argument
+ *         -3: Decompilation error
+ *         -4: Cancelled
+ */
+int vbdecompiler_decompile_buffer_streaming(
+    VBDecompilerHandle* handle,
+    const uint8_t* data,
+    size_t data_len,
+    VBMethodCallback on_method,
+    VBProgressCallback progress,
+    void* user_data,
+    const VBCancelToken* token,
+    VBDecompilationResult** result
+);
+
 /**
  * Free a decompilation result
  * 
@@ -80,6 +322,27 @@ void vbdecompiler_free_result(VBDecompilationResult* result);
  */
 void vbdecompiler_free_string(char* s);
 
+/**
+ * Create a new cancellation token
+ *
+ * @return Token handle, must be freed with vbdecompiler_cancel_token_free
+ */
+VBCancelToken* vbdecompiler_cancel_token_new(void);
+
+/**
+ * Request cancellation of decompilations using this token (thread-safe)
+ *
+ * @param token Cancellation token
+ */
+void vbdecompiler_cancel_token_cancel(const VBCancelToken* token);
+
+/**
+ * Free a cancellation token
+ *
+ * @param token Cancellation token to free
+ */
+void vbdecompiler_cancel_token_free(VBCancelToken* token);
+
 /**
  * Get last error message (returns NULL if no error)
  * 
@@ -87,12 +350,438 @@ void vbdecompiler_free_string(char* s);
  */
 const char* vbdecompiler_last_error(void);
 
+// ============================================================================
+// Lazy Project FFI
+// ============================================================================
+
+/**
+ * Opaque handle to a lazily decompiled project
+ */
+typedef struct VBProjectHandle VBProjectHandle;
+
+/**
+ * Open a file for lazy, per-method decompilation
+ *
+ * Only the PE and VB structures are parsed, so this returns in roughly
+ * PE-parse time regardless of the number of methods. The project uses the
+ * decompiler's cache directory as configured at the time of the call.
+ *
+ * @param handle Decompiler handle
+ * @param path Path to VB executable
+ * @param project Output project (must be freed with vbdecompiler_project_free)
+ * @return 0 on success, -1 invalid argument, -2 invalid UTF-8, -3 parse error
+ */
+int vbdecompiler_open_project(VBDecompilerHandle* handle,
+                              const char* path,
+                              VBProjectHandle** project);
+
+/**
+ * Free a project, invalidating all code returned for it
+ *
+ * @param project Project to free
+ */
+void vbdecompiler_project_free(VBProjectHandle* project);
+
+/**
+ * Get the project name
+ *
+ * @param project Project handle
+ * @return Name (must be freed with vbdecompiler_free_string), or NULL
+ */
+char* vbdecompiler_project_name(const VBProjectHandle* project);
+
+/**
+ * Get the number of objects
+ *
+ * @param project Project handle
+ * @return Object count
+ */
+size_t vbdecompiler_project_object_count(const VBProjectHandle* project);
+
+/**
+ * Get an object's name
+ *
+ * @param project Project handle
+ * @param object_index Object index
+ * @return Name (must be freed with vbdecompiler_free_string), or NULL
+ */
+char* vbdecompiler_project_object_name(const VBProjectHandle* project, size_t object_index);
+
+/**
+ * Get the number of methods of an object
+ *
+ * @param project Project handle
+ * @param object_index Object index
+ * @return Method count (0 for an invalid index)
+ */
+size_t vbdecompiler_project_method_count(const VBProjectHandle* project, size_t object_index);
+
+/**
+ * Get a method's name
+ *
+ * @param project Project handle
+ * @param object_index Object index
+ * @param method_index Method index within the object
+ * @return Name (must be freed with vbdecompiler_free_string), or NULL
+ */
+char* vbdecompiler_project_method_name(const VBProjectHandle* project,
+                                       size_t object_index,
+                                       size_t method_index);
+
+/**
+ * Decompile a single method, or return its memoized code
+ *
+ * The first call for a method runs the full pipeline; later calls return
+ * the same pointer. Safe to call from several threads at once.
+ *
+ * @param project Project handle
+ * @param object_index Object index
+ * @param method_index Method index within the object
+ * @param code Output UTF-8 code, NOT NUL-terminated, valid until the project is freed
+ * @param code_len Output code length in bytes
+ * @return 0 on success, -1 invalid argument, -3 if the method can't be decompiled
+ */
+int vbdecompiler_project_decompile_method(const VBProjectHandle* project,
+                                          size_t object_index,
+                                          size_t method_index,
+                                          const char** code,
+                                          size_t* code_len);
+
+/**
+ * Entropy of one PE section
+ */
+typedef struct {
+    char name[9];              // Section name, NUL-terminated
+    uint32_t virtual_address;
+    uint32_t raw_size;         // Size of the section's raw data in the file
+    double entropy;            // Shannon entropy (0-8), or -1.0 if there is no raw data
+    bool is_high;              // Above the packer detection threshold
+} VBSectionEntropy;
+
+/**
+ * Get the entropy of each section of the project's executable
+ *
+ * Sections already measured by packer detection are not measured again.
+ * Call with capacity 0 to query the section count.
+ *
+ * @param project Project handle
+ * @param sections Output array (may be NULL if capacity is 0)
+ * @param capacity Number of entries sections can hold
+ * @return Total number of sections (0 for an invalid handle)
+ */
+size_t vbdecompiler_project_section_entropy(const VBProjectHandle* project,
+                                            VBSectionEntropy* sections,
+                                            size_t capacity);
+
+// ============================================================================
+// Method Archive FFI
+// ============================================================================
+
+/*
+ * On-disk layout of a method archive (vbdc decompile --format binary)
+ *
+ * All integers are little-endian and every structure starts on an 8-byte
+ * boundary, so a mapped file can be read through these structs directly:
+ *
+ *   VBArchiveFileHeader
+ *   VBArchiveRecordHeader + strings, once per method, in completion order
+ *   VBArchiveIndexEntry[method_count], sorted by object then method index
+ *   project name, NUL-terminated, padded to 8 bytes
+ *   VBArchiveTrailer (last 32 bytes of the file)
+ *
+ * A record's strings follow its header in the order object name, method
+ * name, code, IR; each is NUL-terminated and its length excludes the NUL.
+ * Step from record to record by `length`, which may grow in later versions.
+ */
+
+#define VB_ARCHIVE_VERSION 1
+#define VB_ARCHIVE_HAS_IR 0x1           // VBArchiveFileHeader.flags
+#define VB_ARCHIVE_IS_PCODE 0x1         // VBArchiveTrailer.flags
+#define VB_RECORD_HAS_IR 0x1            // VBArchiveRecordHeader.flags
+#define VB_RECORD_HAS_PCODE_HASH 0x2    // VBArchiveRecordHeader.flags
+
+typedef struct {
+    char magic[8];              // "VBDCMETH"
+    uint32_t version;           // VB_ARCHIVE_VERSION
+    uint32_t flags;
+} VBArchiveFileHeader;
+
+typedef struct {
+    uint32_t length;            // Whole record including strings and padding
+    uint32_t object_index;
+    uint32_t method_index;
+    uint32_t object_name_len;
+    uint32_t method_name_len;
+    uint32_t code_len;
+    uint32_t ir_len;
+    uint32_t flags;
+    uint64_t pcode_hash;        // FNV-1a of the method's P-Code
+} VBArchiveRecordHeader;
+
+typedef struct {
+    uint64_t offset;            // File offset of the VBArchiveRecordHeader
+    uint32_t object_index;
+    uint32_t method_index;
+} VBArchiveIndexEntry;
+
+typedef struct {
+    uint64_t index_offset;      // File offset of the first VBArchiveIndexEntry
+    uint64_t method_count;
+    uint32_t project_name_len;
+    uint32_t flags;
+    char magic[8];              // "VBDCINDX"; absent if the writer did not finish
+} VBArchiveTrailer;
+
+/**
+ * Opaque handle to a memory-mapped method archive
+ */
+typedef struct VBArchiveHandle VBArchiveHandle;
+
+/**
+ * One method of an archive
+ *
+ * Strings point into the mapping, are UTF-8 and NUL-terminated, and stay
+ * valid until the archive is freed.
+ */
+typedef struct {
+    uint32_t object_index;
+    uint32_t method_index;
+    const char* object_name;
+    size_t object_name_len;
+    const char* method_name;
+    size_t method_name_len;
+    const char* code;
+    size_t code_len;
+    const char* ir;             // NULL if the record has no IR listing
+    size_t ir_len;
+    uint64_t pcode_hash;        // 0 if has_pcode_hash is false (native methods)
+    bool has_pcode_hash;
+} VBArchiveRecord;
+
+/**
+ * Map an archive for reading
+ *
+ * Only the header and trailer are read.
+ *
+ * @param path Path to the archive
+ * @param archive Output archive (must be freed with vbdecompiler_archive_free)
+ * @return 0 on success, -1 invalid argument, -2 invalid UTF-8, -3 unreadable or not an archive
+ */
+int vbdecompiler_archive_open(const char* path, VBArchiveHandle** archive);
+
+/**
+ * Unmap an archive, invalidating every record read from it
+ *
+ * @param archive Archive to free
+ */
+void vbdecompiler_archive_free(VBArchiveHandle* archive);
+
+/**
+ * Get the number of methods
+ *
+ * @param archive Archive handle
+ * @return Method count (0 for an invalid handle)
+ */
+size_t vbdecompiler_archive_count(const VBArchiveHandle* archive);
+
+/**
+ * Get the project name
+ *
+ * @param archive Archive handle
+ * @return NUL-terminated name borrowed from the mapping (do not free), or NULL
+ */
+const char* vbdecompiler_archive_project_name(const VBArchiveHandle* archive);
+
+/**
+ * Find a method by its indices
+ *
+ * Binary search over the index; no other record is read.
+ *
+ * @param archive Archive handle
+ * @param object_index Object index
+ * @param method_index Method index within the object
+ * @return Position for vbdecompiler_archive_record, or -1 if absent
+ */
+int64_t vbdecompiler_archive_find(const VBArchiveHandle* archive,
+                                  uint32_t object_index,
+                                  uint32_t method_index);
+
+/**
+ * Read one method
+ *
+ * @param archive Archive handle
+ * @param position Position in object/method index order (0 to count - 1)
+ * @param record Output record
+ * @return 0 on success, -1 invalid argument or position, -3 corrupt record
+ */
+int vbdecompiler_archive_record(const VBArchiveHandle* archive,
+                                size_t position,
+                                VBArchiveRecord* record);
+
+// ============================================================================
+// Symbol Index FFI
+// ============================================================================
+
+/*
+ * Symbol ids run from 0 to vbdecompiler_index_symbol_count - 1 in
+ * case-insensitive name order; string ids from 0 to
+ * vbdecompiler_index_string_count - 1 in byte order. Strings returned from
+ * an index are UTF-8, NOT NUL-terminated, and stay valid until it is freed.
+ *
+ * Functions returning id lists write up to capacity ids and return the total
+ * number, so a NULL buffer with capacity 0 sizes the buffer.
+ */
+
+/** Only ever called: a runtime function, API import or unresolved target */
+#define VB_SYMBOL_EXTERNAL 0
+/** A generated method (Object_Method) */
+#define VB_SYMBOL_METHOD 1
+/** An entry of the VB object table */
+#define VB_SYMBOL_OBJECT 2
+
+/**
+ * Free an index detached from its result
+ *
+ * @param index Index to free (set result->index to NULL before freeing the result)
+ */
+void vbdecompiler_index_free(VBIndexHandle* index);
+
+/**
+ * Get the number of symbols
+ *
+ * @param index Index handle
+ * @return Symbol count (0 for an invalid handle)
+ */
+size_t vbdecompiler_index_symbol_count(const VBIndexHandle* index);
+
+/**
+ * Get the name of a symbol
+ *
+ * @param index Index handle
+ * @param id Symbol id
+ * @param len Output name length in bytes (may be NULL)
+ * @return Name borrowed from the index (do not free), or NULL if absent
+ */
+const char* vbdecompiler_index_symbol(const VBIndexHandle* index, uint32_t id, size_t* len);
+
+/**
+ * Get the kind of a symbol
+ *
+ * @param index Index handle
+ * @param id Symbol id
+ * @return VB_SYMBOL_* value, or -1 if absent
+ */
+int vbdecompiler_index_symbol_kind(const VBIndexHandle* index, uint32_t id);
+
+/**
+ * Find a symbol by name, ignoring ASCII case
+ *
+ * @param index Index handle
+ * @param name Symbol name (UTF-8)
+ * @return Symbol id, or -1 if absent
+ */
+int64_t vbdecompiler_index_lookup(const VBIndexHandle* index, const char* name);
+
+/**
+ * Find the symbols starting with a prefix, ignoring ASCII case
+ *
+ * Matching ids are consecutive.
+ *
+ * @param index Index handle
+ * @param prefix Name prefix (UTF-8)
+ * @param first Output id of the first match (may be NULL)
+ * @return Number of matches
+ */
+size_t vbdecompiler_index_find_symbols(const VBIndexHandle* index,
+                                       const char* prefix,
+                                       uint32_t* first);
+
+/**
+ * List the symbols a method calls ("what does X call")
+ *
+ * @param index Index handle
+ * @param caller Symbol id of the method
+ * @param callees Output symbol ids in id order (may be NULL if capacity is 0)
+ * @param capacity Size of callees
+ * @return Total number of callees
+ */
+size_t vbdecompiler_index_callees(const VBIndexHandle* index,
+                                  uint32_t caller,
+                                  uint32_t* callees,
+                                  size_t capacity);
+
+/**
+ * List the methods calling a symbol ("who calls X")
+ *
+ * @param index Index handle
+ * @param callee Symbol id
+ * @param callers Output symbol ids in id order (may be NULL if capacity is 0)
+ * @param capacity Size of callers
+ * @return Total number of callers
+ */
+size_t vbdecompiler_index_callers(const VBIndexHandle* index,
+                                  uint32_t callee,
+                                  uint32_t* callers,
+                                  size_t capacity);
+
+/**
+ * Get the number of distinct string constants
+ *
+ * @param index Index handle
+ * @return String count (0 for an invalid handle)
+ */
+size_t vbdecompiler_index_string_count(const VBIndexHandle* index);
+
+/**
+ * Get a string constant
+ *
+ * @param index Index handle
+ * @param id String id
+ * @param len Output length in bytes (may be NULL)
+ * @return String borrowed from the index (do not free), or NULL if absent
+ */
+const char* vbdecompiler_index_string(const VBIndexHandle* index, uint32_t id, size_t* len);
+
+/**
+ * Find the string constants containing a substring
+ *
+ * @param index Index handle
+ * @param needle Substring (UTF-8)
+ * @param ignore_case Compare ASCII letters case-insensitively
+ * @param strings Output string ids in id order (may be NULL if capacity is 0)
+ * @param capacity Size of strings
+ * @return Total number of matches
+ */
+size_t vbdecompiler_index_find_strings(const VBIndexHandle* index,
+                                       const char* needle,
+                                       bool ignore_case,
+                                       uint32_t* strings,
+                                       size_t capacity);
+
+/**
+ * List the methods using a string constant
+ *
+ * @param index Index handle
+ * @param id String id
+ * @param methods Output symbol ids in id order (may be NULL if capacity is 0)
+ * @param capacity Size of methods
+ * @return Total number of methods
+ */
+size_t vbdecompiler_index_string_users(const VBIndexHandle* index,
+                                       uint32_t id,
+                                       uint32_t* methods,
+                                       size_t capacity);
+
 // ============================================================================
 // X86 Disassembler FFI
 // ============================================================================
 
 /**
  * Opaque handle to an X86Disassembler instance
+ *
+ * Every call on a handle reuses its decode and format buffers, so a handle
+ * must not be used from two threads at once. Create one handle per thread,
+ * or serialize the calls.
  */
 typedef struct X86DisassemblerHandle X86DisassemblerHandle;
 
@@ -157,6 +846,160 @@ int x86_disassemble(
  */
 void x86_disassembler_free_results(X86InstructionResult* results, size_t count);
 
+/**
+ * Compact x86 instruction record within an X86Listing
+ */
+typedef struct {
+    uint64_t address;       // Address of instruction
+    size_t code_offset;     // Offset of instruction bytes in the input code
+    size_t text_offset;     // Offset of NUL-terminated text in X86Listing::text
+    uint32_t length;        // Instruction length in bytes
+    uint32_t text_len;      // Text length in bytes, excluding the NUL
+} X86InstructionRecord;
+
+/**
+ * Batch disassembly result
+ *
+ * All instructions share one record array and one text buffer. Instruction
+ * bytes are not copied; read them from the input buffer at code_offset.
+ */
+typedef struct {
+    X86InstructionRecord* records;  // Instruction records
+    size_t count;                   // Number of records
+    char* text;                     // Text buffer shared by all records
+    size_t text_len;                // Size of the text buffer in bytes
+} X86Listing;
+
+/**
+ * Disassemble x86 code into a single arena
+ *
+ * Avoids the per-instruction allocations of x86_disassemble; prefer this for
+ * whole sections.
+ *
+ * @param handle Disassembler handle
+ * @param code Byte array to disassemble (must outlive use of code_offset)
+ * @param code_len Length of code array
+ * @param address Starting address (RVA or virtual address)
+ * @param listing Output listing (must be freed with x86_listing_free)
+ * @return Number of instructions on success, -1 on error
+ */
+int x86_disassemble_batch(
+    X86DisassemblerHandle* handle,
+    const uint8_t* code,
+    size_t code_len,
+    uint64_t address,
+    X86Listing** listing
+);
+
+/**
+ * Free a batch disassembly listing
+ *
+ * @param listing Listing to free
+ */
+void x86_listing_free(X86Listing* listing);
+
+/**
+ * Control flow of an X86DecodedInstruction
+ */
+typedef enum {
+    X86_FLOW_NEXT = 0,                // Continues with the next instruction
+    X86_FLOW_BRANCH = 1,              // Unconditional direct or indirect jump
+    X86_FLOW_CONDITIONAL_BRANCH = 2,
+    X86_FLOW_CALL = 3,
+    X86_FLOW_RETURN = 4,
+    X86_FLOW_OTHER = 5                // Interrupts, exceptions and the like
+} X86Flow;
+
+/**
+ * Kind of an X86Operand
+ */
+typedef enum {
+    X86_OPERAND_NONE = 0,             // Unused operand slot
+    X86_OPERAND_REGISTER = 1,
+    X86_OPERAND_IMMEDIATE = 2,
+    X86_OPERAND_MEMORY = 3,
+    X86_OPERAND_BRANCH = 4,           // Direct near branch target
+    X86_OPERAND_OTHER = 5             // Far branches, string instruction memory
+} X86OperandKind;
+
+#define X86_MAX_OPERANDS 4
+
+/**
+ * Operand of an X86DecodedInstruction
+ *
+ * Registers are iced-x86 Register values; 0 means none.
+ */
+typedef struct {
+    uint32_t kind;          // X86OperandKind
+    uint32_t reg;           // Register, or base register of a memory operand
+    uint32_t index;         // Index register of a memory operand
+    uint32_t scale;         // Index scale (1, 2, 4 or 8)
+    uint64_t value;         // Immediate, displacement or branch target
+} X86Operand;
+
+/**
+ * Decoded instruction without its text
+ */
+typedef struct {
+    uint64_t address;       // Address of instruction
+    uint64_t branch_target; // Target of a direct branch or call, or 0
+    size_t code_offset;     // Offset of instruction bytes in the input code
+    uint32_t length;        // Instruction length in bytes
+    uint32_t mnemonic;      // iced-x86 Mnemonic value
+    uint32_t flow;          // X86Flow
+    uint32_t operand_count; // Operand count; the first X86_MAX_OPERANDS are kept
+    X86Operand operands[X86_MAX_OPERANDS];
+} X86DecodedInstruction;
+
+/**
+ * Decode x86 code without formatting any text
+ *
+ * For analysis passes; format the lines that are displayed with x86_format.
+ * The records belong to the handle and are reused by its next call, so
+ * nothing needs to be freed. Like every call on a handle, not thread-safe;
+ * see X86DisassemblerHandle.
+ *
+ * @param handle Disassembler handle
+ * @param code Byte array to decode
+ * @param code_len Length of code array
+ * @param address Starting address (RVA or virtual address)
+ * @param records Output pointer to the records, valid until the next call on handle
+ * @param count Output pointer for number of records
+ * @return Number of instructions on success, -1 on error
+ */
+int x86_decode(
+    X86DisassemblerHandle* handle,
+    const uint8_t* code,
+    size_t code_len,
+    uint64_t address,
+    const X86DecodedInstruction** records,
+    size_t* count
+);
+
+/**
+ * Format one instruction
+ *
+ * Behaves like snprintf: at most buffer_len - 1 bytes and a NUL are written.
+ * Formats through the handle's buffer, so not thread-safe; see
+ * X86DisassemblerHandle.
+ *
+ * @param handle Disassembler handle
+ * @param code Instruction bytes (e.g. code + record.code_offset)
+ * @param code_len Bytes available at code
+ * @param address Address of the instruction
+ * @param buffer Output buffer (may be NULL if buffer_len is 0)
+ * @param buffer_len Size of buffer in bytes
+ * @return Full text length, or -1 if no instruction could be decoded
+ */
+int x86_format(
+    X86DisassemblerHandle* handle,
+    const uint8_t* code,
+    size_t code_len,
+    uint64_t address,
+    char* buffer,
+    size_t buffer_len
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,277 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "CodeView.h"
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <cstring>
+#include <limits>
+
+namespace {
+// Space between the viewport edge and the text, in pixels
+constexpr int Margin = 4;
+
+int clampToInt(qsizetype value)
+{
+    return static_cast<int>(qBound<qsizetype>(0, value, std::numeric_limits<int>::max()));
+}
+}
+
+CodeView::CodeView(QWidget* parent)
+    : QAbstractScrollArea(parent)
+    , lineStarts{0}
+    , longestLine(0)
+    , selectionAnchor(-1)
+    , selectionCursor(-1)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    updateScrollBars();
+}
+
+void CodeView::setText(const QByteArray& utf8)
+{
+    text = utf8;
+    lineStarts.assign(1, 0);
+    longestLine = 0;
+    selectionAnchor = selectionCursor = -1;
+    indexFrom(0);
+
+    updateScrollBars();
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    viewport()->update();
+}
+
+void CodeView::appendText(QByteArrayView utf8)
+{
+    if (utf8.isEmpty()) {
+        return;
+    }
+
+    // The unfinished last line simply continues, so only the new bytes are scanned
+    const qsizetype end = text.size();
+    text.append(utf8);
+    indexFrom(end);
+
+    updateScrollBars();
+    viewport()->update();
+}
+
+void CodeView::prependText(QByteArrayView utf8)
+{
+    if (utf8.isEmpty()) {
+        return;
+    }
+
+    const qsizetype before = lineCount();
+    text.prepend(utf8);
+    lineStarts.assign(1, 0);
+    longestLine = 0;
+    indexFrom(0);
+
+    const qsizetype added = lineCount() - before;
+    if (selectionAnchor >= 0) {
+        selectionAnchor += added;
+        selectionCursor += added;
+    }
+
+    // Stay at the top so the new text is seen; otherwise keep the same lines in view
+    const int top = verticalScrollBar()->value();
+    updateScrollBars();
+    if (top > 0) {
+        verticalScrollBar()->setValue(clampToInt(top + added));
+    }
+    viewport()->update();
+}
+
+void CodeView::clear()
+{
+    setText(QByteArray());
+}
+
+void CodeView::setPlaceholderText(const QString& newText)
+{
+    placeholder = newText;
+    if (text.isEmpty()) {
+        viewport()->update();
+    }
+}
+
+QString CodeView::selectedText() const
+{
+    if (selectionAnchor < 0) {
+        return QString::fromUtf8(text);
+    }
+
+    const qsizetype first = qMin(selectionAnchor, selectionCursor);
+    const qsizetype last = qMax(selectionAnchor, selectionCursor);
+    const qsizetype start = lineStarts[first];
+    const qsizetype end = last + 1 < lineCount() ? lineStarts[last + 1] : text.size();
+    return QString::fromUtf8(QByteArrayView(text.constData() + start, end - start));
+}
+
+void CodeView::paintEvent(QPaintEvent*)
+{
+    QPainter painter(viewport());
+
+    if (text.isEmpty()) {
+        painter.setPen(palette().placeholderText().color());
+        painter.drawText(viewport()->rect().adjusted(Margin, Margin, -Margin, -Margin),
+                         Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, placeholder);
+        return;
+    }
+
+    const int height = lineHeight();
+    const int ascent = fontMetrics().ascent();
+    const int x = Margin - horizontalScrollBar()->value();
+    const qsizetype first = verticalScrollBar()->value();
+    const qsizetype last = qMin(lineCount(), first + viewport()->height() / height + 2);
+    const qsizetype selectedFirst = qMin(selectionAnchor, selectionCursor);
+    const qsizetype selectedLast = qMax(selectionAnchor, selectionCursor);
+
+    // Only the visible lines are decoded and drawn
+    for (qsizetype i = first; i < last; ++i) {
+        const int y = static_cast<int>(i - first) * height;
+        const bool selected = selectionAnchor >= 0 && i >= selectedFirst && i <= selectedLast;
+        if (selected) {
+            painter.fillRect(0, y, viewport()->width(), height, palette().highlight());
+            painter.setPen(palette().highlightedText().color());
+        } else {
+            painter.setPen(palette().text().color());
+        }
+        painter.drawText(x, y + ascent, QString::fromUtf8(line(i)));
+    }
+}
+
+void CodeView::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void CodeView::changeEvent(QEvent* event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+void CodeView::keyPressEvent(QKeyEvent* event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        QGuiApplication::clipboard()->setText(selectedText());
+    } else if (event->matches(QKeySequence::SelectAll)) {
+        selectionAnchor = 0;
+        selectionCursor = lineCount() - 1;
+        viewport()->update();
+    } else if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMinimum);
+    } else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMaximum);
+    } else {
+        // Arrow and page keys scroll
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void CodeView::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+
+    const qsizetype clicked = lineAt(event->position().toPoint().y());
+    if (!(event->modifiers() & Qt::ShiftModifier) || selectionAnchor < 0) {
+        selectionAnchor = clicked;
+    }
+    selectionCursor = clicked;
+    viewport()->update();
+}
+
+void CodeView::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || selectionAnchor < 0) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+
+    // Dragging past the edges scrolls a line at a time
+    const int y = event->position().toPoint().y();
+    if (y < 0) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    } else if (y >= viewport()->height()) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    }
+    selectionCursor = lineAt(y);
+    viewport()->update();
+}
+
+qsizetype CodeView::lineCount() const
+{
+    return static_cast<qsizetype>(lineStarts.size());
+}
+
+QByteArrayView CodeView::line(qsizetype index) const
+{
+    const qsizetype start = lineStarts[index];
+    qsizetype end = index + 1 < lineCount() ? lineStarts[index + 1] - 1 : text.size();
+    if (end > start && text[end - 1] == '\r') {
+        --end;
+    }
+    return QByteArrayView(text.constData() + start, end - start);
+}
+
+qsizetype CodeView::lineAt(int y) const
+{
+    const int height = lineHeight();
+    // Round towards negative infinity so rows above the viewport count
+    const qsizetype row = (y < 0 ? y - height + 1 : y) / height;
+    return qBound<qsizetype>(0, verticalScrollBar()->value() + row, lineCount() - 1);
+}
+
+int CodeView::lineHeight() const
+{
+    return qMax(1, fontMetrics().lineSpacing());
+}
+
+void CodeView::indexFrom(qsizetype offset)
+{
+    const char* data = text.constData();
+    const qsizetype size = text.size();
+    qsizetype pos = offset;
+    while (pos < size) {
+        const void* hit = std::memchr(data + pos, '\n', static_cast<std::size_t>(size - pos));
+        if (!hit) {
+            break;
+        }
+        const qsizetype newline = static_cast<const char*>(hit) - data;
+        longestLine = qMax(longestLine, newline - lineStarts.back());
+        lineStarts.push_back(newline + 1);
+        pos = newline + 1;
+    }
+    longestLine = qMax(longestLine, size - lineStarts.back());
+}
+
+void CodeView::updateScrollBars()
+{
+    const int visibleLines = qMax(1, viewport()->height() / lineHeight());
+    verticalScrollBar()->setRange(0, clampToInt(lineCount() - visibleLines));
+    verticalScrollBar()->setPageStep(visibleLines);
+    verticalScrollBar()->setSingleStep(1);
+
+    // Monospace text: the longest line in bytes bounds its width in columns
+    const int charWidth = fontMetrics().horizontalAdvance(QLatin1Char('M'));
+    const qsizetype contentWidth = longestLine * charWidth + 2 * Margin;
+    horizontalScrollBar()->setRange(0, clampToInt(contentWidth - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(charWidth);
+}
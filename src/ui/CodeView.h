@@ -0,0 +1,76 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef CODEVIEW_H
+#define CODEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <vector>
+
+/**
+ * Read-only plain-text viewer that lays out only the visible lines
+ *
+ * Text is kept as UTF-8 with an index of line starts, so showing, appending
+ * and scrolling cost the same for a ten-line method as for a multi-megabyte
+ * listing. Selection is by whole lines; Ctrl+C copies it and Ctrl+A selects
+ * everything.
+ */
+class CodeView : public QAbstractScrollArea
+{
+    Q_OBJECT
+    Q_PROPERTY(QString placeholderText READ placeholderText WRITE setPlaceholderText)
+
+public:
+    explicit CodeView(QWidget* parent = nullptr);
+
+    /**
+     * Show utf8, scrolled to the top
+     *
+     * The bytes are not copied if utf8 was made with QByteArray::fromRawData;
+     * they must then stay valid until the next setText() or clear().
+     */
+    void setText(const QByteArray& utf8);
+    /** Append utf8 without moving the scroll position */
+    void appendText(QByteArrayView utf8);
+    /** Insert utf8 at the start; keeps the same lines in view unless at the top */
+    void prependText(QByteArrayView utf8);
+    void clear();
+
+    QString placeholderText() const { return placeholder; }
+    void setPlaceholderText(const QString& text);
+
+    /** Text of the selected lines, or of everything if nothing is selected */
+    QString selectedText() const;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void changeEvent(QEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+
+private:
+    QByteArray text;
+    // Byte offset of the start of every line; never empty
+    std::vector<qsizetype> lineStarts;
+    // Length in bytes of the longest line, for the horizontal scroll range
+    qsizetype longestLine;
+    QString placeholder;
+    // Selected lines [anchor, cursor] in either order; -1 if none
+    qsizetype selectionAnchor;
+    qsizetype selectionCursor;
+
+    qsizetype lineCount() const;
+    QByteArrayView line(qsizetype index) const;
+    qsizetype lineAt(int y) const;
+    int lineHeight() const;
+    void indexFrom(qsizetype offset);
+    void updateScrollBars();
+};
+
+#endif // CODEVIEW_H
@@ -0,0 +1,118 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "DecompileWorker.h"
+#include "../../include/vbdecompiler_ffi.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <utility>
+
+namespace {
+// Minimum interval between codeChunk() signals, to keep the GUI event queue short
+constexpr qint64 FlushIntervalMs = 50;
+}
+
+DecompileWorker::DecompileWorker(VBDecompilerHandle* decompiler,
+                                 const VBCancelToken* cancelToken,
+                                 const QString& filePath)
+    : decompiler(decompiler)
+    , cancelToken(cancelToken)
+    , filePath(filePath)
+{
+}
+
+void DecompileWorker::run()
+{
+    VBDecompilationResult* result = nullptr;
+    flushTimer.start();
+
+    // Hand the core a read-only mapping so the file is never copied; fall back
+    // to letting the core open the path if the file can't be mapped
+    QFile file(filePath);
+    uchar* image = nullptr;
+    if (file.open(QIODevice::ReadOnly) && file.size() > 0) {
+        image = file.map(0, file.size());
+    }
+
+    int status = 0;
+    if (image) {
+        status = vbdecompiler_decompile_buffer_streaming(
+            decompiler, image, static_cast<size_t>(file.size()), &DecompileWorker::onMethod,
+            &DecompileWorker::onProgress, this, cancelToken, &result);
+        file.unmap(image);
+    } else {
+        const std::string path = filePath.toStdString();
+        status = vbdecompiler_decompile_file_streaming(
+            decompiler, path.c_str(), &DecompileWorker::onMethod, &DecompileWorker::onProgress,
+            this, cancelToken, &result);
+    }
+
+    // Deliver whatever is still buffered before reporting completion
+    flushPending();
+
+    if (status != 0 || !result) {
+        emit finished(status, QString(), QString());
+        return;
+    }
+
+    // The header goes above the streamed methods once the totals are known
+    const QString header = QStringLiteral("' VBDecompiler - Decompiled from: %1\n"
+                                          "' Project: %2\n"
+                                          "' P-Code: %3\n"
+                                          "' Objects: %4\n"
+                                          "' Methods: %5\n"
+                                          "'\n\n")
+                         .arg(filePath)
+                         .arg(QString::fromUtf8(result->project_name))
+                         .arg(result->is_pcode ? QStringLiteral("Yes") : QStringLiteral("No"))
+                         .arg(result->object_count)
+                         .arg(result->method_count);
+
+    const QString summary = tr("%1 objects, %2 methods")
+                                .arg(result->object_count)
+                                .arg(result->method_count);
+
+    vbdecompiler_free_result(result);
+    emit finished(status, header, summary);
+}
+
+void DecompileWorker::flushPending()
+{
+    QByteArray code;
+    {
+        QMutexLocker lock(&pendingMutex);
+        code = std::exchange(pendingCode, QByteArray());
+        flushTimer.restart();
+    }
+    if (!code.isEmpty()) {
+        emit codeChunk(code);
+    }
+}
+
+void DecompileWorker::onProgress(void* userData, std::size_t completed, std::size_t total)
+{
+    // Called from Rayon worker threads; only emit when the percentage changes
+    auto* worker = static_cast<DecompileWorker*>(userData);
+    const int percent = total == 0 ? 100 : static_cast<int>(completed * 100 / total);
+    if (worker->lastPercent.exchange(percent) != percent) {
+        emit worker->progressChanged(static_cast<int>(completed), static_cast<int>(total));
+    }
+}
+
+void DecompileWorker::onMethod(void* userData, const VBMethodChunk* chunk)
+{
+    // Called from Rayon worker threads (serialized by the FFI); batch methods
+    // so the GUI appends a block of text at most every FlushIntervalMs
+    auto* worker = static_cast<DecompileWorker*>(userData);
+    bool flush = false;
+    {
+        QMutexLocker lock(&worker->pendingMutex);
+        worker->pendingCode.append(chunk->code, static_cast<qsizetype>(chunk->code_len));
+        worker->pendingCode.append("\n\n");
+        flush = worker->flushTimer.elapsed() >= FlushIntervalMs;
+    }
+    if (flush) {
+        worker->flushPending();
+    }
+}
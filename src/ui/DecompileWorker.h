@@ -0,0 +1,62 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DECOMPILEWORKER_H
+#define DECOMPILEWORKER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstddef>
+
+// Forward declare C FFI types
+struct VBDecompilerHandle;
+struct VBCancelToken;
+struct VBMethodChunk;
+
+/**
+ * Runs a decompilation on a background thread
+ *
+ * Move to a QThread and invoke run(); progress and completion are reported
+ * through queued signals so the GUI thread never blocks on the Rust core.
+ * Methods are streamed in batches of UTF-8 via codeChunk() as they are
+ * decompiled.
+ */
+class DecompileWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    DecompileWorker(VBDecompilerHandle* decompiler,
+                    const VBCancelToken* cancelToken,
+                    const QString& filePath);
+
+public slots:
+    void run();
+
+signals:
+    void progressChanged(int completed, int total);
+    void codeChunk(const QByteArray& code);
+    void finished(int status, const QString& header, const QString& summary);
+
+private:
+    VBDecompilerHandle* decompiler;
+    const VBCancelToken* cancelToken;
+    QString filePath;
+    std::atomic<int> lastPercent{-1};
+
+    QMutex pendingMutex;
+    QByteArray pendingCode;
+    QElapsedTimer flushTimer;
+
+    void flushPending();
+
+    static void onProgress(void* userData, std::size_t completed, std::size_t total);
+    static void onMethod(void* userData, const VBMethodChunk* chunk);
+};
+
+#endif // DECOMPILEWORKER_H
@@ -4,21 +4,51 @@
 
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
+#include "DecompileWorker.h"
+#include "ProjectModel.h"
 #include "../../include/vbdecompiler_ffi.h"
 #include <QFileDialog>
+#include <QItemSelectionModel>
 #include <QMessageBox>
-#include <sstream>
+#include <QDir>
+#include <QProgressBar>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , decompiler(nullptr)
+    , cancelToken(nullptr)
+    , project(nullptr)
+    , projectModel(new ProjectModel(this))
+    , progressBar(new QProgressBar(this))
 {
     ui->setupUi(this);
+    ui->projectTree->setModel(projectModel);
     setupConnections();
     
-    // Initialize Rust decompiler
-    decompiler = vbdecompiler_new();
+    // Initialize Rust decompiler on its own pool, leaving a core for the UI
+    VBDecompilerConfig config;
+    vbdecompiler_config_default(&config);
+    config.threads = static_cast<size_t>(qMax(1, QThread::idealThreadCount() - 1));
+    decompiler = vbdecompiler_new_with_config(&config);
+    if (!decompiler) {
+        decompiler = vbdecompiler_new();
+    }
+
+    // Caching writes decompiled code to disk, so it is opt-in; checking the
+    // action turns it on through onCacheToggled
+    QSettings settings;
+    ui->actionCacheResults->setChecked(
+        settings.value(QStringLiteral("decompiler/cacheResults"), false).toBool());
+
+    progressBar->setMaximumWidth(240);
+    progressBar->setTextVisible(true);
+    progressBar->hide();
+    statusBar()->addPermanentWidget(progressBar);
+    ui->splitter->setSizes({280, 1000});
     
     setWindowTitle("VBDecompiler - Visual Basic 5/6 Decompiler");
     resize(1280, 800);
@@ -26,6 +56,8 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    stopWorker();
+    closeProject();
     if (decompiler) {
         vbdecompiler_free(decompiler);
     }
@@ -35,6 +67,11 @@ MainWindow::~MainWindow()
 void MainWindow::setupConnections()
 {
     connect(ui->actionOpen, &QAction::triggered, this, &MainWindow::onOpenFile);
+    connect(ui->actionDecompileAll, &QAction::triggered, this, &MainWindow::onDecompileAll);
+    connect(ui->actionCancel, &QAction::triggered, this, &MainWindow::onCancelDecompile);
+    connect(ui->projectTree->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &MainWindow::onTreeItemChanged);
+    connect(ui->actionCacheResults, &QAction::toggled, this, &MainWindow::onCacheToggled);
     connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::onAbout);
 }
 
@@ -52,6 +89,37 @@ void MainWindow::onOpenFile()
     }
 }
 
+void MainWindow::onCancelDecompile()
+{
+    if (cancelToken) {
+        vbdecompiler_cancel_token_cancel(cancelToken);
+        ui->actionCancel->setEnabled(false);
+        statusBar()->showMessage(tr("Cancelling..."));
+    }
+}
+
+void MainWindow::onCacheToggled(bool enabled)
+{
+    QSettings().setValue(QStringLiteral("decompiler/cacheResults"), enabled);
+    applyCacheSetting(enabled);
+}
+
+void MainWindow::applyCacheSetting(bool enabled)
+{
+    if (!decompiler) {
+        return;
+    }
+
+    // Re-opened files are served from the cache while it is enabled
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (enabled && !cacheDir.isEmpty()) {
+        const QByteArray dir = QDir(cacheDir).filePath(QStringLiteral("decompiled")).toUtf8();
+        vbdecompiler_set_cache_dir(decompiler, dir.constData());
+    } else {
+        vbdecompiler_set_cache_dir(decompiler, nullptr);
+    }
+}
+
 void MainWindow::onAbout()
 {
     QMessageBox::about(
@@ -73,9 +141,12 @@ void MainWindow::onAbout()
 
 void MainWindow::loadFile(const QString& filePath)
 {
-    ui->codeEditor->clear();
-    statusBar()->showMessage(tr("Loading: %1").arg(filePath));
-    
+    if (cancelToken) {
+        // The decompiler handle is not shareable between concurrent runs
+        statusBar()->showMessage(tr("A decompilation is already running"), 5000);
+        return;
+    }
+
     if (!decompiler) {
         QMessageBox::critical(
             this,
@@ -84,70 +155,200 @@ void MainWindow::loadFile(const QString& filePath)
         );
         return;
     }
-    
-    // Call Rust decompiler via FFI
-    VBDecompilationResult* result = nullptr;
-    std::string path = filePath.toStdString();
-    int status = vbdecompiler_decompile_file(decompiler, path.c_str(), &result);
-    
+
+    closeProject();
+    currentFile = filePath;
+    statusBar()->showMessage(tr("Loading: %1").arg(filePath));
+
+    // Only the PE and VB structures are parsed here; methods are decompiled
+    // when selected, so this is fast enough for the GUI thread
+    const std::string path = filePath.toStdString();
+    const int status = vbdecompiler_open_project(decompiler, path.c_str(), &project);
     if (status != 0) {
-        // Error occurred
-        QString errorMsg;
-        switch (status) {
-            case -1:
-                errorMsg = tr("Invalid argument");
-                break;
-            case -2:
-                errorMsg = tr("Invalid UTF-8 in path");
-                break;
-            case -3:
-                errorMsg = tr("Decompilation failed. This might be due to:\n"
-                             "  - Unsupported VB version\n"
-                             "  - Corrupted or packed executable\n"
-                             "  - Native code (not P-Code)\n"
-                             "  - Invalid VB5/6 executable");
-                break;
-            default:
-                errorMsg = tr("Unknown error (code: %1)").arg(status);
-                break;
-        }
-        
+        project = nullptr;
         QMessageBox::critical(
             this,
             tr("Decompilation Error"),
-            errorMsg
+            errorMessage(status)
         );
-        statusBar()->showMessage(tr("Decompilation failed"), 5000);
+        statusBar()->showMessage(tr("Failed to open %1").arg(filePath), 5000);
         return;
     }
-    
-    // Success - display results
-    if (result) {
-        std::ostringstream output;
-        
-        // Header
-        output << "' VBDecompiler - Decompiled from: " << path << "\n";
-        output << "' Project: " << result->project_name << "\n";
-        output << "' P-Code: " << (result->is_pcode ? "Yes" : "No") << "\n";
-        output << "' Objects: " << result->object_count << "\n";
-        output << "' Methods: " << result->method_count << "\n";
-        output << "'\n\n";
-        
-        // Generated VB6 code
-        output << result->vb6_code;
-        
-        // Display in editor
-        ui->codeEditor->setPlainText(QString::fromStdString(output.str()));
-        
-        statusBar()->showMessage(
-            tr("Successfully decompiled %1 (%2 objects, %3 methods)")
-                .arg(filePath)
-                .arg(result->object_count)
-                .arg(result->method_count),
-            10000
+
+    populateTree();
+    ui->actionDecompileAll->setEnabled(true);
+    ui->codeView->setPlaceholderText(tr("Select a method to decompile it, or use Decompile All (Ctrl+D)"));
+    statusBar()->showMessage(tr("Opened %1").arg(filePath), 10000);
+}
+
+void MainWindow::populateTree()
+{
+    // Names are fetched as rows scroll into view, whatever the project size
+    projectModel->setProject(project);
+    ui->projectTree->expand(projectModel->index(0, 0));
+}
+
+void MainWindow::closeProject()
+{
+    // The view may borrow code owned by the project, so drop it first
+    ui->codeView->clear();
+    projectModel->setProject(nullptr);
+    ui->actionDecompileAll->setEnabled(false);
+    if (project) {
+        vbdecompiler_project_free(project);
+        project = nullptr;
+    }
+}
+
+void MainWindow::onTreeItemChanged(const QModelIndex& current)
+{
+    std::size_t obj = 0;
+    std::size_t method = 0;
+    if (!project || !projectModel->methodAt(current, &obj, &method)) {
+        return;
+    }
+
+    const QString name = QStringLiteral("%1.%2").arg(current.parent().data().toString(),
+                                                      current.data().toString());
+
+    // Decompiled on first selection, then served from the project's memo; the
+    // view shows the project's copy in place until the project is closed
+    const char* code = nullptr;
+    size_t codeLen = 0;
+    if (vbdecompiler_project_decompile_method(project, obj, method, &code, &codeLen) != 0) {
+        ui->codeView->setText(tr("' %1: could not be decompiled").arg(name).toUtf8());
+        return;
+    }
+
+    ui->codeView->setText(QByteArray::fromRawData(code, static_cast<qsizetype>(codeLen)));
+    statusBar()->showMessage(tr("Decompiled %1").arg(name), 5000);
+}
+
+void MainWindow::onDecompileAll()
+{
+    if (cancelToken || currentFile.isEmpty()) {
+        return;
+    }
+
+    ui->projectTree->setCurrentIndex(QModelIndex());
+    ui->codeView->clear();
+    statusBar()->showMessage(tr("Decompiling: %1").arg(currentFile));
+
+    if (workerThread) {
+        // The previous run has already finished; let its thread wind down
+        workerThread->wait();
+    }
+
+    cancelToken = vbdecompiler_cancel_token_new();
+
+    // Run the Rust decompiler off the GUI thread
+    auto* thread = new QThread(this);
+    auto* worker = new DecompileWorker(decompiler, cancelToken, currentFile);
+    worker->moveToThread(thread);
+
+    connect(thread, &QThread::started, worker, &DecompileWorker::run);
+    connect(worker, &DecompileWorker::progressChanged, this, &MainWindow::onDecompileProgress);
+    connect(worker, &DecompileWorker::codeChunk, this, &MainWindow::onDecompileChunk);
+    connect(worker, &DecompileWorker::finished, this, &MainWindow::onDecompileFinished);
+    // Direct connection: quit() is thread-safe and must not wait on the GUI event loop
+    connect(worker, &DecompileWorker::finished, thread, &QThread::quit, Qt::DirectConnection);
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+    workerThread = thread;
+    setDecompiling(true);
+    thread->start();
+}
+
+void MainWindow::onDecompileProgress(int completed, int total)
+{
+    progressBar->setRange(0, total);
+    progressBar->setValue(completed);
+}
+
+void MainWindow::onDecompileChunk(const QByteArray& code)
+{
+    // Append at the end without disturbing the user's scroll position
+    ui->codeView->appendText(code);
+}
+
+void MainWindow::onDecompileFinished(int status, const QString& header, const QString& summary)
+{
+    setDecompiling(false);
+    if (cancelToken) {
+        vbdecompiler_cancel_token_free(cancelToken);
+        cancelToken = nullptr;
+    }
+
+    if (status == -4) {
+        statusBar()->showMessage(tr("Decompilation cancelled"), 5000);
+        return;
+    }
+
+    if (status != 0) {
+        ui->codeView->clear();
+        QMessageBox::critical(
+            this,
+            tr("Decompilation Error"),
+            errorMessage(status)
         );
-        
-        // Free the result
-        vbdecompiler_free_result(result);
+        statusBar()->showMessage(tr("Decompilation failed"), 5000);
+        return;
+    }
+
+    // Success - methods are already shown, prepend the summary header
+    ui->codeView->prependText(header.toUtf8());
+    statusBar()->showMessage(
+        tr("Successfully decompiled %1 (%2)").arg(currentFile, summary),
+        10000
+    );
+}
+
+void MainWindow::setDecompiling(bool running)
+{
+    ui->actionOpen->setEnabled(!running);
+    ui->actionDecompileAll->setEnabled(!running && project);
+    ui->actionCancel->setEnabled(running);
+    // The cache setting replaces the cache the worker is using
+    ui->actionCacheResults->setEnabled(!running);
+    ui->projectTree->setEnabled(!running);
+    progressBar->setRange(0, 0);
+    progressBar->setVisible(running);
+}
+
+void MainWindow::stopWorker()
+{
+    if (!workerThread) {
+        return;
+    }
+
+    // Let the running decompilation skip its remaining methods, then wait for it
+    if (cancelToken) {
+        vbdecompiler_cancel_token_cancel(cancelToken);
+    }
+    workerThread->quit();
+    workerThread->wait();
+
+    if (cancelToken) {
+        vbdecompiler_cancel_token_free(cancelToken);
+        cancelToken = nullptr;
+    }
+}
+
+QString MainWindow::errorMessage(int status) const
+{
+    switch (status) {
+        case -1:
+            return tr("Invalid argument");
+        case -2:
+            return tr("Invalid UTF-8 in path");
+        case -3:
+            return tr("Decompilation failed. This might be due to:\n"
+                      "  - Unsupported VB version\n"
+                      "  - Corrupted or packed executable\n"
+                      "  - Native code (not P-Code)\n"
+                      "  - Invalid VB5/6 executable");
+        default:
+            return tr("Unknown error (code: %1)").arg(status);
     }
 }
@@ -6,9 +6,17 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QPointer>
 
-// Forward declare C FFI type
+// Forward declare C FFI types
 struct VBDecompilerHandle;
+struct VBCancelToken;
+struct VBProjectHandle;
+
+class ProjectModel;
+class QModelIndex;
+class QProgressBar;
+class QThread;
 
 namespace Ui {
 class MainWindow;
@@ -24,14 +32,33 @@ public:
 
 private slots:
     void onOpenFile();
+    void onDecompileAll();
+    void onCancelDecompile();
     void onAbout();
+    void onCacheToggled(bool enabled);
+    void onTreeItemChanged(const QModelIndex& current);
+    void onDecompileProgress(int completed, int total);
+    void onDecompileChunk(const QByteArray& code);
+    void onDecompileFinished(int status, const QString& header, const QString& summary);
 
 private:
     Ui::MainWindow *ui;
     VBDecompilerHandle* decompiler;
+    VBCancelToken* cancelToken;
+    VBProjectHandle* project;
+    ProjectModel* projectModel;
+    QPointer<QThread> workerThread;
+    QProgressBar* progressBar;
+    QString currentFile;
     
     void setupConnections();
     void loadFile(const QString& filePath);
+    void populateTree();
+    void closeProject();
+    void setDecompiling(bool running);
+    void applyCacheSetting(bool enabled);
+    void stopWorker();
+    QString errorMessage(int status) const;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,189 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "ProjectModel.h"
+#include "../../include/vbdecompiler_ffi.h"
+
+namespace {
+// An index's internal id names its parent: the project item has none, object
+// and section rows hang off the project item, methods off object k
+constexpr quintptr TopLevel = 0;
+constexpr quintptr UnderProject = 1;
+constexpr quintptr UnderSections = 2;
+constexpr quintptr UnderObject = 3;
+
+// Take ownership of a string returned by the FFI
+QString takeString(char* s)
+{
+    const QString result = QString::fromUtf8(s);
+    vbdecompiler_free_string(s);
+    return result;
+}
+}
+
+ProjectModel::ProjectModel(QObject* parent)
+    : QAbstractItemModel(parent)
+    , project(nullptr)
+{
+}
+
+void ProjectModel::setProject(VBProjectHandle* newProject)
+{
+    beginResetModel();
+    project = newProject;
+    projectName.clear();
+    objects.clear();
+    sections.clear();
+    if (project) {
+        projectName = takeString(vbdecompiler_project_name(project));
+        objects.resize(vbdecompiler_project_object_count(project));
+        loadSections();
+    }
+    endResetModel();
+}
+
+void ProjectModel::loadSections()
+{
+    // Entropy measured during packer detection, so this costs no second pass
+    std::vector<VBSectionEntropy> entropy(vbdecompiler_project_section_entropy(project, nullptr, 0));
+    vbdecompiler_project_section_entropy(project, entropy.data(), entropy.size());
+
+    sections.reserve(entropy.size());
+    for (const auto& section : entropy) {
+        const QString name = QString::fromLatin1(section.name);
+        if (section.entropy < 0.0) {
+            sections.push_back({tr("%1 (no raw data)").arg(name)});
+            continue;
+        }
+        sections.push_back({tr("%1  entropy %2%3")
+            .arg(name)
+            .arg(section.entropy, 0, 'f', 2)
+            .arg(section.is_high ? tr(" (high)") : QString())});
+    }
+}
+
+bool ProjectModel::methodAt(const QModelIndex& index, std::size_t* object, std::size_t* method) const
+{
+    if (!index.isValid() || index.internalId() < UnderObject) {
+        return false;
+    }
+    *object = static_cast<std::size_t>(index.internalId() - UnderObject);
+    *method = static_cast<std::size_t>(index.row());
+    return true;
+}
+
+QModelIndex ProjectModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    if (!parent.isValid()) {
+        return createIndex(row, column, TopLevel);
+    }
+
+    switch (parent.internalId()) {
+        case TopLevel:
+            return createIndex(row, column, UnderProject);
+        case UnderProject:
+            if (static_cast<std::size_t>(parent.row()) < objects.size()) {
+                return createIndex(row, column, UnderObject + static_cast<quintptr>(parent.row()));
+            }
+            return createIndex(row, column, UnderSections);
+        default:
+            return QModelIndex();
+    }
+}
+
+QModelIndex ProjectModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+
+    switch (child.internalId()) {
+        case TopLevel:
+            return QModelIndex();
+        case UnderProject:
+            return createIndex(0, 0, TopLevel);
+        case UnderSections:
+            return createIndex(static_cast<int>(objects.size()), 0, UnderProject);
+        default:
+            return createIndex(static_cast<int>(child.internalId() - UnderObject), 0, UnderProject);
+    }
+}
+
+int ProjectModel::rowCount(const QModelIndex& parent) const
+{
+    if (!project || parent.column() > 0) {
+        return 0;
+    }
+    if (!parent.isValid()) {
+        return 1;
+    }
+
+    switch (parent.internalId()) {
+        case TopLevel:
+            return static_cast<int>(objects.size() + (sections.empty() ? 0 : 1));
+        case UnderProject:
+            if (static_cast<std::size_t>(parent.row()) < objects.size()) {
+                return methodCount(static_cast<std::size_t>(parent.row()));
+            }
+            return static_cast<int>(sections.size());
+        default:
+            return 0;
+    }
+}
+
+int ProjectModel::columnCount(const QModelIndex&) const
+{
+    return 1;
+}
+
+QVariant ProjectModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    const auto row = static_cast<std::size_t>(index.row());
+    switch (index.internalId()) {
+        case TopLevel:
+            return projectName;
+        case UnderProject:
+            return row < objects.size() ? objectName(row) : tr("Sections");
+        case UnderSections:
+            return sections[row].label;
+        default:
+            return methodName(static_cast<std::size_t>(index.internalId() - UnderObject), row);
+    }
+}
+
+int ProjectModel::methodCount(std::size_t object) const
+{
+    ObjectNode& node = objects[object];
+    if (node.methodCount < 0) {
+        node.methodCount = static_cast<int>(vbdecompiler_project_method_count(project, object));
+        node.methodNames.resize(static_cast<std::size_t>(node.methodCount));
+    }
+    return node.methodCount;
+}
+
+QString ProjectModel::objectName(std::size_t object) const
+{
+    ObjectNode& node = objects[object];
+    if (node.name.isNull()) {
+        node.name = takeString(vbdecompiler_project_object_name(project, object));
+    }
+    return node.name;
+}
+
+QString ProjectModel::methodName(std::size_t object, std::size_t method) const
+{
+    methodCount(object);
+    QString& name = objects[object].methodNames[method];
+    if (name.isNull()) {
+        name = takeString(vbdecompiler_project_method_name(project, object, method));
+    }
+    return name;
+}
@@ -0,0 +1,65 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PROJECTMODEL_H
+#define PROJECTMODEL_H
+
+#include <QAbstractItemModel>
+#include <QString>
+#include <cstddef>
+#include <vector>
+
+// Forward declare C FFI types
+struct VBProjectHandle;
+
+/**
+ * Tree model of a lazily decompiled project: objects, their methods and the
+ * PE sections
+ *
+ * Names and method counts are read from the core the first time a view asks
+ * for them, so opening a project with thousands of objects costs only the
+ * rows that are actually shown. The model does not own the project handle.
+ */
+class ProjectModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectModel(QObject* parent = nullptr);
+
+    /** Show project (may be nullptr); it must outlive its use by the model */
+    void setProject(VBProjectHandle* project);
+
+    /** Indices of the method at index; false for any other row */
+    bool methodAt(const QModelIndex& index, std::size_t* object, std::size_t* method) const;
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct ObjectNode {
+        QString name;         // Null until first shown
+        int methodCount = -1; // -1 until first asked for
+        std::vector<QString> methodNames;
+    };
+
+    struct SectionNode {
+        QString label;
+    };
+
+    VBProjectHandle* project;
+    QString projectName;
+    mutable std::vector<ObjectNode> objects;
+    std::vector<SectionNode> sections;
+
+    int methodCount(std::size_t object) const;
+    QString objectName(std::size_t object) const;
+    QString methodName(std::size_t object, std::size_t method) const;
+    void loadSections();
+};
+
+#endif // PROJECTMODEL_H
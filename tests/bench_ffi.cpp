@@ -0,0 +1,121 @@
+// VBDecompiler - Visual Basic Decompiler
+// Copyright (c) 2026 VBDecompiler Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * Decompilation benchmark from the C++ side of the FFI
+ *
+ * Times the calls the GUI makes over the synthetic corpus and prints one JSON
+ * record per (bench, input), in the same shape as the cargo benches.
+ *
+ * Usage: bench_ffi [CORPUS_DIR]
+ */
+
+#include "vbdecompiler_ffi.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::array<std::string_view, 3> CorpusFiles = {"synthetic-small", "synthetic-medium", "synthetic-large"};
+constexpr int Samples = 7;
+
+std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// Run body Samples times and print min/median/mean as a JSON record
+template <typename F>
+void bench(const char* name, const std::string& input, size_t bytes, F&& body) {
+    std::vector<int64_t> samples;
+    samples.reserve(Samples);
+    for (int i = 0; i < Samples; ++i) {
+        const auto start = Clock::now();
+        body();
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+
+    std::ranges::sort(samples);
+    int64_t total = 0;
+    for (auto sample : samples) {
+        total += sample;
+    }
+    const int64_t median = samples[samples.size() / 2];
+    const double mibPerSec = median > 0 ? (bytes / (1024.0 * 1024.0)) / (median / 1e9) : 0.0;
+
+    std::println(
+        R"({{"bench":"{}","bytes":{},"input":"{}","iterations":1,"mean_ns":{},"median_ns":{},"mib_per_s":{:.1f},"min_ns":{}}})",
+        name, bytes, input, total / Samples, median, mibPerSec, samples.front());
+}
+
+bool benchFile(VBDecompilerHandle* handle, const std::filesystem::path& path, const std::string& input) {
+    const auto data = readFile(path);
+    if (data.empty()) {
+        std::println(stderr, "{}: missing or empty (regenerate with `cargo run --example gen-bench-corpus`)",
+                     path.string());
+        return false;
+    }
+
+    bool ok = true;
+    bench("cpp_decompile_buffer", input, data.size(), [&] {
+        VBDecompilationResult* result = nullptr;
+        if (vbdecompiler_decompile_buffer(handle, data.data(), data.size(), &result) != 0) {
+            ok = false;
+            return;
+        }
+        vbdecompiler_free_result(result);
+    });
+
+    // What the tree view does: open once, then decompile each method on demand
+    const std::string pathString = path.string();
+    bench("cpp_project_methods", input, data.size(), [&] {
+        VBProjectHandle* project = nullptr;
+        if (vbdecompiler_open_project(handle, pathString.c_str(), &project) != 0) {
+            ok = false;
+            return;
+        }
+        const size_t objects = vbdecompiler_project_object_count(project);
+        for (size_t obj = 0; obj < objects; ++obj) {
+            const size_t methods = vbdecompiler_project_method_count(project, obj);
+            for (size_t method = 0; method < methods; ++method) {
+                const char* code = nullptr;
+                size_t codeLen = 0;
+                vbdecompiler_project_decompile_method(project, obj, method, &code, &codeLen);
+            }
+        }
+        vbdecompiler_project_free(project);
+    });
+
+    if (!ok) {
+        std::println(stderr, "{}: decompilation failed", path.string());
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::filesystem::path corpusDir = argc > 1 ? argv[1] : VBDC_BENCH_CORPUS_DIR;
+
+    VBDecompilerHandle* handle = vbdecompiler_new();
+    bool ok = true;
+    for (const std::string_view name : CorpusFiles) {
+        const std::string input(name);
+        ok = benchFile(handle, corpusDir / (input + ".exe"), input) && ok;
+    }
+    vbdecompiler_free(handle);
+
+    return ok ? 0 : 1;
+}
@@ -7,9 +7,171 @@
  */
 
 #include "vbdecompiler_ffi.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <print>
 #include <vector>
-#include <cstdint>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Typical VB native-code shapes: prologue, immediates, calls, epilogue
+std::vector<uint8_t> makeBenchmarkCode(size_t size) {
+    const uint8_t pattern[] = {
+        0x55,                               // PUSH EBP
+        0x8B, 0xEC,                         // MOV EBP, ESP
+        0x83, 0xEC, 0x10,                   // SUB ESP, 0x10
+        0xB8, 0x2A, 0x00, 0x00, 0x00,       // MOV EAX, 42
+        0x8B, 0x45, 0x08,                   // MOV EAX, [EBP+8]
+        0xE8, 0x00, 0x00, 0x00, 0x00,       // CALL rel32
+        0x85, 0xC0,                         // TEST EAX, EAX
+        0x74, 0x02,                         // JE +2
+        0x33, 0xC0,                         // XOR EAX, EAX
+        0x8B, 0xE5,                         // MOV ESP, EBP
+        0x5D,                               // POP EBP
+        0xC3                                // RET
+    };
+
+    std::vector<uint8_t> code;
+    code.reserve(size + sizeof(pattern));
+    while (code.size() < size) {
+        code.insert(code.end(), std::begin(pattern), std::end(pattern));
+    }
+    return code;
+}
+
+template <typename F>
+double bestOfMs(int runs, F&& body) {
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        const auto start = Clock::now();
+        body();
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        best = (i == 0) ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Compare per-instruction x86_disassemble, the x86_disassemble_batch arena and
+// decode-only x86_decode
+bool runBenchmark(X86DisassemblerHandle* disasm) {
+    constexpr size_t CodeSize = 4 * 1024 * 1024;
+    constexpr int Runs = 3;
+    const auto code = makeBenchmarkCode(CodeSize);
+
+    std::println("\nBenchmark: {} MiB of x86 code, best of {} runs", code.size() / (1024 * 1024), Runs);
+
+    size_t perInstrCount = 0;
+    const double perInstrMs = bestOfMs(Runs, [&] {
+        X86InstructionResult* results = nullptr;
+        size_t count = 0;
+        if (x86_disassemble(disasm, code.data(), code.size(), 0x401000, &results, &count) >= 0) {
+            perInstrCount = count;
+            x86_disassembler_free_results(results, count);
+        }
+    });
+
+    size_t batchCount = 0;
+    const double batchMs = bestOfMs(Runs, [&] {
+        X86Listing* listing = nullptr;
+        if (x86_disassemble_batch(disasm, code.data(), code.size(), 0x401000, &listing) >= 0) {
+            batchCount = listing->count;
+            x86_listing_free(listing);
+        }
+    });
+
+    // Records are reused by the handle, so nothing is freed between runs
+    size_t decodeCount = 0;
+    const double decodeMs = bestOfMs(Runs, [&] {
+        const X86DecodedInstruction* records = nullptr;
+        size_t count = 0;
+        if (x86_decode(disasm, code.data(), code.size(), 0x401000, &records, &count) >= 0) {
+            decodeCount = count;
+        }
+    });
+
+    std::println("  x86_disassemble:       {:10.2f} ms ({} instructions)", perInstrMs, perInstrCount);
+    std::println("  x86_disassemble_batch: {:10.2f} ms ({} instructions)", batchMs, batchCount);
+    std::println("  x86_decode:            {:10.2f} ms ({} instructions)", decodeMs, decodeCount);
+    if (batchMs > 0.0) {
+        std::println("  speedup:               {:10.2f}x", perInstrMs / batchMs);
+    }
+    if (decodeMs > 0.0) {
+        std::println("  decode-only speedup:   {:10.2f}x", batchMs / decodeMs);
+    }
+
+    if (perInstrCount == 0 || perInstrCount != batchCount || batchCount != decodeCount) {
+        std::println(stderr, "Instruction count mismatch between APIs");
+        return false;
+    }
+    return true;
+}
+
+// Both APIs must agree on addresses, lengths, bytes and text
+bool checkBatchMatches(X86DisassemblerHandle* disasm, const std::vector<uint8_t>& code) {
+    X86InstructionResult* results = nullptr;
+    size_t count = 0;
+    X86Listing* listing = nullptr;
+
+    if (x86_disassemble(disasm, code.data(), code.size(), 0, &results, &count) < 0) {
+        return false;
+    }
+    if (x86_disassemble_batch(disasm, code.data(), code.size(), 0, &listing) < 0) {
+        x86_disassembler_free_results(results, count);
+        return false;
+    }
+
+    bool ok = listing->count == count;
+    for (size_t i = 0; ok && i < count; ++i) {
+        const auto& record = listing->records[i];
+        const char* text = listing->text + record.text_offset;
+        ok = record.address == results[i].address
+            && record.length == results[i].length
+            && std::memcmp(code.data() + record.code_offset, results[i].bytes, record.length) == 0
+            && results[i].text
+            && std::strcmp(text, results[i].text) == 0
+            && std::strlen(text) == record.text_len;
+    }
+
+    x86_listing_free(listing);
+    x86_disassembler_free_results(results, count);
+    return ok;
+}
+
+// Decoded records formatted on demand must match the batch listing
+bool checkDecodeMatches(X86DisassemblerHandle* disasm, const std::vector<uint8_t>& code) {
+    X86Listing* listing = nullptr;
+    if (x86_disassemble_batch(disasm, code.data(), code.size(), 0, &listing) < 0) {
+        return false;
+    }
+
+    const X86DecodedInstruction* records = nullptr;
+    size_t count = 0;
+    bool ok = x86_decode(disasm, code.data(), code.size(), 0, &records, &count) >= 0
+        && count == listing->count;
+    for (size_t i = 0; ok && i < count; ++i) {
+        const auto& record = records[i];
+        const auto& expected = listing->records[i];
+        char text[128];
+        const int len = x86_format(disasm, code.data() + record.code_offset,
+                                   code.size() - record.code_offset, record.address,
+                                   text, sizeof(text));
+        ok = record.address == expected.address
+            && record.length == expected.length
+            && record.code_offset == expected.code_offset
+            && len == static_cast<int>(expected.text_len)
+            && std::strcmp(text, listing->text + expected.text_offset) == 0;
+    }
+
+    x86_listing_free(listing);
+    return ok;
+}
+
+} // namespace
 
 int main() {
     std::println("X86 Disassembler Test (Rust Backend)");
@@ -68,6 +230,24 @@ int main() {
 
     // Cleanup
     x86_disassembler_free_results(results, count);
+
+    if (!checkBatchMatches(disasm, code)) {
+        std::println(stderr, "Batch disassembly does not match x86_disassemble");
+        x86_disassembler_free(disasm);
+        return 1;
+    }
+
+    if (!checkDecodeMatches(disasm, code)) {
+        std::println(stderr, "Decoded and formatted instructions do not match the batch listing");
+        x86_disassembler_free(disasm);
+        return 1;
+    }
+
+    if (!runBenchmark(disasm)) {
+        x86_disassembler_free(disasm);
+        return 1;
+    }
+
     x86_disassembler_free(disasm);
 
     std::println("\nTest PASSED");